@@ -0,0 +1,480 @@
+/************************************************************************/
+/*                                                                      */
+/*   Copyright 2014 by Ullrich Koethe  and Thorsten Beier               */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_BLOCKWISE_HIERARCHICAL_CLUSTERING_HXX
+#define VIGRA_BLOCKWISE_HIERARCHICAL_CLUSTERING_HXX
+
+/*std*/
+#include <vector>
+#include <map>
+#include <utility>
+#include <algorithm>
+
+/*vigra*/
+#include "adjacency_list_graph.hxx"
+#include "merge_graph_adaptor.hxx"
+#include "hierarchical_clustering.hxx"
+#include "multi_array_chunked.hxx"
+#include "union_find.hxx"
+#include "parallel_foreach.hxx"
+
+namespace vigra{
+
+    /// \brief options for \ref blockwiseHierarchicalClustering()
+    class BlockwiseClusteringOptions{
+    public:
+        BlockwiseClusteringOptions()
+        :   beta_(0.5),
+            wardness_(1.0),
+            metric_(metrics::ManhattanMetric),
+            blockThreshold_(0.5),
+            nodeNumStopCond_(1),
+            maxMergeWeight_(NumericTraits<float>::max()),
+            blockGrowth_(2),
+            queueOptions_(),
+            parallelOptions_(){
+        }
+
+        /// \brief weight of the node feature distance (see \ref cluster_operators::EdgeWeightNodeFeatures)
+        BlockwiseClusteringOptions & beta(const float beta){
+            beta_=beta;
+            return *this;
+        }
+
+        /// \brief weight of the size regularization (see \ref cluster_operators::EdgeWeightNodeFeatures)
+        BlockwiseClusteringOptions & wardness(const float wardness){
+            wardness_=wardness;
+            return *this;
+        }
+
+        /// \brief metric for the node feature distance
+        BlockwiseClusteringOptions & metric(const metrics::MetricType metric){
+            metric_=metric;
+            return *this;
+        }
+
+        /// \brief merges inside of blocks stop at this edge weight (default: 0.5)
+        ///
+        /// This should be a conservative (i.e. small) threshold, since merges inside of a block
+        /// cannot be undone when the block borders are removed at the next level.
+        BlockwiseClusteringOptions & blockThreshold(const float threshold){
+            blockThreshold_=threshold;
+            return *this;
+        }
+
+        /// \brief stopping condition of the final, global level
+        ///
+        /// Clustering stops when the graph has \a nodeNum nodes or when the
+        /// next edge weight exceeds \a maxMergeWeight (default: merge until a single node is left).
+        BlockwiseClusteringOptions & stopCondition(const size_t nodeNum,
+                                                   const float maxMergeWeight = NumericTraits<float>::max()){
+            nodeNumStopCond_=nodeNum;
+            maxMergeWeight_=maxMergeWeight;
+            return *this;
+        }
+
+        /// \brief factor by which the block size grows from one level to the next (default: 2)
+        BlockwiseClusteringOptions & blockGrowth(const unsigned int factor){
+            vigra_precondition(factor>1,
+                "BlockwiseClusteringOptions::blockGrowth(): factor must be at least 2.");
+            blockGrowth_=factor;
+            return *this;
+        }
+
+        /// \brief queue mode of the cluster operator
+        BlockwiseClusteringOptions & queueOptions(const cluster_operators::ClusterQueueOptions & options){
+            queueOptions_=options;
+            return *this;
+        }
+
+        /// \brief number of threads used to process the blocks of a level
+        BlockwiseClusteringOptions & numThreads(const int n){
+            parallelOptions_.numThreads(n);
+            return *this;
+        }
+
+        float beta_;
+        float wardness_;
+        metrics::MetricType metric_;
+        float blockThreshold_;
+        size_t nodeNumStopCond_;
+        float maxMergeWeight_;
+        unsigned int blockGrowth_;
+        cluster_operators::ClusterQueueOptions queueOptions_;
+        ParallelOptions parallelOptions_;
+    };
+
+namespace detail_blockwise_clustering{
+
+    // the features of the graph items are stored at these indices
+    // of the chunked arrays
+    struct IdentityIds{
+        Int64 operator[](const Int64 id)const{
+            return id;
+        }
+    };
+
+    // graph of a higher level of the block hierarchy
+    struct LevelGraph{
+        AdjacencyListGraph graph;
+        std::vector<Int64> nodeIds;
+        std::vector<Int64> edgeIds;
+    };
+
+    template<class FEATURE_TYPE>
+    struct FeatureArrays{
+        ChunkedArray<1, float>        & edgeIndicators;
+        ChunkedArray<1, float>        & edgeSizes;
+        ChunkedArray<1, FEATURE_TYPE> & nodeFeatures;
+        ChunkedArray<1, float>        & nodeSizes;
+    };
+
+    // records the merges of a block (in terms of feature indices)
+    // via the merge graph's callbacks
+    struct MergeRecorder{
+        typedef MergeGraphAdaptor<AdjacencyListGraph>::Node Node;
+
+        void mergeNodes(const Node & a, const Node & b){
+            merges->push_back(std::make_pair((*ids)[a.id()], (*ids)[b.id()]));
+        }
+
+        const std::vector<Int64>                 * ids;
+        std::vector<std::pair<Int64, Int64> >    * merges;
+    };
+
+    // agglomerate the nodes of a single block
+    template<class GRAPH, class NODE_IDS, class EDGE_IDS, class FEATURE_TYPE>
+    void clusterBlock(
+        const GRAPH & g,
+        const NODE_IDS & nodeIds,
+        const EDGE_IDS & edgeIds,
+        const std::vector<typename GRAPH::index_type> & blockNodes,
+        FeatureArrays<FEATURE_TYPE> & arrays,
+        const BlockwiseClusteringOptions & options,
+        const size_t nodeNumStopCond,
+        const float maxMergeWeight,
+        std::vector<std::pair<Int64, Int64> > & merges
+    ){
+        typedef typename GRAPH::index_type index_type;
+        typedef typename GRAPH::Node Node;
+        typedef typename GRAPH::IncEdgeIt IncEdgeIt;
+        typedef AdjacencyListGraph::EdgeMap<float>         FloatEdgeMap;
+        typedef AdjacencyListGraph::NodeMap<float>         FloatNodeMap;
+        typedef AdjacencyListGraph::NodeMap<FEATURE_TYPE>  FeatureNodeMap;
+        typedef MergeGraphAdaptor<AdjacencyListGraph>      MergeGraph;
+        typedef cluster_operators::EdgeWeightNodeFeatures<
+            MergeGraph, FloatEdgeMap, FloatEdgeMap, FeatureNodeMap, FloatNodeMap, FloatEdgeMap
+        > ClusterOperator;
+        typedef HierarchicalClustering<ClusterOperator> Clustering;
+
+        // blockNodes are sorted, so the local id of a node can be found by bisection
+        AdjacencyListGraph local(blockNodes.size());
+        std::vector<Int64> localNodeIds(blockNodes.size()), localEdgeIds;
+        for(size_t k=0; k<blockNodes.size(); ++k){
+            local.addNode();
+            localNodeIds[k]=nodeIds[blockNodes[k]];
+        }
+        for(size_t k=0; k<blockNodes.size(); ++k){
+            const Node node(g.nodeFromId(blockNodes[k]));
+            for(IncEdgeIt e(g, node); e!=lemon::INVALID; ++e){
+                const index_type other = g.id(g.u(*e))==blockNodes[k] ? g.id(g.v(*e)) : g.id(g.u(*e));
+                if(other<=blockNodes[k])
+                    continue;
+                typename std::vector<index_type>::const_iterator iter =
+                    std::lower_bound(blockNodes.begin(), blockNodes.end(), other);
+                if(iter==blockNodes.end() || *iter!=other)
+                    continue;
+                local.addEdge(local.nodeFromId(k), local.nodeFromId(iter-blockNodes.begin()));
+                localEdgeIds.push_back(edgeIds[g.id(*e)]);
+            }
+        }
+        if(local.edgeNum()==0)
+            return;
+
+        FloatEdgeMap edgeIndicators(local), edgeSizes(local), minWeights(local);
+        FloatNodeMap nodeSizes(local);
+        FeatureNodeMap nodeFeatures(local);
+        for(size_t k=0; k<localEdgeIds.size(); ++k){
+            const Shape1 p(localEdgeIds[k]);
+            edgeIndicators[local.edgeFromId(k)]=arrays.edgeIndicators.getItem(p);
+            edgeSizes[local.edgeFromId(k)]=arrays.edgeSizes.getItem(p);
+        }
+        for(size_t k=0; k<localNodeIds.size(); ++k){
+            const Shape1 p(localNodeIds[k]);
+            nodeFeatures[local.nodeFromId(k)]=arrays.nodeFeatures.getItem(p);
+            nodeSizes[local.nodeFromId(k)]=arrays.nodeSizes.getItem(p);
+        }
+
+        MergeGraph mergeGraph(local);
+        ClusterOperator clusterOperator(mergeGraph, edgeIndicators, edgeSizes, nodeFeatures,
+                                        nodeSizes, minWeights, options.beta_, options.metric_,
+                                        options.wardness_, options.queueOptions_);
+        MergeRecorder recorder;
+        recorder.ids=&localNodeIds;
+        recorder.merges=&merges;
+        mergeGraph.registerMergeNodeCallBack(MergeGraph::MergeNodeCallBackType::
+            template from_method<MergeRecorder, &MergeRecorder::mergeNodes>(&recorder));
+
+        Clustering clustering(clusterOperator,
+            typename Clustering::Parameter(nodeNumStopCond, false, false, maxMergeWeight));
+        clustering.cluster();
+    }
+
+    // agglomerate block b of a level (called by parallel_foreach())
+    template<class GRAPH, class NODE_IDS, class EDGE_IDS, class FEATURE_TYPE>
+    struct BlockClusterer{
+        typedef typename GRAPH::index_type index_type;
+
+        BlockClusterer(const GRAPH & g,
+                       const NODE_IDS & nodeIds,
+                       const EDGE_IDS & edgeIds,
+                       const std::vector<std::vector<index_type> > & blocks,
+                       FeatureArrays<FEATURE_TYPE> & arrays,
+                       const BlockwiseClusteringOptions & options,
+                       const size_t nodeNumStopCond,
+                       const float maxMergeWeight,
+                       std::vector<std::vector<std::pair<Int64, Int64> > > & merges)
+        :   g_(g), nodeIds_(nodeIds), edgeIds_(edgeIds), blocks_(blocks), arrays_(arrays),
+            options_(options), nodeNumStopCond_(nodeNumStopCond), maxMergeWeight_(maxMergeWeight),
+            merges_(merges){
+        }
+
+        void operator()(int, MultiArrayIndex b) const{
+            clusterBlock(g_, nodeIds_, edgeIds_, blocks_[b], arrays_, options_,
+                         nodeNumStopCond_, maxMergeWeight_, merges_[b]);
+        }
+
+        const GRAPH & g_;
+        const NODE_IDS & nodeIds_;
+        const EDGE_IDS & edgeIds_;
+        const std::vector<std::vector<index_type> > & blocks_;
+        FeatureArrays<FEATURE_TYPE> & arrays_;
+        const BlockwiseClusteringOptions & options_;
+        const size_t nodeNumStopCond_;
+        const float maxMergeWeight_;
+        std::vector<std::vector<std::pair<Int64, Int64> > > & merges_;
+    };
+
+    // agglomerate all blocks of a level and record the merges in ufd,
+    // returns true when the level consists of a single block
+    template<int N, class GRAPH, class NODE_IDS, class EDGE_IDS, class BLOCKS, class FEATURE_TYPE>
+    bool clusterLevel(
+        const GRAPH & g,
+        const NODE_IDS & nodeIds,
+        const EDGE_IDS & edgeIds,
+        const BLOCKS & nodeBlocks,
+        const TinyVector<MultiArrayIndex, N> & blockScale,
+        FeatureArrays<FEATURE_TYPE> & arrays,
+        const BlockwiseClusteringOptions & options,
+        UnionFindArray<Int64> & ufd
+    ){
+        typedef typename GRAPH::index_type index_type;
+        typedef typename GRAPH::NodeIt NodeIt;
+        typedef TinyVector<MultiArrayIndex, N> BlockCoordinate;
+
+        std::map<BlockCoordinate, std::vector<index_type> > blockMap;
+        for(NodeIt n(g); n!=lemon::INVALID; ++n){
+            const index_type id = g.id(*n);
+            blockMap[nodeBlocks(nodeIds[id]) / blockScale].push_back(id);
+        }
+        std::vector<std::vector<index_type> > blocks;
+        blocks.reserve(blockMap.size());
+        for(typename std::map<BlockCoordinate, std::vector<index_type> >::iterator
+                b=blockMap.begin(); b!=blockMap.end(); ++b){
+            blocks.push_back(std::vector<index_type>());
+            blocks.back().swap(b->second);
+            std::sort(blocks.back().begin(), blocks.back().end());
+        }
+        blockMap.clear();
+
+        const bool finalLevel = blocks.size()<=1;
+        const size_t nodeNumStopCond = finalLevel ? options.nodeNumStopCond_ : 1;
+        const float maxMergeWeight = finalLevel ? options.maxMergeWeight_ : options.blockThreshold_;
+
+        std::vector<std::vector<std::pair<Int64, Int64> > > merges(blocks.size());
+        parallel_foreach(options.parallelOptions_.getActualNumThreads(), blocks.size(),
+            BlockClusterer<GRAPH, NODE_IDS, EDGE_IDS, FEATURE_TYPE>(
+                g, nodeIds, edgeIds, blocks, arrays, options,
+                nodeNumStopCond, maxMergeWeight, merges));
+
+        for(size_t b=0; b<merges.size(); ++b)
+            for(size_t k=0; k<merges[b].size(); ++k)
+                ufd.makeUnion(merges[b][k].first, merges[b][k].second);
+        return finalLevel;
+    }
+
+    // build the graph of the next level by contracting the merged nodes, and
+    // store the merged features at the representatives' indices
+    template<class GRAPH, class NODE_IDS, class EDGE_IDS, class FEATURE_TYPE>
+    void contractLevel(
+        const GRAPH & g,
+        const NODE_IDS & nodeIds,
+        const EDGE_IDS & edgeIds,
+        FeatureArrays<FEATURE_TYPE> & arrays,
+        UnionFindArray<Int64> & ufd,
+        std::vector<Int64> & levelIndex,
+        LevelGraph & next
+    ){
+        typedef typename GRAPH::NodeIt NodeIt;
+        typedef typename GRAPH::EdgeIt EdgeIt;
+
+        std::vector<FEATURE_TYPE> featureSums;
+        std::vector<float>        sizeSums;
+        for(NodeIt n(g); n!=lemon::INVALID; ++n){
+            const Int64 id = nodeIds[g.id(*n)];
+            const Int64 root = ufd.findIndex(id);
+            if(levelIndex[root]<0){
+                levelIndex[root]=next.graph.id(next.graph.addNode());
+                next.nodeIds.push_back(root);
+                featureSums.push_back(FEATURE_TYPE());
+                sizeSums.push_back(0.0f);
+            }
+            const float size = arrays.nodeSizes.getItem(Shape1(id));
+            featureSums[levelIndex[root]]+=arrays.nodeFeatures.getItem(Shape1(id))*size;
+            sizeSums[levelIndex[root]]+=size;
+        }
+        for(size_t k=0; k<next.nodeIds.size(); ++k){
+            arrays.nodeFeatures.setItem(Shape1(next.nodeIds[k]), featureSums[k]/sizeSums[k]);
+            arrays.nodeSizes.setItem(Shape1(next.nodeIds[k]), sizeSums[k]);
+        }
+        std::vector<FEATURE_TYPE>().swap(featureSums);
+
+        std::vector<float> indicatorSums;
+        sizeSums.clear();
+        for(EdgeIt e(g); e!=lemon::INVALID; ++e){
+            const Int64 u = levelIndex[ufd.findIndex(nodeIds[g.id(g.u(*e))])];
+            const Int64 v = levelIndex[ufd.findIndex(nodeIds[g.id(g.v(*e))])];
+            if(u==v)
+                continue;
+            const Int64 id = edgeIds[g.id(*e)];
+            const Int64 edge = next.graph.id(next.graph.addEdge(next.graph.nodeFromId(u),
+                                                                 next.graph.nodeFromId(v)));
+            if(edge==static_cast<Int64>(next.edgeIds.size())){
+                next.edgeIds.push_back(id);
+                indicatorSums.push_back(0.0f);
+                sizeSums.push_back(0.0f);
+            }
+            const float size = arrays.edgeSizes.getItem(Shape1(id));
+            indicatorSums[edge]+=arrays.edgeIndicators.getItem(Shape1(id))*size;
+            sizeSums[edge]+=size;
+        }
+        for(size_t k=0; k<next.edgeIds.size(); ++k){
+            arrays.edgeIndicators.setItem(Shape1(next.edgeIds[k]), indicatorSums[k]/sizeSums[k]);
+            arrays.edgeSizes.setItem(Shape1(next.edgeIds[k]), sizeSums[k]);
+        }
+
+        for(size_t k=0; k<next.nodeIds.size(); ++k)
+            levelIndex[next.nodeIds[k]]=-1;
+    }
+
+} // namespace detail_blockwise_clustering
+
+    /// \brief block-hierarchical agglomerative clustering of a region adjacency graph
+    ///
+    /// The graph topology is kept in memory, but the edge and node features are
+    /// stored in chunked arrays (e.g. \ref ChunkedArrayCompressed, \ref ChunkedArrayTmpFile
+    /// or \ref ChunkedArrayHDF5), indexed by the edge and node ids of \a rag.
+    /// Every node is assigned to a block by \a nodeBlocks (indexed by node id).
+    ///
+    /// The clustering proceeds in levels. At each level, the nodes of every block
+    /// are agglomerated independently (and in parallel) with
+    /// \ref cluster_operators::EdgeWeightNodeFeatures and \ref HierarchicalClustering,
+    /// only loading the features of the block into memory. Within a block, merging stops
+    /// at <tt>options.blockThreshold()</tt>. Then the graph is contracted, i.e. merged nodes
+    /// and parallel edges are replaced by their representatives with size-weighted mean
+    /// features, and the block coordinates are divided by <tt>options.blockGrowth()</tt>
+    /// for the next level. When all nodes are in a single block, the final level
+    /// runs until <tt>options.stopCondition()</tt> is reached.
+    ///
+    /// On return, \a nodeLabels holds for each node id the id of the cluster's representative
+    /// (the smallest node id in the cluster), and the merged features of each cluster are stored
+    /// in the chunked arrays at the index of its representative node and edges. The function
+    /// returns the number of clusters.
+    ///
+    /// <b>\#include</b> \<vigra/blockwise_hierarchical_clustering.hxx\><br/>
+    /// Namespace: vigra
+    template<int N, class S1, class FEATURE_TYPE, class LABEL_TYPE, class S2>
+    size_t blockwiseHierarchicalClustering(
+        const AdjacencyListGraph & rag,
+        const MultiArrayView<1, TinyVector<MultiArrayIndex, N>, S1> & nodeBlocks,
+        ChunkedArray<1, float> & edgeIndicators,
+        ChunkedArray<1, float> & edgeSizes,
+        ChunkedArray<1, FEATURE_TYPE> & nodeFeatures,
+        ChunkedArray<1, float> & nodeSizes,
+        MultiArrayView<1, LABEL_TYPE, S2> nodeLabels,
+        const BlockwiseClusteringOptions & options = BlockwiseClusteringOptions()
+    ){
+        using namespace detail_blockwise_clustering;
+        typedef AdjacencyListGraph::NodeIt NodeIt;
+
+        const MultiArrayIndex nodeCount = rag.maxNodeId()+1;
+        vigra_precondition(nodeBlocks.size()==nodeCount && nodeLabels.size()==nodeCount &&
+                           nodeFeatures.size()==nodeCount && nodeSizes.size()==nodeCount,
+            "blockwiseHierarchicalClustering(): node arrays must have size rag.maxNodeId()+1.");
+        vigra_precondition(edgeIndicators.size()==rag.maxEdgeId()+1 && edgeSizes.size()==rag.maxEdgeId()+1,
+            "blockwiseHierarchicalClustering(): edge arrays must have size rag.maxEdgeId()+1.");
+
+        FeatureArrays<FEATURE_TYPE> arrays = { edgeIndicators, edgeSizes, nodeFeatures, nodeSizes };
+        UnionFindArray<Int64> ufd(nodeCount);
+        std::vector<Int64> levelIndex(nodeCount, -1);
+        TinyVector<MultiArrayIndex, N> blockScale(1);
+
+        // the first level works on the rag itself, higher levels on contracted copies
+        LevelGraph levels[2];
+        int current = 0;
+        bool finalLevel = clusterLevel(rag, IdentityIds(), IdentityIds(), nodeBlocks,
+                                       blockScale, arrays, options, ufd);
+        contractLevel(rag, IdentityIds(), IdentityIds(), arrays, ufd, levelIndex, levels[current]);
+        while(!finalLevel){
+            const LevelGraph & graph = levels[current];
+            blockScale*=options.blockGrowth_;
+            finalLevel = clusterLevel(graph.graph, graph.nodeIds, graph.edgeIds, nodeBlocks,
+                                      blockScale, arrays, options, ufd);
+            levels[1-current] = LevelGraph();
+            contractLevel(graph.graph, graph.nodeIds, graph.edgeIds, arrays, ufd, levelIndex, levels[1-current]);
+            current = 1-current;
+        }
+
+        for(NodeIt n(rag); n!=lemon::INVALID; ++n){
+            const Int64 id = rag.id(*n);
+            nodeLabels(id)=static_cast<LABEL_TYPE>(ufd.findIndex(id));
+        }
+        return levels[current].nodeIds.size();
+    }
+
+} // namespace vigra
+
+#endif // VIGRA_BLOCKWISE_HIERARCHICAL_CLUSTERING_HXX
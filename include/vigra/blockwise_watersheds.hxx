@@ -41,8 +41,11 @@
 #include "blockify.hxx"
 #include "blockwise_labeling.hxx"
 #include "overlapped_blocks.hxx"
+#include "multi_watersheds.hxx"
+#include "parallel_foreach.hxx"
 
 #include <limits>
+#include <vector>
 
 namespace vigra
 {
@@ -123,6 +126,429 @@ struct UnionFindWatershedsEquality
     {};
 };
 
+    // Costs as stored by seededWatershedsBlockwiseImpl(), and their keys in the
+    // priority queue. In general, the priorities of the serial algorithm are
+    // stored directly.
+template <class PriorityFunctor>
+struct BlockwiseWatershedCosts
+{
+    typedef typename PriorityFunctor::priority_type  cost_type;
+    typedef typename PriorityFunctor::priority_type  key_type;
+
+    BlockwiseWatershedCosts(PriorityFunctor const & priority)
+    : priority_(priority)
+    {}
+
+    template <class T>
+    cost_type operator()(T data) const
+    {
+        return priority_(data);
+    }
+
+    key_type key(cost_type cost) const
+    {
+        return cost;
+    }
+
+    bool exceeds(cost_type cost, double threshold) const
+    {
+        return priority_.exceeds(cost, threshold);
+    }
+
+    PriorityFunctor priority_;
+};
+
+    // Integral data are mapped one-to-one onto the buckets when their range 
+    // is small enough (see watershedBucketParameters()). Then the costs can be 
+    // stored in the data type itself, which is usually much smaller than the 
+    // bucket index.
+template <class Data>
+struct BlockwiseWatershedExactBucketCosts
+{
+    typedef Data            cost_type;
+    typedef std::ptrdiff_t  key_type;
+
+    explicit BlockwiseWatershedExactBucketCosts(double offset)
+    : offset_((key_type)offset)
+    {}
+
+    cost_type operator()(Data data) const
+    {
+        return data;
+    }
+
+    key_type key(cost_type cost) const
+    {
+        return (key_type)cost - offset_;
+    }
+
+    bool exceeds(cost_type cost, double threshold) const
+    {
+        return cost > threshold;
+    }
+
+    key_type offset_;
+};
+
+    // Labels and costs on the block borders at the end of the previous round, 
+    // and the round in which they last changed. The blocks read their halo from
+    // here, so that all blocks of a round can run in parallel. The arrays of 
+    // dimension d only hold the first and the last slice along d of every 
+    // block, i.e. 2 / block_shape[d] of a full array (pixels on several 
+    // borders are stored in each of the corresponding arrays).
+template <unsigned int N, class Label, class CostType>
+struct BlockBorderSnapshot
+{
+    typedef typename MultiArrayShape<N>::type  Shape;
+    typedef std::pair<Shape, Shape>            Box;
+
+    BlockBorderSnapshot(Shape const & shape, Shape const & block_shape)
+    : block_shape_(block_shape)
+    {
+        for(unsigned int d=0; d<N; ++d)
+        {
+            Shape slices_shape(shape);
+            slices_shape[d] = 2*((shape[d] + block_shape[d] - 1) / block_shape[d]);
+            labels[d].reshape(slices_shape);
+            cost[d].reshape(slices_shape);
+            round[d].reshape(slices_shape);
+        }
+    }
+
+        // find the array holding the halo pixel p of 'box', and p's index in it
+    Shape haloIndex(Box const & box, Shape p, unsigned int & d) const
+    {
+        for(d=0; p[d] >= box.first[d] && p[d] < box.second[d]; ++d)
+            ;
+        p[d] = p[d] < box.first[d]
+                  ? 2*(p[d] / block_shape_[d]) + 1  // last slice of the preceding block
+                  : 2*(p[d] / block_shape_[d]);     // first slice of the following block
+        return p;
+    }
+
+        // copy the border of 'box', marking the pixels that changed with 'current_round'
+    template <class LabelArray, class CostArray>
+    void store(Box const & box, LabelArray const & new_labels, CostArray const & new_cost,
+               int current_round)
+    {
+        for(unsigned int d=0; d<N; ++d)
+        {
+            for(int side=0; side<2; ++side)
+            {
+                Shape face_begin(box.first), face_end(box.second);
+                face_begin[d] = side == 0
+                                   ? box.first[d]
+                                   : box.second[d] - 1;
+                face_end[d] = face_begin[d] + 1;
+                MultiArrayIndex slice = 2*(box.first[d] / block_shape_[d]) + side;
+                MultiCoordinateIterator<N> i(face_end - face_begin), end(i.getEndIterator());
+                for(; i != end; ++i)
+                {
+                    Shape p = face_begin + *i, q = p;
+                    q[d] = slice;
+                    if(labels[d][q] != new_labels[p] || cost[d][q] != new_cost[p])
+                    {
+                        labels[d][q] = new_labels[p];
+                        cost[d][q] = new_cost[p];
+                        round[d][q] = current_round;
+                    }
+                }
+            }
+        }
+    }
+
+    Shape block_shape_;
+    MultiArray<N, Label> labels[N];
+    MultiArray<N, CostType> cost[N];
+    MultiArray<N, int> round[N];
+};
+
+    // Flood block active[k] in the current round (called by parallel_foreach()).
+template <unsigned int N, class Data, class S1, class Label, class S2,
+          class Queue, class CostFunctor>
+struct BlockwiseWatershedFlooder
+{
+    typedef typename MultiArrayShape<N>::type        Shape;
+    typedef GridGraph<N, undirected_tag>             Graph;
+    typedef typename Graph::OutArcIt                 neighbor_iterator;
+    typedef typename CostFunctor::cost_type          CostType;
+    typedef std::pair<Shape, Shape>                  Box;
+    typedef BlockBorderSnapshot<N, Label, CostType>  Halo;
+
+    BlockwiseWatershedFlooder(MultiArrayView<N, Data, S1> const & data,
+                              MultiArrayView<N, Label, S2> & labels,
+                              Graph const & graph,
+                              WatershedOptions const & options,
+                              CostFunctor const & costOf,
+                              std::vector<Box> const & blocks,
+                              std::vector<MultiArrayIndex> const & active,
+                              Halo const & halo,
+                              int round,
+                              std::vector<Queue> & queues,
+                              MultiArray<N, CostType> & cost,
+                              MultiArray<N, CostType> & arrival,
+                              MultiArray<N, unsigned short> & predecessor,
+                              std::vector<char> & border_changed)
+    : data_(data), labels_(labels), graph_(graph), options_(options), costOf_(costOf),
+      shape_(data.shape()), blocks_(blocks), active_(active), halo_(halo), round_(round),
+      queues_(queues), cost_(cost), arrival_(arrival), predecessor_(predecessor),
+      border_changed_(border_changed)
+    {}
+
+    void operator()(int thread_id, MultiArrayIndex k) const
+    {
+        MultiArrayIndex b = active_[k];
+        Box const & box = blocks_[b];
+        Shape halo_begin = max(box.first - Shape(1), Shape()),
+              halo_end   = min(box.second + Shape(1), shape_);
+        Queue & pqueue = queues_[thread_id];
+
+        // register the halo pixels that changed in the previous round 
+        // (in the first round: all labeled ones), each of them exactly once
+        for(unsigned int d=0; d<N; ++d)
+        {
+            Shape face_begin(halo_begin), face_end(halo_end);
+            for(unsigned int j=0; j<d; ++j)
+            {
+                face_begin[j] = box.first[j];
+                face_end[j] = box.second[j];
+            }
+            for(int side=0; side<2; ++side)
+            {
+                MultiArrayIndex c = side == 0
+                                       ? box.first[d] - 1
+                                       : box.second[d];
+                if(c < 0 || c >= shape_[d])
+                    continue;
+                face_begin[d] = c;
+                face_end[d] = c + 1;
+                MultiCoordinateIterator<N> i(face_end - face_begin), end(i.getEndIterator());
+                for(; i != end; ++i)
+                {
+                    unsigned int hd;
+                    Shape q = halo_.haloIndex(box, face_begin + *i, hd);
+                    if(halo_.labels[hd][q] != 0 && 
+                       (round_ == 0 || halo_.round[hd][q] == round_ - 1))
+                        pqueue.push(face_begin + *i, costOf_.key(halo_.cost[hd][q]));
+                }
+            }
+        }
+        if(round_ == 0)
+        {
+            // register the seeds inside the block
+            MultiCoordinateIterator<N> i(box.second - box.first), end(i.getEndIterator());
+            for(; i != end; ++i)
+                if(labels_[box.first + *i] != 0)
+                    pqueue.push(box.first + *i, costOf_.key(cost_[box.first + *i]));
+        }
+
+        bool changed = false;
+        while(!pqueue.empty())
+        {
+            Shape node = pqueue.top();
+            typename CostFunctor::key_type key = pqueue.topPriority();
+            pqueue.pop();
+
+            CostType c;
+            Label label;
+            if(within(node, box))
+            {
+                c = cost_[node];
+                label = labels_[node];
+            }
+            else
+            {
+                unsigned int hd;
+                Shape q = halo_.haloIndex(box, node, hd);
+                c = halo_.cost[hd][q];
+                label = halo_.labels[hd][q];
+            }
+            if(key != costOf_.key(c))
+                continue; // outdated queue entry
+            if((options_.terminate & StopAtThreshold) && costOf_.exceeds(c, options_.max_cost))
+                continue;
+
+            for(neighbor_iterator arc(graph_, node); arc != lemon::INVALID; ++arc)
+            {
+                Shape target = graph_.target(*arc);
+                if(!within(target, box))
+                    continue;
+                unsigned short back = (unsigned short)graph_.oppositeIndex(arc.neighborIndex());
+                if(labels_[target] != 0 && !(c < arrival_[target]) &&
+                   !(c == arrival_[target] && predecessor_[target] == back && labels_[target] != label))
+                    continue;
+                CostType priority = costOf_(data_[target]);
+                if(priority < c)
+                    priority = c;
+                labels_[target] = label;
+                arrival_[target] = c;
+                predecessor_[target] = back;
+                cost_[target] = priority;
+                pqueue.push(target, costOf_.key(priority));
+                if(!allLess(box.first, target) || !allLess(target + Shape(1), box.second))
+                    changed = true;
+            }
+        }
+        border_changed_[b] = changed;
+    }
+
+    MultiArrayView<N, Data, S1> const & data_;
+    MultiArrayView<N, Label, S2> & labels_;
+    Graph const & graph_;
+    WatershedOptions const & options_;
+    CostFunctor const & costOf_;
+    Shape shape_;
+    std::vector<Box> const & blocks_;
+    std::vector<MultiArrayIndex> const & active_;
+    Halo const & halo_;
+    int round_;
+    std::vector<Queue> & queues_;
+    MultiArray<N, CostType> & cost_;
+    MultiArray<N, CostType> & arrival_;
+    MultiArray<N, unsigned short> & predecessor_;
+    std::vector<char> & border_changed_;
+};
+
+    // Copy the borders of the changed blocks into the snapshot (called by parallel_foreach()).
+template <unsigned int N, class Label, class S2, class CostType>
+struct BlockBorderStorer
+{
+    typedef typename MultiArrayShape<N>::type  Shape;
+    typedef std::pair<Shape, Shape>            Box;
+
+    BlockBorderStorer(BlockBorderSnapshot<N, Label, CostType> & halo,
+                      std::vector<Box> const & blocks,
+                      std::vector<MultiArrayIndex> const & changed_blocks,
+                      MultiArrayView<N, Label, S2> const & labels,
+                      MultiArray<N, CostType> const & cost,
+                      int round)
+    : halo_(halo), blocks_(blocks), changed_blocks_(changed_blocks),
+      labels_(labels), cost_(cost), round_(round)
+    {}
+
+    void operator()(int, MultiArrayIndex k) const
+    {
+        halo_.store(blocks_[changed_blocks_[k]], labels_, cost_, round_);
+    }
+
+    BlockBorderSnapshot<N, Label, CostType> & halo_;
+    std::vector<Box> const & blocks_;
+    std::vector<MultiArrayIndex> const & changed_blocks_;
+    MultiArrayView<N, Label, S2> const & labels_;
+    MultiArray<N, CostType> const & cost_;
+    int round_;
+};
+
+    // Blockwise seeded watersheds: each block is flooded by a priority queue from
+    // the seeds in the block and from the labeled pixels in its 1-pixel halo.
+    // A pixel takes the label of the neighbor from which it is reached with
+    // lowest cost ('arrival'), exactly as in the serial algorithm. Since a
+    // neighbor may later change its label without changing its cost, we also
+    // remember the direction of that neighbor ('predecessor') and follow such
+    // label changes. When a block changes pixels on its border, its neighbors 
+    // are flooded again in the next round from the halo pixels that changed, 
+    // until no border changes anymore. All blocks of a round read the halo from
+    // a snapshot of the block borders after the previous round, so that they 
+    // can run in parallel.
+template <unsigned int N, class Data, class S1, class Label, class S2,
+          class Queue, class CostFunctor>
+Label
+seededWatershedsBlockwiseImpl(MultiArrayView<N, Data, S1> const & data,
+                              MultiArrayView<N, Label, S2> labels,
+                              NeighborhoodType neighborhood,
+                              WatershedOptions const & options,
+                              typename MultiArrayShape<N>::type const & block_shape,
+                              ParallelOptions const & parallel_options,
+                              Queue const & queue_prototype,
+                              CostFunctor const & costOf)
+{
+    typedef typename MultiArrayShape<N>::type        Shape;
+    typedef GridGraph<N, undirected_tag>             Graph;
+    typedef typename CostFunctor::cost_type          CostType;
+    typedef std::pair<Shape, Shape>                  Box;
+
+    Shape shape = data.shape();
+    Graph graph(shape, neighborhood);
+
+    Shape blocks_shape;
+    for(unsigned int k=0; k<N; ++k)
+        blocks_shape[k] = (shape[k] + block_shape[k] - 1) / block_shape[k];
+    MultiArrayIndex block_count = prod(blocks_shape);
+
+    std::vector<Box> blocks;
+    blocks.reserve(block_count);
+    MultiCoordinateIterator<N> bi(blocks_shape), bend(bi.getEndIterator());
+    for(; bi != bend; ++bi)
+        blocks.push_back(Box(*bi*block_shape, min((*bi + Shape(1))*block_shape, shape)));
+
+    // initialize costs from the seeds
+    MultiArray<N, CostType> cost(shape), arrival(shape);
+    MultiArray<N, unsigned short> predecessor(shape, NumericTraits<unsigned short>::max());
+    Label maxRegionLabel = 0;
+    {
+        MultiCoordinateIterator<N> i(shape), end(i.getEndIterator());
+        for(; i != end; ++i)
+        {
+            Label label = labels[*i];
+            if(label == 0)
+                continue;
+            if(maxRegionLabel < label)
+                maxRegionLabel = label;
+            cost[*i] = costOf(data[*i]);
+            arrival[*i] = NumericTraits<CostType>::isIntegral::value
+                             ? NumericTraits<CostType>::min()
+                             : -NumericTraits<CostType>::max();
+        }
+    }
+    BlockBorderSnapshot<N, Label, CostType> halo(shape, block_shape);
+    for(MultiArrayIndex b=0; b<block_count; ++b)
+        halo.store(blocks[b], labels, cost, 0);
+
+    int nThreads = parallel_options.getActualNumThreads();
+    std::vector<Queue> queues(nThreads, queue_prototype);
+    std::vector<MultiArrayIndex> active(block_count);
+    for(MultiArrayIndex b=0; b<block_count; ++b)
+        active[b] = b;
+    std::vector<char> border_changed(block_count, 0);
+
+    for(int round = 0; !active.empty(); ++round)
+    {
+        std::fill(border_changed.begin(), border_changed.end(), 0);
+
+        parallel_foreach(nThreads, (MultiArrayIndex)active.size(),
+            BlockwiseWatershedFlooder<N, Data, S1, Label, S2, Queue, CostFunctor>(
+                data, labels, graph, options, costOf, blocks, active, halo, round,
+                queues, cost, arrival, predecessor, border_changed));
+
+        // update the halo snapshot and activate the neighbors of changed blocks
+        std::vector<MultiArrayIndex> changed_blocks;
+        for(MultiArrayIndex b=0; b<block_count; ++b)
+            if(border_changed[b])
+                changed_blocks.push_back(b);
+
+        parallel_foreach(nThreads, (MultiArrayIndex)changed_blocks.size(),
+            BlockBorderStorer<N, Label, S2, CostType>(halo, blocks, changed_blocks, 
+                                                      labels, cost, round));
+
+        std::vector<char> is_active(block_count, 0);
+        for(unsigned int k=0; k<changed_blocks.size(); ++k)
+        {
+            Shape b = blocks[changed_blocks[k]].first / block_shape,
+                  begin = max(b - Shape(1), Shape()),
+                  end = min(b + Shape(2), blocks_shape);
+            MultiCoordinateIterator<N> i(end - begin), iend(i.getEndIterator());
+            for(; i != iend; ++i)
+                if(begin + *i != b)
+                    is_active[detail::CoordinateToScanOrder<N>::exec(blocks_shape, begin + *i)] = 1;
+        }
+        active.clear();
+        for(MultiArrayIndex b=0; b<block_count; ++b)
+            if(is_active[b])
+                active.push_back(b);
+    }
+    return maxRegionLabel;
+}
+
 } // namespace blockwise_watersheds_detail
 
 template <unsigned int N, class Data, class S1,
@@ -235,6 +661,127 @@ unionFindWatershedsBlockwise(const ChunkedArray<N, Data>& data,
     return unionFindWatershedsBlockwise(data, labels, neighborhood, directions);
 }
 
+/*************************************************************/
+/*                                                           */
+/*                 seededWatershedsBlockwise                 */
+/*                                                           */
+/*************************************************************/
+
+/** \brief Parallel seeded watersheds transform.
+    
+    <b> Declaration:</b>
+    
+    \code
+    namespace vigra {
+        template <unsigned int N, class Data, class S1,
+                                  class Label, class S2>
+        Label seededWatershedsBlockwise(MultiArrayView<N, Data, S1> const & data,
+                                        MultiArrayView<N, Label, S2> labels,  // may also hold input seeds
+                                        NeighborhoodType neighborhood = DirectNeighborhood,
+                                        WatershedOptions const & options = WatershedOptions(),
+                                        typename MultiArrayShape<N>::type const & block_shape = 
+                                                 typename MultiArrayShape<N>::type(64),
+                                        ParallelOptions const & parallel_options = ParallelOptions());
+    }
+    \endcode
+    
+    This is a parallel version of \ref watershedsMultiArray() with method <tt>regionGrowing()</tt>.
+    The array is divided into blocks of the given \a block_shape, which are flooded 
+    concurrently from the seeds in \a labels (if \a labels contains no seeds, or if seeding 
+    options are given, seeds are computed by generateWatershedSeeds() first). Each block 
+    also receives the labels of its 1-pixel halo, and whenever a block changes the labels 
+    along its border, its neighbors are flooded again, until all blocks agree. The result is
+    the same as for watershedsMultiArray(), except for pixels where two regions meet at
+    exactly the same cost (tie breaking may then differ). The choice of the priority queue
+    (bucket queue for integer data or with <tt>turboAlgorithm()</tt>, heap otherwise) is the 
+    same as in watershedsMultiArray().
+    
+    The option <tt>stopAtThreshold()</tt> is supported, <tt>keepContours()</tt> and 
+    <tt>biasLabel()</tt> are not (a biased region's cost depends on which region finally 
+    gets a pixel, so the blocks would not necessarily agree). When the method <tt>unionFind()</tt> is requested, 
+    the call is forwarded to unionFindWatershedsBlockwise().
+    
+    Return: the number of regions (= the highest seed label)
+    
+    <b> Usage: </b>
+
+    <b>\#include </b> \<vigra/blockwise_watersheds.hxx\><br>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, UInt16> data(Shape3(512));
+    MultiArray<3, UInt32> labels(data.shape());
+    ... // fill data and put seeds into 'labels'
+    
+    seededWatershedsBlockwise(data, labels, DirectNeighborhood, WatershedOptions(), 
+                              Shape3(64), ParallelOptions().numThreads(8));
+    \endcode
+    */
+doxygen_overloaded_function(template <...> unsigned int seededWatershedsBlockwise)
+
+template <unsigned int N, class Data, class S1,
+                          class Label, class S2>
+Label 
+seededWatershedsBlockwise(MultiArrayView<N, Data, S1> const & data,
+                          MultiArrayView<N, Label, S2> labels,
+                          NeighborhoodType neighborhood = DirectNeighborhood,
+                          WatershedOptions const & options = WatershedOptions(),
+                          typename MultiArrayShape<N>::type const & block_shape = 
+                                   typename MultiArrayShape<N>::type(64),
+                          ParallelOptions const & parallel_options = ParallelOptions())
+{
+    using namespace blockwise_watersheds_detail;
+    typedef GridGraph<N, undirected_tag>  Graph;
+    typedef typename Graph::Node          Node;
+    
+    vigra_precondition(data.shape() == labels.shape(),
+        "seededWatershedsBlockwise(): Shape mismatch between input and output.");
+    vigra_precondition(allGreater(block_shape, typename MultiArrayShape<N>::type()),
+        "seededWatershedsBlockwise(): block shape must be positive.");
+    
+    if(options.method == WatershedOptions::UnionFind)
+        return unionFindWatershedsBlockwise(data, labels, neighborhood, block_shape);
+    
+    vigra_precondition(options.method == WatershedOptions::RegionGrowing,
+        "seededWatershedsBlockwise(): invalid method in watershed options.");
+    vigra_precondition((options.terminate & KeepContours) == 0,
+        "seededWatershedsBlockwise(): keepContours() is not supported, use watershedsMultiArray().");
+    vigra_precondition(options.biased_label == 0,
+        "seededWatershedsBlockwise(): biasLabel() is not supported, use watershedsMultiArray().");
+    
+    Graph graph(data.shape(), neighborhood);
+    
+    // compute seeds under the same conditions as watershedsMultiArray()
+    if(options.seed_options.mini != SeedOptions::Unspecified)
+    {
+        lemon_graph::graph_detail::generateWatershedSeeds(graph, data, labels, options.seed_options);
+    }
+    else if(!labels.any())
+    {
+        lemon_graph::graph_detail::generateWatershedSeeds(graph, data, labels, SeedOptions());
+    }
+    
+    double offset, scale;
+    std::ptrdiff_t bucketCount;
+    bool exact;
+    if(lemon_graph::graph_detail::watershedBucketParameters(graph, data, options, 
+                                                            offset, scale, bucketCount, exact))
+    {
+        if(exact)
+            return seededWatershedsBlockwiseImpl(data, labels, neighborhood, options, 
+                       block_shape, parallel_options, BucketQueue<Node, true>(bucketCount),
+                       BlockwiseWatershedExactBucketCosts<Data>(offset));
+        typedef lemon_graph::graph_detail::WatershedBucketPriority BucketPriority;
+        return seededWatershedsBlockwiseImpl(data, labels, neighborhood, options, 
+                   block_shape, parallel_options, BucketQueue<Node, true>(bucketCount),
+                   BlockwiseWatershedCosts<BucketPriority>(BucketPriority(offset, scale, bucketCount)));
+    }
+    typedef lemon_graph::graph_detail::WatershedHeapPriority<Data> HeapPriority;
+    return seededWatershedsBlockwiseImpl(data, labels, neighborhood, options, 
+               block_shape, parallel_options, PriorityQueue<Node, Data, true>(),
+               BlockwiseWatershedCosts<HeapPriority>(HeapPriority()));
+}
+
 //@}
 
 } // namespace vigra
@@ -47,6 +47,7 @@
 #ifndef VIGRA_CODEC_HXX
 #define VIGRA_CODEC_HXX
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <vector>
@@ -200,6 +201,44 @@ namespace vigra
 
         virtual unsigned int getOffset() const = 0;
 
+        // restrict decoding to a region of interest (must be called before
+        // the first nextScanline()). Codecs that can skip the data outside the
+        // region (e.g. tiled TIFF) return true and afterwards report the
+        // region's size via getWidth() and getHeight(). All other codecs
+        // return false and keep delivering complete scanlines.
+        virtual bool setROI( const vigra::Diff2D & /*upperLeft*/, const vigra::Size2D & /*size*/ )
+        {
+            return false;
+        }
+
+        // optional bulk interface: decode all rows (of the image or the
+        // region set by setROI()) at once instead of calling nextScanline().
+        // Band b of pixel (x, y) is written to
+        //     dest[x*pixelStride + y*rowStride + b*bandStride],
+        // where 'dest' points to data of the decoder's pixel type and the
+        // strides are given in units of that type. Codecs that can't decode
+        // into the requested layout return false without consuming any data.
+        virtual bool decodeBlock( void * /*dest*/, std::ptrdiff_t /*pixelStride*/,
+                                  std::ptrdiff_t /*rowStride*/, std::ptrdiff_t /*bandStride*/ )
+        {
+            return false;
+        }
+
+        // optional zero-copy interface: codecs that store the pixels
+        // uncompressed report where they are located in the file, so that
+        // the file can be memory-mapped instead of decoded. Band b of pixel
+        // (x, y) is then found at byte position
+        //     offset + (x*pixelStride + y*rowStride + b*bandStride)*size,
+        // where 'size' is the size of the decoder's pixel type, and is stored
+        // in the given byte order ("big endian" or "little endian"). Codecs
+        // that can't describe their data in this way return false.
+        virtual bool getRawDataLayout( std::size_t & /*offset*/, std::ptrdiff_t & /*pixelStride*/,
+                                       std::ptrdiff_t & /*rowStride*/, std::ptrdiff_t & /*bandStride*/,
+                                       std::string & /*byteOrder*/ ) const
+        {
+            return false;
+        }
+
         virtual const void * currentScanlineOfBand( unsigned int ) const = 0;
         virtual void nextScanline() = 0;
 
@@ -250,6 +289,18 @@ namespace vigra
         {
         }
 
+        // request tiled output with the given tile size (only
+        // supported by TIFF, ignored by all other codecs)
+        virtual void setTileSize( const vigra::Size2D & /*size*/ )
+        {
+        }
+
+        // compress with up to the given number of threads (only
+        // supported by PNG and JPEG, ignored by all other codecs)
+        virtual void setNumThreads( int /*n*/ )
+        {
+        }
+
         typedef ArrayVector<unsigned char> ICCProfile;
 
         virtual void setICCProfile(const ICCProfile & /* data */)
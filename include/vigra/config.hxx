@@ -311,6 +311,23 @@
     #define VIGRA_SAFE_STATIC(p, v) v
 #endif
 
+    // define VIGRA_NO_STD_THREADING when std::thread is unavailable (see threading.hxx)
+#if !defined(VIGRA_SINGLE_THREADED) && !defined(VIGRA_NO_STD_THREADING)
+# if defined(__clang__)
+#  if (!__has_include(<thread>) || !__has_include(<mutex>) || !__has_include(<atomic>))
+#    define VIGRA_NO_STD_THREADING
+#  endif
+# else
+#  if defined(__GNUC__) && (!defined(_GLIBCXX_HAS_GTHREADS) || !defined(_GLIBCXX_USE_C99_STDINT_TR1) || !defined(_GLIBCXX_USE_SCHED_YIELD))
+#    define VIGRA_NO_STD_THREADING
+#  endif
+# endif
+
+# if defined(_MSC_VER) && _MSC_VER <= 1600
+#  define VIGRA_NO_STD_THREADING
+# endif
+#endif
+
 namespace vigra {
 
 #ifndef SPECIAL_STDEXCEPTION_DEFINITION_NEEDED
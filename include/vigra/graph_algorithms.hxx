@@ -44,6 +44,7 @@
 #include <algorithm>
 #include <vector>
 #include <functional>
+#include <cstring>
 
 
 /*vigra*/
@@ -56,6 +57,7 @@
 #include "graph_maps.hxx"
 #include "functorexpression.hxx"
 #include "array_vector.hxx"
+#include "parallel_foreach.hxx"
 
 namespace vigra{
 
@@ -82,6 +84,240 @@ namespace vigra{
             const GRAPH_MAP & map_;
             const COMPERATOR & comperator_;
         };
+
+        // order preserving mapping of floating point weights to unsigned integers
+        // (keys of descending sorts are inverted)
+        template<class T>
+        struct RadixSortKey;
+
+        template<>
+        struct RadixSortKey<float>{
+            typedef UInt32 type;
+            static type get(const float value,const bool descending){
+                type bits;
+                std::memcpy(&bits,&value,sizeof(bits));
+                bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+                return descending ? ~bits : bits;
+            }
+        };
+
+        template<>
+        struct RadixSortKey<double>{
+            typedef UInt64 type;
+            static type get(const double value,const bool descending){
+                type bits;
+                std::memcpy(&bits,&value,sizeof(bits));
+                const type sign = static_cast<type>(1) << 63;
+                bits = (bits & sign) ? ~bits : (bits | sign);
+                return descending ? ~bits : bits;
+            }
+        };
+
+        // edgeSort() uses a radix sort for float and double weights
+        // compared with std::less or std::greater
+        template<class T,class COMPERATOR>
+        struct RadixSortableWeights{
+            static const bool value = false;
+            static const bool descending = false;
+        };
+        template<class T,bool DESCENDING>
+        struct RadixSortableFloatWeights{
+            static const bool value = true;
+            static const bool descending = DESCENDING;
+        };
+        template<> struct RadixSortableWeights<float, std::less<float> >     : RadixSortableFloatWeights<float, false>{};
+        template<> struct RadixSortableWeights<float, std::greater<float> >  : RadixSortableFloatWeights<float, true>{};
+        template<> struct RadixSortableWeights<double,std::less<double> >    : RadixSortableFloatWeights<double,false>{};
+        template<> struct RadixSortableWeights<double,std::greater<double> > : RadixSortableFloatWeights<double,true>{};
+
+        // histogram of the current digit of the keys in each chunk
+        template<class KEY>
+        struct RadixHistogram{
+            RadixHistogram(const std::vector<KEY> & keys,std::vector<MultiArrayIndex> & counts,
+                           const MultiArrayIndex chunk,const unsigned int shift)
+            :   keys_(keys),
+                counts_(counts),
+                chunk_(chunk),
+                shift_(shift){
+            }
+            void operator()(const int,const MultiArrayIndex t)const{
+                MultiArrayIndex * c = &counts_[256*t];
+                const MultiArrayIndex end = std::min<MultiArrayIndex>(keys_.size(),(t+1)*chunk_);
+                for(MultiArrayIndex i=t*chunk_;i<end;++i)
+                    ++c[(keys_[i]>>shift_) & 0xff];
+            }
+            const std::vector<KEY> & keys_;
+            std::vector<MultiArrayIndex> & counts_;
+            const MultiArrayIndex chunk_;
+            const unsigned int shift_;
+        };
+
+        // move the keys and values of each chunk to their output positions
+        template<class KEY,class VALUE>
+        struct RadixScatter{
+            RadixScatter(const std::vector<KEY> & keys,const std::vector<VALUE> & values,
+                         std::vector<KEY> & keysOut,std::vector<VALUE> & valuesOut,
+                         std::vector<MultiArrayIndex> & positions,
+                         const MultiArrayIndex chunk,const unsigned int shift)
+            :   keys_(keys),
+                values_(values),
+                keysOut_(keysOut),
+                valuesOut_(valuesOut),
+                positions_(positions),
+                chunk_(chunk),
+                shift_(shift){
+            }
+            void operator()(const int,const MultiArrayIndex t)const{
+                MultiArrayIndex * pos = &positions_[256*t];
+                const MultiArrayIndex end = std::min<MultiArrayIndex>(keys_.size(),(t+1)*chunk_);
+                for(MultiArrayIndex i=t*chunk_;i<end;++i){
+                    const MultiArrayIndex p = pos[(keys_[i]>>shift_) & 0xff]++;
+                    keysOut_[p]=keys_[i];
+                    valuesOut_[p]=values_[i];
+                }
+            }
+            const std::vector<KEY> & keys_;
+            const std::vector<VALUE> & values_;
+            std::vector<KEY> & keysOut_;
+            std::vector<VALUE> & valuesOut_;
+            std::vector<MultiArrayIndex> & positions_;
+            const MultiArrayIndex chunk_;
+            const unsigned int shift_;
+        };
+
+        // stable parallel LSD radix sort of keys with payload, 8 bits per pass
+        template<class KEY,class VALUE>
+        void radixSortKeyValue(std::vector<KEY> & keys,std::vector<VALUE> & values,int nThreads){
+            const MultiArrayIndex size = keys.size();
+            nThreads = static_cast<int>(std::max<MultiArrayIndex>(1,std::min<MultiArrayIndex>(nThreads,size/65536)));
+            const MultiArrayIndex chunk = (size+nThreads-1)/nThreads;
+
+            std::vector<KEY>   keysTmp(size);
+            std::vector<VALUE> valuesTmp(size);
+            std::vector<MultiArrayIndex> counts(256*nThreads);
+
+            for(unsigned int shift=0;shift<8*sizeof(KEY);shift+=8){
+                // histogram of each chunk
+                std::fill(counts.begin(),counts.end(),0);
+                parallel_foreach(nThreads,nThreads,
+                    RadixHistogram<KEY>(keys,counts,chunk,shift));
+                // skip passes where all keys have the same digit
+                bool trivial=false;
+                for(int d=0;d<256 && !trivial;++d){
+                    MultiArrayIndex total=0;
+                    for(int t=0;t<nThreads;++t)
+                        total+=counts[256*t+d];
+                    trivial = total==size;
+                }
+                if(trivial)
+                    continue;
+                // turn the counts into output positions
+                MultiArrayIndex offset=0;
+                for(int d=0;d<256;++d){
+                    for(int t=0;t<nThreads;++t){
+                        const MultiArrayIndex c = counts[256*t+d];
+                        counts[256*t+d]=offset;
+                        offset+=c;
+                    }
+                }
+                // scatter
+                parallel_foreach(nThreads,nThreads,
+                    RadixScatter<KEY,VALUE>(keys,values,keysTmp,valuesTmp,counts,chunk,shift));
+                keys.swap(keysTmp);
+                values.swap(valuesTmp);
+            }
+        }
+
+        // compute the radix sort keys of the edge weights, chunk by chunk
+        template<class WEIGHTS,class EDGE,class KEY>
+        struct RadixEdgeKeys{
+            RadixEdgeKeys(const WEIGHTS & weights,const std::vector<EDGE> & edges,
+                          std::vector<typename KEY::type> & keys,std::vector<MultiArrayIndex> & order,
+                          const MultiArrayIndex chunk,const bool descending)
+            :   weights_(weights),
+                edges_(edges),
+                keys_(keys),
+                order_(order),
+                chunk_(chunk),
+                descending_(descending){
+            }
+            void operator()(const int,const MultiArrayIndex c)const{
+                const MultiArrayIndex end = std::min<MultiArrayIndex>(edges_.size(),(c+1)*chunk_);
+                for(MultiArrayIndex i=c*chunk_;i<end;++i){
+                    keys_[i]=KEY::get(weights_[edges_[i]],descending_);
+                    order_[i]=i;
+                }
+            }
+            const WEIGHTS & weights_;
+            const std::vector<EDGE> & edges_;
+            std::vector<typename KEY::type> & keys_;
+            std::vector<MultiArrayIndex> & order_;
+            const MultiArrayIndex chunk_;
+            const bool descending_;
+        };
+
+        // copy the edges in sorted order, chunk by chunk
+        template<class EDGE>
+        struct RadixEdgePermutation{
+            RadixEdgePermutation(const std::vector<EDGE> & edges,const std::vector<MultiArrayIndex> & order,
+                                 std::vector<EDGE> & sortedEdges,const MultiArrayIndex chunk)
+            :   edges_(edges),
+                order_(order),
+                sortedEdges_(sortedEdges),
+                chunk_(chunk){
+            }
+            void operator()(const int,const MultiArrayIndex c)const{
+                const MultiArrayIndex end = std::min<MultiArrayIndex>(edges_.size(),(c+1)*chunk_);
+                for(MultiArrayIndex i=c*chunk_;i<end;++i)
+                    sortedEdges_[i]=edges_[order_[i]];
+            }
+            const std::vector<EDGE> & edges_;
+            const std::vector<MultiArrayIndex> & order_;
+            std::vector<EDGE> & sortedEdges_;
+            const MultiArrayIndex chunk_;
+        };
+
+        template<class GRAPH,class WEIGHTS,class COMPERATOR>
+        void edgeSortImpl(
+            const GRAPH   & g,
+            const WEIGHTS & weights,
+            const COMPERATOR  & comperator,
+            std::vector<typename GRAPH::Edge> & sortedEdges,
+            const int nThreads,
+            VigraFalseType  // not radix sortable
+        ){
+            detail_graph_algorithms::GraphItemCompare<WEIGHTS,COMPERATOR> edgeComperator(weights,comperator);
+            std::sort(sortedEdges.begin(),sortedEdges.end(),edgeComperator);
+        }
+
+        template<class GRAPH,class WEIGHTS,class COMPERATOR>
+        void edgeSortImpl(
+            const GRAPH   & g,
+            const WEIGHTS & weights,
+            const COMPERATOR  & comperator,
+            std::vector<typename GRAPH::Edge> & sortedEdges,
+            const int nThreads,
+            VigraTrueType  // radix sortable
+        ){
+            typedef typename WEIGHTS::Value WeightType;
+            typedef RadixSortKey<WeightType> Key;
+            typedef typename GRAPH::Edge Edge;
+            const bool descending = RadixSortableWeights<WeightType,COMPERATOR>::descending;
+
+            const MultiArrayIndex size = sortedEdges.size();
+            const MultiArrayIndex chunk = 65536;
+            std::vector<typename Key::type> keys(size);
+            std::vector<MultiArrayIndex>    order(size);
+            parallel_foreach(nThreads,(size+chunk-1)/chunk,
+                RadixEdgeKeys<WEIGHTS,Edge,Key>(weights,sortedEdges,keys,order,chunk,descending));
+            radixSortKeyValue(keys,order,nThreads);
+            std::vector<typename Key::type>().swap(keys);
+
+            std::vector<Edge> edges(size);
+            parallel_foreach(nThreads,(size+chunk-1)/chunk,
+                RadixEdgePermutation<Edge>(sortedEdges,order,edges,chunk));
+            sortedEdges.swap(edges);
+        }
     } // namespace detail_graph_algorithms
 
     /// \brief get a vector of Edge descriptors
@@ -105,6 +341,33 @@ namespace vigra{
         std::sort(sortedEdges.begin(),sortedEdges.end(),edgeComperator);
     }
 
+    /// \brief get a vector of Edge descriptors (parallel version)
+    ///
+    /// Same as above, but float and double weights compared with
+    /// <tt>std::less</tt> or <tt>std::greater</tt> are sorted by a
+    /// parallel radix sort with the edge positions as payload.
+    /// The radix sort is stable, i.e. edges with equal weights
+    /// stay in <tt>EdgeIt</tt> order. Other weight types and
+    /// comparators fall back to <tt>std::sort</tt>.
+    template<class GRAPH,class WEIGHTS,class COMPERATOR>
+    void edgeSort(
+        const GRAPH   & g,
+        const WEIGHTS & weights,
+        const COMPERATOR  & comperator,
+        std::vector<typename GRAPH::Edge> & sortedEdges,
+        const ParallelOptions & options
+    ){
+        typedef detail_graph_algorithms::RadixSortableWeights<typename WEIGHTS::Value,COMPERATOR> Sortable;
+        sortedEdges.resize(g.edgeNum());
+        size_t c=0;
+        for(typename GRAPH::EdgeIt e(g);e!=lemon::INVALID;++e){
+            sortedEdges[c]=*e;
+            ++c;
+        }
+        detail_graph_algorithms::edgeSortImpl(g,weights,comperator,sortedEdges,
+            options.getActualNumThreads(),typename IfBool<Sortable::value,VigraTrueType,VigraFalseType>::type());
+    }
+
 
     /// \brief copy a lemon node map
     template<class G,class A,class B>
@@ -207,6 +470,466 @@ namespace vigra{
         }
     }
 
+    /// \brief compact storage of the affiliated edges of a region adjacency graph
+    ///
+    /// Instead of a <tt>std::vector</tt> of edge descriptors per RAG edge (e.g. 32 bytes per
+    /// grid edge of a 3D \ref GridGraph plus one heap allocation per RAG edge), the ids of the
+    /// affiliated edges of all RAG edges are stored consecutively in a single array in
+    /// compressed sparse row (CSR) layout: the affiliated edges of RAG edge \a e are
+    /// <tt>edgeIds()[offsets()[rag.id(e)]], ..., edgeIds()[offsets()[rag.id(e)+1]-1]</tt>.
+    /// They are stored in the same order as in the <tt>std::vector</tt> representation,
+    /// and the edge descriptors can be recovered by <tt>graph.edgeFromId(id)</tt>.
+    ///
+    /// \a INDEX_TYPE is the integer type of the edge ids. <tt>UInt32</tt> halves the memory
+    /// again, but requires <tt>graph.maxEdgeId() < 2^32</tt>.
+    template<class GRAPH,class INDEX_TYPE = UInt64>
+    class CompressedAffiliatedEdges{
+    public:
+        typedef GRAPH                      Graph;
+        typedef typename Graph::Edge       Edge;
+        typedef AdjacencyListGraph         RagGraph;
+        typedef typename RagGraph::Edge    RagEdge;
+        typedef INDEX_TYPE                 index_type;
+        typedef const index_type *         const_iterator;
+
+        /// \brief construct empty
+        CompressedAffiliatedEdges()
+        :   offsets_(1,0),
+            edgeIds_(){
+        }
+
+        /// \brief convert from the <tt>std::vector</tt> representation
+        template<class AFFILIATED_EDGES>
+        CompressedAffiliatedEdges(const Graph & graph,
+                                  const RagGraph & rag,
+                                  const AFFILIATED_EDGES & affiliatedEdges)
+        :   offsets_(rag.maxEdgeId()+2,0),
+            edgeIds_(){
+            vigra_precondition(fitsIndexType(graph),
+                "CompressedAffiliatedEdges(): INDEX_TYPE is too small for the edge ids of this graph.");
+            for(typename RagGraph::EdgeIt e(rag);e!=lemon::INVALID;++e)
+                offsets_[rag.id(*e)+1]=affiliatedEdges[*e].size();
+            for(size_t i=1;i<offsets_.size();++i)
+                offsets_[i]+=offsets_[i-1];
+            edgeIds_.resize(offsets_.back());
+            for(typename RagGraph::EdgeIt e(rag);e!=lemon::INVALID;++e){
+                index_type * ids = edgeIds_.begin()+offsets_[rag.id(*e)];
+                for(size_t i=0;i<affiliatedEdges[*e].size();++i)
+                    ids[i]=static_cast<index_type>(graph.id(affiliatedEdges[*e][i]));
+            }
+        }
+
+        /// \brief number of affiliated edges of a RAG edge
+        MultiArrayIndex size(const RagEdge & e)const{
+            const Int64 id = e.id();
+            return offsets_[id+1]-offsets_[id];
+        }
+
+        /// \brief first affiliated edge id of a RAG edge
+        const_iterator begin(const RagEdge & e)const{
+            return edgeIds_.begin()+offsets_[e.id()];
+        }
+
+        /// \brief end of the affiliated edge ids of a RAG edge
+        const_iterator end(const RagEdge & e)const{
+            return edgeIds_.begin()+offsets_[e.id()+1];
+        }
+
+        /// \brief total number of affiliated edges
+        MultiArrayIndex totalSize()const{
+            return edgeIds_.size();
+        }
+
+        /// \brief row offsets (size: <tt>rag.maxEdgeId()+2</tt>)
+        const ArrayVector<Int64> & offsets()const{
+            return offsets_;
+        }
+
+        /// \brief concatenated affiliated edge ids
+        const ArrayVector<index_type> & edgeIds()const{
+            return edgeIds_;
+        }
+
+        /// \brief check if all edge ids of \a graph can be represented by \a INDEX_TYPE
+        static bool fitsIndexType(const Graph & graph){
+            const Int64 maxId = graph.maxEdgeId();
+            return maxId<0 || static_cast<UInt64>(maxId)<=static_cast<UInt64>(NumericTraits<index_type>::max());
+        }
+
+        /// \brief allocated memory in bytes
+        size_t memoryUsage()const{
+            return offsets_.size()*sizeof(Int64)+edgeIds_.size()*sizeof(index_type);
+        }
+
+        // used by makeRegionAdjacencyGraph()
+        ArrayVector<Int64>      & offsets(){ return offsets_; }
+        ArrayVector<index_type> & edgeIds(){ return edgeIds_; }
+
+    private:
+        ArrayVector<Int64>      offsets_;
+        ArrayVector<index_type> edgeIds_;
+    };
+
+    /// \brief make a region adjacency graph with compressed affiliated edges
+    ///
+    /// Same as the version with <tt>std::vector</tt> affiliated edges, but stores the
+    /// affiliated edges as \ref CompressedAffiliatedEdges.
+    template<
+        class GRAPH_IN,
+        class GRAPH_IN_NODE_LABEL_MAP,
+        class INDEX_TYPE
+    >
+    void makeRegionAdjacencyGraph(
+        GRAPH_IN                   graphIn,
+        GRAPH_IN_NODE_LABEL_MAP    labels,
+        AdjacencyListGraph & rag,
+        CompressedAffiliatedEdges<GRAPH_IN,INDEX_TYPE> & affiliatedEdges,
+        const Int64   ignoreLabel=-1
+    ){
+        typename AdjacencyListGraph:: template EdgeMap< std::vector<typename GRAPH_IN::Edge> > tmp;
+        makeRegionAdjacencyGraph(graphIn,labels,rag,tmp,ignoreLabel);
+        affiliatedEdges = CompressedAffiliatedEdges<GRAPH_IN,INDEX_TYPE>(graphIn,rag,tmp);
+    }
+
+    namespace detail_graph_algorithms{
+
+        // a grid graph edge between two different regions
+        template<class LABEL,class EDGE>
+        struct RagEdgeRecord{
+            typedef EDGE EdgeType;
+
+            LABEL low() const{
+                return std::min(lu,lv);
+            }
+            LABEL high() const{
+                return std::max(lu,lv);
+            }
+            bool operator<(const RagEdgeRecord & other)const{
+                return low()<other.low() || (low()==other.low() && high()<other.high());
+            }
+
+            LABEL lu,lv;
+            MultiArrayIndex order; // position in EdgeIt order
+            EDGE edge;             // edge descriptor or edge id
+        };
+
+        // consecutive RagEdgeRecords which belong to the same RAG edge
+        struct RagEdgeGroup{
+            bool operator<(const RagEdgeGroup & other)const{
+                return order<other.order;
+            }
+            MultiArrayIndex order,begin,end;
+        };
+
+        template<class GRAPH,class EDGE>
+        inline EDGE ragRecordEdge(const GRAPH &,const typename GRAPH::Edge & edge,VigraTrueType){
+            return edge;
+        }
+
+        template<class GRAPH,class EDGE>
+        inline EDGE ragRecordEdge(const GRAPH & graph,const typename GRAPH::Edge & edge,VigraFalseType){
+            return static_cast<EDGE>(graph.id(edge));
+        }
+
+        // scan one slab of the grid graph (a range along the last axis)
+        template<unsigned int N,class LABEL_MAP,class RECORD>
+        struct RagSlabScanner{
+            typedef GridGraph<N, boost_graph::undirected_tag> Graph;
+            typedef typename Graph::shape_type Shape;
+            typedef typename Graph::Edge Edge;
+            typedef typename Graph::IncBackEdgeIt IncBackEdgeIt;
+            typedef typename RECORD::EdgeType RecordEdge;
+
+            RagSlabScanner(const Graph & graph,const LABEL_MAP & labels,const Int64 ignoreLabel,
+                           const MultiArrayIndex slabCount,
+                           std::vector<std::vector<RECORD> > & slabRecords,
+                           std::vector<std::vector<bool> > & threadLabels)
+            :   graph_(graph),
+                labels_(labels),
+                ignoreLabel_(ignoreLabel),
+                slabCount_(slabCount),
+                slabRecords_(slabRecords),
+                threadLabels_(threadLabels){
+            }
+
+            bool ignored(const Int64 l)const{
+                return ignoreLabel_!=-1 && l==ignoreLabel_;
+            }
+
+            void operator()(const int threadId,const MultiArrayIndex slab)const{
+                const Shape & shape = graph_.shape();
+                Shape start,stop(shape);
+                start[N-1] = (slab*shape[N-1])/slabCount_;
+                stop[N-1]  = ((slab+1)*shape[N-1])/slabCount_;
+
+                std::vector<RECORD> & records = slabRecords_[slab];
+                std::vector<bool>   & present = threadLabels_[threadId];
+                MultiCoordinateIterator<N> iter(stop-start),end(iter.getEndIterator());
+                for(;iter!=end;++iter){
+                    const Shape node = start+*iter;
+                    const Int64 l = static_cast<Int64>(labels_[node]);
+                    if(!ignored(l)){
+                        if(present.size()<=static_cast<size_t>(l))
+                            present.resize(l+1,false);
+                        present[l]=true;
+                    }
+                    for(IncBackEdgeIt e(graph_,node);e.isValid();++e){
+                        const Edge edge(*e);
+                        RECORD record;
+                        record.lu = labels_[graph_.u(edge)];
+                        record.lv = labels_[graph_.v(edge)];
+                        if(record.lu!=record.lv &&
+                           !ignored(static_cast<Int64>(record.lu)) &&
+                           !ignored(static_cast<Int64>(record.lv))){
+                            record.order = records.size();
+                            record.edge  = ragRecordEdge<Graph,RecordEdge>(graph_,edge,
+                                               typename IsSameType<RecordEdge,Edge>::type());
+                            records.push_back(record);
+                        }
+                    }
+                }
+                // keeps EdgeIt order within each RAG edge
+                std::stable_sort(records.begin(),records.end());
+            }
+
+            const Graph & graph_;
+            const LABEL_MAP & labels_;
+            const Int64 ignoreLabel_;
+            const MultiArrayIndex slabCount_;
+            std::vector<std::vector<RECORD> > & slabRecords_;
+            std::vector<std::vector<bool> > & threadLabels_;
+        };
+
+        // merge pairs of adjacent sorted runs [runs[2k], runs[2k+1]) and [runs[2k+1], runs[2k+2])
+        template<class RECORD>
+        struct RagRunMerger{
+            RagRunMerger(std::vector<RECORD> & records,const std::vector<MultiArrayIndex> & runs)
+            :   records_(records),
+                runs_(runs){
+            }
+            void operator()(const int,const MultiArrayIndex k)const{
+                if(2*k+2<static_cast<MultiArrayIndex>(runs_.size()))
+                    std::inplace_merge(records_.begin()+runs_[2*k],
+                                       records_.begin()+runs_[2*k+1],
+                                       records_.begin()+runs_[2*k+2]);
+            }
+            std::vector<RECORD> & records_;
+            const std::vector<MultiArrayIndex> & runs_;
+        };
+
+        // copy the affiliated edges of each RAG edge (RAG edge ids are assigned in group order)
+        template<class RECORD,class AFFILIATED_EDGES>
+        struct RagAffiliatedEdgeWriter{
+            RagAffiliatedEdgeWriter(const std::vector<RECORD> & records,
+                                    const std::vector<RagEdgeGroup> & groups,
+                                    AFFILIATED_EDGES & affiliatedEdges)
+            :   records_(records),
+                groups_(groups),
+                affiliatedEdges_(affiliatedEdges){
+            }
+            void operator()(const int,const MultiArrayIndex k)const{
+                typename AFFILIATED_EDGES::Reference edges = affiliatedEdges_[AdjacencyListGraph::Edge(k)];
+                edges.reserve(groups_[k].end-groups_[k].begin);
+                for(MultiArrayIndex i=groups_[k].begin;i<groups_[k].end;++i)
+                    edges.push_back(records_[i].edge);
+            }
+            const std::vector<RECORD> & records_;
+            const std::vector<RagEdgeGroup> & groups_;
+            AFFILIATED_EDGES & affiliatedEdges_;
+        };
+
+        template<class RECORD,class INDEX_TYPE>
+        struct RagCompressedEdgeWriter{
+            RagCompressedEdgeWriter(const std::vector<RECORD> & records,
+                                    const std::vector<RagEdgeGroup> & groups,
+                                    const ArrayVector<Int64> & offsets,
+                                    ArrayVector<INDEX_TYPE> & edgeIds)
+            :   records_(records),
+                groups_(groups),
+                offsets_(offsets),
+                edgeIds_(edgeIds){
+            }
+            void operator()(const int,const MultiArrayIndex k)const{
+                INDEX_TYPE * ids = edgeIds_.begin()+offsets_[k];
+                for(MultiArrayIndex i=groups_[k].begin;i<groups_[k].end;++i,++ids)
+                    *ids = records_[i].edge;
+            }
+            const std::vector<RECORD> & records_;
+            const std::vector<RagEdgeGroup> & groups_;
+            const ArrayVector<Int64> & offsets_;
+            ArrayVector<INDEX_TYPE> & edgeIds_;
+        };
+
+        // Build the RAG of a labeled GridGraph. On return, records contains the grid edges
+        // between different regions, and groups[k] is the range of records belonging to
+        // the RAG edge with id k (in EdgeIt order).
+        template<unsigned int N,class GRAPH_IN_NODE_LABEL_MAP,class RECORD>
+        void gridGraphRag(
+            const GridGraph<N, boost_graph::undirected_tag> & graphIn,
+            const GRAPH_IN_NODE_LABEL_MAP & labels,
+            AdjacencyListGraph & rag,
+            const Int64 ignoreLabel,
+            const int nThreads,
+            std::vector<RECORD> & records,
+            std::vector<RagEdgeGroup> & groups
+        ){
+            const MultiArrayIndex slabCount = nThreads==1
+                ? 1
+                : std::min<MultiArrayIndex>(graphIn.shape()[N-1], 4*nThreads);
+
+            // collect the label pairs of all grid edges between different regions
+            std::vector<std::vector<RECORD> > slabRecords(slabCount);
+            std::vector<std::vector<bool> >   threadLabels(nThreads);
+            parallel_foreach(nThreads, slabCount,
+                RagSlabScanner<N,GRAPH_IN_NODE_LABEL_MAP,RECORD>(
+                    graphIn,labels,ignoreLabel,slabCount,slabRecords,threadLabels));
+
+            // concatenate the slabs in scan order and merge the sorted runs
+            std::vector<MultiArrayIndex> runs(1,0);
+            for(MultiArrayIndex s=0;s<slabCount;++s)
+                runs.push_back(runs.back()+slabRecords[s].size());
+            records.clear();
+            records.reserve(runs.back());
+            for(MultiArrayIndex s=0;s<slabCount;++s){
+                for(size_t i=0;i<slabRecords[s].size();++i){
+                    records.push_back(slabRecords[s][i]);
+                    records.back().order+=runs[s];
+                }
+                std::vector<RECORD>().swap(slabRecords[s]);
+            }
+            while(runs.size()>2){
+                parallel_foreach(nThreads, (runs.size()-1)/2,
+                    RagRunMerger<RECORD>(records,runs));
+                std::vector<MultiArrayIndex> merged;
+                for(size_t k=0;k<runs.size();k+=2)
+                    merged.push_back(runs[k]);
+                if(merged.back()!=runs.back())
+                    merged.push_back(runs.back());
+                runs.swap(merged);
+            }
+
+            // deduplicate: each group of equal label pairs becomes one RAG edge,
+            // numbered in the order of its first grid edge
+            groups.clear();
+            for(size_t i=0;i<records.size();){
+                RagEdgeGroup group;
+                group.begin=i;
+                group.order=records[i].order;
+                for(++i;i<records.size() && !(records[group.begin]<records[i]);++i){}
+                group.end=i;
+                groups.push_back(group);
+            }
+            std::sort(groups.begin(),groups.end());
+
+            // merge the labels seen by the threads
+            std::vector<bool> present;
+            for(int t=0;t<nThreads;++t){
+                if(present.size()<threadLabels[t].size())
+                    present.resize(threadLabels[t].size(),false);
+                for(size_t l=0;l<threadLabels[t].size();++l)
+                    if(threadLabels[t][l])
+                        present[l]=true;
+            }
+
+            size_t nodeCount=0;
+            for(size_t l=0;l<present.size();++l)
+                nodeCount+=present[l];
+            rag=AdjacencyListGraph(nodeCount,groups.size());
+            for(size_t l=0;l<present.size();++l)
+                if(present[l])
+                    rag.addNode(l);
+            for(size_t k=0;k<groups.size();++k){
+                const RECORD & first = records[groups[k].begin];
+                rag.addEdge(rag.nodeFromId(first.lu),rag.nodeFromId(first.lv));
+            }
+        }
+
+    } // namespace detail_graph_algorithms
+
+    /// \brief make a region adjacency graph from a GridGraph and labels w.r.t. that graph
+    ///
+    /// Specialization for undirected \ref GridGraph "GridGraphs", which produces the same
+    /// result (including node and edge ids and the order of the affiliated edges) as the
+    /// generic version above, but in a single pass over the grid graph: The grid is split
+    /// into slabs along the last axis, and each slab collects the pairs of adjacent labels
+    /// in parallel. The pairs are then sorted and deduplicated, and the region adjacency graph
+    /// and its affiliated edges are built without searching the adjacency sets of the RAG.
+    ///
+    /// \param graphIn  : input grid graph
+    /// \param labels   : labels w.r.t. graphIn (e.g. <tt>GridGraph<N>::NodeMap<UInt32></tt>)
+    /// \param[out] rag  : region adjacency graph
+    /// \param[out] affiliatedEdges : a vector of edges of graphIn for each edge in rag
+    /// \param      ignoreLabel : optional label to ignore (default: -1 means no label will be ignored)
+    /// \param      options : number of threads (default: as many as there are cores)
+    ///
+    template<
+        unsigned int N,
+        class GRAPH_IN_NODE_LABEL_MAP
+    >
+    void makeRegionAdjacencyGraph(
+        const GridGraph<N, boost_graph::undirected_tag> & graphIn,
+        const GRAPH_IN_NODE_LABEL_MAP & labels,
+        AdjacencyListGraph & rag,
+        typename AdjacencyListGraph:: template EdgeMap< std::vector<typename GridGraph<N, boost_graph::undirected_tag>::Edge> > & affiliatedEdges,
+        const Int64   ignoreLabel=-1,
+        const ParallelOptions & options = ParallelOptions()
+    ){
+        typedef typename GridGraph<N, boost_graph::undirected_tag>::Edge EdgeGraphIn;
+        typedef typename GraphMapTypeTraits<GRAPH_IN_NODE_LABEL_MAP>::Value LabelType;
+        typedef detail_graph_algorithms::RagEdgeRecord<LabelType,EdgeGraphIn> Record;
+        typedef typename AdjacencyListGraph:: template EdgeMap< std::vector<EdgeGraphIn> > AffiliatedEdges;
+
+        const int nThreads = options.getActualNumThreads();
+        std::vector<Record> records;
+        std::vector<detail_graph_algorithms::RagEdgeGroup> groups;
+        detail_graph_algorithms::gridGraphRag(graphIn,labels,rag,ignoreLabel,nThreads,records,groups);
+
+        affiliatedEdges.assign(rag);
+        parallel_foreach(nThreads, groups.size(),
+            detail_graph_algorithms::RagAffiliatedEdgeWriter<Record,AffiliatedEdges>(
+                records,groups,affiliatedEdges));
+    }
+
+    /// \brief make a region adjacency graph with compressed affiliated edges from a GridGraph
+    ///
+    /// Same as above, but stores the affiliated edges as \ref CompressedAffiliatedEdges.
+    /// The grid edges are only kept as ids during construction, so that the peak memory
+    /// is much smaller than with the <tt>std::vector</tt> representation.
+    template<
+        unsigned int N,
+        class GRAPH_IN_NODE_LABEL_MAP,
+        class INDEX_TYPE
+    >
+    void makeRegionAdjacencyGraph(
+        const GridGraph<N, boost_graph::undirected_tag> & graphIn,
+        const GRAPH_IN_NODE_LABEL_MAP & labels,
+        AdjacencyListGraph & rag,
+        CompressedAffiliatedEdges<GridGraph<N, boost_graph::undirected_tag>,INDEX_TYPE> & affiliatedEdges,
+        const Int64   ignoreLabel=-1,
+        const ParallelOptions & options = ParallelOptions()
+    ){
+        typedef typename GraphMapTypeTraits<GRAPH_IN_NODE_LABEL_MAP>::Value LabelType;
+        typedef detail_graph_algorithms::RagEdgeRecord<LabelType,INDEX_TYPE> Record;
+
+        vigra_precondition(affiliatedEdges.fitsIndexType(graphIn),
+            "makeRegionAdjacencyGraph(): INDEX_TYPE is too small for the edge ids of this graph.");
+
+        const int nThreads = options.getActualNumThreads();
+        std::vector<Record> records;
+        std::vector<detail_graph_algorithms::RagEdgeGroup> groups;
+        detail_graph_algorithms::gridGraphRag(graphIn,labels,rag,ignoreLabel,nThreads,records,groups);
+
+        ArrayVector<Int64> & offsets = affiliatedEdges.offsets();
+        offsets.resize(groups.size()+1);
+        offsets[0]=0;
+        for(size_t k=0;k<groups.size();++k)
+            offsets[k+1]=offsets[k]+(groups[k].end-groups[k].begin);
+        affiliatedEdges.edgeIds().resize(offsets.back());
+        parallel_foreach(nThreads, groups.size(),
+            detail_graph_algorithms::RagCompressedEdgeWriter<Record,INDEX_TYPE>(
+                records,groups,offsets,affiliatedEdges.edgeIds()));
+    }
+
     /// \brief shortest path computer
     template<class GRAPH,class WEIGHT_TYPE>
     class ShortestPathDijkstra{
@@ -229,7 +952,8 @@ namespace vigra{
         :   graph_(g),
             pq_(g.maxNodeId()+1),
             predMap_(g),
-            distMap_(g)
+            distMap_(g),
+            sparseReset_(false)
         {
         }
 
@@ -245,6 +969,10 @@ namespace vigra{
         /// or \a maxDistance is exceeded), it is set to <tt>lemon::INVALID</tt>. In contrast, if \a target
         /// was <tt>lemon::INVALID</tt> at the beginning, it will always be set to the last node 
         /// visited in the search.
+        ///
+        /// Only the first run resets the entire graph. Subsequent runs (except after a run
+        /// in a region of interest) only reset the nodes visited in the previous run,
+        /// like <tt>reRun()</tt>.
         template<class WEIGHTS>
         void run(const WEIGHTS & weights, const Node & source,
                  const Node & target = lemon::INVALID, 
@@ -403,11 +1131,25 @@ namespace vigra{
                                                   // was unreachable within maxDistance, target_ remains INVALID.
         }
 
-        void initializeMaps(Node const & source){
-            for(NodeIt n(graph_); n!=lemon::INVALID; ++n){
-                const Node node(*n);
-                predMap_[node]=lemon::INVALID;
+        // after a run without ROI, only the nodes in discoveryOrder_
+        // have a valid predecessor
+        void resetPredecessors(){
+            if(sparseReset_){
+                for(unsigned int n=0; n<discoveryOrder_.size(); ++n){
+                    predMap_[discoveryOrder_[n]]=lemon::INVALID;
+                }
+            }
+            else{
+                for(NodeIt n(graph_); n!=lemon::INVALID; ++n){
+                    const Node node(*n);
+                    predMap_[node]=lemon::INVALID;
+                }
+                sparseReset_=true;
             }
+        }
+
+        void initializeMaps(Node const & source){
+            resetPredecessors();
             distMap_[source]=static_cast<WeightType>(0.0);
             predMap_[source]=source;
             discoveryOrder_.clear();
@@ -424,6 +1166,7 @@ namespace vigra{
             
             initMultiArrayBorder(predMap_.subarray(start-left_border, stop+right_border),
                                  left_border, right_border, DONT_TOUCH);
+            sparseReset_=false;
             predMap_.subarray(start, stop) = lemon::INVALID;
             predMap_[source]=source;
             
@@ -435,10 +1178,7 @@ namespace vigra{
 
         template <class ITER>
         void initializeMapsMultiSource(ITER source, ITER source_end){
-            for(NodeIt n(graph_); n!=lemon::INVALID; ++n){
-                const Node node(*n);
-                predMap_[node]=lemon::INVALID;
-            }
+            resetPredecessors();
             discoveryOrder_.clear();
             for( ; source != source_end; ++source)
             {
@@ -465,11 +1205,452 @@ namespace vigra{
         PredecessorsMap predMap_;
         DistanceMap     distMap_;
         DiscoveryOrder  discoveryOrder_;
+        bool            sparseReset_;
 
         Node source_;
         Node target_;
     };
 
+    /// \brief bidirectional shortest path computer for point-to-point queries
+    ///
+    /// Searches from source and target simultaneously (always expanding the side
+    /// whose queue has the smaller top distance) and stops as soon as the sum of the
+    /// top distances exceeds the length of the best path found so far. For a single
+    /// source/target pair, this visits roughly half as many nodes as \ref ShortestPathDijkstra
+    /// on grid graphs. The maps are allocated once per instance, and each run only
+    /// resets the nodes touched in the previous run, so that repeated queries
+    /// (e.g. interactive tracing) do not pay for the size of the graph.
+    ///
+    /// The graph must be undirected (edge weights are used for both directions).
+    template<class GRAPH,class WEIGHT_TYPE>
+    class BidirectionalShortestPathDijkstra{
+    public:
+        typedef GRAPH Graph;
+
+        typedef typename Graph::Node Node;
+        typedef typename Graph::NodeIt NodeIt;
+        typedef typename Graph::Edge Edge;
+        typedef typename Graph::OutArcIt OutArcIt;
+
+        typedef WEIGHT_TYPE WeightType;
+        typedef ChangeablePriorityQueue<WeightType>           PqType;
+        typedef typename Graph:: template NodeMap<Node>       PredecessorsMap;
+        typedef typename Graph:: template NodeMap<WeightType> DistanceMap;
+        typedef ArrayVector<Node>                             Path;
+
+        /// \brief constructor from graph
+        BidirectionalShortestPathDijkstra(const Graph & g)
+        :   graph_(g),
+            forwardPq_(g.maxNodeId()+1),
+            backwardPq_(g.maxNodeId()+1),
+            forwardPred_(g),
+            backwardPred_(g),
+            forwardDist_(g),
+            backwardDist_(g),
+            distance_(NumericTraits<WeightType>::max())
+        {
+            for(NodeIt n(graph_); n!=lemon::INVALID; ++n){
+                forwardPred_[*n]=lemon::INVALID;
+                backwardPred_[*n]=lemon::INVALID;
+            }
+        }
+
+        /// \brief find the shortest path from \a source to \a target
+        ///
+        /// \param weights : edge weights encoding the distance between adjacent nodes (must be non-negative)
+        /// \param source  : start of the path
+        /// \param target  : end of the path
+        /// \param maxDistance  : path search is terminated when the path length exceeds <tt>maxDistance</tt>
+        ///
+        /// Returns the length of the path, or <tt>NumericTraits<WeightType>::max()</tt> if
+        /// \a target cannot be reached within \a maxDistance (<tt>path()</tt> is empty then).
+        template<class WEIGHTS>
+        WeightType run(const WEIGHTS & weights, const Node & source, const Node & target,
+                       WeightType maxDistance=NumericTraits<WeightType>::max())
+        {
+            reset();
+            source_=source;
+            target_=target;
+            if(source==target){
+                path_.push_back(source);
+                distance_=static_cast<WeightType>(0.0);
+                return distance_;
+            }
+            start(forwardPq_,forwardPred_,forwardDist_,source);
+            start(backwardPq_,backwardPred_,backwardDist_,target);
+
+            Node meetForward(lemon::INVALID),meetBackward(lemon::INVALID);
+            WeightType best = NumericTraits<WeightType>::max();
+            while(!forwardPq_.empty() && !backwardPq_.empty()){
+                const WeightType forwardTop  = forwardPq_.topPriority();
+                const WeightType backwardTop = backwardPq_.topPriority();
+                if(forwardTop+backwardTop>=best || forwardTop+backwardTop>maxDistance)
+                    break;
+                if(forwardTop<=backwardTop)
+                    expand(weights,forwardPq_,forwardPred_,forwardDist_,backwardPred_,backwardDist_,
+                           best,meetForward,meetBackward);
+                else
+                    expand(weights,backwardPq_,backwardPred_,backwardDist_,forwardPred_,forwardDist_,
+                           best,meetBackward,meetForward);
+            }
+            forwardPq_.clear();
+            backwardPq_.clear();
+
+            if(meetForward!=lemon::INVALID && best<=maxDistance){
+                for(Node node=meetForward;node!=source;node=forwardPred_[node])
+                    path_.push_back(node);
+                path_.push_back(source);
+                std::reverse(path_.begin(),path_.end());
+                for(Node node=meetBackward;node!=target;node=backwardPred_[node])
+                    path_.push_back(node);
+                path_.push_back(target);
+                distance_=best;
+            }
+            return distance_;
+        }
+
+        /// \brief get the graph
+        const Graph & graph()const{
+            return graph_;
+        }
+        /// \brief get the source node of the last run
+        const Node & source()const{
+            return source_;
+        }
+        /// \brief get the target node of the last run
+        const Node & target()const{
+            return target_;
+        }
+        /// \brief get the nodes of the shortest path from source to target (after a call of run)
+        const Path & path()const{
+            return path_;
+        }
+        /// \brief get the length of the shortest path (after a call of run)
+        WeightType distance()const{
+            return distance_;
+        }
+        /// \brief get the number of nodes touched in the last run
+        size_t touchedNodeCount()const{
+            return touched_.size();
+        }
+
+    private:
+        void reset(){
+            for(size_t k=0;k<touched_.size();++k){
+                forwardPred_[touched_[k]]=lemon::INVALID;
+                backwardPred_[touched_[k]]=lemon::INVALID;
+            }
+            touched_.clear();
+            path_.clear();
+            distance_=NumericTraits<WeightType>::max();
+        }
+
+        void start(PqType & pq,PredecessorsMap & pred,DistanceMap & dist,const Node & node){
+            dist[node]=static_cast<WeightType>(0.0);
+            pred[node]=node;
+            pq.push(graph_.id(node),static_cast<WeightType>(0.0));
+            touched_.push_back(node);
+        }
+
+        // settle the top node of one side and check for paths to the other side
+        template<class WEIGHTS>
+        void expand(const WEIGHTS & weights,
+                    PqType & pq,PredecessorsMap & pred,DistanceMap & dist,
+                    const PredecessorsMap & otherPred,const DistanceMap & otherDist,
+                    WeightType & best,Node & meet,Node & otherMeet)
+        {
+            const Node topNode(graph_.nodeFromId(pq.top()));
+            pq.pop();
+            for(OutArcIt outArcIt(graph_,topNode);outArcIt!=lemon::INVALID;++outArcIt){
+                const Node otherNode = graph_.target(*outArcIt);
+                const size_t otherNodeId = graph_.id(otherNode);
+                const WeightType alternativeDist = dist[topNode]+weights[Edge(*outArcIt)];
+                if(pq.contains(otherNodeId)){
+                    if(alternativeDist<dist[otherNode]){
+                        pq.push(otherNodeId,alternativeDist);
+                        dist[otherNode]=alternativeDist;
+                        pred[otherNode]=topNode;
+                    }
+                }
+                else if(pred[otherNode]==lemon::INVALID){
+                    if(otherPred[otherNode]==lemon::INVALID)
+                        touched_.push_back(otherNode);
+                    pq.push(otherNodeId,alternativeDist);
+                    dist[otherNode]=alternativeDist;
+                    pred[otherNode]=topNode;
+                }
+                if(otherPred[otherNode]!=lemon::INVALID &&
+                   alternativeDist+otherDist[otherNode]<best){
+                    best=alternativeDist+otherDist[otherNode];
+                    meet=topNode;
+                    otherMeet=otherNode;
+                }
+            }
+        }
+
+        const Graph  & graph_;
+        PqType          forwardPq_, backwardPq_;
+        PredecessorsMap forwardPred_, backwardPred_;
+        DistanceMap     forwardDist_, backwardDist_;
+        ArrayVector<Node> touched_;
+        Path            path_;
+        WeightType      distance_;
+        Node source_;
+        Node target_;
+    };
+
+    namespace detail_graph_algorithms{
+
+        template<class WEIGHT_TYPE>
+        struct DeltaSteppingRequest{
+            Int64       node, pred;
+            WEIGHT_TYPE dist;
+        };
+
+        // collect the relaxation requests of one chunk of nodes,
+        // partitioned by owner = target node id % nThreads
+        template<class GRAPH,class WEIGHTS,class WEIGHT_TYPE>
+        struct DeltaSteppingRequestCollector{
+            typedef typename GRAPH::Node     Node;
+            typedef typename GRAPH::Edge     Edge;
+            typedef typename GRAPH::OutArcIt OutArcIt;
+            typedef DeltaSteppingRequest<WEIGHT_TYPE> Request;
+
+            DeltaSteppingRequestCollector(const GRAPH & graph,const WEIGHTS & weights,
+                                          const WEIGHT_TYPE delta,const bool light,
+                                          const std::vector<WEIGHT_TYPE> & dist,
+                                          const std::vector<Int64> & nodes,
+                                          const MultiArrayIndex chunkSize,
+                                          std::vector<std::vector<std::vector<Request> > > & requests)
+            :   graph_(graph),
+                weights_(weights),
+                delta_(delta),
+                light_(light),
+                dist_(dist),
+                nodes_(nodes),
+                chunkSize_(chunkSize),
+                requests_(requests){
+            }
+            void operator()(const int,const MultiArrayIndex c)const{
+                const Int64 nThreads = requests_[c].size();
+                const MultiArrayIndex end = std::min<MultiArrayIndex>(nodes_.size(),(c+1)*chunkSize_);
+                for(MultiArrayIndex i=c*chunkSize_;i<end;++i){
+                    const Int64 u = nodes_[i];
+                    const Node node = graph_.nodeFromId(u);
+                    for(OutArcIt a(graph_,node);a!=lemon::INVALID;++a){
+                        const WEIGHT_TYPE w = weights_[Edge(*a)];
+                        if((w<=delta_)!=light_)
+                            continue;
+                        const Int64 v = graph_.id(graph_.target(*a));
+                        Request request;
+                        request.node=v;
+                        request.pred=u;
+                        request.dist=dist_[u]+w;
+                        if(request.dist<dist_[v])
+                            requests_[c][v%nThreads].push_back(request);
+                    }
+                }
+            }
+            const GRAPH & graph_;
+            const WEIGHTS & weights_;
+            const WEIGHT_TYPE delta_;
+            const bool light_;
+            const std::vector<WEIGHT_TYPE> & dist_;
+            const std::vector<Int64> & nodes_;
+            const MultiArrayIndex chunkSize_;
+            std::vector<std::vector<std::vector<Request> > > & requests_;
+        };
+
+        // apply the requests for the nodes of one owner, so that
+        // every node is only updated by a single thread
+        template<class WEIGHT_TYPE>
+        struct DeltaSteppingRequestApplier{
+            typedef DeltaSteppingRequest<WEIGHT_TYPE> Request;
+
+            DeltaSteppingRequestApplier(std::vector<std::vector<std::vector<Request> > > & requests,
+                                        const MultiArrayIndex chunkCount,
+                                        std::vector<WEIGHT_TYPE> & dist,
+                                        std::vector<Int64> & pred,
+                                        std::vector<std::vector<Int64> > & updated)
+            :   requests_(requests),
+                chunkCount_(chunkCount),
+                dist_(dist),
+                pred_(pred),
+                updated_(updated){
+            }
+            void operator()(const int,const MultiArrayIndex owner)const{
+                updated_[owner].clear();
+                for(MultiArrayIndex c=0;c<chunkCount_;++c){
+                    std::vector<Request> & r = requests_[c][owner];
+                    for(size_t k=0;k<r.size();++k){
+                        if(r[k].dist<dist_[r[k].node]){
+                            dist_[r[k].node]=r[k].dist;
+                            pred_[r[k].node]=r[k].pred;
+                            updated_[owner].push_back(r[k].node);
+                        }
+                    }
+                    r.clear();
+                }
+            }
+            std::vector<std::vector<std::vector<Request> > > & requests_;
+            const MultiArrayIndex chunkCount_;
+            std::vector<WEIGHT_TYPE> & dist_;
+            std::vector<Int64> & pred_;
+            std::vector<std::vector<Int64> > & updated_;
+        };
+
+        // state of shortestPathDeltaStepping(), indexed by node id
+        template<class GRAPH,class WEIGHTS,class WEIGHT_TYPE>
+        class DeltaStepping{
+          public:
+            typedef DeltaSteppingRequest<WEIGHT_TYPE> Request;
+
+            DeltaStepping(const GRAPH & graph,const WEIGHTS & weights,
+                          const WEIGHT_TYPE delta,const int nThreads)
+            :   graph_(graph),
+                weights_(weights),
+                delta_(delta),
+                nThreads_(nThreads),
+                dist_(graph.maxNodeId()+1,NumericTraits<WEIGHT_TYPE>::max()),
+                pred_(graph.maxNodeId()+1,-1),
+                updated_(nThreads){
+            }
+
+            void addSource(const Int64 id){
+                dist_[id]=static_cast<WEIGHT_TYPE>(0.0);
+                pred_[id]=id;
+                addToBucket(id);
+            }
+
+            void run(){
+                std::vector<char>  inFrontier(dist_.size(),0),inSettled(dist_.size(),0);
+                std::vector<Int64> frontier,settled;
+                for(size_t b=0;b<buckets_.size();++b){
+                    settled.clear();
+                    while(!buckets_[b].empty()){
+                        // nodes whose distance is still in this bucket, without duplicates
+                        frontier.clear();
+                        for(size_t k=0;k<buckets_[b].size();++k){
+                            const Int64 node = buckets_[b][k];
+                            if(!inFrontier[node] && bucketOf(dist_[node])==b){
+                                inFrontier[node]=1;
+                                frontier.push_back(node);
+                                if(!inSettled[node]){
+                                    inSettled[node]=1;
+                                    settled.push_back(node);
+                                }
+                            }
+                        }
+                        std::vector<Int64>().swap(buckets_[b]);
+                        for(size_t k=0;k<frontier.size();++k)
+                            inFrontier[frontier[k]]=0;
+                        relax(frontier,true);
+                    }
+                    relax(settled,false);
+                    for(size_t k=0;k<settled.size();++k)
+                        inSettled[settled[k]]=0;
+                }
+            }
+
+            const std::vector<WEIGHT_TYPE> & distances()const{
+                return dist_;
+            }
+
+            const std::vector<Int64> & predecessors()const{
+                return pred_;
+            }
+
+          private:
+            size_t bucketOf(const WEIGHT_TYPE d)const{
+                return static_cast<size_t>(d/delta_);
+            }
+
+            void addToBucket(const Int64 node){
+                const size_t b = bucketOf(dist_[node]);
+                if(buckets_.size()<=b)
+                    buckets_.resize(b+1);
+                buckets_[b].push_back(node);
+            }
+
+            // relax the light or heavy edges of the given nodes
+            void relax(const std::vector<Int64> & nodes,const bool light){
+                const MultiArrayIndex chunkSize = 1024;
+                const MultiArrayIndex chunkCount = (nodes.size()+chunkSize-1)/chunkSize;
+                if(requests_.size()<static_cast<size_t>(chunkCount))
+                    requests_.resize(chunkCount,std::vector<std::vector<Request> >(nThreads_));
+                parallel_foreach(nThreads_,chunkCount,
+                    DeltaSteppingRequestCollector<GRAPH,WEIGHTS,WEIGHT_TYPE>(
+                        graph_,weights_,delta_,light,dist_,nodes,chunkSize,requests_));
+                parallel_foreach(nThreads_,nThreads_,
+                    DeltaSteppingRequestApplier<WEIGHT_TYPE>(requests_,chunkCount,dist_,pred_,updated_));
+                for(int owner=0;owner<nThreads_;++owner)
+                    for(size_t k=0;k<updated_[owner].size();++k)
+                        addToBucket(updated_[owner][k]);
+            }
+
+            const GRAPH & graph_;
+            const WEIGHTS & weights_;
+            const WEIGHT_TYPE delta_;
+            const int nThreads_;
+            std::vector<WEIGHT_TYPE> dist_;
+            std::vector<Int64> pred_;
+            std::vector<std::vector<Int64> > buckets_;
+            // requests_[chunk][owner], owner = target node id % nThreads
+            std::vector<std::vector<std::vector<Request> > > requests_;
+            std::vector<std::vector<Int64> > updated_;
+        };
+
+    } // namespace detail_graph_algorithms
+
+    /// \brief parallel multi-source shortest path distances by delta-stepping
+    ///
+    /// Computes the distance of every node to the nearest of the given sources and
+    /// the corresponding predecessors (sources are their own predecessors,
+    /// unreachable nodes get distance <tt>NumericTraits<WeightType>::max()</tt> and
+    /// predecessor <tt>lemon::INVALID</tt>). Nodes are grouped into buckets of width
+    /// \a delta by tentative distance. The nodes of the current bucket are relaxed
+    /// in parallel, first along light edges (weight <= \a delta) until the bucket
+    /// is stable, then along heavy edges. Relaxation requests are partitioned by
+    /// target node, so that every node is only updated by a single thread.
+    ///
+    /// \a delta trades parallelism against redundant work: a good choice is
+    /// about the average edge weight. The number of buckets is the maximum
+    /// distance divided by \a delta. The distances are identical to
+    /// \ref ShortestPathDijkstra::runMultiSource(); predecessors may differ
+    /// between paths of equal length.
+    template<class GRAPH,class WEIGHTS,class ITER,class DISTANCE_MAP,class PREDECESSOR_MAP>
+    void shortestPathDeltaStepping(
+        const GRAPH          &  graph,
+        const WEIGHTS        &  weights,
+        ITER                    sourceBegin,
+        ITER                    sourceEnd,
+        const typename DISTANCE_MAP::Value delta,
+        DISTANCE_MAP         &  distances,
+        PREDECESSOR_MAP      &  predecessors,
+        const ParallelOptions & options = ParallelOptions()
+    ){
+        typedef typename GRAPH::Node     Node;
+        typedef typename GRAPH::NodeIt   NodeIt;
+        typedef typename DISTANCE_MAP::Value WeightType;
+
+        vigra_precondition(delta>0,
+            "shortestPathDeltaStepping(): delta must be positive.");
+
+        detail_graph_algorithms::DeltaStepping<GRAPH,WEIGHTS,WeightType>
+            deltaStepping(graph,weights,delta,options.getActualNumThreads());
+        for(;sourceBegin!=sourceEnd;++sourceBegin)
+            deltaStepping.addSource(graph.id(*sourceBegin));
+        deltaStepping.run();
+
+        const std::vector<WeightType> & dist = deltaStepping.distances();
+        const std::vector<Int64>      & pred = deltaStepping.predecessors();
+        for(NodeIt n(graph);n!=lemon::INVALID;++n){
+            const Int64 id = graph.id(*n);
+            distances[*n]=dist[id];
+            predecessors[*n]= pred[id]<0 ? Node(lemon::INVALID) : graph.nodeFromId(pred[id]);
+        }
+    }
+
     /// \brief get the length in node units of a path
     template<class NODE,class PREDECESSORS>
     size_t pathLength(
@@ -753,6 +1934,12 @@ namespace vigra{
     /// \param k : free parameter of felzenszwalb algorithm
     /// \param[out] nodeLabeling :  nodeLabeling (not necessarily dense)
     /// \param nodeNumStopCond      : optional stopping condition
+    /// \param options              : number of threads used to sort the edges.
+    ///                               Float and double weights are sorted by the stable
+    ///                               radix sort of edgeSort(), so edges with equal weight
+    ///                               are processed in <tt>EdgeIt</tt> order regardless of
+    ///                               the number of threads. This tie order may differ from
+    ///                               the one of <tt>std::sort</tt>, which earlier versions used.
     template< class GRAPH , class EDGE_WEIGHTS, class NODE_SIZE,class NODE_LABEL_MAP>
     void felzenszwalbSegmentation(
         const GRAPH &         graph,
@@ -760,7 +1947,8 @@ namespace vigra{
         const NODE_SIZE    &  nodeSizes,
         float           k,
         NODE_LABEL_MAP     &  nodeLabeling,
-        const int             nodeNumStopCond = -1
+        const int             nodeNumStopCond = -1,
+        const ParallelOptions & options = ParallelOptions()
     ){
         typedef GRAPH Graph;
         typedef typename Graph::Edge Edge;
@@ -784,7 +1972,7 @@ namespace vigra{
         // sort the edges by their weights
         std::vector<Edge> sortedEdges;
         std::less<WeightType> comperator;
-        edgeSort(graph,edgeWeights,comperator,sortedEdges);
+        edgeSort(graph,edgeWeights,comperator,sortedEdges,options);
 
         // make the ufd
         UnionFindArray<UInt64> ufdArray(graph.maxNodeId()+1);
@@ -847,6 +2035,226 @@ namespace vigra{
 
 
 
+    namespace detail_graph_algorithms{
+
+        template<class WEIGHT,class INDEX>
+        struct FelzenszwalbEdge{
+            bool operator<(const FelzenszwalbEdge & other)const{
+                return w<other.w;
+            }
+            WEIGHT w;
+            INDEX  u,v;
+        };
+
+        // Felzenszwalb merges along edges sorted by weight
+        template<class EDGE_ITER,class INDEX,class WEIGHT,class SIZE>
+        void felzenszwalbMergeEdges(
+            EDGE_ITER edge,
+            const EDGE_ITER end,
+            UnionFindArray<INDEX> & ufd,
+            WEIGHT * internalDiff,
+            SIZE   * nodeSize,
+            const WEIGHT k
+        ){
+            for(;edge!=end;++edge){
+                const INDEX ru = ufd.findIndex(edge->u);
+                const INDEX rv = ufd.findIndex(edge->v);
+                if(ru==rv)
+                    continue;
+                const WEIGHT w          = edge->w;
+                const SIZE   sizeRu     = nodeSize[ru];
+                const SIZE   sizeRv     = nodeSize[rv];
+                const WEIGHT tauRu      = k/static_cast<WEIGHT>(sizeRu);
+                const WEIGHT tauRv      = k/static_cast<WEIGHT>(sizeRv);
+                const WEIGHT minIntDiff = std::min(internalDiff[ru]+tauRu,internalDiff[rv]+tauRv);
+                if(w<=minIntDiff){
+                    const INDEX r = ufd.makeUnion(ru,rv);
+                    internalDiff[r] = w;
+                    nodeSize[r]     = sizeRu+sizeRv;
+                }
+            }
+        }
+
+        // segment block b of a GridGraph on its own and record its border edges
+        template<unsigned int N,class EDGE_WEIGHTS,class NODE_SIZE>
+        struct FelzenszwalbBlockSegmenter{
+            typedef GridGraph<N, boost_graph::undirected_tag> Graph;
+            typedef typename Graph::shape_type    Shape;
+            typedef typename Graph::Edge          Edge;
+            typedef typename Graph::Node          Node;
+            typedef typename Graph::IncBackEdgeIt IncBackEdgeIt;
+            typedef typename EDGE_WEIGHTS::Value  WeightType;
+            typedef typename EDGE_WEIGHTS::Value  NodeSizeType;
+            typedef FelzenszwalbEdge<WeightType,UInt64> FEdge;
+
+            FelzenszwalbBlockSegmenter(const Graph & graph,
+                                       const EDGE_WEIGHTS & edgeWeights,
+                                       const NODE_SIZE & nodeSizes,
+                                       const WeightType k,
+                                       const Shape & blocks,
+                                       const Shape & blockShape,
+                                       std::vector<WeightType> & internalDiff,
+                                       std::vector<NodeSizeType> & nodeSize,
+                                       std::vector<UInt64> & blockRoot,
+                                       std::vector<std::vector<FEdge> > & borderEdges)
+            :   graph_(graph),
+                edgeWeights_(edgeWeights),
+                nodeSizes_(nodeSizes),
+                k_(k),
+                shape_(graph.shape()),
+                blocks_(blocks),
+                blockShape_(blockShape),
+                internalDiff_(internalDiff),
+                nodeSize_(nodeSize),
+                blockRoot_(blockRoot),
+                borderEdges_(borderEdges){
+            }
+
+            void operator()(const int,const MultiArrayIndex b)const{
+                Shape blockBegin;
+                detail::ScanOrderToCoordinate<N>::exec(b,blocks_,blockBegin);
+                blockBegin*=blockShape_;
+                const Shape blockEnd = min(blockBegin+blockShape_,shape_);
+                const Shape localShape = blockEnd-blockBegin;
+                const Shape localStrides = detail::defaultStride<N>(localShape);
+
+                std::vector<FEdge> edges;
+                std::vector<WeightType>   diff(prod(localShape),static_cast<WeightType>(0.0));
+                std::vector<NodeSizeType> size(prod(localShape));
+                MultiCoordinateIterator<N> iter(localShape),iterEnd(iter.getEndIterator());
+                for(;iter!=iterEnd;++iter){
+                    const Node node = blockBegin+*iter;
+                    size[iter.scanOrderIndex()] = nodeSizes_[node];
+                    for(IncBackEdgeIt e(graph_,node);e.isValid();++e){
+                        const Edge edge(*e);
+                        const Node other = graph_.oppositeNode(node,edge);
+                        FEdge fEdge;
+                        fEdge.w = edgeWeights_[edge];
+                        if(allLessEqual(blockBegin,other) && allLess(other,blockEnd)){
+                            fEdge.u = iter.scanOrderIndex();
+                            fEdge.v = dot(other-blockBegin,localStrides);
+                            edges.push_back(fEdge);
+                        }
+                        else{
+                            fEdge.u = graph_.id(node);
+                            fEdge.v = graph_.id(other);
+                            borderEdges_[b].push_back(fEdge);
+                        }
+                    }
+                }
+                std::stable_sort(edges.begin(),edges.end());
+                UnionFindArray<UInt64> ufd(size.size());
+                felzenszwalbMergeEdges(edges.begin(),edges.end(),ufd,&diff[0],&size[0],k_);
+
+                // the root of each region is its node with the smallest scan order index,
+                // both within the block and in the whole graph
+                for(iter=MultiCoordinateIterator<N>(localShape);iter!=iterEnd;++iter){
+                    const MultiArrayIndex local = iter.scanOrderIndex();
+                    const MultiArrayIndex root  = ufd.findIndex(local);
+                    Shape rootCoord;
+                    detail::ScanOrderToCoordinate<N>::exec(root,localShape,rootCoord);
+                    const MultiArrayIndex globalId = graph_.id(Node(blockBegin+*iter));
+                    blockRoot_[globalId] = graph_.id(Node(blockBegin+rootCoord));
+                    if(root==local){
+                        internalDiff_[globalId] = diff[local];
+                        nodeSize_[globalId]     = size[local];
+                    }
+                }
+            }
+
+            const Graph & graph_;
+            const EDGE_WEIGHTS & edgeWeights_;
+            const NODE_SIZE & nodeSizes_;
+            const WeightType k_;
+            const Shape shape_;
+            const Shape blocks_;
+            const Shape blockShape_;
+            std::vector<WeightType> & internalDiff_;
+            std::vector<NodeSizeType> & nodeSize_;
+            std::vector<UInt64> & blockRoot_;
+            std::vector<std::vector<FEdge> > & borderEdges_;
+        };
+
+    } // namespace detail_graph_algorithms
+
+    /// \brief blockwise felzenszwalb segmentation of a GridGraph
+    ///
+    /// The grid is split into blocks of shape \a blockShape, which are segmented
+    /// independently and in parallel using only the edges inside each block.
+    /// Afterwards, the edges between blocks are sorted and the block segments are
+    /// merged with the same criterion. Since the edges are not processed in a single
+    /// global order, the result may differ from \ref felzenszwalbSegmentation near
+    /// block borders, but memory for sorting is only needed per block and for the
+    /// border edges.
+    ///
+    /// \param graph: input grid graph
+    /// \param edgeWeights : edge weights / edge indicator
+    /// \param nodeSizes : size of each node
+    /// \param k : free parameter of felzenszwalb algorithm
+    /// \param[out] nodeLabeling :  nodeLabeling (not necessarily dense)
+    /// \param blockShape : shape of the blocks
+    /// \param options : number of threads
+    template<unsigned int N, class EDGE_WEIGHTS, class NODE_SIZE, class NODE_LABEL_MAP>
+    void felzenszwalbSegmentationBlockwise(
+        const GridGraph<N, boost_graph::undirected_tag> & graph,
+        const EDGE_WEIGHTS &  edgeWeights,
+        const NODE_SIZE    &  nodeSizes,
+        float           k,
+        NODE_LABEL_MAP     &  nodeLabeling,
+        const typename MultiArrayShape<N>::type & blockShape,
+        const ParallelOptions & options = ParallelOptions()
+    ){
+        typedef GridGraph<N, boost_graph::undirected_tag> Graph;
+        typedef typename Graph::shape_type    Shape;
+        typedef typename Graph::Node          Node;
+        typedef typename EDGE_WEIGHTS::Value  WeightType;
+        typedef typename EDGE_WEIGHTS::Value  NodeSizeType;
+        typedef detail_graph_algorithms::FelzenszwalbEdge<WeightType,UInt64> FEdge;
+
+        vigra_precondition(allGreater(blockShape,Shape(0)),
+            "felzenszwalbSegmentationBlockwise(): blockShape must be positive.");
+
+        const Shape & shape = graph.shape();
+        const Shape blocks = (shape+blockShape-Shape(1))/blockShape;
+        const MultiArrayIndex blockCount = prod(blocks);
+        const MultiArrayIndex nodeCount  = graph.nodeNum();
+        const WeightType kk = static_cast<WeightType>(k);
+
+        std::vector<WeightType>   internalDiff(nodeCount,static_cast<WeightType>(0.0));
+        std::vector<NodeSizeType> nodeSize(nodeCount);
+        std::vector<UInt64>       blockRoot(nodeCount);
+        std::vector<std::vector<FEdge> > borderEdges(blockCount);
+
+        // segment the blocks
+        parallel_foreach(options.getActualNumThreads(),blockCount,
+            detail_graph_algorithms::FelzenszwalbBlockSegmenter<N,EDGE_WEIGHTS,NODE_SIZE>(
+                graph,edgeWeights,nodeSizes,kk,blocks,blockShape,
+                internalDiff,nodeSize,blockRoot,borderEdges));
+
+        UnionFindArray<UInt64> ufd(nodeCount);
+        for(MultiArrayIndex i=0;i<nodeCount;++i)
+            if(blockRoot[i]!=static_cast<UInt64>(i))
+                ufd.makeUnion(blockRoot[i],i);
+        std::vector<UInt64>().swap(blockRoot);
+
+        // merge the block segments along the border edges
+        std::vector<FEdge> edges;
+        for(MultiArrayIndex b=0;b<blockCount;++b){
+            edges.insert(edges.end(),borderEdges[b].begin(),borderEdges[b].end());
+            std::vector<FEdge>().swap(borderEdges[b]);
+        }
+        std::stable_sort(edges.begin(),edges.end());
+        detail_graph_algorithms::felzenszwalbMergeEdges(edges.begin(),edges.end(),ufd,
+                                                         &internalDiff[0],&nodeSize[0],kk);
+
+        ufd.makeContiguous();
+        for(typename Graph::NodeIt n(graph);n!=lemon::INVALID;++n){
+            const Node node(*n);
+            nodeLabeling[node]=ufd.findLabel(graph.id(node));
+        }
+    }
+
+
     namespace detail_graph_smoothing{
 
     template<
@@ -1156,6 +2564,208 @@ namespace vigra{
         }
     }
 
+    namespace detail_graph_algorithms{
+        // default functor of the implicit node weights edge map
+        struct MeanOfNodeWeights{
+            template<class T>
+            typename NumericTraits<T>::RealPromote
+            operator()(const T & a, const T & b)const{
+                return 0.5*(a+b);
+            }
+        };
+
+        template<unsigned int N, class DirectedTag>
+        void edgeLengths(const GridGraph<N, DirectedTag> & g, ArrayVector<double> & lengths){
+            lengths.resize(g.maxDegree());
+            for(unsigned int k=0; k<lengths.size(); ++k)
+                lengths[k] = norm(g.neighborOffset(k));
+        }
+    }
+
+    /// \brief implicit edge map computing the edge weights from node weights on access
+    ///
+    /// This is the lazy equivalent of \ref edgeWeightsFromNodeWeights(): instead of
+    /// an explicit <tt>GridGraph::EdgeMap</tt> with <tt>maxDegree()/2</tt> entries per
+    /// node, only a view to the node weights is kept, and <tt>operator[]</tt> applies
+    /// the functor to the weights of the edge's end nodes. It can be passed as edge weights
+    /// to all graph algorithms that only read the weights (e.g. \ref ShortestPathDijkstra,
+    /// \ref felzenszwalbSegmentation(), \ref edgeWeightedWatershedsSegmentation()).
+    /// The node weights must stay alive as long as the map is used.
+    /// The value type defaults to <tt>NumericTraits<T>::RealPromote</tt>, so that
+    /// the mean of integer node weights is not truncated.
+    ///
+    /// Use \ref implicitEdgeWeightsFromNodeWeights() to create the map.
+    template<unsigned int N, class DirectedTag, class T,
+             class FUNCTOR = detail_graph_algorithms::MeanOfNodeWeights,
+             class VALUE = typename NumericTraits<T>::RealPromote>
+    class ImplicitNodeWeightsEdgeMap
+    {
+    public:
+        typedef GridGraph<N, DirectedTag>           Graph;
+        typedef typename Graph::Edge                Key;
+        typedef VALUE                               Value;
+        typedef VALUE                               ConstReference;
+        typedef MultiArrayView<N, T, StridedArrayTag> NodeWeights;
+
+        typedef Key             key_type;
+        typedef Value           value_type;
+        typedef ConstReference  const_reference;
+
+        typedef boost::readable_property_map_tag category;
+
+        /// \brief constructor
+        ///
+        /// \param g : the graph
+        /// \param nodeWeights : node weights (shape must be <tt>g.shape()</tt>)
+        /// \param euclidean : if 'true', multiply the weights with the Euclidean
+        ///                    distance between the edge's end nodes
+        /// \param func : binary function that computes the edge weight from the
+        ///               weights of the edge's end nodes
+        ImplicitNodeWeightsEdgeMap(const Graph & g, const NodeWeights & nodeWeights,
+                                   bool euclidean = false, FUNCTOR const & func = FUNCTOR())
+        :   graph_(g),
+            nodeWeights_(nodeWeights),
+            euclidean_(euclidean),
+            func_(func)
+        {
+            vigra_precondition(nodeWeights.shape() == g.shape(),
+                 "ImplicitNodeWeightsEdgeMap(): shape mismatch between graph and nodeWeights.");
+            if(euclidean_)
+                detail_graph_algorithms::edgeLengths(g, lengths_);
+        }
+
+        ConstReference operator[](const Key & edge)const{
+            const typename Graph::Node u(graph_.u(edge));
+            const typename Graph::Node v(graph_.v(edge));
+            if(euclidean_)
+                return static_cast<Value>(lengths_[edge[N]] * func_(nodeWeights_[u], nodeWeights_[v]));
+            return static_cast<Value>(func_(nodeWeights_[u], nodeWeights_[v]));
+        }
+
+        const Graph & graph()const{
+            return graph_;
+        }
+
+    private:
+        const Graph &       graph_;
+        NodeWeights         nodeWeights_;
+        bool                euclidean_;
+        FUNCTOR             func_;
+        ArrayVector<double> lengths_;
+    };
+
+    /// \brief implicit edge map reading the edge weights from an interpolated image on access
+    ///
+    /// This is the lazy equivalent of \ref edgeWeightsFromInterpolatedImage(): the weight
+    /// of an edge is read from <tt>interpolatedImage[u+v]</tt> when the edge is accessed.
+    /// The interpolated image must stay alive as long as the map is used.
+    ///
+    /// Use \ref implicitEdgeWeightsFromInterpolatedImage() to create the map.
+    template<unsigned int N, class DirectedTag, class T, class VALUE = T>
+    class ImplicitInterpolatedEdgeMap
+    {
+    public:
+        typedef GridGraph<N, DirectedTag>           Graph;
+        typedef typename Graph::Edge                Key;
+        typedef VALUE                               Value;
+        typedef VALUE                               ConstReference;
+        typedef MultiArrayView<N, T, StridedArrayTag> InterpolatedImage;
+
+        typedef Key             key_type;
+        typedef Value           value_type;
+        typedef ConstReference  const_reference;
+
+        typedef boost::readable_property_map_tag category;
+
+        /// \brief constructor
+        ///
+        /// \param g : the graph
+        /// \param interpolatedImage : interpolated image (shape must be <tt>2*g.shape()-1</tt>)
+        /// \param euclidean : if 'true', multiply the weights with the Euclidean
+        ///                    distance between the edge's end nodes
+        ImplicitInterpolatedEdgeMap(const Graph & g, const InterpolatedImage & interpolatedImage,
+                                    bool euclidean = false)
+        :   graph_(g),
+            interpolatedImage_(interpolatedImage),
+            euclidean_(euclidean)
+        {
+            typedef typename MultiArrayShape<N>::type CoordType;
+            vigra_precondition(interpolatedImage.shape() == 2*g.shape()-CoordType(1),
+                 "ImplicitInterpolatedEdgeMap(): interpolated shape must be shape*2-1");
+            if(euclidean_)
+                detail_graph_algorithms::edgeLengths(g, lengths_);
+        }
+
+        ConstReference operator[](const Key & edge)const{
+            const typename Graph::Node u(graph_.u(edge));
+            const typename Graph::Node v(graph_.v(edge));
+            if(euclidean_)
+                return static_cast<Value>(lengths_[edge[N]] * interpolatedImage_[u+v]);
+            return static_cast<Value>(interpolatedImage_[u+v]);
+        }
+
+        const Graph & graph()const{
+            return graph_;
+        }
+
+    private:
+        const Graph &       graph_;
+        InterpolatedImage   interpolatedImage_;
+        bool                euclidean_;
+        ArrayVector<double> lengths_;
+    };
+
+    /// \brief create an implicit edge map which computes edge weights from node weights on access
+    ///
+    /// \param g : input graph
+    /// \param nodeWeights : node weights
+    /// \param euclidean : if 'true', multiply the weights with the Euclidean
+    ///                    distance between the edge's end nodes (default: 'false')
+    /// \param func : binary function that computes the edge weight from the 
+    ///               weights of the edge's end nodes (default: take the average)
+    ///
+    /// The values are identical to those computed by \ref edgeWeightsFromNodeWeights(),
+    /// but no memory is needed for the edge weights. See \ref ImplicitNodeWeightsEdgeMap.
+    template<unsigned int N, class DirectedTag, class T, class S, class FUNCTOR>
+    inline ImplicitNodeWeightsEdgeMap<N, DirectedTag, T, FUNCTOR>
+    implicitEdgeWeightsFromNodeWeights(
+            const GridGraph<N, DirectedTag> & g,
+            const MultiArrayView<N, T, S> & nodeWeights,
+            bool euclidean,
+            FUNCTOR const & func)
+    {
+        return ImplicitNodeWeightsEdgeMap<N, DirectedTag, T, FUNCTOR>(g, nodeWeights, euclidean, func);
+    }
+
+    template<unsigned int N, class DirectedTag, class T, class S>
+    inline ImplicitNodeWeightsEdgeMap<N, DirectedTag, T>
+    implicitEdgeWeightsFromNodeWeights(
+            const GridGraph<N, DirectedTag> & g,
+            const MultiArrayView<N, T, S> & nodeWeights,
+            bool euclidean = false)
+    {
+        return ImplicitNodeWeightsEdgeMap<N, DirectedTag, T>(g, nodeWeights, euclidean);
+    }
+
+    /// \brief create an implicit edge map which reads edge weights from an interpolated image on access
+    ///
+    /// \param g : input graph
+    /// \param interpolatedImage : interpolated image
+    /// \param euclidean : if 'true', multiply the weights with the Euclidean
+    ///                    distance between the edge's end nodes (default: 'false')
+    ///
+    /// The values are identical to those computed by \ref edgeWeightsFromInterpolatedImage(),
+    /// but no memory is needed for the edge weights. See \ref ImplicitInterpolatedEdgeMap.
+    template<unsigned int N, class DirectedTag, class T, class S>
+    inline ImplicitInterpolatedEdgeMap<N, DirectedTag, T>
+    implicitEdgeWeightsFromInterpolatedImage(
+            const GridGraph<N, DirectedTag> & g,
+            const MultiArrayView<N, T, S> & interpolatedImage,
+            bool euclidean = false)
+    {
+        return ImplicitInterpolatedEdgeMap<N, DirectedTag, T>(g, interpolatedImage, euclidean);
+    }
+
 //@}
 
 } // namespace vigra
@@ -290,6 +290,12 @@ namespace vigra{
         public:
             typedef T Value;
 
+            Adjacency()
+            :   nodeId_(-1),
+                edgeId_(-1){
+
+            }
+
             Adjacency(const Value nodeId, const Value edgeId)
             :   nodeId_(nodeId),
                 edgeId_(edgeId){
@@ -316,6 +322,170 @@ namespace vigra{
         };
 
 
+        // sorted flat set which stores up to INLINE_SIZE
+        // elements inside the object itself and only
+        // allocates when a node has more neighbors.
+        // The node storage of the graphs is kept in a
+        // contiguous std::vector, so small adjacencies
+        // need neither allocations nor pointer chasing.
+        // T must be default constructible and cheap
+        // to copy (elements are moved by assignment).
+        // => implementation detail
+        template<class T,unsigned int INLINE_SIZE>
+        class SmallSortedSet{
+        public:
+            typedef T           value_type;
+            typedef T           key_type;
+            typedef T *         iterator;
+            typedef const T *   const_iterator;
+            typedef std::size_t size_type;
+
+            SmallSortedSet()
+            :   data_(inline_),
+                size_(0),
+                capacity_(INLINE_SIZE){
+            }
+
+            SmallSortedSet(const SmallSortedSet & other)
+            :   data_(inline_),
+                size_(0),
+                capacity_(INLINE_SIZE){
+                reserve(other.size_);
+                std::copy(other.begin(),other.end(),data_);
+                size_=other.size_;
+            }
+
+            ~SmallSortedSet(){
+                deallocate();
+            }
+
+            SmallSortedSet & operator=(const SmallSortedSet & other){
+                if(this!=&other){
+                    size_=0;
+                    reserve(other.size_);
+                    std::copy(other.begin(),other.end(),data_);
+                    size_=other.size_;
+                }
+                return *this;
+            }
+
+            const_iterator begin()const{ return data_; }
+            const_iterator end()const{ return data_+size_; }
+            iterator begin(){ return data_; }
+            iterator end(){ return data_+size_; }
+
+            size_type size()const{ return size_; }
+            bool empty()const{ return size_==0; }
+            size_type capacity()const{ return capacity_; }
+            bool isInline()const{ return data_==inline_; }
+
+            const_iterator lower_bound(const key_type & key)const{
+                return std::lower_bound(begin(),end(),key);
+            }
+            iterator lower_bound(const key_type & key){
+                return std::lower_bound(begin(),end(),key);
+            }
+
+            const_iterator find(const key_type & key)const{
+                const_iterator iter=lower_bound(key);
+                return (iter==end() || key<*iter) ? end() : iter;
+            }
+            iterator find(const key_type & key){
+                iterator iter=lower_bound(key);
+                return (iter==end() || key<*iter) ? end() : iter;
+            }
+
+            std::pair<iterator,bool> insert(const value_type & value){
+                size_type pos=lower_bound(value)-begin();
+                if(pos<size_ && !(value<data_[pos]))
+                    return std::pair<iterator,bool>(data_+pos,false);
+                if(size_==capacity_)
+                    reserve(2*capacity_);
+                std::copy_backward(data_+pos,data_+size_,data_+size_+1);
+                data_[pos]=value;
+                ++size_;
+                return std::pair<iterator,bool>(data_+pos,true);
+            }
+
+            template<class ITER>
+            void insert(ITER iter,const ITER end){
+                for(;iter!=end;++iter)
+                    insert(*iter);
+            }
+
+            size_type erase(const key_type & key){
+                iterator iter=find(key);
+                if(iter==end())
+                    return 0;
+                std::copy(iter+1,end(),iter);
+                --size_;
+                return 1;
+            }
+
+            // remove the element with key oldKey (if any) and insert value, or
+            // overwrite the element with the key of value if it already exists.
+            // Equivalent to erase(oldKey); erase(value); insert(value), but the
+            // elements in between are only shifted once.
+            void replace(const key_type & oldKey,const value_type & value){
+                iterator oldIter=find(oldKey);
+                if(oldIter==end()){
+                    iterator iter=find(value);
+                    if(iter!=end())
+                        *iter=value;
+                    else
+                        insert(value);
+                    return;
+                }
+                if(!(oldKey<value) && !(value<oldKey)){
+                    *oldIter=value;
+                    return;
+                }
+                iterator iter=lower_bound(value);
+                if(iter!=end() && !(value<*iter)){
+                    *iter=value;
+                    std::copy(oldIter+1,end(),oldIter);
+                    --size_;
+                }
+                else if(oldIter<iter){
+                    std::copy(oldIter+1,iter,oldIter);
+                    *(iter-1)=value;
+                }
+                else{
+                    std::copy_backward(iter,oldIter,oldIter+1);
+                    *iter=value;
+                }
+            }
+
+            // removes all elements and releases the allocated memory
+            void clear(){
+                deallocate();
+                data_=inline_;
+                size_=0;
+                capacity_=INLINE_SIZE;
+            }
+
+            void reserve(const size_type capacity){
+                if(capacity<=capacity_)
+                    return;
+                T * data = new T[capacity];
+                std::copy(begin(),end(),data);
+                deallocate();
+                data_=data;
+                capacity_=static_cast<UInt32>(capacity);
+            }
+
+        private:
+            void deallocate(){
+                if(!isInline())
+                    delete [] data_;
+            }
+
+            T *    data_;
+            UInt32 size_;
+            UInt32 capacity_;
+            T      inline_[INLINE_SIZE];
+        };
+
         // an element in the implementation
         // of adjacency list
         // End users will not notice this class
@@ -328,7 +498,8 @@ namespace vigra{
                 typedef Adjacency<index_type>    AdjacencyElement;
                 typedef std::set<AdjacencyElement >        StdSetType;
                 typedef RandomAccessSet<AdjacencyElement > RandAccessSet;
-                typedef typename IfBool<USE_STL_SET,StdSetType,RandAccessSet>::type SetType;
+                typedef SmallSortedSet<AdjacencyElement,6> FlatSetType;
+                typedef typename IfBool<USE_STL_SET,StdSetType,FlatSetType>::type SetType;
 
                 typedef typename SetType::const_iterator AdjIt;
             public:
@@ -389,8 +560,26 @@ namespace vigra{
                     adjacency_.erase(AdjacencyElement(nodeId,0));
                 }
 
+                // replace the neighbor oldNodeId by newNodeId,
+                // or update the edge to newNodeId if it already exists
+                void replaceInAdjacency(const index_type oldNodeId,const index_type newNodeId,const index_type edgeId){
+                    replaceInAdjacency(adjacency_,oldNodeId,newNodeId,edgeId);
+                }
+
                 SetType adjacency_;
                 index_type id_;
+
+            private:
+                static void replaceInAdjacency(StdSetType & adjacency,const index_type oldNodeId,
+                                               const index_type newNodeId,const index_type edgeId){
+                    adjacency.erase(AdjacencyElement(oldNodeId,0));
+                    adjacency.erase(AdjacencyElement(newNodeId,0));
+                    adjacency.insert(AdjacencyElement(newNodeId,edgeId));
+                }
+                static void replaceInAdjacency(FlatSetType & adjacency,const index_type oldNodeId,
+                                               const index_type newNodeId,const index_type edgeId){
+                    adjacency.replace(AdjacencyElement(oldNodeId,0),AdjacencyElement(newNodeId,edgeId));
+                }
         };
 
         template<class INDEX_TYPE>
@@ -0,0 +1,365 @@
+/************************************************************************/
+/*                                                                      */
+/*   Copyright 2014 by Ullrich Koethe  and Thorsten Beier               */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_GRAPH_RAG_FEATURES_HXX
+#define VIGRA_GRAPH_RAG_FEATURES_HXX
+
+/*std*/
+#include <vector>
+#include <algorithm>
+
+/*vigra*/
+#include "multi_gridgraph.hxx"
+#include "adjacency_list_graph.hxx"
+#include "accumulator.hxx"
+#include "array_vector.hxx"
+#include "parallel_foreach.hxx"
+
+namespace vigra{
+
+namespace detail_rag_features{
+
+    // placeholder for the data and accumulators of the
+    // RAG items (edges or nodes) that are not requested
+    struct NoData{
+        template<class KEY>
+        int operator[](const KEY &)const{
+            return 0;
+        }
+    };
+
+    struct NoAccumulator{
+        unsigned int passesRequired()const{
+            return 0;
+        }
+        void updatePassN(const int,const unsigned int){
+        }
+        void merge(const NoAccumulator &){
+        }
+    };
+
+    template<class ACCUMULATOR>
+    unsigned int passesRequired(const ArrayVector<ACCUMULATOR> & accumulators){
+        return accumulators.size()==0 ? 0 : accumulators[0].passesRequired();
+    }
+
+    // accumulators of one thread, 'touched' marks the accumulators which
+    // received data (only those are merged)
+    template<class ACCUMULATOR>
+    struct PartialAccumulators{
+        ArrayVector<ACCUMULATOR> * accumulators;
+        std::vector<char>          touched;
+    };
+
+    // scans the nodes of a slab of the grid and updates the accumulators
+    // of the RAG edges and nodes
+    template<unsigned int N,class LABELS,class EDGE_DATA,class NODE_DATA,class EDGE_ACC,class NODE_ACC>
+    struct RagFeatureScanner{
+        typedef GridGraph<N, boost_graph::undirected_tag> Graph;
+        typedef typename Graph::shape_type Shape;
+        typedef typename Graph::Edge Edge;
+        typedef typename Graph::IncBackEdgeIt IncBackEdgeIt;
+
+        RagFeatureScanner(const Graph & graph,const LABELS & labels,const AdjacencyListGraph & rag,
+                          const EDGE_DATA & edgeData,const NODE_DATA & nodeData,
+                          const Int64 ignoreLabel,const unsigned int pass,
+                          const MultiArrayIndex slabCount,
+                          std::vector<PartialAccumulators<EDGE_ACC> > & edgeAccumulators,
+                          std::vector<PartialAccumulators<NODE_ACC> > & nodeAccumulators)
+        :   graph_(graph),
+            labels_(labels),
+            rag_(rag),
+            edgeData_(edgeData),
+            nodeData_(nodeData),
+            ignoreLabel_(ignoreLabel),
+            pass_(pass),
+            slabCount_(slabCount),
+            edgeAccumulators_(edgeAccumulators),
+            nodeAccumulators_(nodeAccumulators){
+        }
+
+        bool ignored(const Int64 l)const{
+            return ignoreLabel_!=-1 && l==ignoreLabel_;
+        }
+
+        void operator()(const int threadId,const MultiArrayIndex slab)const{
+            const Shape & shape = graph_.shape();
+            Shape start,stop(shape);
+            start[N-1] = (slab*shape[N-1])/slabCount_;
+            stop[N-1]  = ((slab+1)*shape[N-1])/slabCount_;
+
+            PartialAccumulators<EDGE_ACC> & edgeAccumulators = edgeAccumulators_[threadId];
+            PartialAccumulators<NODE_ACC> & nodeAccumulators = nodeAccumulators_[threadId];
+            const bool doEdges = edgeAccumulators.accumulators->size()>0 && pass_<=passesRequired(*edgeAccumulators.accumulators);
+            const bool doNodes = nodeAccumulators.accumulators->size()>0 && pass_<=passesRequired(*nodeAccumulators.accumulators);
+
+            // neighboring grid edges mostly belong to the same RAG edge
+            Int64 lastU=-1,lastV=-1,lastEdge=-1;
+            MultiCoordinateIterator<N> iter(stop-start),end(iter.getEndIterator());
+            for(;iter!=end;++iter){
+                const Shape node = start+*iter;
+                const Int64 l = static_cast<Int64>(labels_[node]);
+                if(ignored(l))
+                    continue;
+                if(doNodes){
+                    (*nodeAccumulators.accumulators)[l].updatePassN(nodeData_[node],pass_);
+                    nodeAccumulators.touched[l]=1;
+                }
+                if(!doEdges)
+                    continue;
+                for(IncBackEdgeIt e(graph_,node);e.isValid();++e){
+                    const Edge edge(*e);
+                    const Int64 lu = static_cast<Int64>(labels_[graph_.u(edge)]);
+                    const Int64 lv = static_cast<Int64>(labels_[graph_.v(edge)]);
+                    if(lu==lv || ignored(lu) || ignored(lv))
+                        continue;
+                    if(lu!=lastU || lv!=lastV){
+                        lastU=lu;
+                        lastV=lv;
+                        lastEdge=rag_.id(rag_.findEdge(rag_.nodeFromId(lu),rag_.nodeFromId(lv)));
+                    }
+                    (*edgeAccumulators.accumulators)[lastEdge].updatePassN(edgeData_[edge],pass_);
+                    edgeAccumulators.touched[lastEdge]=1;
+                }
+            }
+        }
+
+        const Graph & graph_;
+        const LABELS & labels_;
+        const AdjacencyListGraph & rag_;
+        const EDGE_DATA & edgeData_;
+        const NODE_DATA & nodeData_;
+        const Int64 ignoreLabel_;
+        const unsigned int pass_;
+        const MultiArrayIndex slabCount_;
+        std::vector<PartialAccumulators<EDGE_ACC> > & edgeAccumulators_;
+        std::vector<PartialAccumulators<NODE_ACC> > & nodeAccumulators_;
+    };
+
+    // merges one chunk of the accumulators of all threads into those of thread 0
+    template<class ACCUMULATOR>
+    struct PartialAccumulatorMerger{
+        PartialAccumulatorMerger(std::vector<PartialAccumulators<ACCUMULATOR> > & partials,
+                                 const MultiArrayIndex chunkSize)
+        :   partials_(partials),
+            chunkSize_(chunkSize){
+        }
+
+        void operator()(const int,const MultiArrayIndex c)const{
+            ArrayVector<ACCUMULATOR> & result = *partials_[0].accumulators;
+            const MultiArrayIndex end = std::min<MultiArrayIndex>(result.size(),(c+1)*chunkSize_);
+            for(size_t t=1;t<partials_.size();++t){
+                const ArrayVector<ACCUMULATOR> & partial = *partials_[t].accumulators;
+                for(MultiArrayIndex i=c*chunkSize_;i<end;++i){
+                    if(!partials_[t].touched[i])
+                        continue;
+                    // untouched accumulators may not be shaped for the data yet
+                    if(partials_[0].touched[i])
+                        result[i].merge(partial[i]);
+                    else
+                        result[i]=partial[i];
+                    partials_[0].touched[i]=1;
+                }
+            }
+        }
+
+        std::vector<PartialAccumulators<ACCUMULATOR> > & partials_;
+        const MultiArrayIndex chunkSize_;
+    };
+
+    // merge the accumulators of all threads into those of thread 0
+    template<class ACCUMULATOR>
+    void mergePartialAccumulators(std::vector<PartialAccumulators<ACCUMULATOR> > & partials,
+                                  const int nThreads){
+        const MultiArrayIndex chunkSize = 4096;
+        const MultiArrayIndex chunkCount = (partials[0].accumulators->size()+chunkSize-1)/chunkSize;
+        parallel_foreach(nThreads,chunkCount,
+            PartialAccumulatorMerger<ACCUMULATOR>(partials,chunkSize));
+    }
+
+    template<unsigned int N,class LABELS,class EDGE_DATA,class NODE_DATA,class EDGE_ACC,class NODE_ACC>
+    void accumulateRagFeatures(
+        const GridGraph<N, boost_graph::undirected_tag> & graph,
+        const LABELS & labels,
+        const AdjacencyListGraph & rag,
+        const EDGE_DATA & edgeData,
+        const NODE_DATA & nodeData,
+        ArrayVector<EDGE_ACC> & edgeFeatures,
+        ArrayVector<NODE_ACC> & nodeFeatures,
+        const Int64 ignoreLabel,
+        const ParallelOptions & options
+    ){
+        typedef RagFeatureScanner<N,LABELS,EDGE_DATA,NODE_DATA,EDGE_ACC,NODE_ACC> Scanner;
+
+        const unsigned int passes = std::max(passesRequired(edgeFeatures),passesRequired(nodeFeatures));
+        const int nThreads = options.getActualNumThreads();
+        const MultiArrayIndex slabCount = nThreads==1
+            ? 1
+            : std::min<MultiArrayIndex>(graph.shape()[N-1], 4*nThreads);
+
+        // thread 0 works on the result, the others on copies of the initial
+        // accumulators (so that options like histogram ranges are preserved)
+        ArrayVector<ArrayVector<EDGE_ACC> > edgeCopies(nThreads-1,edgeFeatures);
+        ArrayVector<ArrayVector<NODE_ACC> > nodeCopies(nThreads-1,nodeFeatures);
+        std::vector<PartialAccumulators<EDGE_ACC> > edgePartials(nThreads);
+        std::vector<PartialAccumulators<NODE_ACC> > nodePartials(nThreads);
+        for(int t=0;t<nThreads;++t){
+            edgePartials[t].accumulators = t==0 ? &edgeFeatures : &edgeCopies[t-1];
+            edgePartials[t].touched.resize(edgeFeatures.size(),0);
+            nodePartials[t].accumulators = t==0 ? &nodeFeatures : &nodeCopies[t-1];
+            nodePartials[t].touched.resize(nodeFeatures.size(),0);
+        }
+
+        // first pass: threads fill their own accumulators, which are merged afterwards
+        parallel_foreach(nThreads,slabCount,
+            Scanner(graph,labels,rag,edgeData,nodeData,ignoreLabel,1,slabCount,edgePartials,nodePartials));
+        if(nThreads>1){
+            mergePartialAccumulators(edgePartials,nThreads);
+            mergePartialAccumulators(nodePartials,nThreads);
+            edgeCopies.clear();
+            nodeCopies.clear();
+            edgePartials.resize(1);
+            nodePartials.resize(1);
+        }
+
+        // later passes depend on the merged results of the previous pass
+        for(unsigned int pass=2;pass<=passes;++pass)
+            Scanner(graph,labels,rag,edgeData,nodeData,ignoreLabel,pass,1,edgePartials,nodePartials)(0,0);
+    }
+
+} // namespace detail_rag_features
+
+    /** \brief compute statistics of the edges and nodes of a region adjacency graph
+
+        Computes statistics of grid edge data (e.g. boundary probabilities) over the
+        grid edges of each RAG edge, and statistics of grid node data over the nodes of
+        each region, in a single pass over the grid. The statistics are arbitrary
+        accumulator chains (see \ref FeatureAccumulators), e.g.
+
+        \code
+        using namespace vigra::acc;
+        typedef AccumulatorChain<float, Select<Mean, Minimum, Maximum, Count> > EdgeStatistics;
+        typedef AccumulatorChain<TinyVector<float, 3>, Select<Mean, Variance> > NodeStatistics;
+
+        ArrayVector<EdgeStatistics> edgeFeatures(rag.maxEdgeId()+1);
+        ArrayVector<NodeStatistics> nodeFeatures(rag.maxNodeId()+1);
+        accumulateRagFeatures(gridGraph, labels, rag, boundaryProbabilities, rgb,
+                              edgeFeatures, nodeFeatures);
+        double meanProbability = get<Mean>(edgeFeatures[rag.id(ragEdge)]);
+        \endcode
+
+        \a rag must be the region adjacency graph of \a labels (see \ref makeRegionAdjacencyGraph()),
+        i.e. its node ids are the labels. The accumulators are indexed by the RAG's edge and node ids,
+        \a edgeData and \a nodeData are indexed by the edges and nodes of \a graph (implicit edge
+        maps like \ref ImplicitNodeWeightsEdgeMap can be used as well).
+        Options of the accumulators (e.g. histogram ranges) must be set before the call.
+
+        The grid is split into slabs which are processed in parallel. Each thread
+        updates its own copy of the accumulators, and the copies are combined with
+        <tt>AccumulatorChain::merge()</tt> afterwards. Hence, all statistics must support
+        merging. Statistics requiring more than one pass (e.g. quantiles based on
+        <tt>AutoRangeHistogram</tt>) are supported, but only the first pass is parallelized;
+        for data with a known range, <tt>UserRangeHistogram</tt> gives quantiles in a single pass.
+        Memory for the accumulators is needed once per thread.
+
+        <b>\#include</b> \<vigra/graph_rag_features.hxx\><br/>
+        Namespace: vigra
+    */
+    template<unsigned int N,class LABELS,class EDGE_DATA,class NODE_DATA,class EDGE_ACC,class NODE_ACC>
+    void accumulateRagFeatures(
+        const GridGraph<N, boost_graph::undirected_tag> & graph,
+        const LABELS & labels,
+        const AdjacencyListGraph & rag,
+        const EDGE_DATA & edgeData,
+        const NODE_DATA & nodeData,
+        ArrayVector<EDGE_ACC> & edgeFeatures,
+        ArrayVector<NODE_ACC> & nodeFeatures,
+        const Int64 ignoreLabel = -1,
+        const ParallelOptions & options = ParallelOptions()
+    ){
+        vigra_precondition(edgeFeatures.size()==static_cast<size_t>(rag.maxEdgeId()+1),
+            "accumulateRagFeatures(): need one edge accumulator per RAG edge id.");
+        vigra_precondition(nodeFeatures.size()==static_cast<size_t>(rag.maxNodeId()+1),
+            "accumulateRagFeatures(): need one node accumulator per RAG node id.");
+        detail_rag_features::accumulateRagFeatures(graph,labels,rag,edgeData,nodeData,
+                                                   edgeFeatures,nodeFeatures,ignoreLabel,options);
+    }
+
+    /** \brief compute statistics of the edges of a region adjacency graph
+
+        Same as \ref accumulateRagFeatures(), but only computes the edge statistics.
+    */
+    template<unsigned int N,class LABELS,class EDGE_DATA,class EDGE_ACC>
+    void accumulateRagEdgeFeatures(
+        const GridGraph<N, boost_graph::undirected_tag> & graph,
+        const LABELS & labels,
+        const AdjacencyListGraph & rag,
+        const EDGE_DATA & edgeData,
+        ArrayVector<EDGE_ACC> & edgeFeatures,
+        const Int64 ignoreLabel = -1,
+        const ParallelOptions & options = ParallelOptions()
+    ){
+        vigra_precondition(edgeFeatures.size()==static_cast<size_t>(rag.maxEdgeId()+1),
+            "accumulateRagEdgeFeatures(): need one edge accumulator per RAG edge id.");
+        ArrayVector<detail_rag_features::NoAccumulator> nodeFeatures;
+        detail_rag_features::accumulateRagFeatures(graph,labels,rag,edgeData,detail_rag_features::NoData(),
+                                                   edgeFeatures,nodeFeatures,ignoreLabel,options);
+    }
+
+    /** \brief compute statistics of the nodes of a region adjacency graph
+
+        Same as \ref accumulateRagFeatures(), but only computes the node statistics.
+    */
+    template<unsigned int N,class LABELS,class NODE_DATA,class NODE_ACC>
+    void accumulateRagNodeFeatures(
+        const GridGraph<N, boost_graph::undirected_tag> & graph,
+        const LABELS & labels,
+        const AdjacencyListGraph & rag,
+        const NODE_DATA & nodeData,
+        ArrayVector<NODE_ACC> & nodeFeatures,
+        const Int64 ignoreLabel = -1,
+        const ParallelOptions & options = ParallelOptions()
+    ){
+        vigra_precondition(nodeFeatures.size()==static_cast<size_t>(rag.maxNodeId()+1),
+            "accumulateRagNodeFeatures(): need one node accumulator per RAG node id.");
+        ArrayVector<detail_rag_features::NoAccumulator> edgeFeatures;
+        detail_rag_features::accumulateRagFeatures(graph,labels,rag,detail_rag_features::NoData(),nodeData,
+                                                   edgeFeatures,nodeFeatures,ignoreLabel,options);
+    }
+
+} // namespace vigra
+
+#endif // VIGRA_GRAPH_RAG_FEATURES_HXX
@@ -43,15 +43,74 @@
 /*std*/
 #include <queue>          
 #include <iomanip>
+#include <vector>
+#include <utility>
+#include <cmath>
 
 /*vigra*/
 #include "priority_queue.hxx"
-#include "metrics.hxx" 
+#include "metrics.hxx"
+#include "metaprogramming.hxx" 
 
 namespace vigra{      
 
 namespace cluster_operators{
 
+    /// \brief options which select how a cluster operator keeps its edge priority queue up to date
+    ///
+    /// <ul>
+    /// <li> <b>eager</b> (default): after each merge, the weights of all edges incident
+    ///      to the merged node are recomputed and updated in the queue.
+    /// <li> <b>lazy</b>: merges only mark the incident edges as stale. The weight of a
+    ///      stale edge is recomputed when it reaches the top of the queue, and the edge
+    ///      is re-inserted with its new weight. The result is identical to eager updates
+    ///      as long as merging never decreases edge weights, otherwise edges whose weight
+    ///      decreased may be contracted later than with eager updates.
+    /// <li> <b>buckets</b>: like lazy, but the weights are quantized into a fixed number of
+    ///      buckets covering <tt>[minWeight, maxWeight]</tt> (weights outside are clamped),
+    ///      and edges in the same bucket are contracted in first-in first-out order.
+    ///      Push and pop are O(1), but edges with similar weights are not ordered exactly.
+    /// </ul>
+    class ClusterQueueOptions{
+    public:
+        enum Mode{ Eager, Lazy, Buckets };
+
+        ClusterQueueOptions()
+        :   mode_(Eager),
+            bucketCount_(1024),
+            minWeight_(0.0),
+            maxWeight_(1.0){
+        }
+
+        /// \brief recompute all incident edge weights after each merge (default)
+        ClusterQueueOptions & eager(){
+            mode_=Eager;
+            return *this;
+        }
+
+        /// \brief recompute edge weights only when a stale edge reaches the top of the queue
+        ClusterQueueOptions & lazy(){
+            mode_=Lazy;
+            return *this;
+        }
+
+        /// \brief lazy updates in a bucket queue with \a bucketCount quantization levels
+        ClusterQueueOptions & buckets(const size_t bucketCount,const double minWeight,const double maxWeight){
+            vigra_precondition(bucketCount>0 && minWeight<maxWeight,
+                "ClusterQueueOptions::buckets(): need bucketCount > 0 and minWeight < maxWeight.");
+            mode_=Buckets;
+            bucketCount_=bucketCount;
+            minWeight_=minWeight;
+            maxWeight_=maxWeight;
+            return *this;
+        }
+
+        Mode mode_;
+        size_t bucketCount_;
+        double minWeight_;
+        double maxWeight_;
+    };
+
     /// \brief  get minimum edge weight from an edge indicator and difference of node features
     template<
         class MERGE_GRAPH,
@@ -92,6 +151,11 @@ namespace cluster_operators{
 
         typedef typename EDGE_INDICATOR_MAP::Reference EdgeIndicatorReference;
         typedef typename NODE_FEATURE_MAP::Reference NodeFeatureReference;
+
+        // bucket queue entry: edge id and generation of the edge
+        // (entries with an outdated generation are ignored)
+        typedef std::pair<index_type,index_type> BucketEntry;
+
         /// \brief construct cluster operator
         EdgeWeightNodeFeatures(
             MergeGraph & mergeGraph,
@@ -102,7 +166,8 @@ namespace cluster_operators{
             MIN_WEIGHT_MAP minWeightEdgeMap,
             const ValueType beta,
             const metrics::MetricType metricType,
-            const ValueType wardness=1.0
+            const ValueType wardness=1.0,
+            const ClusterQueueOptions & queueOptions = ClusterQueueOptions()
         )
         :   mergeGraph_(mergeGraph),
             edgeIndicatorMap_(edgeIndicatorMap),
@@ -110,7 +175,10 @@ namespace cluster_operators{
             nodeFeatureMap_(nodeFeatureMap),
             nodeSizeMap_(nodeSizeMap),
             minWeightEdgeMap_(minWeightEdgeMap),
-            pq_(mergeGraph.maxEdgeId()+1),
+            pq_(queueOptions.mode_==ClusterQueueOptions::Buckets ? 0 : mergeGraph.maxEdgeId()+1),
+            bq_(queueOptions.mode_==ClusterQueueOptions::Buckets ? queueOptions.bucketCount_ : 1),
+            queueOptions_(queueOptions),
+            time_(0),
             beta_(beta),
             wardness_(wardness),
             metric_(metricType)
@@ -129,12 +197,21 @@ namespace cluster_operators{
             mergeGraph_.registerEraseEdgeCallBack(cbEe);
 
 
+            if(queueOptions_.mode_!=ClusterQueueOptions::Eager){
+                nodeTime_.resize(mergeGraph.maxNodeId()+1,0);
+                edgeTime_.resize(mergeGraph.maxEdgeId()+1,0);
+            }
+            if(queueOptions_.mode_==ClusterQueueOptions::Buckets){
+                edgeGeneration_.resize(mergeGraph.maxEdgeId()+1,0);
+                edgeWeight_.resize(mergeGraph.maxEdgeId()+1);
+            }
+
             for(EdgeIt e(mergeGraph);e!=lemon::INVALID;++e){
                 const Edge edge = *e;
                 const BaseGraphEdge graphEdge=EdgeHelper::itemToGraphItem(mergeGraph_,edge);
                 const index_type edgeId = mergeGraph_.id(edge);
                 const ValueType currentWeight = this->getEdgeWeight(edge);
-                pq_.push(edgeId,currentWeight);
+                pushEdge(edgeId,currentWeight);
                 minWeightEdgeMap_[graphEdge]=currentWeight;
             }
         }
@@ -152,8 +229,10 @@ namespace cluster_operators{
             edgeSizeMap_[aa]+=edgeSizeMap_[bb];
             va/=(edgeSizeMap_[aa]);
             vb/=edgeSizeMap_[bb];
-            // delete b from pq
-            pq_.deleteItem(b.id());
+            // delete b from pq (bucket entries of b are discarded
+            // when they reach the top)
+            if(queueOptions_.mode_!=ClusterQueueOptions::Buckets)
+                pq_.deleteItem(b.id());
         }
 
         /// \brief will be called via callbacks from mergegraph
@@ -168,14 +247,26 @@ namespace cluster_operators{
             nodeSizeMap_[aa]+=nodeSizeMap_[bb];
             va/=(nodeSizeMap_[aa]);
             vb/=nodeSizeMap_[bb];
+            if(queueOptions_.mode_!=ClusterQueueOptions::Eager){
+                // all edges of a are stale now
+                ++time_;
+                nodeTime_[a.id()]=time_;
+            }
         }
 
         /// \brief will be called via callbacks from mergegraph
         void eraseEdge(const Edge & edge){
 
+            if(queueOptions_.mode_==ClusterQueueOptions::Buckets){
+                return;
+            }
             //std::cout<<"start to erase edge "<<mergeGraph_.id(edge)<<"\n";
             // delete edge from pq
             pq_.deleteItem(edge.id());
+            if(queueOptions_.mode_==ClusterQueueOptions::Lazy){
+                // incident edges are updated in validTop()
+                return;
+            }
             // get the new region the edge is in
             // (since the edge is no any more an active edge)
             //std::cout<<"get the new node  \n";
@@ -211,31 +302,111 @@ namespace cluster_operators{
 
         /// \brief get the edge which should be contracted next
         Edge contractionEdge(){
-            index_type minLabel = pq_.top();
-            while(mergeGraph_.hasEdgeId(minLabel)==false){
-                pq_.deleteItem(minLabel);
-                minLabel = pq_.top();
-            }
-            return Edge(minLabel);
+            return Edge(validTop());
         }
 
         /// \brief get the edge weight of the edge which should be contracted next
         WeightType contractionWeight(){
-            index_type minLabel = pq_.top();
-            while(mergeGraph_.hasEdgeId(minLabel)==false){
-                pq_.deleteItem(minLabel);
-                minLabel = pq_.top();
-            }
+            const index_type minLabel = validTop();
+            if(queueOptions_.mode_==ClusterQueueOptions::Buckets)
+                return edgeWeight_[minLabel];
             return pq_.topPriority();
-
         }
 
 
+        /// \brief will be called by HierarchicalClustering::cluster() when it is done
+        ///
+        /// In the lazy modes, the weights of stale edges which never reached the top
+        /// of the queue are recomputed here, so that the min weight edge map holds
+        /// the current weights of all active edges (as in eager mode).
+        void done(){
+            if(queueOptions_.mode_==ClusterQueueOptions::Eager)
+                return;
+            for(EdgeIt e(mergeGraph_);e!=lemon::INVALID;++e){
+                const index_type edgeId = mergeGraph_.id(*e);
+                if(isStale(edgeId)){
+                    if(queueOptions_.mode_==ClusterQueueOptions::Buckets)
+                        ++edgeGeneration_[edgeId];
+                    updateEdgeWeight(edgeId);
+                }
+            }
+        }
+
         /// \brief get a reference to the merge
         MergeGraph & mergeGraph(){
             return mergeGraph_;
         }
     private:
+        void pushEdge(const index_type edgeId,const ValueType weight){
+            if(queueOptions_.mode_==ClusterQueueOptions::Buckets){
+                edgeWeight_[edgeId]=weight;
+                bq_.push(BucketEntry(edgeId,edgeGeneration_[edgeId]),bucketIndex(weight));
+            }
+            else{
+                pq_.push(edgeId,weight);
+            }
+            if(queueOptions_.mode_!=ClusterQueueOptions::Eager)
+                edgeTime_[edgeId]=time_;
+        }
+
+        typename BucketQueue<BucketEntry,true>::priority_type bucketIndex(const ValueType weight)const{
+            const double scaled = (static_cast<double>(weight)-queueOptions_.minWeight_) /
+                                  (queueOptions_.maxWeight_-queueOptions_.minWeight_) * bq_.maxIndex();
+            if(!(scaled>0.0))
+                return 0;
+            if(scaled>=bq_.maxIndex())
+                return bq_.maxIndex();
+            return static_cast<typename BucketQueue<BucketEntry,true>::priority_type>(scaled);
+        }
+
+        // a node of the edge was merged after the weight was computed
+        bool isStale(const index_type edgeId){
+            const Edge edge(edgeId);
+            return nodeTime_[mergeGraph_.id(mergeGraph_.u(edge))]>edgeTime_[edgeId] ||
+                   nodeTime_[mergeGraph_.id(mergeGraph_.v(edge))]>edgeTime_[edgeId];
+        }
+
+        // drop entries of contracted edges and (in lazy modes) recompute
+        // stale weights until the top of the queue is valid
+        index_type validTop(){
+            if(queueOptions_.mode_==ClusterQueueOptions::Buckets){
+                for(;;){
+                    const BucketEntry entry = bq_.top();
+                    const index_type edgeId = entry.first;
+                    if(!mergeGraph_.hasEdgeId(edgeId) || entry.second!=edgeGeneration_[edgeId]){
+                        bq_.pop();
+                    }
+                    else if(isStale(edgeId)){
+                        bq_.pop();
+                        ++edgeGeneration_[edgeId];
+                        updateEdgeWeight(edgeId);
+                    }
+                    else{
+                        return edgeId;
+                    }
+                }
+            }
+            for(;;){
+                const index_type edgeId = pq_.top();
+                if(!mergeGraph_.hasEdgeId(edgeId)){
+                    pq_.deleteItem(edgeId);
+                }
+                else if(queueOptions_.mode_==ClusterQueueOptions::Lazy && isStale(edgeId)){
+                    updateEdgeWeight(edgeId);
+                }
+                else{
+                    return edgeId;
+                }
+            }
+        }
+
+        void updateEdgeWeight(const index_type edgeId){
+            const Edge edge(edgeId);
+            const ValueType newWeight = getEdgeWeight(edge);
+            pushEdge(edgeId,newWeight);
+            minWeightEdgeMap_[EdgeHelper::itemToGraphItem(mergeGraph_,edge)]=newWeight;
+        }
+
         ValueType getEdgeWeight(const Edge & e){
             
             const Node u = mergeGraph_.u(e);
@@ -262,6 +433,15 @@ namespace cluster_operators{
         NODE_SIZE_MAP nodeSizeMap_;
         MIN_WEIGHT_MAP minWeightEdgeMap_;
         vigra::ChangeablePriorityQueue< ValueType > pq_;
+        vigra::BucketQueue< BucketEntry, true >     bq_;
+        ClusterQueueOptions queueOptions_;
+        // merge counter, time of the last merge per node,
+        // and time of the last weight computation per edge
+        index_type time_;
+        std::vector<index_type> nodeTime_;
+        std::vector<index_type> edgeTime_;
+        std::vector<index_type> edgeGeneration_;
+        std::vector<ValueType>  edgeWeight_;
         ValueType beta_;
         ValueType wardness_;
 
@@ -269,9 +449,37 @@ namespace cluster_operators{
     };
 } // end namespace cluster_operators
 
+namespace detail_hierarchical_clustering{
+
+    template<class T, void (T::*)()>
+    struct DoneMember{};
+
+    // does the cluster operator have a member function 'void done()'?
+    template<class T>
+    struct HasDone : public sfinae_test<T, HasDone>
+    {
+        template<class U> HasDone(U*, DoneMember<U, &U::done>* = 0);
+    };
+
+    template<class CLUSTER_OPERATOR>
+    void callDone(CLUSTER_OPERATOR & clusterOperator, VigraTrueType){
+        clusterOperator.done();
+    }
+
+    template<class CLUSTER_OPERATOR>
+    void callDone(CLUSTER_OPERATOR &, VigraFalseType){
+    }
+
+} // end namespace detail_hierarchical_clustering
+
 
 
     /// \brief  do hierarchical clustering with a given cluster operator
+    ///
+    /// The cluster operator provides <tt>contractionEdge()</tt>,
+    /// <tt>contractionWeight()</tt> and <tt>mergeGraph()</tt>. If it also
+    /// has a member function <tt>void done()</tt>, this is called once at the
+    /// end of cluster(), e.g. to bring lazily updated edge weights up to date.
     template< class CLUSTER_OPERATOR>
     class HierarchicalClustering{
 
@@ -287,18 +495,26 @@ namespace cluster_operators{
         typedef typename MergeGraph::index_type         MergeGraphIndexType;
 
         struct Parameter{
+            /// \param nodeNumStopCond : stop when the graph has this number of nodes
+            /// \param buildMergeTree : record the merge tree encoding
+            /// \param verbose : print the number of nodes during clustering
+            /// \param maxMergeWeight : stop when the weight of the next contraction
+            ///                         edge exceeds this value
             Parameter(
                 const size_t      nodeNumStopCond = 1,
                 const bool        buildMergeTree  = true,
-                const bool        verbose         = false
+                const bool        verbose         = false,
+                const ValueType   maxMergeWeight  = NumericTraits<ValueType>::max()
             )
             :   nodeNumStopCond_ (nodeNumStopCond),
                 buildMergeTreeEncoding_(buildMergeTree),
-                verbose_(verbose){                
+                verbose_(verbose),
+                maxMergeWeight_(maxMergeWeight){                
             }
             size_t nodeNumStopCond_;
             bool   buildMergeTreeEncoding_;
             bool   verbose_;
+            ValueType maxMergeWeight_;
         };
 
         struct MergeItem{
@@ -348,6 +564,9 @@ namespace cluster_operators{
                 std::cout<<"\n"; 
             while(mergeGraph_.nodeNum()>param_.nodeNumStopCond_ && mergeGraph_.edgeNum()>0){
                 
+                if(param_.maxMergeWeight_<NumericTraits<ValueType>::max() &&
+                   clusterOperator_.contractionWeight()>param_.maxMergeWeight_)
+                    break;
 
                 const Edge edgeToRemove = clusterOperator_.contractionEdge();
                 if(param_.buildMergeTreeEncoding_){
@@ -371,6 +590,8 @@ namespace cluster_operators{
                     std::cout<<"\rNodes: "<<std::setw(10)<<mergeGraph_.nodeNum()<<std::flush;
                 
             }
+            detail_hierarchical_clustering::callDone(clusterOperator_,
+                typename detail_hierarchical_clustering::HasDone<ClusterOperator>::type());
             if(param_.verbose_)
                 std::cout<<"\n"; 
         }
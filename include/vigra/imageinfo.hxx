@@ -146,7 +146,10 @@ class ImageExportInfo
             
             If the data is exported to TIFF, the \a mode may be "a", in which case
             the exported image is appended to the existing file, resulting in a 
-            multi-page TIFF image.
+            multi-page TIFF image. Mode "w8" forces the BigTIFF format. When the mode
+            is "w" and the uncompressed image data would not fit into a classic
+            TIFF file (4 GB), BigTIFF is selected automatically (requires libtiff 4.0
+            or newer).
          **/
     VIGRA_EXPORT ImageExportInfo( const char * filename, const char * mode = "w" );
     VIGRA_EXPORT ~ImageExportInfo();
@@ -344,6 +347,39 @@ class ImageExportInfo
          **/
     VIGRA_EXPORT ImageExportInfo & setCanvasSize(const Size2D & size);
 
+        /** Write the image in tiles of the given size rather than in strips.
+
+            Currently only supported by TIFF files, where tiled storage allows
+            to read regions of interest efficiently (see \ref importImage()).
+            TIFF requires the tile width and height to be multiples of 16, so
+            the given size is rounded up accordingly. The default
+            <tt>Size2D(0,0)</tt> selects strip-wise storage.
+         **/
+    VIGRA_EXPORT ImageExportInfo & setTileSize(const Size2D & size);
+
+        /** Get the tile size (<tt>Size2D(0,0)</tt> means strip-wise storage).
+         **/
+    VIGRA_EXPORT Size2D getTileSize() const;
+
+        /** Compress the image with up to \a n threads.
+
+            Currently supported by PNG and JPEG files. PNG splits the filtered image
+            data into blocks which are deflated in parallel (each block uses the end of
+            its predecessor as dictionary) and stitched into a single zlib stream. JPEG
+            encodes bands of 8 rows in parallel and joins them with restart markers;
+            this requires the standard Huffman tables, which makes the files slightly
+            larger than those written sequentially.
+
+            <tt>n</tt> may also be one of the constants <tt>ParallelOptions::Auto</tt>
+            and <tt>ParallelOptions::Nice</tt>. The default <tt>n = 1</tt> selects the
+            sequential encoder.
+         **/
+    VIGRA_EXPORT ImageExportInfo & setNumThreads(int n);
+
+        /** Get the number of threads used for compression.
+         **/
+    VIGRA_EXPORT int getNumThreads() const;
+
         /**
           ICC profiles (handled as raw data so far).
           see getICCProfile()/setICCProfile()
@@ -365,7 +401,8 @@ class ImageExportInfo
     float m_x_res, m_y_res;
     Diff2D m_pos;
     ICCProfile m_icc_profile;
-    Size2D m_canvas_size;
+    Size2D m_canvas_size, m_tile_size;
+    int m_num_threads;
     double fromMin_, fromMax_, toMin_, toMax_;
 };
 
@@ -60,23 +60,52 @@ namespace vigra
 */
     namespace detail
     {
+        inline void
+        skip_scanlines(Decoder* decoder, int count)
+        {
+            for (int y = 0; y < count; ++y)
+            {
+                decoder->nextScanline();
+            }
+        }
+
+
+        // Restrict the decoder to the given region of interest. Returns the
+        // offset the scanline readers still have to skip themselves, which
+        // is zero if the codec supports ROI decoding natively.
+        inline Diff2D
+        restrict_decoder_to_roi(Decoder* decoder,
+                                const Diff2D& roi_offset, const Size2D& roi_size)
+        {
+            if (roi_size == Size2D() || decoder->setROI(roi_offset, roi_size))
+            {
+                return Diff2D();
+            }
+            return roi_offset;
+        }
+
+
         template <class ValueType,
                   class ImageIterator, class ImageAccessor>
         void
         read_image_band(Decoder* decoder,
-                        ImageIterator image_iterator, ImageAccessor image_accessor)
+                        ImageIterator image_iterator, ImageAccessor image_accessor,
+                        const Diff2D& roi_offset = Diff2D(), const Size2D& roi_size = Size2D())
         {
             typedef typename ImageIterator::row_iterator ImageRowIterator;
 
-            const unsigned width(decoder->getWidth());
-            const unsigned height(decoder->getHeight());
+            const unsigned width(roi_size.x > 0 ? roi_size.x : decoder->getWidth());
+            const unsigned height(roi_size.y > 0 ? roi_size.y : decoder->getHeight());
             const unsigned offset(decoder->getOffset());
+            const unsigned skip(roi_offset.x * offset);
+
+            skip_scanlines(decoder, roi_offset.y);
 
             for (unsigned y = 0U; y != height; ++y)
             {
                 decoder->nextScanline();
 
-                const ValueType* scanline = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0));
+                const ValueType* scanline = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0)) + skip;
 
                 ImageRowIterator is(image_iterator.rowIterator());
                 const ImageRowIterator is_end(is + width);
@@ -97,15 +126,19 @@ namespace vigra
                   class ImageIterator, class ImageAccessor>
         void
         read_image_bands(Decoder* decoder,
-                         ImageIterator image_iterator, ImageAccessor image_accessor)
+                         ImageIterator image_iterator, ImageAccessor image_accessor,
+                         const Diff2D& roi_offset = Diff2D(), const Size2D& roi_size = Size2D())
         {
             typedef typename ImageIterator::row_iterator ImageRowIterator;
 
-            const unsigned width(decoder->getWidth());
-            const unsigned height(decoder->getHeight());
+            const unsigned width(roi_size.x > 0 ? roi_size.x : decoder->getWidth());
+            const unsigned height(roi_size.y > 0 ? roi_size.y : decoder->getHeight());
             const unsigned bands(decoder->getNumBands());
             const unsigned offset(decoder->getOffset());
+            const unsigned skip(roi_offset.x * offset);
             const unsigned accessor_size(image_accessor.size(image_iterator));
+
+            skip_scanlines(decoder, roi_offset.y);
             
             // OPTIMIZATION: Specialization for the most common case
             // of an RGB-image, i.e. 3 channels.
@@ -119,7 +152,7 @@ namespace vigra
                 {
                     decoder->nextScanline();
 
-                    scanline_0 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0));
+                    scanline_0 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0)) + skip;
                     
                     if(bands == 1)
                     {
@@ -128,8 +161,8 @@ namespace vigra
                     }
                     else
                     {
-                        scanline_1 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(1));
-                        scanline_2 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(2));
+                        scanline_1 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(1)) + skip;
+                        scanline_2 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(2)) + skip;
                     }
                     
                     ImageRowIterator is(image_iterator.rowIterator());
@@ -159,7 +192,7 @@ namespace vigra
                 {
                     decoder->nextScanline();
                     
-                    scanlines[0] = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0));
+                    scanlines[0] = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0)) + skip;
 
                     if(bands == 1)
                     {
@@ -172,7 +205,7 @@ namespace vigra
                     {
                         for (unsigned i = 1U; i != accessor_size; ++i)
                         {
-                            scanlines[i] = static_cast<const ValueType*>(decoder->currentScanlineOfBand(i));
+                            scanlines[i] = static_cast<const ValueType*>(decoder->currentScanlineOfBand(i)) + skip;
                         }
                     }
                     
@@ -197,82 +230,138 @@ namespace vigra
 
         template <class ImageIterator, class ImageAccessor>
         void
-        importImage(const ImageImportInfo& import_info,
-                    ImageIterator image_iterator, ImageAccessor image_accessor,
-                    /* isScalar? */ VigraTrueType)
+        read_image(Decoder* decoder,
+                   ImageIterator image_iterator, ImageAccessor image_accessor,
+                   /* isScalar? */ VigraTrueType,
+                   const Diff2D& skip, const Size2D& roi_size)
         {
-            VIGRA_UNIQUE_PTR<Decoder> decoder(vigra::decoder(import_info));
-
             switch (pixel_t_of_string(decoder->getPixelType()))
             {
             case UNSIGNED_INT_8:
-                read_image_band<UInt8>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<UInt8>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case UNSIGNED_INT_16:
-                read_image_band<UInt16>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<UInt16>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case UNSIGNED_INT_32:
-                read_image_band<UInt32>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<UInt32>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case SIGNED_INT_16:
-                read_image_band<Int16>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<Int16>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case SIGNED_INT_32:
-                read_image_band<Int32>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<Int32>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case IEEE_FLOAT_32:
-                read_image_band<float>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<float>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case IEEE_FLOAT_64:
-                read_image_band<double>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<double>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             default:
                 vigra_fail("detail::importImage<scalar>: not reached");
             }
-
-            decoder->close();
         }
 
 
         template <class ImageIterator, class ImageAccessor>
         void
-        importImage(const ImageImportInfo& import_info,
-                    ImageIterator image_iterator, ImageAccessor image_accessor,
-                    /* isScalar? */ VigraFalseType)
+        read_image(Decoder* decoder,
+                   ImageIterator image_iterator, ImageAccessor image_accessor,
+                   /* isScalar? */ VigraFalseType,
+                   const Diff2D& skip, const Size2D& roi_size)
         {
-            vigra_precondition((static_cast<unsigned int>(import_info.numBands())
-                                == image_accessor.size(image_iterator)) ||
-                               import_info.numBands() == 1,
+            vigra_precondition(decoder->getNumBands() == image_accessor.size(image_iterator) ||
+                               decoder->getNumBands() == 1,
                 "importImage(): Number of channels in input and destination image don't match.");
 
-            VIGRA_UNIQUE_PTR<Decoder> decoder(vigra::decoder(import_info));
-            
             switch (pixel_t_of_string(decoder->getPixelType()))
             {
             case UNSIGNED_INT_8:
-                read_image_bands<UInt8>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<UInt8>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case UNSIGNED_INT_16:
-                read_image_bands<UInt16>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<UInt16>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case UNSIGNED_INT_32:
-                read_image_bands<UInt32>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<UInt32>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case SIGNED_INT_16:
-                read_image_bands<Int16>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<Int16>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case SIGNED_INT_32:
-                read_image_bands<Int32>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<Int32>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case IEEE_FLOAT_32:
-                read_image_bands<float>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<float>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             case IEEE_FLOAT_64:
-                read_image_bands<double>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<double>(decoder, image_iterator, image_accessor, skip, roi_size);
                 break;
             default:
                 vigra_fail("vigra::detail::importImage<non-scalar>: not reached");
             }
+        }
+
+
+        template <class ImageIterator, class ImageAccessor, class IsScalar>
+        void
+        importImage(const ImageImportInfo& import_info,
+                    ImageIterator image_iterator, ImageAccessor image_accessor,
+                    IsScalar is_scalar,
+                    const Diff2D& roi_offset = Diff2D(), const Size2D& roi_size = Size2D())
+        {
+            VIGRA_UNIQUE_PTR<Decoder> decoder(vigra::decoder(import_info));
+            const Diff2D skip(restrict_decoder_to_roi(decoder.get(), roi_offset, roi_size));
+
+            read_image(decoder.get(), image_iterator, image_accessor, is_scalar, skip, roi_size);
+
+            decoder->close();
+        }
+
+
+        // Let the codec decode directly into the array's memory. This only
+        // applies when the array's element type and band count equal the
+        // file's, so that no conversion is necessary.
+        template <class T, class S>
+        bool
+        read_image_block(Decoder* decoder, MultiArrayView<2, T, S> image)
+        {
+            typedef typename ExpandElementResult<T>::type ElementType;
+            const int size = ExpandElementResult<T>::size;
+
+            if (TypeAsString<ElementType>::result() != decoder->getPixelType() ||
+                decoder->getNumBands() != static_cast<unsigned int>(size))
+            {
+                return false;
+            }
+            return decoder->decodeBlock(image.data(),
+                                        size * image.stride(0), size * image.stride(1), 1);
+        }
+
+
+        template <class T, class S>
+        void
+        import_image_view(const ImageImportInfo& import_info,
+                          MultiArrayView<2, T, S> image,
+                          const Diff2D& roi_offset = Diff2D(), const Size2D& roi_size = Size2D())
+        {
+            typedef typename NumericTraits<T>::isScalar is_scalar;
+
+            VIGRA_UNIQUE_PTR<Decoder> decoder(vigra::decoder(import_info));
+            const Diff2D skip(restrict_decoder_to_roi(decoder.get(), roi_offset, roi_size));
+
+            // the block interface writes the decoder's full width and height,
+            // so it only applies when the decoder delivers exactly the image
+            // (or the ROI, if the codec restricted itself to it)
+            if (skip != Diff2D() ||
+                decoder->getWidth() != static_cast<unsigned int>(image.shape(0)) ||
+                decoder->getHeight() != static_cast<unsigned int>(image.shape(1)) ||
+                !read_image_block(decoder.get(), image))
+            {
+                read_image(decoder.get(), destImage(image).first, destImage(image).second,
+                           is_scalar(), skip, roi_size);
+            }
 
             decoder->close();
         }
@@ -654,6 +743,15 @@ namespace vigra
         importImage(ImageImportInfo const & import_info,
                     MultiArrayView<2, T, S> image);
 
+        // read the region of interest starting at 'roi_offset' with the
+        // size of 'image'. Codecs supporting it (e.g. tiled TIFF) only
+        // decode the data intersecting the region.
+        template <class T, class S>
+        void
+        importImage(ImageImportInfo const & import_info,
+                    MultiArrayView<2, T, S> image,
+                    MultiArrayShape<2>::type const & roi_offset);
+
         // resize the given array and then read the data
         template <class T, class A>
         void
@@ -816,7 +914,30 @@ namespace vigra
     {
         vigra_precondition(import_info.shape() == image.shape(),
             "importImage(): shape mismatch between input and output.");
-        importImage(import_info, destImage(image));
+        detail::import_image_view(import_info, image);
+    }
+
+    template <class T, class S>
+    inline void
+    importImage(ImageImportInfo const & import_info,
+                MultiArrayView<2, T, S> image,
+                MultiArrayShape<2>::type const & roi_offset)
+    {
+        vigra_precondition(allGreaterEqual(roi_offset, MultiArrayShape<2>::type()) &&
+                           allLessEqual(roi_offset + image.shape(), import_info.shape()),
+            "importImage(): region of interest exceeds the image.");
+        detail::import_image_view(import_info, image,
+                                  Diff2D(roi_offset[0], roi_offset[1]),
+                                  Size2D(image.shape(0), image.shape(1)));
+    }
+
+    template <class T, class A>
+    inline void
+    importImage(ImageImportInfo const & import_info,
+                MultiArray<2, T, A> & image,
+                MultiArrayShape<2>::type const & roi_offset)
+    {
+        importImage(import_info, static_cast<MultiArrayView<2, T> &>(image), roi_offset);
     }
 
     template <class T, class A>
@@ -826,7 +947,7 @@ namespace vigra
     {
         ImageImportInfo info(name);
         image.reshape(info.shape());
-        importImage(info, destImage(image));
+        detail::import_image_view(info, image);
     }
 
     template <class T, class A>
@@ -37,6 +37,7 @@
 #define VIGRA_LABELVOLUME_HXX
 
 
+#include <iostream>
 #include "voxelneighborhood.hxx"
 #include "multi_array.hxx"
 #include "union_find.hxx"
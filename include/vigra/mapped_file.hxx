@@ -0,0 +1,180 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_MAPPED_FILE_HXX
+#define VIGRA_MAPPED_FILE_HXX
+
+#include <string>
+#include <cstddef>
+#include "config.hxx"
+#include "error.hxx"
+
+#ifdef _WIN32
+# include "windows.h"
+#else
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+#endif
+
+namespace vigra {
+
+/** \brief Memory mapping of an entire file.
+
+    The pages of the file are loaded on demand when they are first accessed.
+    In mode <tt>MappedFile::ReadOnly</tt> (the default), the mapping is shared, 
+    so that all processes mapping the same file share the physical pages. 
+    In mode <tt>MappedFile::CopyOnWrite</tt>, the mapping is writable, but 
+    modifications only affect private copies of the touched pages and are 
+    never written back to the file.
+
+    Throws a <tt>PreconditionViolation</tt> if the file cannot be opened, and a
+    <tt>PostconditionViolation</tt> if it cannot be mapped (e.g. because it is empty).
+
+    <b>\#include</b> \<vigra/mapped_file.hxx\> <br/>
+    Namespace: vigra
+*/
+class MappedFile
+{
+  public:
+        /** Access mode of the mapping.
+         */
+    enum Mode { ReadOnly, CopyOnWrite };
+
+        /** Map the file \a filename into memory.
+         */
+    explicit MappedFile(std::string const & filename, Mode mode = ReadOnly)
+    : data_(0),
+      size_(0),
+      mode_(mode)
+    {
+        std::string message("MappedFile(): Unable to open file '" + filename + "'.");
+#ifdef _WIN32
+        HANDLE file = ::CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                    NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        vigra_precondition(file != INVALID_HANDLE_VALUE, message);
+        LARGE_INTEGER size;
+        if(!::GetFileSizeEx(file, &size))
+        {
+            ::CloseHandle(file);
+            vigra_fail("MappedFile(): unable to determine file size.");
+        }
+        size_ = (std::size_t)size.QuadPart;
+        HANDLE mapping = size_ > 0
+                            ? ::CreateFileMapping(file, NULL, 
+                                   mode == ReadOnly ? PAGE_READONLY : PAGE_WRITECOPY, 0, 0, NULL)
+                            : NULL;
+        // the view remains valid after the handles have been closed
+        ::CloseHandle(file);
+        vigra_postcondition(mapping != NULL, "MappedFile(): CreateFileMapping() failed.");
+        data_ = (char *)::MapViewOfFile(mapping, 
+                                        mode == ReadOnly ? FILE_MAP_READ : FILE_MAP_COPY, 0, 0, 0);
+        ::CloseHandle(mapping);
+        vigra_postcondition(data_ != NULL, "MappedFile(): MapViewOfFile() failed.");
+#else
+        int file = ::open(filename.c_str(), O_RDONLY);
+        vigra_precondition(file != -1, message);
+        struct stat info;
+        if(::fstat(file, &info) == -1)
+        {
+            ::close(file);
+            vigra_fail("MappedFile(): unable to determine file size.");
+        }
+        size_ = (std::size_t)info.st_size;
+        void * data = size_ > 0
+                         ? (mode == ReadOnly
+                               ? ::mmap(0, size_, PROT_READ, MAP_SHARED, file, 0)
+                               : ::mmap(0, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0))
+                         : MAP_FAILED;
+        // the mapping remains valid after the descriptor has been closed
+        ::close(file);
+        vigra_postcondition(data != MAP_FAILED, "MappedFile(): mmap() failed.");
+        data_ = (char *)data;
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        ::UnmapViewOfFile(data_);
+#else
+        ::munmap(data_, size_);
+#endif
+    }
+
+        /** Pointer to the first byte of the file.
+         */
+    char const * data() const
+    {
+        return data_;
+    }
+
+        /** Writable pointer to the first byte of the file (only 
+            in mode <tt>MappedFile::CopyOnWrite</tt>).
+         */
+    char * writableData() const
+    {
+        vigra_precondition(mode_ == CopyOnWrite,
+            "MappedFile::writableData(): the file is mapped read-only.");
+        return data_;
+    }
+
+        /** Size of the file in bytes.
+         */
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+        /** Access mode of the mapping.
+         */
+    Mode mode() const
+    {
+        return mode_;
+    }
+
+  private:
+    MappedFile(MappedFile const &);
+    MappedFile & operator=(MappedFile const &);
+
+    char * data_;
+    std::size_t size_;
+    Mode mode_;
+};
+
+} // namespace vigra
+
+#endif // VIGRA_MAPPED_FILE_HXX
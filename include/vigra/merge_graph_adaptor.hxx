@@ -1159,23 +1159,17 @@ void MergeGraphAdaptor<GRAPH>::contractEdge(
                 const index_type edgeR  = edgeUfd_.find(edgeA);
                 const index_type edgeNR = edgeR==edgeA ? edgeB : edgeA; 
 
-                nodeVector_[adjToDeadNodeId].eraseFromAdjacency(notNewNodeRep);
+                // remove the dead node and update the edge to newNodeRep in place
+                nodeVector_[adjToDeadNodeId].replaceInAdjacency(notNewNodeRep,newNodeRep,edgeR);
 
-                // refactor me ... this DOES NOT change the key
-                nodeVector_[adjToDeadNodeId].eraseFromAdjacency(newNodeRep);
-                nodeVector_[adjToDeadNodeId].insert(newNodeRep,edgeR);
-
-                // refactor me .. this DOES NOT change the key
-                nodeVector_[newNodeRep].eraseFromAdjacency(adjToDeadNodeId);
-                nodeVector_[newNodeRep].insert(adjToDeadNodeId,edgeR);
+                // this DOES NOT change the key
+                nodeVector_[newNodeRep].replaceInAdjacency(adjToDeadNodeId,adjToDeadNodeId,edgeR);
 
                 doubleEdges_[nDoubleEdges_]=std::pair<index_type,index_type>(edgeR,edgeNR );
                 ++nDoubleEdges_;
             }
             else{
-                nodeVector_[adjToDeadNodeId].eraseFromAdjacency(notNewNodeRep);
-                //nodeVector_[adjToDeadNodeId].eraseFromAdjacency(newNodeRep);
-                nodeVector_[adjToDeadNodeId].insert(newNodeRep,iter->edgeId());
+                nodeVector_[adjToDeadNodeId].replaceInAdjacency(notNewNodeRep,newNodeRep,iter->edgeId());
 
                 // symetric
                 //nodeVector_[newNodeRep].eraseFromAdjacency(adjToDeadNodeId);
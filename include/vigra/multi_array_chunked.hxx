@@ -1923,6 +1923,48 @@ class ChunkedArray
         return view;
     }
     
+        /** Load the chunk with the given index and return a view to its memory
+            (no data are copied). The chunk is pinned, i.e. it remains in memory
+            and the view remains valid until a matching <tt>unpinChunk()</tt>.
+            Pinned chunks are never evicted from the cache, so pins should be
+            short-lived.
+
+            When <tt>isConst</tt> is true, the view must only be read. This is
+            required for read-only arrays. A chunk that has never been written
+            is then not allocated, and the view refers to the fill value instead
+            (all its strides are zero).
+        */
+    MultiArrayView<N, T, StridedArrayTag>
+    pinChunk(shape_type const & chunk_index, bool isConst = false)
+    {
+        vigra_precondition(allLessEqual(shape_type(), chunk_index) &&
+                           allLess(chunk_index, chunkArrayShape()),
+            "ChunkedArray::pinChunk(): chunk index out of bounds.");
+        vigra_precondition(isConst || !this->isReadOnly(),
+            "ChunkedArray::pinChunk(): array is read-only.");
+        Handle * handle = lookupHandle(chunk_index);
+        if(isConst && handle->chunk_state_.load() == chunk_uninitialized)
+            return MultiArrayView<N, T, StridedArrayTag>(chunkShape(chunk_index),
+                                                         shape_type(), &fill_value_);
+        pointer p = getChunk(handle, isConst, true, chunk_index);
+        return MultiArrayView<N, T, StridedArrayTag>(chunkShape(chunk_index),
+                                                     handle->strides(), p);
+    }
+
+        /** Release a chunk pinned by <tt>pinChunk(chunk_index, isConst)</tt>.
+            <tt>data</tt> must be the data pointer of the view returned by
+            <tt>pinChunk()</tt>.
+        */
+    void unpinChunk(shape_type const & chunk_index, const_pointer data)
+    {
+        vigra_precondition(allLessEqual(shape_type(), chunk_index) &&
+                           allLess(chunk_index, chunkArrayShape()),
+            "ChunkedArray::unpinChunk(): chunk index out of bounds.");
+        if(data == &fill_value_)
+            return;  // read-only pin of an uninitialized chunk
+        unrefChunk(lookupHandle(chunk_index));
+    }
+
     value_type getItem(shape_type const & point) const
     {
         vigra_precondition(this->isInside(point),
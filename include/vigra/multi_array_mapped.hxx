@@ -0,0 +1,238 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_MULTI_ARRAY_MAPPED_HXX
+#define VIGRA_MULTI_ARRAY_MAPPED_HXX
+
+#include <string>
+#include <memory>
+#include <cstring>
+#include "config.hxx"
+#include "error.hxx"
+#include "codec.hxx"
+#include "imageinfo.hxx"
+#include "multi_array.hxx"
+#include "multi_impex.hxx"
+#include "mapped_file.hxx"
+
+namespace vigra {
+
+/** \addtogroup VolumeImpex
+*/
+//@{
+
+/** \brief MultiArrayView onto the uncompressed data of a memory-mapped file.
+
+    The array keeps the file mapped for as long as it (or a copy of it) exists.
+    Copies are shallow, i.e. all copies refer to the same mapping. Since the
+    operating system loads the pages on first access, creating the array takes
+    constant time regardless of the file size.
+
+    If the data are stored in non-native byte order, the constructor swaps the bytes
+    in place. Likewise, if the data don't start at a multiple of <tt>sizeof(T)</tt>
+    (e.g. 16-bit PNM files whose header has odd length), the constructor moves them
+    to the preceding aligned position. This touches all pages and converts them 
+    into private copies, so the file itself remains unchanged, but the advantage 
+    of lazy loading is lost.
+
+    <b>\#include</b> \<vigra/multi_array_mapped.hxx\> <br/>
+    Namespace: vigra
+*/
+template <unsigned int N, class T>
+class MappedMultiArray
+: public MultiArrayView<N, T, StridedArrayTag>
+{
+  public:
+    typedef MultiArrayView<N, T, StridedArrayTag> view_type;
+    typedef typename view_type::difference_type   difference_type;
+
+        /** Create an empty array.
+         */
+    MappedMultiArray()
+    {}
+
+        /** Map the file \a filename and create a view with the given \a shape and \a stride
+            (in units of <tt>T</tt>) whose first element is located at byte position
+            \a offset of the file. \a byteOrder is either "little endian" or "big endian"
+            (default: the byte order of the host). Negative strides are not supported.
+         */
+    MappedMultiArray(std::string const & filename,
+                     difference_type const & shape, difference_type const & stride,
+                     std::size_t offset = 0, std::string const & byteOrder = "")
+    : view_type(),
+      file_(new MappedFile(filename, MappedFile::CopyOnWrite))
+    {
+        std::size_t last = 0;
+        for(unsigned int k = 0; k < N; ++k)
+        {
+            vigra_precondition(shape[k] > 0 && stride[k] >= 0,
+                "MappedMultiArray(): shape must be positive and strides non-negative.");
+            last += (shape[k] - 1) * stride[k];
+        }
+        vigra_precondition(offset + (last + 1)*sizeof(T) <= file_->size(),
+            "MappedMultiArray(): file '" + filename + "' is too small for the requested array.");
+
+        char * data = file_->writableData();
+        if(offset % sizeof(T) != 0)
+        {
+            // move the data to the preceding aligned position
+            std::size_t aligned = offset - offset % sizeof(T);
+            std::memmove(data + aligned, data + offset, (last + 1)*sizeof(T));
+            offset = aligned;
+        }
+
+        this->m_shape = shape;
+        this->m_stride = stride;
+        this->m_ptr = reinterpret_cast<T *>(data + offset);
+
+        if(sizeof(T) > 1 && byteOrder != "" && !detail::isHostByteOrder(byteOrder))
+        {
+            typename view_type::iterator i = this->begin(), end = this->end();
+            for(; i != end; ++i)
+                detail::swapBytes(*i);
+        }
+    }
+
+    MappedMultiArray(MappedMultiArray const & rhs)
+    : view_type(rhs),
+      file_(rhs.file_)
+    {}
+
+        /** Make this array refer to the same mapping as \a rhs (no data are copied).
+         */
+    MappedMultiArray & operator=(MappedMultiArray const & rhs)
+    {
+        this->m_shape = rhs.m_shape;
+        this->m_stride = rhs.m_stride;
+        this->m_ptr = rhs.m_ptr;
+        file_ = rhs.file_;
+        return *this;
+    }
+
+        /** The underlying file mapping (may be empty).
+         */
+    VIGRA_SHARED_PTR<MappedFile> const & mappedFile() const
+    {
+        return file_;
+    }
+
+  private:
+    VIGRA_SHARED_PTR<MappedFile> file_;
+};
+
+/** \brief Map the pixel data of an uncompressed image file into memory.
+
+    This works for file formats that store the pixels uncompressed, currently
+    raw PNM (P5 and P6) and VIFF files without color map. The result is a
+    3-dimensional array of shape <tt>(width, height, numBands)</tt> that refers
+    directly to the mapped file, i.e. no pixel data are read until they are accessed.
+    The \a value_type <tt>T</tt> must be a scalar type matching the file's
+    pixel type exactly. For all other files, use \ref importImage().
+    When the pixel data are not aligned to <tt>sizeof(T)</tt> in the file, or are
+    stored in non-native byte order, they are read completely when the file is
+    mapped (see \ref MappedMultiArray).
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_array_mapped.hxx\> <br/>
+    Namespace: vigra
+
+    \code
+    ImageImportInfo info("image.pgm");
+    MappedMultiArray<3, UInt8> mapped = mapImage<UInt8>(info);
+    MultiArrayView<2, UInt8, StridedArrayTag> image = mapped.bindOuter(0);
+    \endcode
+*/
+template <class T>
+MappedMultiArray<3, T>
+mapImage(ImageImportInfo const & info)
+{
+    vigra_precondition(TypeAsString<T>::result() == info.getPixelType(),
+        "mapImage(): value_type doesn't match the file's pixel type.");
+
+    VIGRA_UNIQUE_PTR<Decoder> dec(decoder(info));
+    std::size_t offset = 0;
+    std::ptrdiff_t pixelStride = 0, rowStride = 0, bandStride = 0;
+    std::string byteOrder;
+    bool isRaw = dec->getRawDataLayout(offset, pixelStride, rowStride, bandStride, byteOrder);
+    dec->abort();
+    vigra_precondition(isRaw,
+        "mapImage(): file format doesn't store the pixels uncompressed, use importImage().");
+
+    typedef typename MappedMultiArray<3, T>::difference_type Shape;
+    return MappedMultiArray<3, T>(info.getFileName(),
+                                  Shape(info.width(), info.height(), info.numBands()),
+                                  Shape(pixelStride, rowStride, bandStride),
+                                  offset, byteOrder);
+}
+
+/** \brief Map the data of a raw volume into memory.
+
+    This works for volumes described by a ".info" file (file type "RAW", see
+    \ref VolumeImportInfo). The result refers directly to the mapped raw data file,
+    i.e. opening the volume takes constant time, and no data are read until they
+    are accessed. The \a value_type <tt>T</tt> must match the volume's pixel type
+    exactly. For all other volume formats, use \ref importVolume().
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_array_mapped.hxx\> <br/>
+    Namespace: vigra
+
+    \code
+    VolumeImportInfo info("volume.info");
+    MappedMultiArray<3, UInt16> volume = mapVolume<UInt16>(info);
+    \endcode
+*/
+template <class T>
+MappedMultiArray<3, T>
+mapVolume(VolumeImportInfo const & info)
+{
+    vigra_precondition(std::string(info.getFileType()) == "RAW",
+        "mapVolume(): only raw volumes (described by a .info file) can be mapped.");
+    vigra_precondition(TypeAsString<T>::result() == info.getPixelType(),
+        "mapVolume(): value_type doesn't match the volume's pixel type.");
+
+    typedef typename MappedMultiArray<3, T>::difference_type Shape;
+    Shape shape(info.shape());
+    return MappedMultiArray<3, T>(info.getRawFilename(), shape,
+                                  detail::defaultStride(shape), 0, info.getByteOrder());
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_ARRAY_MAPPED_HXX
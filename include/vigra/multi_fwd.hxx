@@ -136,6 +136,9 @@ class ChunkedArrayBase;
 template <unsigned int N, class T>
 class ChunkedArray;
 
+template <class T>
+struct ExpandElementResult;
+
 /********************************************************/
 /*                                                      */
 /*                iterators / traversers                */
@@ -38,6 +38,7 @@
 #define VIGRA_MULTI_IMPEX_HXX
 
 #include <memory>
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 #include <iostream>
@@ -49,6 +50,7 @@
 #include "impex.hxx"
 #include "multi_array.hxx"
 #include "multi_pointoperators.hxx"
+#include "parallel_foreach.hxx"
 #include "sifImport.hxx"
 
 #ifdef _MSC_VER
@@ -106,6 +108,7 @@ class VolumeImportInfo
                 <li> height = [positive integer] (required)
                 <li> depth = [positive integer] (required)
                 <li> datatype = [ UINT8 | INT16 | UINT16 | INT32 | UINT32 | FLOAT | DOUBLE ] (required)
+                <li> byteorder = [ little endian | big endian ] (optional, default: byte order of the host)
                 </UL>
                 Lines starting with "#" are ignored. To read the data correctly, the 
                 value_type of the target MultiArray must match the datatype stored in the file. 
@@ -222,8 +225,29 @@ class VolumeImportInfo
 
     VIGRA_EXPORT const std::string &description() const;
 
+        /** Get the full path of the raw data file belonging to a ".info" file.
+
+            Returns an empty string unless getFileType() is "RAW".
+         */
+    VIGRA_EXPORT std::string getRawFilename() const;
+
+        /** Get the byte order of the raw data file ("little endian" or "big endian").
+
+            This is the byte order given in the ".info" file, or the byte order
+            of the host if the file doesn't specify one.
+         */
+    VIGRA_EXPORT const std::string &getByteOrder() const;
+
+        /** Read the volume data into \a volume.
+
+            Image stacks and multi-page files are decoded slice by slice. Since the
+            slices are independent, they can be decoded by up to
+            <tt>options.getActualNumThreads()</tt> threads in parallel, each writing
+            directly into its own slice of \a volume. By default, a single thread is used.
+         */
     template <class T, class Stride>
-    void importImpl(MultiArrayView <3, T, Stride> &volume) const;
+    void importImpl(MultiArrayView <3, T, Stride> &volume,
+                    ParallelOptions const & options = ParallelOptions().numThreads(1)) const;
 
   protected:
     void getVolumeInfoFromFirstSlice(const std::string &filename);
@@ -235,7 +259,7 @@ class VolumeImportInfo
 
     std::string path_, name_, description_, fileType_, pixelType_;
 
-    std::string rawFilename_;
+    std::string rawFilename_, byteOrder_;
     std::string baseName_, extension_;
     std::vector<std::string> numbers_;
 };
@@ -459,11 +483,33 @@ class VolumeExportInfo
 
 namespace detail {
 
+    // check if the given byte order ("little endian" or "big endian")
+    // is the byte order of the host
+inline bool
+isHostByteOrder(std::string const & byteOrder)
+{
+    const UInt16 one = 1;
+    const bool littleEndian = *reinterpret_cast<const UInt8 *>(&one) == 1;
+    return byteOrder == (littleEndian ? "little endian" : "big endian");
+}
+
+template <class T>
+inline void
+swapBytes(T & x)
+{
+    UInt8 * c = reinterpret_cast<UInt8 *>(&x);
+    std::reverse(c, c + sizeof(T));
+}
+
 template <class DestIterator, class Shape, class T>
 inline void
-readVolumeImpl(DestIterator d, Shape const & shape, std::ifstream & s, ArrayVector<T> & buffer, MetaInt<0>)
+readVolumeImpl(DestIterator d, Shape const & shape, std::ifstream & s, ArrayVector<T> & buffer,
+               bool swap, MetaInt<0>)
 {
     s.read((char*)buffer.begin(), shape[0]*sizeof(T));
+    if(swap)
+        for(MultiArrayIndex k = 0; k < shape[0]; ++k)
+            swapBytes(buffer[k]);
 
     DestIterator dend = d + shape[0];
     int k = 0;
@@ -475,19 +521,73 @@ readVolumeImpl(DestIterator d, Shape const & shape, std::ifstream & s, ArrayVect
 
 template <class DestIterator, class Shape, class T, int N>
 void
-readVolumeImpl(DestIterator d, Shape const & shape, std::ifstream & s, ArrayVector<T> & buffer, MetaInt<N>)
+readVolumeImpl(DestIterator d, Shape const & shape, std::ifstream & s, ArrayVector<T> & buffer,
+               bool swap, MetaInt<N>)
 {
     DestIterator dend = d + shape[N];
     for(; d < dend; ++d)
     {
-        readVolumeImpl(d.begin(), shape, s, buffer, MetaInt<N-1>());
+        readVolumeImpl(d.begin(), shape, s, buffer, swap, MetaInt<N-1>());
     }
 }
 
+    // import slice 'i' of an image stack (called by parallel_foreach())
+template <class T, class Stride>
+struct ImportStackSliceFunctor
+{
+    ImportStackSliceFunctor(std::string const & baseName, 
+                            std::vector<std::string> const & numbers,
+                            std::string const & extension,
+                            MultiArrayView <3, T, Stride> & volume)
+    : baseName_(baseName), numbers_(numbers), extension_(extension), volume_(volume)
+    {}
+
+    void operator()(int /* threadId */, MultiArrayIndex i) const
+    {
+        // build the filename
+        std::string filename = baseName_ + numbers_[i] + extension_;
+
+        // import the image
+        ImageImportInfo info (filename.c_str ());
+
+        // generate a basic image view to the current layer
+        MultiArrayView <2, T, Stride> view (volume_.bindOuter (i));
+        vigra_precondition(view.shape() == info.shape(),
+            "importVolume(): the images have inconsistent sizes.");
+
+        importImage (info, destImage(view));
+    }
+
+    std::string const & baseName_;
+    std::vector<std::string> const & numbers_;
+    std::string const & extension_;
+    MultiArrayView <3, T, Stride> & volume_;
+};
+
+    // import page 'k' of a multi-page file (called by parallel_foreach())
+template <class T, class Stride>
+struct ImportMultipageSliceFunctor
+{
+    ImportMultipageSliceFunctor(std::string const & filename, 
+                                MultiArrayView <3, T, Stride> & volume)
+    : filename_(filename), volume_(volume)
+    {}
+
+    void operator()(int /* threadId */, MultiArrayIndex k) const
+    {
+        ImageImportInfo info(filename_.c_str(), (unsigned int)k);
+        importImage(info, volume_.bindOuter(k));
+    }
+
+    std::string const & filename_;
+    MultiArrayView <3, T, Stride> & volume_;
+};
+
 } // namespace detail
 
 template <class T, class Stride>
-void VolumeImportInfo::importImpl(MultiArrayView <3, T, Stride> &volume) const
+void VolumeImportInfo::importImpl(MultiArrayView <3, T, Stride> &volume,
+                                  ParallelOptions const & options) const
 {
     vigra_precondition(this->shape() == volume.shape(), "importVolume(): Output array must be shaped according to VolumeImportInfo.");
 
@@ -524,7 +624,9 @@ void VolumeImportInfo::importImpl(MultiArrayView <3, T, Stride> &volume) const
         vigra_precondition(s.good(), "RAW file could not be opened");
 
         ArrayVector<T> buffer(shape_[0]);
-        detail::readVolumeImpl(volume.traverser_begin(), shape_, s, buffer, vigra::MetaInt<2>());
+        detail::readVolumeImpl(volume.traverser_begin(), shape_, s, buffer,
+                               sizeof(T) > 1 && !detail::isHostByteOrder(byteOrder_),
+                               vigra::MetaInt<2>());
 
         //vigra_precondition(s.good(), "RAW file could not be opened");
         //s.read((char*)volume.data(), shape_[0]*shape_[1]*shape_[2]*sizeof(T));
@@ -542,31 +644,16 @@ void VolumeImportInfo::importImpl(MultiArrayView <3, T, Stride> &volume) const
     }
     else if(fileType_ == "STACK")
     {
-        for (unsigned int i = 0; i < numbers_.size(); ++i)
-        {
-            // build the filename
-            std::string filename = baseName_ + numbers_[i] + extension_;
-
-            // import the image
-            ImageImportInfo info (filename.c_str ());
-
-            // generate a basic image view to the current layer
-            MultiArrayView <2, T, Stride> view (volume.bindOuter (i));
-            vigra_precondition(view.shape() == info.shape(),
-                "importVolume(): the images have inconsistent sizes.");
-
-            importImage (info, destImage(view));
-        }
+        // the slices are decoded independently, each into its own layer
+        parallel_foreach(options.getActualNumThreads(), numbers_.size(),
+            detail::ImportStackSliceFunctor<T, Stride>(baseName_, numbers_, extension_, volume));
     }
     else if(fileType_ == "MULTIPAGE")
     {
-        ImageImportInfo info(baseName_.c_str());
-
-        for(int k=0; k<info.numImages(); ++k)
-        {
-            info.setImageIndex(k);
-            importImage(info, volume.bindOuter(k));
-        }
+        // every thread opens the file on its own, so the
+        // decoders don't share any state
+        parallel_foreach(options.getActualNumThreads(), shape_[2],
+            detail::ImportMultipageSliceFunctor<T, Stride>(baseName_, volume));
     }
     // else if(fileType_ == "HDF5")
     // {
@@ -598,10 +685,13 @@ VIGRA_EXPORT void findImageSequence(const std::string &name_base,
     \code
     namespace vigra {
         // variant 1: read data specified by the given VolumeImportInfo object
+        // image stacks and multi-page files are decoded in parallel
+        // if 'options' requests more than one thread
         template <class T, class Stride>
         void 
         importVolume(VolumeImportInfo const & info, 
-                     MultiArrayView <3, T, Stride> &volume);
+                     MultiArrayView <3, T, Stride> &volume,
+                     ParallelOptions const & options = ParallelOptions().numThreads(1));
                      
         // variant 2: read data using a single filename, resize volume automatically
         template <class T, class Allocator>
@@ -656,20 +746,29 @@ VIGRA_EXPORT void findImageSequence(const std::string &name_base,
     VolumeImportInfo info("my_data", ".png");  // looks for files 'my_data0.png', 'my_data1.png' etc.
     MultiArray<3, float> volume(info.shape());
     importVolume(info, volume);
+    
+    // the same, but decode the slices on all cores
+    importVolume(info, volume, ParallelOptions());
     \endcode
     Notice that slice numbers in a stack need not be consecutive (i.e. gaps are allowed) and 
     will be interpreted according to their numerical order (i.e. "009", "010", "011" 
     are read in the same order as "9", "10", "11"). The number of images
     found determines the depth of the volume.
+    
+    Parallel decoding is opt-in: importVolume() is often called from code that already 
+    runs in several threads (e.g. one volume per worker), where additional decoder 
+    threads would only oversubscribe the machine. When threading is unavailable, 
+    the slices are always decoded sequentially.
 */
 doxygen_overloaded_function(template <...> void importVolume)
 
 template <class T, class Stride>
 void 
 importVolume(VolumeImportInfo const & info, 
-             MultiArrayView <3, T, Stride> &volume)
+             MultiArrayView <3, T, Stride> &volume,
+             ParallelOptions const & options = ParallelOptions().numThreads(1))
 {
-    info.importImpl(volume);
+    info.importImpl(volume, options);
 }
 
 template <class T, class Allocator>
@@ -220,21 +220,70 @@ generateWatershedSeeds(Graph const & g,
 }
 
 
-template <class Graph, class T1Map, class T2Map>
+    // priorities for the heap-based queue: the (biased) costs themselves
+template <class CostType>
+struct WatershedHeapPriority
+{
+    typedef CostType priority_type;
+
+    template <class T>
+    priority_type operator()(T cost) const
+    {
+        return static_cast<priority_type>(cost);
+    }
+
+    bool exceeds(priority_type priority, double threshold) const
+    {
+        return priority > threshold;
+    }
+};
+
+    // priorities for the bucket queue: costs are mapped linearly onto
+    // the bucket indices [0, ..., bucket_count-1]
+struct WatershedBucketPriority
+{
+    typedef std::ptrdiff_t priority_type;
+
+    WatershedBucketPriority(double offset, double scale, priority_type bucket_count)
+    : offset_(offset),
+      scale_(scale),
+      max_index_(bucket_count - 1)
+    {}
+
+    priority_type operator()(double cost) const
+    {
+        double index = std::floor((cost - offset_)*scale_);
+        return index <= 0.0
+                   ? 0
+                   : index >= max_index_
+                       ? max_index_
+                       : (priority_type)index;
+    }
+
+    bool exceeds(priority_type priority, double threshold) const
+    {
+        return priority > std::floor((threshold - offset_)*scale_);
+    }
+
+    double offset_, scale_;
+    priority_type max_index_;
+};
+
+template <class Graph, class T1Map, class T2Map, class Queue, class PriorityFunctor>
 typename T2Map::value_type 
-seededWatersheds(Graph const & g, 
-                 T1Map const & data,
-                 T2Map & labels,
-                 WatershedOptions const & options)
+seededWatershedsImpl(Graph const & g, 
+                     T1Map const & data,
+                     T2Map & labels,
+                     WatershedOptions const & options,
+                     Queue & pqueue,
+                     PriorityFunctor const & priorityOf)
 {
     typedef typename Graph::Node        Node;
     typedef typename Graph::NodeIt      graph_scanner;
     typedef typename Graph::OutArcIt    neighbor_iterator;
-    typedef typename T1Map::value_type  CostType;
+    typedef typename PriorityFunctor::priority_type  CostType;
     typedef typename T2Map::value_type  LabelType;
 
-    PriorityQueue<Node, CostType, true> pqueue;
-    
     bool keepContours = ((options.terminate & KeepContours) != 0);
     LabelType maxRegionLabel = 0;
     
@@ -252,9 +301,9 @@ seededWatersheds(Graph const & g,
                 {
                     // register all seeds that have an unlabeled neighbor
                     if(label == options.biased_label)
-                        pqueue.push(*node, data[*node] * options.bias);
+                        pqueue.push(*node, priorityOf(data[*node] * options.bias));
                     else
-                        pqueue.push(*node, data[*node]);
+                        pqueue.push(*node, priorityOf(data[*node]));
                     break;
                 }
             }
@@ -270,7 +319,7 @@ seededWatersheds(Graph const & g,
         CostType cost = pqueue.topPriority();
         pqueue.pop();
         
-        if((options.terminate & StopAtThreshold) && (cost > options.max_cost))
+        if((options.terminate & StopAtThreshold) && priorityOf.exceeds(cost, options.max_cost))
             break;
 
         LabelType label = labels[node];
@@ -286,8 +335,8 @@ seededWatersheds(Graph const & g,
             {
                 labels[g.target(*arc)] = label;
                 CostType priority = (label == options.biased_label)
-                                       ? data[g.target(*arc)] * options.bias
-                                       : data[g.target(*arc)];
+                                       ? priorityOf(data[g.target(*arc)] * options.bias)
+                                       : priorityOf(data[g.target(*arc)]);
                 if(priority < cost)
                     priority = cost;
                 pqueue.push(g.target(*arc), priority);
@@ -297,8 +346,8 @@ seededWatersheds(Graph const & g,
                 // The present neighbor is adjacent to more than one region
                 // => mark it as contour.
                 CostType priority = (neighborLabel == options.biased_label)
-                                       ? data[g.target(*arc)] * options.bias
-                                       : data[g.target(*arc)];
+                                       ? priorityOf(data[g.target(*arc)] * options.bias)
+                                       : priorityOf(data[g.target(*arc)]);
                 if(cost < priority) // neighbor not yet processed
                     labels[g.target(*arc)] = contourLabel;
             }
@@ -323,6 +372,99 @@ seededWatersheds(Graph const & g,
     return maxRegionLabel;
 }
 
+    // Determine whether the costs can be processed by a BucketQueue: integer costs 
+    // whose range fits into 2^16 buckets are mapped exactly (unless a non-integral 
+    // bias is applied), arbitrary costs are quantized linearly between their minimum 
+    // and maximum when a bucket count was requested via 
+    // WatershedOptions::turboAlgorithm(). Returns false if a heap should be used.
+    // Otherwise, 'exact' tells whether costs and buckets correspond one-to-one.
+template <class Graph, class T1Map>
+bool
+watershedBucketParameters(Graph const & g, 
+                          T1Map const & data,
+                          WatershedOptions const & options,
+                          double & offset, double & scale, std::ptrdiff_t & bucketCount,
+                          bool & exact)
+{
+    typedef typename Graph::NodeIt      graph_scanner;
+    typedef typename T1Map::value_type  CostType;
+
+    static const std::ptrdiff_t maxExactBucketCount = 1 << 16;
+    bool isIntegral = NumericTraits<CostType>::isIntegral::value;
+
+    if(!isIntegral && options.bucket_count == 0)
+        return false;
+
+    // determine the range of the (biased) costs
+    double minCost = std::numeric_limits<double>::max(),
+           maxCost = -std::numeric_limits<double>::max();
+    for (graph_scanner node(g); node != INVALID; ++node) 
+    {
+        double c = data[*node];
+        if(c < minCost)
+            minCost = c;
+        if(maxCost < c)
+            maxCost = c;
+    }
+    if(options.biased_label != 0 && minCost <= maxCost)
+    {
+        double c1 = minCost * options.bias,
+               c2 = maxCost * options.bias;
+        minCost = std::min(minCost, std::min(c1, c2));
+        maxCost = std::max(maxCost, std::max(c1, c2));
+        // biased costs are only integers if the bias is
+        if(options.bias != std::floor(options.bias))
+            isIntegral = false;
+    }
+    
+    if(isIntegral && minCost <= maxCost && 
+       std::floor(maxCost) - std::floor(minCost) < maxExactBucketCount)
+    {
+        offset = std::floor(minCost);
+        scale = 1.0;
+        bucketCount = (std::ptrdiff_t)(std::floor(maxCost) - offset) + 1;
+        exact = true;
+        return true;
+    }
+    else if(options.bucket_count > 0)
+    {
+        offset = minCost;
+        bucketCount = options.bucket_count;
+        scale = minCost < maxCost
+                   ? bucketCount / (maxCost - minCost)
+                   : 0.0;
+        exact = false;
+        return true;
+    }
+    return false;
+}
+
+    // Choose the priority queue according to the cost type (see watershedBucketParameters()).
+template <class Graph, class T1Map, class T2Map>
+typename T2Map::value_type 
+seededWatersheds(Graph const & g, 
+                 T1Map const & data,
+                 T2Map & labels,
+                 WatershedOptions const & options)
+{
+    typedef typename Graph::Node        Node;
+    typedef typename T1Map::value_type  CostType;
+
+    double offset, scale;
+    std::ptrdiff_t bucketCount;
+    bool exact;
+    if(watershedBucketParameters(g, data, options, offset, scale, bucketCount, exact))
+    {
+        BucketQueue<Node, true> pqueue(bucketCount);
+        return seededWatershedsImpl(g, data, labels, options, pqueue,
+                   WatershedBucketPriority(offset, scale, bucketCount));
+    }
+    
+    PriorityQueue<Node, CostType, true> pqueue;
+    return seededWatershedsImpl(g, data, labels, options, pqueue,
+                                WatershedHeapPriority<CostType>());
+}
+
 } // namespace graph_detail
 
 template <class Graph, class T1Map, class T2Map>
@@ -439,8 +581,16 @@ generateWatershedSeeds(MultiArrayView<N, T, S1> const & data,
          with a given factor (smaller than 1 for preference, larger than 1 for discouragement).
     </ul>
     
-    The option <tt>turboAlgorithm()</tt> is implied by method <tt>regionGrowing()</tt> (this is
-    in contrast to watershedsRegionGrowing(), which supports an additional algorithm in 2D only).
+    The region growing algorithm chooses its priority queue automatically: when \a data
+    contains integers (e.g. <tt>UInt8</tt> or <tt>UInt16</tt>) whose range spans at most
+    65536 values, a \ref BucketQueue is used, which has constant-time push and pop and gives
+    the same result as the general algorithm (up to tie breaking). Otherwise, a heap-based
+    queue is used, unless you call <tt>turboAlgorithm(bucket_count)</tt>: then, the costs are
+    linearly quantized into <tt>bucket_count</tt> levels between their minimum and maximum,
+    and a BucketQueue is used as well. This is much faster for large volumes, but costs that
+    fall into the same level are treated as equal (this is in contrast to
+    watershedsRegionGrowing(), where the turbo algorithm requires the data to be integers in
+    the range <tt>[0, ..., bucket_count-1]</tt>).
 
     watershedsMultiArray() returns the number of regions found (= the highest region label, because 
     labels start at 1). 
@@ -0,0 +1,237 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2013-2014 by Ullrich Koethe                  */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_PARALLEL_FOREACH_HXX
+#define VIGRA_PARALLEL_FOREACH_HXX
+
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include "config.hxx"
+#include "multi_fwd.hxx"
+
+    // run sequentially when threading is switched off or unavailable, so
+    // that headers with parallel algorithms compile on every platform
+#if defined(VIGRA_SINGLE_THREADED) || \
+    (defined(VIGRA_NO_STD_THREADING) && !defined(USE_BOOST_THREAD))
+#  define VIGRA_PARALLEL_FOREACH_SEQUENTIAL
+#else
+#  include "threading.hxx"
+#endif
+
+namespace vigra {
+
+/** \brief Option object for parallel algorithms.
+
+    <b>\#include</b> \<vigra/parallel_foreach.hxx\><br/>
+    Namespace: vigra
+*/
+class ParallelOptions
+{
+  public:
+
+        /** Constants for special settings.
+        */
+    enum {
+        Auto       = -1, ///< Determine number of threads automatically (from <tt>threading::thread::hardware_concurrency()</tt>)
+        Nice       = -2, ///< Use half as many threads as <tt>Auto</tt> would.
+        NoThreads  =  0  ///< Switch off multi-threading (i.e. execute tasks sequentially)
+    };
+
+    ParallelOptions()
+    :   numThreads_(actualNumThreads(Auto))
+    {}
+
+        /** \brief Get desired number of threads.
+
+            <b>Note:</b> This function may return 0, which means that multi-threading
+            shall be switched off entirely. If an algorithm receives this value,
+            it should revert to a sequential implementation.
+        */
+    int getNumThreads() const
+    {
+        return numThreads_;
+    }
+
+        /** \brief Get desired number of threads.
+
+            In contrast to <tt>getNumThreads()</tt>, this will always return a value <tt>>=1</tt>.
+        */
+    int getActualNumThreads() const
+    {
+        return std::max(1, numThreads_);
+    }
+
+        /** \brief Set the number of threads or one of the constants <tt>Auto</tt>,
+                   <tt>Nice</tt> and <tt>NoThreads</tt>.
+
+            Default: <tt>ParallelOptions::Auto</tt> (use system default)
+        */
+    ParallelOptions & numThreads(const int n)
+    {
+        numThreads_ = actualNumThreads(n);
+        return *this;
+    }
+
+  private:
+        // helper function to compute the actual number of threads
+    static int actualNumThreads(const int userNThreads)
+    {
+#ifdef VIGRA_PARALLEL_FOREACH_SEQUENTIAL
+        return 0;
+#else
+        int hardware = (int)threading::thread::hardware_concurrency();
+        return userNThreads >= 0
+                   ? userNThreads
+                   : userNThreads == Nice
+                           ? hardware / 2
+                           : hardware;
+#endif
+    }
+
+    int numThreads_;
+};
+
+namespace detail {
+
+#ifndef VIGRA_PARALLEL_FOREACH_SEQUENTIAL
+
+template <class F>
+struct ParallelForeachWorker
+{
+    ParallelForeachWorker(F & f, threading::atomic_long & next, MultiArrayIndex count,
+                          std::exception_ptr & error, threading::mutex & errorLock,
+                          int threadId)
+    : f_(f), next_(next), count_(count), error_(error), errorLock_(errorLock),
+      threadId_(threadId)
+    {}
+
+    void operator()()
+    {
+        try
+        {
+            for(MultiArrayIndex i = next_.fetch_add(1); i < count_; i = next_.fetch_add(1))
+                f_(threadId_, i);
+        }
+        catch(...)
+        {
+            threading::lock_guard<threading::mutex> guard(errorLock_);
+            if(!error_)
+                error_ = std::current_exception();
+            // let the other threads run out of work
+            next_.store(count_);
+        }
+    }
+
+    F & f_;
+    threading::atomic_long & next_;
+    MultiArrayIndex count_;
+    std::exception_ptr & error_;
+    threading::mutex & errorLock_;
+    int threadId_;
+};
+
+#endif // VIGRA_PARALLEL_FOREACH_SEQUENTIAL
+
+} // namespace detail
+
+/** \brief Apply a functor to the indices <tt>0, ..., count-1</tt> in parallel.
+
+    The functor is called as <tt>f(threadId, i)</tt>, where <tt>threadId</tt>
+    is in <tt>[0, nThreads)</tt> and can be used to index per-thread
+    scratch data. Indices are handed out dynamically, i.e. there is no
+    guarantee which thread processes which index, and different indices may
+    be processed in any order. When <tt>nThreads <= 1</tt> (or
+    <tt>VIGRA_SINGLE_THREADED</tt> is defined), the indices are processed
+    sequentially in the calling thread with <tt>threadId == 0</tt>.
+    The same happens when the compiler supports neither <tt>std::thread</tt>
+    nor <tt>boost::thread</tt> (when <tt>USE_BOOST_THREAD</tt> is defined).
+
+    If the functor throws, the remaining indices are skipped, and the first
+    exception is re-thrown in the calling thread after all workers finished.
+
+    <b>\#include</b> \<vigra/parallel_foreach.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    struct BlockSummer
+    {
+        BlockSummer(std::vector<Block> const & blocks, std::vector<double> & sums)
+        : blocks_(blocks), sums_(sums)
+        {}
+
+        void operator()(const int threadId, const MultiArrayIndex k) const
+        {
+            sums_[threadId] += processBlock(blocks_[k]);
+        }
+
+        std::vector<Block> const & blocks_;
+        std::vector<double> & sums_;
+    };
+
+    std::vector<double> sums(options.getActualNumThreads(), 0.0);
+    parallel_foreach(options.getActualNumThreads(), blocks.size(),
+                     BlockSummer(blocks, sums));
+    \endcode
+*/
+template <class F>
+void parallel_foreach(int nThreads, MultiArrayIndex count, F f)
+{
+#ifndef VIGRA_PARALLEL_FOREACH_SEQUENTIAL
+    nThreads = (int)std::min<MultiArrayIndex>(nThreads, count);
+    if(nThreads > 1)
+    {
+        threading::atomic_long next(0);
+        threading::mutex errorLock;
+        std::exception_ptr error;
+        std::vector<threading::thread> workers;
+        workers.reserve(nThreads);
+        for(int k = 0; k < nThreads; ++k)
+            workers.push_back(threading::thread(
+                detail::ParallelForeachWorker<F>(f, next, count, error, errorLock, k)));
+        for(int k = 0; k < nThreads; ++k)
+            workers[k].join();
+        if(error)
+            std::rethrow_exception(error);
+        return;
+    }
+#endif
+    for(MultiArrayIndex i = 0; i < count; ++i)
+        f(0, i);
+}
+
+} // namespace vigra
+
+#endif // VIGRA_PARALLEL_FOREACH_HXX
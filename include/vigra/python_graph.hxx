@@ -765,6 +765,8 @@ public:
     WeightType contractionWeight()const{
         return boost::python::extract<WeightType>(object_.attr("contractionWeight")());
     }
+    void done(){
+    }
 
     MergeGraph & mergeGraph(){
         return mergeGraph_;
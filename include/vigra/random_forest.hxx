@@ -135,6 +135,12 @@ inline SamplerOptions make_sampler_opt ( RandomForestOptions     & RF_opt)
  *
  *  \endcode
  *
+ *  The feature matrix can have any scalar value type (e.g. <tt>float</tt>, 
+ *  <tt>UInt8</tt> or <tt>UInt16</tt>). Learning and prediction work directly
+ *  on the given view, so the features are never converted into a 
+ *  <tt>double</tt> matrix. Only the split thresholds, which are chosen halfway 
+ *  between adjacent feature values, are stored as <tt>double</tt>.
+ *
  *  Additional information such as Variable Importance measures are accessed
  *  via Visitors defined in rf::visitors. 
  *  Have a look at rf::split for other splitting methods.
@@ -670,6 +676,52 @@ class RandomForest
         predictProbabilities(features, prob, rf_default()); 
     }   
 
+    /** \brief predict the class probabilities of every pixel of a feature image
+     *
+     *  \param features an N-dimensional array whose last axis holds the 
+     *         features of each pixel (at least featureCount channels). 
+     *         The remaining N-1 axes are the spatial axes. 
+     *  \param prob an N-dimensional array of the same spatial shape whose
+     *         last axis has class_count() channels. It receives the class 
+     *         probabilities of each pixel.
+     *
+     *  This is equivalent to reshaping the features into a 
+     *  (pixels x featureCount) matrix and calling the matrix version,
+     *  but no such matrix is created: every scanline of the feature image
+     *  is itself a strided sample matrix and is passed to the trees as a view.
+     *  For one-dimensional data, use the matrix version directly.
+     */
+    template <unsigned int N, class U, class C1, class T, class C2>
+    void predictProbabilities(MultiArrayView<N, Multiband<U>, C1> const & features,
+                              MultiArrayView<N, Multiband<T>, C2>         prob) const;
+
+    /** \brief predict the class probabilities of every pixel of a vector-valued 
+     *  feature image
+     *
+     *  Same as above, but the features of each pixel are stored in a TinyVector.
+     *  \a prob must have one axis more than \a features, holding the classes.
+     */
+    template <unsigned int N, class U, int M, class C1, class T, class C2>
+    void predictProbabilities(MultiArrayView<N, TinyVector<U, M>, C1> const & features,
+                              MultiArrayView<N+1, Multiband<T>, C2>           prob) const
+    {
+        predictProbabilities(MultiArrayView<N+1, Multiband<U>, StridedArrayTag>(features.expandElements(N)),
+                             prob);
+    }
+
+    /** \brief predict the class probabilities of every pixel of a chunked
+     *  feature image
+     *
+     *  The last axis of \a features holds the features, the last axis of 
+     *  \a prob the class probabilities, as in the MultiArrayView version. 
+     *  The images are processed in blocks whose spatial shape equals the chunk 
+     *  shape of \a features, so that only one block of features and 
+     *  probabilities is held in memory at any time.
+     */
+    template <unsigned int N, class U, class T>
+    void predictProbabilities(ChunkedArray<N, U> const & features,
+                              ChunkedArray<N, T>       & prob) const;
+
     template <class U, class C1, class T, class C2>
     void predictRaw(MultiArrayView<2, U, C1>const &   features,
                     MultiArrayView<2, T, C2> &        prob)  const;
@@ -1312,6 +1364,84 @@ void RandomForest<LabelType, PreprocessorTag>
 
 }
 
+template <class LabelType, class PreprocessorTag>
+template <unsigned int N, class U, class C1, class T, class C2>
+void RandomForest<LabelType, PreprocessorTag>
+    ::predictProbabilities(MultiArrayView<N, Multiband<U>, C1> const & features,
+                           MultiArrayView<N, Multiband<T>, C2>         prob) const
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef typename MultiArrayShape<N-1>::type SpatialShape;
+
+    SpatialShape spatialShape(features.shape().template subarray<0, N-1>()),
+                 probSpatialShape(prob.shape().template subarray<0, N-1>());
+    vigra_precondition(spatialShape == probSpatialShape,
+      "RandomForest::predictProbabilities(): "
+        "Feature image and probability image have different spatial shapes.");
+
+    // iterate over the scanlines along the first spatial axis. 
+    // Each scanline is a (pixels x features) matrix view.
+    SpatialShape lines(spatialShape);
+    lines[0] = 1;
+    MultiCoordinateIterator<N-1> line(lines), end = line.getEndIterator();
+    for(; line != end; ++line)
+    {
+        Shape start;
+        start.template subarray<0, N-1>() = *line;
+
+        MultiArrayView<2, U, StridedArrayTag> 
+            lineFeatures(Shape2(features.shape(0), features.shape(N-1)),
+                         Shape2(features.stride(0), features.stride(N-1)),
+                         features.data() + dot(start, features.stride()));
+        MultiArrayView<2, T, StridedArrayTag> 
+            lineProb(Shape2(prob.shape(0), prob.shape(N-1)),
+                     Shape2(prob.stride(0), prob.stride(N-1)),
+                     prob.data() + dot(start, prob.stride()));
+        predictProbabilities(lineFeatures, lineProb);
+    }
+}
+
+template <class LabelType, class PreprocessorTag>
+template <unsigned int N, class U, class T>
+void RandomForest<LabelType, PreprocessorTag>
+    ::predictProbabilities(ChunkedArray<N, U> const & features,
+                           ChunkedArray<N, T>       & prob) const
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    typedef typename MultiArrayShape<N-1>::type SpatialShape;
+
+    Shape shape(features.shape()), 
+          probShape(prob.shape());
+    SpatialShape spatialShape(shape.template subarray<0, N-1>()),
+                 probSpatialShape(probShape.template subarray<0, N-1>());
+    vigra_precondition(spatialShape == probSpatialShape,
+      "RandomForest::predictProbabilities(): "
+        "Feature image and probability image have different spatial shapes.");
+
+    // blocks cover all feature channels and have the chunk shape spatially
+    Shape blockShape(features.chunkShape());
+    blockShape[N-1] = shape[N-1];
+    Shape blocks((shape + blockShape - Shape(1)) / blockShape);
+
+    MultiArray<N, U> blockFeatures;
+    MultiArray<N, T> blockProb;
+    MultiCoordinateIterator<N> block(blocks), end = block.getEndIterator();
+    for(; block != end; ++block)
+    {
+        Shape start(*block * blockShape), 
+              stop(min(start + blockShape, shape));
+        blockFeatures.reshape(stop - start);
+        features.checkoutSubarray(start, blockFeatures);
+
+        Shape probStart(start), probBlockShape(stop - start);
+        probBlockShape[N-1] = probShape[N-1];
+        blockProb.reshape(probBlockShape);
+        predictProbabilities(blockFeatures.multiband(), blockProb.multiband());
+        prob.commitSubarray(probStart, blockProb);
+    }
+}
+
 template <class LabelType, class PreprocessorTag>
 template <class U, class C1, class T, class C2>
 void RandomForest<LabelType, PreprocessorTag>
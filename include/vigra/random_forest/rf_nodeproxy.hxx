@@ -90,6 +90,8 @@ class NodeBase
     typedef Int32                               INT;
     typedef ArrayVector<INT>                    T_Container_type;
     typedef ArrayVector<double>                 P_Container_type;
+    typedef ArrayVectorView<INT>                T_ContainerView_type;
+    typedef ArrayVectorView<double>             P_ContainerView_type;
     typedef T_Container_type::iterator          Topology_type;
     typedef P_Container_type::iterator          Parameter_type;
 
@@ -251,8 +253,8 @@ class NodeBase
     /** create ReadOnly Base Node at position n (actual length is unknown)
      * only common features i.e. children etc are accessible.
      */
-    NodeBase(   T_Container_type const   &  topology,
-                P_Container_type const   &  parameter,
+    NodeBase(   T_ContainerView_type const &  topology,
+                P_ContainerView_type const &  parameter,
                 INT                         n)
     :
                     topology_   (const_cast<Topology_type>(topology.begin()+ n)),
@@ -271,8 +273,8 @@ class NodeBase
      */
     NodeBase(   int                      tLen,
                 int                      pLen,
-                T_Container_type const & topology,
-                P_Container_type const & parameter,
+                T_ContainerView_type const & topology,
+                P_ContainerView_type const & parameter,
                 INT                         n)
     :
                     topology_   (const_cast<Topology_type>(topology.begin()+ n)),
@@ -401,8 +403,8 @@ class Node<i_ThresholdNode>
         BT::typeID() = i_ThresholdNode;
     }
 
-    Node(   BT::T_Container_type const     &   topology,
-            BT::P_Container_type const     &   param,
+    Node(   BT::T_ContainerView_type const     &   topology,
+            BT::P_ContainerView_type const     &   param,
                     INT                   n             )
                 :   BT(5,2,topology, param, n)
     {}
@@ -456,8 +458,8 @@ class Node<i_HyperplaneNode>
         BT::typeID() = i_HyperplaneNode;
     }
 
-    Node(           BT::T_Container_type  const  &   topology,
-                    BT::P_Container_type  const  &   split_param,
+    Node(           BT::T_ContainerView_type const  &   topology,
+                    BT::P_ContainerView_type const  &   split_param,
                     int                  n             )
                 :   NodeBase(5 , 2,topology, split_param, n)
     {
@@ -542,8 +544,8 @@ class Node<i_HypersphereNode>
         BT::typeID() = i_HypersphereNode;
     }
 
-    Node(           BT::T_Container_type  const  &   topology,
-                    BT::P_Container_type  const  &  param,
+    Node(           BT::T_ContainerView_type const  &   topology,
+                    BT::P_ContainerView_type const  &  param,
                     int                  n             )
                 :   NodeBase(5, 1,topology, param, n)
     {
@@ -640,8 +642,8 @@ class Node<e_ConstProbNode>
     }
 
 
-    Node(           BT::T_Container_type const &   topology,
-                    BT::P_Container_type const &   param,
+    Node(           BT::T_ContainerView_type const &   topology,
+                    BT::P_ContainerView_type const &   param,
                     int                  n             )
                 :   BT(2, topology[1]+1,topology, param, n)
     { }
@@ -127,6 +127,10 @@ namespace detail
     template<unsigned int N, class T, class C>
     bool contains_nan(MultiArrayView<N, T, C> const & in)
     {
+        // integral features (e.g. UInt8 or UInt16) never contain NaNs -
+        // don't scan possibly huge feature matrices for them
+        if(NumericTraits<T>::isIntegral::value)
+            return false;
         typedef typename MultiArrayView<N, T, C>::const_iterator Iter;
         Iter i = in.begin(), end = in.end();
         for(; i != end; ++i)
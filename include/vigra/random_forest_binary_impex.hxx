@@ -0,0 +1,768 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_RANDOM_FOREST_BINARY_IMPEX_HXX
+#define VIGRA_RANDOM_FOREST_BINARY_IMPEX_HXX
+
+#include "config.hxx"
+#include "random_forest.hxx"
+#include "mapped_file.hxx"
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace vigra
+{
+
+/*  Layout of the binary random forest format (all numbers in native byte
+    order, every section starts at a multiple of 8 bytes):
+
+        header          detail::RFBinaryHeader
+        options         serialized RandomForestOptions (see below)
+        ext_param       serialized ProblemSpec (see below)
+        labels          UInt64 count, followed by the class labels as double
+        tree table      tree_count entries of detail::RFBinaryTreeEntry
+        trees           topology (Int32) and parameters (double) of each tree
+
+    The options and ext_param sections contain the maps produced by
+    make_map(): UInt64 entry count, followed by (UInt64 name length,
+    name padded to 8 bytes, UInt64 value count, values as double) per entry.
+*/
+static const char   rf_binary_magic[8]   = {'V', 'I', 'G', 'R', 'A', 'R', 'F', '\0'};
+static const UInt32 rf_binary_version    = 1;
+static const UInt32 rf_binary_byte_order = 0x01020304;
+
+namespace detail
+{
+
+struct RFBinaryHeader
+{
+    char   magic[8];
+    UInt32 version;
+    UInt32 byte_order;
+    UInt64 tree_count;
+    UInt64 options_offset;
+    UInt64 ext_param_offset;
+    UInt64 labels_offset;
+    UInt64 tree_table_offset;
+    UInt64 file_size;
+};
+
+struct RFBinaryTreeEntry
+{
+    UInt64 topology_offset;
+    UInt64 topology_size;
+    UInt64 parameters_offset;
+    UInt64 parameters_size;
+};
+
+/* Sequential writer which keeps track of the file position and
+ * pads every section to a multiple of 8 bytes.
+ */
+class RFBinaryWriter
+{
+  public:
+    RFBinaryWriter(std::string const & filename)
+    : stream_(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+      pos_(0)
+    {
+        if(!stream_)
+            throw std::runtime_error("rf_export_binary(): unable to open file '"
+                                      + filename + "'.");
+    }
+
+    UInt64 tell() const
+    {
+        return pos_;
+    }
+
+    void write(void const * data, std::size_t size)
+    {
+        stream_.write(static_cast<char const *>(data), size);
+        if(!stream_)
+            throw std::runtime_error("rf_export_binary(): write failed.");
+        pos_ += size;
+    }
+
+    template <class T>
+    void write(T const & value)
+    {
+        write(&value, sizeof(T));
+    }
+
+    void align()
+    {
+        static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        if(pos_ % 8 != 0)
+            write(zeros, 8 - pos_ % 8);
+    }
+
+    template <class MAP>
+    void writeMap(MAP const & map)
+    {
+        write(UInt64(map.size()));
+        for(typename MAP::const_iterator i = map.begin(); i != map.end(); ++i)
+        {
+            write(UInt64(i->first.size()));
+            write(i->first.data(), i->first.size());
+            align();
+            write(UInt64(i->second.size()));
+            if(i->second.size() > 0)
+                write(i->second.data(), i->second.size()*sizeof(double));
+        }
+    }
+
+    void rewrite(UInt64 pos, void const * data, std::size_t size)
+    {
+        stream_.seekp(pos);
+        stream_.write(static_cast<char const *>(data), size);
+        stream_.seekp(pos_);
+        if(!stream_)
+            throw std::runtime_error("rf_export_binary(): write failed.");
+    }
+
+  private:
+    std::ofstream stream_;
+    UInt64 pos_;
+};
+
+/* Bounds-checked sequential reader on a memory block.
+ */
+class RFBinaryReader
+{
+  public:
+    RFBinaryReader(char const * data, std::size_t size, UInt64 pos = 0)
+    : data_(data),
+      size_(size),
+      pos_(pos)
+    {}
+
+    void const * get(std::size_t size)
+    {
+        vigra_precondition(pos_ <= size_ && size <= size_ - pos_,
+            "MappedRandomForest: file is truncated or corrupt.");
+        void const * res = data_ + pos_;
+        pos_ += size;
+        return res;
+    }
+
+    UInt64 readUInt64()
+    {
+        UInt64 res;
+        std::memcpy(&res, get(sizeof(UInt64)), sizeof(UInt64));
+        return res;
+    }
+
+    void align()
+    {
+        pos_ = (pos_ + 7) & ~UInt64(7);
+    }
+
+    template <class MAP>
+    void readMap(MAP & map)
+    {
+        UInt64 count = readUInt64();
+        for(UInt64 k = 0; k < count; ++k)
+        {
+            UInt64 nameSize = readUInt64();
+            std::string name(static_cast<char const *>(get(nameSize)), nameSize);
+            align();
+            UInt64 valueCount = readUInt64();
+            vigra_precondition(valueCount <= size_ / sizeof(double),
+                "MappedRandomForest: file is truncated or corrupt.");
+            double const * values =
+                 static_cast<double const *>(get(valueCount*sizeof(double)));
+            map[name] = ArrayVector<double>(values, values + valueCount);
+        }
+    }
+
+  private:
+    char const * data_;
+    std::size_t size_;
+    UInt64 pos_;
+};
+
+/* Read-only decision tree that refers to topology and parameter arrays
+ * owned by someone else (e.g. a memory mapped file). Prediction works
+ * exactly like DecisionTree::predict().
+ */
+class DecisionTreeView
+{
+  public:
+    typedef Int32 TreeInt;
+
+    ArrayVectorView<TreeInt const>  topology_;
+    ArrayVectorView<double const>   parameters_;
+
+    DecisionTreeView(ArrayVectorView<TreeInt const> const & topology,
+                     ArrayVectorView<double const> const & parameters)
+    : topology_(topology),
+      parameters_(parameters)
+    {}
+
+    bool isLeafNode(TreeInt in) const
+    {
+        return (in & LeafNodeTag) == LeafNodeTag;
+    }
+
+        // Check that all nodes reachable from the root lie inside the topology
+        // array, refer to parameters inside the parameter array and to feature
+        // columns below topology_[0]. Since getToLeaf() and predict() do not
+        // check indices, this must be called before a view of untrusted
+        // data (e.g. a file) is used.
+    void checkIndices() const
+    {
+        std::size_t tsize = topology_.size(),
+                    psize = parameters_.size();
+        if(tsize < 2 || topology_[0] < 0 || topology_[1] < 0)
+            vigra_fail("DecisionTreeView::checkIndices(): invalid tree header.");
+        std::size_t featureCount = (std::size_t)topology_[0],
+                    classCount   = (std::size_t)topology_[1];
+
+        // every node occupies at least two entries, so a tree cannot have more
+        // than tsize/2 nodes; more visits indicate a cycle
+        std::size_t visits = 0;
+        ArrayVector<TreeInt> stack(1, 2);
+        while(stack.size() > 0)
+        {
+            std::size_t n = (std::size_t)stack.back();
+            stack.pop_back();
+            if(++visits > tsize / 2 || n < 2 || n + 2 > tsize || topology_[n+1] < 0)
+                vigra_fail("DecisionTreeView::checkIndices(): node index out of range.");
+            std::size_t param = (std::size_t)topology_[n+1];
+
+            if(isLeafNode(topology_[n]))
+            {
+                if(topology_[n] != e_ConstProbNode)
+                    vigra_fail("DecisionTreeView::checkIndices(): unknown external node type.");
+                if(param + 1 + classCount > psize)
+                    vigra_fail("DecisionTreeView::checkIndices(): parameter index out of range.");
+                continue;
+            }
+
+            if(n + 5 > tsize)
+                vigra_fail("DecisionTreeView::checkIndices(): node index out of range.");
+            std::size_t columnCount;
+            switch(topology_[n])
+            {
+                case i_ThresholdNode:
+                    if(topology_[n+4] < 0 || (std::size_t)topology_[n+4] >= featureCount)
+                        vigra_fail("DecisionTreeView::checkIndices(): feature index out of range.");
+                    columnCount = 0;
+                    break;
+                case i_HyperplaneNode:
+                case i_HypersphereNode:
+                    if(topology_[n+4] == AllColumns)
+                    {
+                        columnCount = featureCount;
+                    }
+                    else
+                    {
+                        columnCount = (std::size_t)topology_[n+4];
+                        if(topology_[n+4] < 0 || n + 5 + columnCount > tsize)
+                            vigra_fail("DecisionTreeView::checkIndices(): node index out of range.");
+                        for(std::size_t k = 0; k < columnCount; ++k)
+                            if(topology_[n+5+k] < 0 || (std::size_t)topology_[n+5+k] >= featureCount)
+                                vigra_fail("DecisionTreeView::checkIndices(): feature index out of range.");
+                    }
+                    break;
+                default:
+                    vigra_fail("DecisionTreeView::checkIndices(): unknown internal node type.");
+            }
+            if(param + 2 + columnCount > psize)
+                vigra_fail("DecisionTreeView::checkIndices(): parameter index out of range.");
+            stack.push_back(topology_[n+2]);
+            stack.push_back(topology_[n+3]);
+        }
+    }
+
+    template<class U, class C>
+    TreeInt getToLeaf(MultiArrayView<2, U, C> const & features) const
+    {
+        NodeBase::T_ContainerView_type topology = nodeTopology();
+        NodeBase::P_ContainerView_type parameters = nodeParameters();
+        TreeInt index = 2;
+        while(!isLeafNode(topology_[index]))
+        {
+            switch(topology_[index])
+            {
+                case i_ThresholdNode:
+                    index = Node<i_ThresholdNode>(topology, parameters, index).next(features);
+                    break;
+                case i_HyperplaneNode:
+                    index = Node<i_HyperplaneNode>(topology, parameters, index).next(features);
+                    break;
+                case i_HypersphereNode:
+                    index = Node<i_HypersphereNode>(topology, parameters, index).next(features);
+                    break;
+                default:
+                    vigra_fail("DecisionTreeView::getToLeaf():"
+                               "encountered unknown internal Node Type");
+            }
+        }
+        return index;
+    }
+
+    template <class U, class C>
+    ArrayVector<double>::const_iterator
+    predict(MultiArrayView<2, U, C> const & features) const
+    {
+        TreeInt nodeindex = getToLeaf(features);
+        vigra_precondition(topology_[nodeindex] == e_ConstProbNode,
+            "DecisionTreeView::predict() : encountered unknown external Node Type");
+        return Node<e_ConstProbNode>(nodeTopology(), nodeParameters(), nodeindex).prob_begin();
+    }
+
+  private:
+        // The node proxies expect mutable views even when they are constructed
+        // read-only (like in DecisionTree::predict()). They never write through them.
+    NodeBase::T_ContainerView_type nodeTopology() const
+    {
+        return NodeBase::T_ContainerView_type(topology_.size(), 
+                                              const_cast<TreeInt *>(topology_.data()));
+    }
+
+    NodeBase::P_ContainerView_type nodeParameters() const
+    {
+        return NodeBase::P_ContainerView_type(parameters_.size(), 
+                                              const_cast<double *>(parameters_.data()));
+    }
+};
+
+} // namespace detail
+
+/** \brief Save a random forest into a memory-mappable binary file.
+
+    The file contains the serialized options and problem specification
+    followed by the topology and parameter arrays of all trees, each
+    aligned to 8 bytes. It can be opened with \ref MappedRandomForest
+    without copying or parsing the trees, or loaded into a regular
+    RandomForest with rf_import_binary(). Numbers are stored in native
+    byte order, class labels are stored as double.
+
+    <b>\#include</b> \<vigra/random_forest_binary_impex.hxx\><br>
+    Namespace: vigra
+
+    \param rf        Random forest object to be exported
+    \param filename  Name of the file to be created (an existing file
+                     is overwritten)
+*/
+template<class T, class Tag>
+void rf_export_binary(const RandomForest<T, Tag> & rf,
+                      const std::string & filename)
+{
+    typedef std::map<std::string, ArrayVector<double> > map_type;
+
+    detail::RFBinaryWriter out(filename);
+    int tree_count = rf.tree_count();
+
+    detail::RFBinaryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, rf_binary_magic, sizeof(header.magic));
+    header.version    = rf_binary_version;
+    header.byte_order = rf_binary_byte_order;
+    header.tree_count = tree_count;
+    out.write(header);
+    out.align();
+
+    map_type options, ext_param;
+    rf.options().make_map(options);
+    rf.ext_param().make_map(ext_param);
+
+    header.options_offset = out.tell();
+    out.writeMap(options);
+    out.align();
+
+    header.ext_param_offset = out.tell();
+    out.writeMap(ext_param);
+    out.align();
+
+    header.labels_offset = out.tell();
+    out.write(UInt64(rf.ext_param().classes.size()));
+    for(unsigned int k = 0; k < rf.ext_param().classes.size(); ++k)
+        out.write(double(rf.ext_param().classes[k]));
+    out.align();
+
+    // the tree table is written twice: now to reserve the space, and
+    // again when all offsets are known
+    header.tree_table_offset = out.tell();
+    ArrayVector<detail::RFBinaryTreeEntry> table(tree_count);
+    if(tree_count > 0)
+        out.write(table.data(), tree_count*sizeof(detail::RFBinaryTreeEntry));
+    out.align();
+
+    for(int k = 0; k < tree_count; ++k)
+    {
+        detail::DecisionTree const & tree = rf.tree(k);
+        table[k].topology_offset = out.tell();
+        table[k].topology_size   = tree.topology_.size();
+        if(tree.topology_.size() > 0)
+            out.write(tree.topology_.data(), tree.topology_.size()*sizeof(Int32));
+        out.align();
+        table[k].parameters_offset = out.tell();
+        table[k].parameters_size   = tree.parameters_.size();
+        if(tree.parameters_.size() > 0)
+            out.write(tree.parameters_.data(), tree.parameters_.size()*sizeof(double));
+        out.align();
+    }
+    header.file_size = out.tell();
+
+    if(tree_count > 0)
+        out.rewrite(header.tree_table_offset, table.data(),
+                    tree_count*sizeof(detail::RFBinaryTreeEntry));
+    out.rewrite(0, &header, sizeof(header));
+}
+
+/** \brief Read-only random forest backed by a memory-mapped binary file.
+
+    The file must have been created by rf_export_binary(). Opening the
+    file only reads the header, the options and the tree table - the trees
+    themselves are accessed in place and loaded by the operating system
+    when prediction touches them for the first time. Since the mapping is
+    shared and read-only, many processes can serve the same model while
+    keeping a single copy in physical memory.
+
+    Prediction gives the same results as RandomForest::predictProbabilities()
+    and RandomForest::predictLabels() of the exported forest (the default
+    stopping criterion is used, i.e. all trees vote).
+
+    <b>\#include</b> \<vigra/random_forest_binary_impex.hxx\><br>
+    Namespace: vigra
+
+    \code
+    RandomForest<> rf;
+    rf.learn(features, labels);
+    rf_export_binary(rf, "forest.bin");
+    ...
+    MappedRandomForest<> mapped("forest.bin");
+    mapped.predictProbabilities(newFeatures, probabilities);
+    \endcode
+*/
+template <class LabelType = double>
+class MappedRandomForest
+{
+  public:
+    typedef detail::DecisionTreeView    DecisionTree_t;
+    typedef ProblemSpec<LabelType>      ProblemSpec_t;
+    typedef RandomForestOptions         Options_t;
+    typedef LabelType                   LabelT;
+
+    /** \brief map the binary random forest file \a filename.
+
+        Throws a <tt>PreconditionViolation</tt> if the file cannot be opened or 
+        is not a valid forest file (see \ref MappedFile for the other errors).
+    */
+    explicit MappedRandomForest(std::string const & filename)
+    : file_(filename, MappedFile::ReadOnly),
+      table_(0),
+      tree_count_(0)
+    {
+        typedef std::map<std::string, ArrayVector<double> > map_type;
+
+        detail::RFBinaryReader in(file_.data(), file_.size());
+        detail::RFBinaryHeader header;
+        std::memcpy(&header, in.get(sizeof(header)), sizeof(header));
+        vigra_precondition(std::memcmp(header.magic, rf_binary_magic, sizeof(header.magic)) == 0,
+            "MappedRandomForest: not a binary random forest file.");
+        vigra_precondition(header.byte_order == rf_binary_byte_order,
+            "MappedRandomForest: file was written with a different byte order.");
+        vigra_precondition(header.version <= rf_binary_version,
+            "MappedRandomForest: unexpected file format version.");
+        vigra_precondition(header.file_size == file_.size(),
+            "MappedRandomForest: file is truncated or corrupt.");
+
+        map_type options, ext_param;
+        detail::RFBinaryReader(file_.data(), file_.size(), header.options_offset)
+            .readMap(options);
+        detail::RFBinaryReader(file_.data(), file_.size(), header.ext_param_offset)
+            .readMap(ext_param);
+        options_.make_from_map(options);
+        ext_param_.make_from_map(ext_param);
+
+        detail::RFBinaryReader labels(file_.data(), file_.size(), header.labels_offset);
+        UInt64 label_count = labels.readUInt64();
+        vigra_precondition(label_count <= file_.size() / sizeof(double),
+            "MappedRandomForest: file is truncated or corrupt.");
+        ArrayVector<double> classes(label_count);
+        if(label_count > 0)
+            std::memcpy(classes.data(), labels.get(label_count*sizeof(double)),
+                        label_count*sizeof(double));
+        ext_param_.classes_(classes.begin(), classes.end());
+
+        // validate the tree table once, so that tree() can simply
+        // create views later on
+        tree_count_ = (int)header.tree_count;
+        vigra_precondition(header.tree_count <= file_.size() / sizeof(detail::RFBinaryTreeEntry) &&
+                           header.tree_table_offset % 8 == 0,
+            "MappedRandomForest: file is truncated or corrupt.");
+        table_ = static_cast<detail::RFBinaryTreeEntry const *>(
+            detail::RFBinaryReader(file_.data(), file_.size(), header.tree_table_offset)
+                .get(tree_count_*sizeof(detail::RFBinaryTreeEntry)));
+        for(int k = 0; k < tree_count_; ++k)
+        {
+            detail::RFBinaryTreeEntry const & e = table_[k];
+            bool valid = e.topology_offset % 8 == 0 && e.parameters_offset % 8 == 0 &&
+                         e.topology_size >= 2 &&
+                         e.topology_size <= file_.size() / sizeof(Int32) &&
+                         e.parameters_size <= file_.size() / sizeof(double);
+            vigra_precondition(valid,
+                "MappedRandomForest: file is truncated or corrupt.");
+            detail::RFBinaryReader(file_.data(), file_.size(), e.topology_offset)
+                .get(e.topology_size*sizeof(Int32));
+            detail::RFBinaryReader(file_.data(), file_.size(), e.parameters_offset)
+                .get(e.parameters_size*sizeof(double));
+            DecisionTree_t view = tree(k);
+            view.checkIndices();
+            vigra_precondition(view.topology_[0] == ext_param_.column_count_ &&
+                               view.topology_[1] == ext_param_.class_count_,
+                "MappedRandomForest: file is truncated or corrupt.");
+        }
+    }
+
+    /** \brief return external parameters for viewing
+     */
+    ProblemSpec_t const & ext_param() const
+    {
+        return ext_param_;
+    }
+
+    /** \brief access const random forest options
+     */
+    Options_t const & options() const
+    {
+        return options_;
+    }
+
+    /** \brief access the k-th tree.
+
+        The returned object refers to the mapped file and becomes
+        invalid when the MappedRandomForest is destroyed.
+    */
+    DecisionTree_t tree(int index) const
+    {
+        detail::RFBinaryTreeEntry const & e = table_[index];
+        typedef DecisionTree_t::TreeInt TreeInt;
+        return DecisionTree_t(
+            ArrayVectorView<TreeInt const>((std::size_t)e.topology_size,
+                  reinterpret_cast<TreeInt const *>(file_.data() + e.topology_offset)),
+            ArrayVectorView<double const>((std::size_t)e.parameters_size,
+                  reinterpret_cast<double const *>(file_.data() + e.parameters_offset)));
+    }
+
+    /** \brief return number of features used while
+     * training.
+     */
+    int feature_count() const
+    {
+      return ext_param_.column_count_;
+    }
+
+    /** \brief return number of features used while
+     * training.
+     */
+    int column_count() const
+    {
+      return ext_param_.column_count_;
+    }
+
+    /** \brief return number of classes used while
+     * training.
+     */
+    int class_count() const
+    {
+      return ext_param_.class_count_;
+    }
+
+    /** \brief return number of trees
+     */
+    int tree_count() const
+    {
+      return tree_count_;
+    }
+
+    /** \brief predict a label given a feature.
+     *
+     * \param features: a 1 by featureCount matrix containing
+     *        data point to be predicted (this only works in
+     *        classification setting)
+     * \return double value representing class. You can use the
+     *         predictLabels() function together with the
+     *         rf.external_parameter().class_type_ attribute
+     *         to get back the same type used during learning.
+     */
+    template <class U, class C>
+    LabelType predictLabel(MultiArrayView<2, U, C> const & features) const;
+
+    /** \brief predict multiple labels with given features
+     *
+     * \param features: a n by featureCount matrix containing
+     *        data point to be predicted (this only works in
+     *        classification setting)
+     * \param labels: a n by 1 matrix passed by reference to store
+     *        output.
+     */
+    template <class U, class C1, class T, class C2>
+    void predictLabels(MultiArrayView<2, U, C1> const & features,
+                       MultiArrayView<2, T, C2> & labels) const
+    {
+        vigra_precondition(features.shape(0) == labels.shape(0),
+            "MappedRandomForest::predictLabels(): Label array has wrong size.");
+        for(int k=0; k<features.shape(0); ++k)
+        {
+            vigra_precondition(!detail::contains_nan(rowVector(features, k)),
+                "MappedRandomForest::predictLabels(): NaN in feature matrix.");
+            labels(k,0) = detail::RequiresExplicitCast<T>::cast(predictLabel(rowVector(features, k)));
+        }
+    }
+
+    /** \brief predict the class probabilities for multiple labels
+     *
+     *  \param features same as above
+     *  \param prob a n x class_count_ matrix. passed by reference to
+     *  save class probabilities
+     */
+    template <class U, class C1, class T, class C2>
+    void predictProbabilities(MultiArrayView<2, U, C1> const & features,
+                              MultiArrayView<2, T, C2> & prob) const;
+
+  private:
+    MappedFile                            file_;
+    detail::RFBinaryTreeEntry const *     table_;
+    int                                   tree_count_;
+    Options_t                             options_;
+    ProblemSpec_t                         ext_param_;
+};
+
+template <class LabelType>
+template <class U, class C>
+LabelType MappedRandomForest<LabelType>
+    ::predictLabel(MultiArrayView<2, U, C> const & features) const
+{
+    vigra_precondition(columnCount(features) >= ext_param_.column_count_,
+        "MappedRandomForest::predictLabel(): Too few columns in feature matrix.");
+    vigra_precondition(rowCount(features) == 1,
+        "MappedRandomForest::predictLabel(): Feature matrix must have a single row.");
+    MultiArray<2, double> probabilities(Shape2(1, ext_param_.class_count_), 0.0);
+    LabelType d;
+    predictProbabilities(features, probabilities);
+    ext_param_.to_classlabel(argMax(probabilities), d);
+    return d;
+}
+
+template <class LabelType>
+template <class U, class C1, class T, class C2>
+void MappedRandomForest<LabelType>
+    ::predictProbabilities(MultiArrayView<2, U, C1> const & features,
+                           MultiArrayView<2, T, C2> & prob) const
+{
+    vigra_precondition(rowCount(features) == rowCount(prob),
+      "MappedRandomForest::predictProbabilities():"
+        " Feature matrix and probability matrix size mismatch.");
+    vigra_precondition(columnCount(features) >= ext_param_.column_count_,
+      "MappedRandomForest::predictProbabilities():"
+        " Too few columns in feature matrix.");
+    vigra_precondition(columnCount(prob)
+                        == static_cast<MultiArrayIndex>(ext_param_.class_count_),
+      "MappedRandomForest::predictProbabilities():"
+      " Probability matrix must have as many columns as there are classes.");
+
+    prob.init(NumericTraits<T>::zero());
+    int weighted = options_.predict_weighted_;
+    for(int row=0; row < rowCount(features); ++row)
+    {
+        MultiArrayView<2, U, StridedArrayTag> currentRow(rowVector(features, row));
+
+        // when the features contain an NaN, the instance doesn't belong to any class
+        // => indicate this by returning a zero probability array.
+        if(detail::contains_nan(currentRow))
+        {
+            rowVector(prob, row).init(0.0);
+            continue;
+        }
+
+        double totalWeight = 0.0;
+        for(int k=0; k<tree_count_; ++k)
+        {
+            ArrayVector<double>::const_iterator weights = tree(k).predict(currentRow);
+            for(int l=0; l<ext_param_.class_count_; ++l)
+            {
+                double cur_w = weights[l] * (weighted * (*(weights-1))
+                                           + (1-weighted));
+                prob(row, l) += static_cast<T>(cur_w);
+                totalWeight += cur_w;
+            }
+        }
+        for(int l=0; l< ext_param_.class_count_; ++l)
+        {
+            prob(row, l) /= detail::RequiresExplicitCast<T>::cast(totalWeight);
+        }
+    }
+}
+
+/** \brief Read a random forest from a binary file created by rf_export_binary().
+
+    In contrast to \ref MappedRandomForest, the trees are copied into
+    the random forest object, so that it can be modified or trained further.
+
+    <b>\#include</b> \<vigra/random_forest_binary_impex.hxx\><br>
+    Namespace: vigra
+
+    \param rf        Random forest object to be imported
+    \param filename  Name of the binary file
+*/
+template<class T, class Tag>
+bool rf_import_binary(RandomForest<T, Tag> & rf,
+                      const std::string & filename)
+{
+    MappedRandomForest<T> mapped(filename);
+    rf.options_   = mapped.options();
+    rf.ext_param_ = mapped.ext_param();
+    rf.trees_.clear();
+    for(int k = 0; k < mapped.tree_count(); ++k)
+    {
+        detail::DecisionTreeView view = mapped.tree(k);
+        rf.trees_.push_back(detail::DecisionTree(rf.ext_param_));
+        rf.trees_.back().topology_.insert(rf.trees_.back().topology_.end(),
+                                          view.topology_.begin(), view.topology_.end());
+        rf.trees_.back().parameters_.insert(rf.trees_.back().parameters_.end(),
+                                            view.parameters_.begin(), view.parameters_.end());
+    }
+    return true;
+}
+
+} // namespace vigra
+
+#endif // VIGRA_RANDOM_FOREST_BINARY_IMPEX_HXX
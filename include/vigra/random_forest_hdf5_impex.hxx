@@ -38,6 +38,7 @@
 
 #include "config.hxx"
 #include "random_forest.hxx"
+#include "random_forest_binary_impex.hxx"
 #include "hdf5impex.hxx"
 #include <string>
 
@@ -355,6 +356,32 @@ bool rf_import_HDF5(RandomForest<T, Tag> & rf,
     return rf_import_HDF5(rf, h5context);
 }
 
+/** \brief Convert a random forest stored in an HDF5 file into the
+           memory-mappable binary format.
+
+    This is equivalent to rf_import_HDF5() into a <tt>RandomForest<LabelType></tt>
+    followed by rf_export_binary(). The resulting file can be opened with 
+    \ref MappedRandomForest. Specify the \a LabelType explicitly when the forest
+    was trained with labels other than <tt>double</tt>:
+    \code
+    rf_convert_HDF5_to_binary<UInt32>("forest.h5", "forest.bin");
+    \endcode
+
+    \param hdf5_filename   Name of the HDF5 file to read
+    \param binary_filename Name of the binary file to be created
+    \param pathname        HDF5 group containing the random forest
+                           (default: root group)
+*/
+template <class LabelType = double>
+void rf_convert_HDF5_to_binary(const std::string & hdf5_filename,
+                               const std::string & binary_filename,
+                               const std::string & pathname = "")
+{
+    RandomForest<LabelType> rf;
+    rf_import_HDF5(rf, hdf5_filename, pathname);
+    rf_export_binary(rf, binary_filename);
+}
+
 } // namespace vigra
 
 #endif // VIGRA_RANDOM_FOREST_HDF5_IMPEX_HXX
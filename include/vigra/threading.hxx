@@ -40,25 +40,11 @@
    when the compiler doesn't yet support C++11.
 */
 
+#include "config.hxx"  // detects VIGRA_NO_STD_THREADING
+
     // ignore all threading if VIGRA_SINGLE_THREADED is defined
 #ifndef VIGRA_SINGLE_THREADED
 
-#ifndef VIGRA_NO_STD_THREADING 
-# if defined(__clang__)
-#  if (!__has_include(<thread>) || !__has_include(<mutex>) || !__has_include(<atomic>))
-#    define VIGRA_NO_STD_THREADING
-#  endif
-# else
-#  if defined(__GNUC__) && (!defined(_GLIBCXX_HAS_GTHREADS) || !defined(_GLIBCXX_USE_C99_STDINT_TR1) || !defined(_GLIBCXX_USE_SCHED_YIELD))
-#    define VIGRA_NO_STD_THREADING
-#  endif
-# endif
-
-# if defined(_MSC_VER) && _MSC_VER <= 1600
-#  define VIGRA_NO_STD_THREADING
-# endif
-#endif
-
 #ifdef USE_BOOST_THREAD
 #  include <boost/thread.hpp>
 #  if BOOST_VERSION >= 105300
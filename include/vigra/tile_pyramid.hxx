@@ -0,0 +1,406 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_TILE_PYRAMID_HXX
+#define VIGRA_TILE_PYRAMID_HXX
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cerrno>
+#include "config.hxx"
+#include "error.hxx"
+#include "numerictraits.hxx"
+#include "array_vector.hxx"
+#include "separableconvolution.hxx"
+#include "resampling_convolution.hxx"
+#include "multi_array.hxx"
+#include "imageinfo.hxx"
+#include "impex.hxx"
+
+#ifdef _MSC_VER
+# include <direct.h>
+#else
+# include <sys/stat.h>
+# include <sys/types.h>
+#endif
+
+namespace vigra {
+
+namespace detail {
+
+inline void tilePyramidMakeDirectory(std::string const & name)
+{
+#ifdef _MSC_VER
+    int res = ::_mkdir(name.c_str());
+#else
+    int res = ::mkdir(name.c_str(), 0777);
+#endif
+    vigra_postcondition(res == 0 || errno == EEXIST,
+        "TilePyramidWriter: unable to create directory '" + name + "'.");
+}
+
+    // Two-fold reduction of a line with reflective border treatment.
+    // resamplingReduceLine2() requires at least three source pixels,
+    // so the (rare) shorter lines at the top of the pyramid are handled here.
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor, class Kernel>
+void
+tilePyramidReduceLine(SrcIterator s, SrcIterator send, SrcAccessor src,
+                      DestIterator d, DestIterator dend, DestAccessor dest,
+                      ArrayVector<Kernel> const & kernels)
+{
+    int wo = send - s;
+    if(wo >= 3)
+    {
+        resamplingReduceLine2(s, send, src, d, dend, dest, kernels);
+        return;
+    }
+
+    typedef typename
+        NumericTraits<typename SrcAccessor::value_type>::RealPromote
+        TmpType;
+    Kernel const & kernel = kernels[0];
+    int wn = dend - d;
+    for(int i = 0; i < wn; ++i, ++d)
+    {
+        TmpType sum = NumericTraits<TmpType>::zero();
+        for(int m = 2*i - kernel.right(); m <= 2*i - kernel.left(); ++m)
+        {
+            int mm = (m < 0) ? -m : m;
+            if(mm >= wo)
+                mm = 2*wo - 2 - mm;
+            mm = std::max(0, std::min(wo - 1, mm));
+            sum += kernel[2*i - m] * src(s, mm);
+        }
+        dest.set(sum, d);
+    }
+}
+
+} // namespace detail
+
+/** \addtogroup VigraImpex
+ * @{
+*/
+
+/** \brief Streaming writer for multi-resolution tile pyramids in Deep Zoom format.
+
+    The full-resolution image is passed to the writer in horizontal bands of
+    arbitrary height (e.g. one at a time as they are produced by a stitcher, or
+    as they are imported with the region-of-interest variant of \ref importImage()).
+    Each incoming row is reduced by the Burt filter (see \ref pyramidReduceBurtFilter())
+    and passed on to the next coarser level immediately, so all levels are computed
+    and written in a single pass over the input. Per level, the writer only keeps
+    one row of tiles (of height <tt>tileSize + 2*overlap</tt>) and the last five
+    rows required by the vertical filter, so the memory consumption is roughly
+    <tt>2*(tileSize + 2*overlap + 3)</tt> times the image width, independent of the
+    image height.
+
+    The output uses the Deep Zoom layout: the tiles of each level are stored as
+    <tt>baseName_files/level/column_row.extension</tt>, where level 0 is a single pixel
+    and the highest level is the original image. Neighboring tiles overlap by
+    <tt>overlap</tt> pixels. When the last row has been added, the descriptor
+    <tt>baseName.dzi</tt> is written.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/tile_pyramid.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    ImageImportInfo info("huge.tif");
+    TilePyramidWriter<RGBValue<UInt8> > writer("huge", info.shape(), 256, 1, "jpg");
+    writer.tileExportInfo().setCompression("JPEG QUALITY=90");
+
+    MultiArray<2, RGBValue<UInt8> > band(Shape2(info.width(), 256));
+    for(int y = 0; y < info.height(); y += 256)
+    {
+        MultiArrayView<2, RGBValue<UInt8> > b =
+            band.subarray(Shape2(0,0), Shape2(info.width(), std::min(256, info.height() - y)));
+        importImage(info, b, Shape2(0, y));
+        writer.addRows(b);
+    }
+    \endcode
+*/
+template <class T>
+class TilePyramidWriter
+{
+  public:
+    typedef T                                           value_type;
+    typedef typename NumericTraits<T>::RealPromote      TmpType;
+    typedef typename MultiArrayShape<2>::type           Shape;
+
+        /** Prepare the pyramid for an image of the given \a shape. Tiles have size
+            <tt>tileSize x tileSize</tt> (plus \a overlap pixels at each inner border)
+            and are stored in the format implied by \a extension (e.g. "png" or "jpg").
+        */
+    TilePyramidWriter(std::string const & baseName, Shape const & shape,
+                      int tileSize = 256, int overlap = 1,
+                      std::string const & extension = "png")
+    : baseName_(baseName),
+      extension_(extension),
+      tileSize_(tileSize),
+      overlap_(overlap),
+      tileInfo_((baseName + "." + extension).c_str()),
+      kernels_(1),
+      inputLine_(MultiArrayShape<1>::type(shape[0]))
+    {
+        vigra_precondition(shape[0] > 0 && shape[1] > 0,
+            "TilePyramidWriter(): image shape must be positive.");
+        vigra_precondition(tileSize > 0 && 0 <= overlap && overlap < tileSize,
+            "TilePyramidWriter(): tileSize must be positive and 0 <= overlap < tileSize.");
+
+        // same kernel as pyramidReduceBurtFilter() with its default centerValue
+        double centerValue = 0.4;
+        kernels_[0].initExplicitly(-2, 2) = 0.25 - centerValue / 2.0, 0.25, centerValue, 0.25, 0.25 - centerValue / 2.0;
+
+        // levels_[0] is the full resolution, levels_.back() a single pixel
+        Shape s(shape);
+        for(;;)
+        {
+            levels_.push_back(Level(s, tileSize_ + 2*overlap_));
+            if(s[0] == 1 && s[1] == 1)
+                break;
+            s = Shape((s[0] + 1) / 2, (s[1] + 1) / 2);
+        }
+        for(unsigned int k = 0; k < levels_.size() - 1; ++k)
+        {
+            levels_[k].reduced.reshape(Shape(levels_[k+1].shape[0], 5));
+            levels_[k].line.reshape(MultiArrayShape<1>::type(levels_[k+1].shape[0]));
+        }
+
+        detail::tilePyramidMakeDirectory(baseName_ + "_files");
+        for(unsigned int k = 0; k < levels_.size(); ++k)
+            detail::tilePyramidMakeDirectory(levelDirectory(k));
+    }
+
+        /** Export settings applied to every tile (e.g. compression, see
+            \ref ImageExportInfo). The file name is replaced for each tile.
+        */
+    ImageExportInfo & tileExportInfo()
+    {
+        return tileInfo_;
+    }
+
+        /** Append the rows of \a rows to the full-resolution image.
+            The width of \a rows must equal the image width. When the last row
+            of the image has been added, all remaining tiles are written.
+        */
+    template <class U, class S>
+    void addRows(MultiArrayView<2, U, S> const & rows)
+    {
+        vigra_precondition(rows.shape(0) == levels_[0].shape[0],
+            "TilePyramidWriter::addRows(): width mismatch.");
+        vigra_precondition(levels_[0].rows + rows.shape(1) <= levels_[0].shape[1],
+            "TilePyramidWriter::addRows(): too many rows.");
+        for(MultiArrayIndex y = 0; y < rows.shape(1); ++y)
+        {
+            inputLine_ = rows.bindOuter(y);
+            pushRow(0, inputLine_);
+        }
+        if(isComplete())
+            writeDescriptor();
+    }
+
+        /** Number of pyramid levels (including the full-resolution level).
+        */
+    int levels() const
+    {
+        return (int)levels_.size();
+    }
+
+        /** Shape of the given Deep Zoom \a level (0 is the single-pixel level).
+        */
+    Shape levelShape(int level) const
+    {
+        return levels_[levels_.size() - 1 - level].shape;
+    }
+
+        /** True when all rows of the image have been added and all tiles written.
+        */
+    bool isComplete() const
+    {
+        return levels_[0].rows == levels_[0].shape[1];
+    }
+
+  private:
+    struct Level
+    {
+        Level(Shape const & s, int bufferHeight)
+        : shape(s),
+          tiles(Shape(s[0], std::min<MultiArrayIndex>(bufferHeight, s[1]))),
+          tilesBegin(0),
+          tileRow(0),
+          rows(0),
+          nextReduced(0)
+        {}
+
+        Shape shape;
+        MultiArray<2, T> tiles;           // current row of tiles (including overlap)
+        MultiArray<2, TmpType> reduced;   // ring buffer of horizontally reduced rows
+        MultiArray<1, T> line;            // output row for the next level
+        MultiArrayIndex tilesBegin, tileRow, rows, nextReduced;
+    };
+
+    std::string levelDirectory(unsigned int k) const
+    {
+        std::ostringstream s;
+        s << baseName_ << "_files/" << (levels_.size() - 1 - k);
+        return s.str();
+    }
+
+    void pushRow(unsigned int k, MultiArrayView<1, T> const & row)
+    {
+        Level & l = levels_[k];
+        MultiArrayIndex y = l.rows++,
+                        h = l.shape[1];
+
+        // collect the row of tiles, write it when complete (near the bottom border,
+        // the rows of the last tile row may already be complete as well)
+        l.tiles.bindOuter(y - l.tilesBegin) = row;
+        while(l.tileRow*tileSize_ < h &&
+              y + 1 == std::min<MultiArrayIndex>(h, (l.tileRow + 1)*tileSize_ + overlap_))
+        {
+            writeTileRow(k, y + 1 - l.tilesBegin);
+            MultiArrayIndex newBegin = (l.tileRow + 1)*tileSize_ - overlap_;
+            for(MultiArrayIndex r = newBegin; r <= y; ++r)
+                l.tiles.bindOuter(r - newBegin) = l.tiles.bindOuter(r - l.tilesBegin);
+            l.tilesBegin = newBegin;
+            ++l.tileRow;
+        }
+
+        if(k + 1 == levels_.size())
+            return;
+
+        // reduce horizontally into the ring buffer
+        MultiArrayView<1, TmpType> r = l.reduced.bindOuter(y % 5);
+        detail::tilePyramidReduceLine(row.begin(), row.end(), StandardConstValueAccessor<T>(),
+                                      r.begin(), r.end(), StandardValueAccessor<TmpType>(),
+                                      kernels_);
+
+        // reduce vertically as soon as all rows needed for an output row are available
+        Kernel1D<double> const & kernel = kernels_[0];
+        MultiArrayIndex hn = levels_[k+1].shape[1];
+        for(; l.nextReduced < hn && (2*l.nextReduced + kernel.right() <= y || y + 1 == h); ++l.nextReduced)
+        {
+            MultiArrayIndex is = 2*l.nextReduced;
+            for(MultiArrayIndex x = 0; x < l.line.size(); ++x)
+            {
+                TmpType sum = NumericTraits<TmpType>::zero();
+                for(MultiArrayIndex m = is - kernel.right(); m <= is - kernel.left(); ++m)
+                {
+                    MultiArrayIndex mm = (m < 0) ? -m : m;
+                    if(mm >= h)
+                        mm = 2*h - 2 - mm;
+                    mm = std::max<MultiArrayIndex>(0, std::min<MultiArrayIndex>(h - 1, mm));
+                    sum += kernel[is - m] * l.reduced(x, mm % 5);
+                }
+                l.line(x) = NumericTraits<T>::fromRealPromote(sum);
+            }
+            pushRow(k + 1, l.line);
+        }
+    }
+
+    void writeTileRow(unsigned int k, MultiArrayIndex height)
+    {
+        Level & l = levels_[k];
+        std::string directory = levelDirectory(k);
+        for(MultiArrayIndex c = 0; c*tileSize_ < l.shape[0]; ++c)
+        {
+            MultiArrayIndex xbegin = std::max<MultiArrayIndex>(0, c*tileSize_ - overlap_),
+                            xend   = std::min(l.shape[0], (c + 1)*tileSize_ + overlap_);
+            std::ostringstream name;
+            name << directory << "/" << c << "_" << l.tileRow << "." << extension_;
+            ImageExportInfo info(tileInfo_);
+            info.setFileName(name.str().c_str());
+            exportImage(l.tiles.subarray(Shape(xbegin, 0), Shape(xend, height)), info);
+        }
+    }
+
+    void writeDescriptor() const
+    {
+        std::string name = baseName_ + ".dzi";
+        std::ofstream dzi(name.c_str());
+        vigra_postcondition(dzi.good(),
+            "TilePyramidWriter: unable to write '" + name + "'.");
+        dzi << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\"\n"
+            << "       Format=\"" << extension_ << "\" Overlap=\"" << overlap_
+            << "\" TileSize=\"" << tileSize_ << "\">\n"
+            << "  <Size Width=\"" << levels_[0].shape[0]
+            << "\" Height=\"" << levels_[0].shape[1] << "\"/>\n"
+            << "</Image>\n";
+    }
+
+    std::string baseName_, extension_;
+    int tileSize_, overlap_;
+    ImageExportInfo tileInfo_;
+    ArrayVector<Kernel1D<double> > kernels_;
+    MultiArray<1, T> inputLine_;
+    std::vector<Level> levels_;
+};
+
+/** \brief Write a Deep Zoom tile pyramid of an image.
+
+    Convenience function for \ref TilePyramidWriter when the entire image
+    is already in memory.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/tile_pyramid.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<2, UInt8> image(...);
+    exportTilePyramid(image, "image", 256, 1, "png");  // creates image.dzi and image_files/
+    \endcode
+*/
+template <class T, class S>
+void
+exportTilePyramid(MultiArrayView<2, T, S> const & image, std::string const & baseName,
+                  int tileSize = 256, int overlap = 1, std::string const & extension = "png")
+{
+    TilePyramidWriter<T> writer(baseName, image.shape(), tileSize, overlap, extension);
+    writer.addRows(image);
+}
+
+/** @} */
+
+} // namespace vigra
+
+#endif // VIGRA_TILE_PYRAMID_HXX
@@ -857,7 +857,10 @@ class WatershedOptions
             in the range <tt>[0, ..., bucket_count-1]</tt>. Since
             these boundary indicators are typically represented as
             UInt8 images, the default <tt>bucket_count</tt> is 256.
-        
+            watershedsMultiArray() instead quantizes non-integer boundary
+            indicators into <tt>bucket_count</tt> levels between their minimum
+            and maximum (integer data always use a bucket queue there).
+
             Default: don't use the turbo algorithm
         */
     WatershedOptions & turboAlgorithm(unsigned int bucket_count = 256)
@@ -61,6 +61,7 @@
 #include "vigra/array_vector.hxx"
 #include "vigra/imageinfo.hxx"
 #include "codecmanager.hxx"
+#include "byteorder.hxx"
 #include "vigra/multi_impex.hxx"
 #include "vigra/sifImport.hxx"
 
@@ -334,7 +335,7 @@ bool isImage(char const * filename)
 
 ImageExportInfo::ImageExportInfo( const char * filename, const char * mode )
     : m_filename(filename), m_mode(mode),
-      m_x_res(0), m_y_res(0),
+      m_x_res(0), m_y_res(0), m_num_threads(1),
       fromMin_(0.0), fromMax_(0.0), toMin_(0.0), toMax_(0.0)
 {}
 
@@ -465,6 +466,28 @@ ImageExportInfo & ImageExportInfo::setCanvasSize(const Size2D & size)
     return *this;
 }
 
+ImageExportInfo & ImageExportInfo::setTileSize(const Size2D & size)
+{
+    m_tile_size = size;
+    return *this;
+}
+
+vigra::Size2D ImageExportInfo::getTileSize() const
+{
+    return m_tile_size;
+}
+
+ImageExportInfo & ImageExportInfo::setNumThreads(int n)
+{
+    m_num_threads = n;
+    return *this;
+}
+
+int ImageExportInfo::getNumThreads() const
+{
+    return m_num_threads;
+}
+
 vigra::Diff2D ImageExportInfo::getPosition() const
 {
     return m_pos;
@@ -546,6 +569,10 @@ VIGRA_UNIQUE_PTR<Encoder> encoder( const ImageExportInfo & info )
     enc->setYResolution(info.getYResolution());
     enc->setPosition(info.getPosition());
     enc->setCanvasSize(info.getCanvasSize());
+    if ( info.getTileSize() != Size2D() )
+        enc->setTileSize(info.getTileSize());
+    if ( info.getNumThreads() != 1 )
+        enc->setNumThreads(info.getNumThreads());
 
     if ( info.getICCProfile().size() > 0 ) {
         enc->setICCProfile(info.getICCProfile());
@@ -886,7 +913,8 @@ VolumeExportInfo & VolumeExportInfo::setICCProfile(
 VolumeImportInfo::VolumeImportInfo(const std::string &filename)
 : shape_(0, 0, 0),
   resolution_(1.f, 1.f, 1.f),
-  numBands_(0)
+  numBands_(0),
+  byteOrder_(byteorder().get_host_byteorder())
 {
     std::string message;
     
@@ -1109,6 +1137,12 @@ VolumeImportInfo::VolumeImportInfo(const std::string &filename)
                     name_ = value;
                 else if(key == "filename")
                     rawFilename_ = value;
+                else if(key == "byteorder")
+                {
+                    vigra_precondition(value == "little endian" || value == "big endian",
+                        "VolumeImportInfo(): Invalid byteorder '" + value +"' in .info file.");
+                    byteOrder_ = value;
+                }
                 else
                 {
                     std::cerr << "VolumeImportInfo(): WARNING: Unknown key '" << key
@@ -1149,7 +1183,8 @@ VolumeImportInfo::VolumeImportInfo(const std::string &filename)
 VolumeImportInfo::VolumeImportInfo(const std::string &baseName, const std::string &extension)
 : shape_(0, 0, 0),
   resolution_(1.f, 1.f, 1.f),
-  numBands_(0)
+  numBands_(0),
+  byteOrder_(byteorder().get_host_byteorder())
 {
     std::vector<std::string> numbers;
     findImageSequence(baseName, extension, numbers);
@@ -1216,5 +1251,17 @@ MultiArrayIndex VolumeImportInfo::height() const { return shape_[1]; }
 MultiArrayIndex VolumeImportInfo::depth() const { return shape_[2]; }
 const std::string & VolumeImportInfo::name() const { return name_; }
 const std::string & VolumeImportInfo::description() const { return description_; }
+const std::string & VolumeImportInfo::getByteOrder() const { return byteOrder_; }
+
+std::string VolumeImportInfo::getRawFilename() const
+{
+    if(fileType_ != "RAW")
+        return std::string();
+    // relative names are interpreted relative to the location of the .info file
+    if(rawFilename_.size() > 0 && (rawFilename_[0] == '/' || rawFilename_[0] == '\\' ||
+                                   (rawFilename_.size() > 1 && rawFilename_[1] == ':')))
+        return rawFilename_;
+    return path_ + "/" + rawFilename_;
+}
 
 } // namespace vigra
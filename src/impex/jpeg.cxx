@@ -42,7 +42,12 @@
 
 #include <stdexcept>
 #include <csetjmp>
+#include <algorithm>
+#include <vector>
 #include "vigra/config.hxx"
+#ifndef VIGRA_SINGLE_THREADED
+#include "vigra/parallel_foreach.hxx"
+#endif
 #include "void_vector.hxx"
 #include "error.hxx"
 #include "auto_file.hxx"
@@ -63,6 +68,13 @@ struct JPEGCodecErrorManager
     std::jmp_buf buf;
 };
 
+// extend the jpeg_destination_mgr by a growing memory buffer
+struct JPEGCodecMemoryDestination
+{
+    jpeg_destination_mgr pub;
+    std::vector<JOCTET> * buffer;
+};
+
 } // namespace
 
 extern "C"
@@ -75,6 +87,30 @@ static void JPEGCodecLongjumper( j_common_ptr info )
     std::longjmp( error->buf, 1 );
 }
 
+static void JPEGCodecInitDestination( j_compress_ptr info )
+{
+    JPEGCodecMemoryDestination * dest = reinterpret_cast< JPEGCodecMemoryDestination * >(info->dest);
+    dest->buffer->resize( 64 * 1024 );
+    dest->pub.next_output_byte = &(*dest->buffer)[0];
+    dest->pub.free_in_buffer = dest->buffer->size();
+}
+
+static boolean JPEGCodecEmptyOutputBuffer( j_compress_ptr info )
+{
+    JPEGCodecMemoryDestination * dest = reinterpret_cast< JPEGCodecMemoryDestination * >(info->dest);
+    const std::size_t used = dest->buffer->size();
+    dest->buffer->resize( 2 * used );
+    dest->pub.next_output_byte = &(*dest->buffer)[used];
+    dest->pub.free_in_buffer = dest->buffer->size() - used;
+    return TRUE;
+}
+
+static void JPEGCodecTermDestination( j_compress_ptr info )
+{
+    JPEGCodecMemoryDestination * dest = reinterpret_cast< JPEGCodecMemoryDestination * >(info->dest);
+    dest->buffer->resize( dest->buffer->size() - dest->pub.free_in_buffer );
+}
+
 } // extern "C"
 
 namespace vigra
@@ -319,12 +355,40 @@ namespace vigra
         }
     }
 
+    bool JPEGDecoder::decodeBlock( void * dest, std::ptrdiff_t pixelStride,
+                                   std::ptrdiff_t rowStride, std::ptrdiff_t bandStride )
+    {
+        // libjpeg writes interleaved rows, only the row stride is free
+        if ( pixelStride != (std::ptrdiff_t)pimpl->components || bandStride != 1 )
+            return false;
+
+        // let libjpeg decode straight into the destination rows,
+        // as many as it produces per call
+        JSAMPLE * const base = static_cast< JSAMPLE * >(dest);
+        void_vector<JSAMPROW> rows(pimpl->info.rec_outbuf_height);
+        if (setjmp(pimpl->err.buf))
+            vigra_fail( "error in jpeg_read_scanlines()" );
+        while ( pimpl->info.output_scanline < pimpl->info.output_height ) {
+            const JDIMENSION first = pimpl->info.output_scanline;
+            const JDIMENSION count = std::min<JDIMENSION>( pimpl->info.rec_outbuf_height,
+                                                           pimpl->info.output_height - first );
+            for ( JDIMENSION k = 0; k < count; ++k )
+                rows[k] = base + ( first + k ) * rowStride;
+            jpeg_read_scanlines( &pimpl->info, rows.data(), count );
+        }
+        return true;
+    }
+
     void JPEGDecoder::close()
     {
-        // finish any pending decompression
+        // finish any pending decompression (libjpeg refuses to finish when
+        // scanlines are left, e.g. after reading a region of interest)
         if (setjmp(pimpl->err.buf))
             vigra_fail( "error in jpeg_finish_decompress()" );
-        jpeg_finish_decompress(&pimpl->info);
+        if ( pimpl->info.output_scanline < pimpl->info.output_height )
+            jpeg_abort_decompress(&pimpl->info);
+        else
+            jpeg_finish_decompress(&pimpl->info);
     }
 
     void JPEGDecoder::abort() {}
@@ -341,8 +405,11 @@ namespace vigra
         // icc profile, if available
         Encoder::ICCProfile iccProfile;
 
+        // number of compression threads
+        int num_threads;
+
         // state
-        bool finalized;
+        bool finalized, parallel;
 
         // ctor, dtor
 
@@ -352,6 +419,10 @@ namespace vigra
         // methods
 
         void finalize();
+        void setup( jpeg_compress_struct & cinfo, unsigned int rows );
+#ifndef VIGRA_SINGLE_THREADED
+        void write_parallel();
+#endif
     };
 
     JPEGEncoderImpl::JPEGEncoderImpl( const std::string & filename )
@@ -360,7 +431,7 @@ namespace vigra
 #else
         : file( filename.c_str(), "w" ),
 #endif
-          scanline(0), quality(-1), finalized(false)
+          scanline(0), quality(-1), num_threads(1), finalized(false), parallel(false)
     {
         // setup setjmp() error handling
         info.err = jpeg_std_error( ( jpeg_error_mgr * ) &err );
@@ -377,45 +448,63 @@ namespace vigra
     {
     }
 
-    void JPEGEncoderImpl::finalize()
+    // apply the encoder settings to a compression struct for the given number of rows
+    void JPEGEncoderImpl::setup( jpeg_compress_struct & cinfo, unsigned int rows )
     {
-        VIGRA_IMPEX_FINALIZED(finalized);
-
-        // alloc memory for a single scanline
-        bands.resize( width * components );
-        finalized = true;
+        JPEGCodecErrorManager * error = reinterpret_cast< JPEGCodecErrorManager * >(cinfo.err);
 
         // init the compression
-        info.image_width = width;
-        info.image_height = height;
-        info.input_components = components;
+        cinfo.image_width = width;
+        cinfo.image_height = rows;
+        cinfo.input_components = components;
 
         // rgb or gray can be assumed here
-        info.in_color_space = components == 1 ? JCS_GRAYSCALE : JCS_RGB;
-        info.X_density = 100;
-        info.Y_density = 100;
+        cinfo.in_color_space = components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+        cinfo.X_density = 100;
+        cinfo.Y_density = 100;
 
         // set defaults based upon the set values
-        if (setjmp(err.buf))
+        if (setjmp(error->buf))
             vigra_fail( "error in jpeg_set_defaults()" );
-        jpeg_set_defaults(&info);
+        jpeg_set_defaults(&cinfo);
 
         // set the quality level
         if ( quality != -1 ) {
-            if (setjmp(err.buf))
+            if (setjmp(error->buf))
                 vigra_fail( "error in jpeg_set_quality()" );
-            jpeg_set_quality( &info, quality, TRUE );
+            jpeg_set_quality( &cinfo, quality, TRUE );
         }
 
         // enhance the quality a little bit
         for ( unsigned int i = 0; i < MAX_COMPONENTS; ++i ) {
-            info.comp_info[i].h_samp_factor = 1;
-            info.comp_info[i].v_samp_factor = 1;
+            cinfo.comp_info[i].h_samp_factor = 1;
+            cinfo.comp_info[i].v_samp_factor = 1;
         }
 #ifdef ENTROPY_OPT_SUPPORTED
-        info.optimize_coding = TRUE;
+        // bands encoded in parallel must share the standard Huffman tables
+        cinfo.optimize_coding = parallel ? FALSE : TRUE;
 #endif
-        info.dct_method = JDCT_FLOAT;
+        cinfo.dct_method = JDCT_FLOAT;
+    }
+
+    void JPEGEncoderImpl::finalize()
+    {
+        VIGRA_IMPEX_FINALIZED(finalized);
+        finalized = true;
+
+        // parallel encoding needs at least two bands of 8 rows, and
+        // arithmetic coding is left to the sequential encoder
+        parallel = num_threads > 1 && height > 8 && !info.arith_code;
+        if ( parallel ) {
+            // alloc memory for the whole image, which is encoded in close()
+            bands.resize( width * components * height );
+            return;
+        }
+
+        // alloc memory for a single scanline
+        bands.resize( width * components );
+
+        setup( info, height );
 
         // start the compression
         if (setjmp(err.buf))
@@ -427,6 +516,131 @@ namespace vigra
         }
     }
 
+#ifndef VIGRA_SINGLE_THREADED
+
+    namespace {
+
+    // Return the position of the first byte of entropy-coded data in a
+    // complete JPEG stream, i.e. the end of the SOS header. The position
+    // of the frame header (SOFn marker) is stored in 'sof'.
+    std::size_t jpeg_scan_start( std::vector<JOCTET> const & stream, std::size_t & sof )
+    {
+        std::size_t pos = 2; // skip SOI
+        while ( pos + 4 <= stream.size() && stream[pos] == 0xFF ) {
+            const JOCTET marker = stream[pos + 1];
+            const std::size_t length = ( stream[pos + 2] << 8 ) | stream[pos + 3];
+            if ( marker >= 0xC0 && marker <= 0xCF &&
+                 marker != 0xC4 && marker != 0xC8 && marker != 0xCC )
+                sof = pos;
+            pos += 2 + length;
+            if ( marker == 0xDA )
+                return pos;
+        }
+        vigra_fail( "JPEGEncoder: internal error, no scan found in encoded band." );
+        return 0;
+    }
+
+    // encode band k of the image into streams[k] (called by parallel_foreach())
+    struct JPEGBandEncoder
+    {
+        JPEGBandEncoder( JPEGEncoderImpl & encoder, unsigned int band_rows, unsigned int row_size,
+                         std::vector< std::vector<JOCTET> > & streams )
+        : encoder_(encoder), band_rows_(band_rows), row_size_(row_size), streams_(streams)
+        {}
+
+        void operator()( int, MultiArrayIndex k ) const
+        {
+            const unsigned int first = k * band_rows_;
+            if ( first >= encoder_.height )
+                return;
+            const unsigned int rows = std::min( band_rows_, encoder_.height - first );
+
+            JPEGEncoderImplBase band;
+            band.info.err = jpeg_std_error( ( jpeg_error_mgr * ) &band.err );
+            band.err.pub.error_exit = &JPEGCodecLongjumper;
+
+            JPEGCodecMemoryDestination dest;
+            dest.buffer = &streams_[k];
+            dest.pub.init_destination = &JPEGCodecInitDestination;
+            dest.pub.empty_output_buffer = &JPEGCodecEmptyOutputBuffer;
+            dest.pub.term_destination = &JPEGCodecTermDestination;
+            band.info.dest = &dest.pub;
+
+            encoder_.setup( band.info, rows );
+            band.info.restart_in_rows = 1;
+
+            if (setjmp(band.err.buf))
+                vigra_fail( "error in parallel JPEG compression" );
+            jpeg_start_compress( &band.info, TRUE );
+            if ( k == 0 && encoder_.iccProfile.size() )
+                write_icc_profile( &band.info, encoder_.iccProfile.begin(),
+                                   (unsigned int)encoder_.iccProfile.size() );
+            std::vector<JSAMPROW> row_pointers( rows );
+            for ( unsigned int y = 0; y < rows; ++y )
+                row_pointers[y] = encoder_.bands.data() + ( first + y ) * row_size_;
+            jpeg_write_scanlines( &band.info, &row_pointers[0], rows );
+            jpeg_finish_compress( &band.info );
+        }
+
+        JPEGEncoderImpl & encoder_;
+        unsigned int band_rows_, row_size_;
+        std::vector< std::vector<JOCTET> > & streams_;
+    };
+
+    } // anonymous namespace
+
+    // The image is split into bands whose heights are multiples of the MCU height
+    // (8 rows). All bands are encoded independently with a restart marker after
+    // every MCU row, using identical settings and the standard Huffman tables.
+    // Since a restart marker resets the DC predictions, the entropy-coded data of
+    // the bands can be joined with additional restart markers, after renumbering
+    // all markers in sequence. The headers of the first band (with the frame
+    // height replaced by the total height) become the headers of the file.
+    void JPEGEncoderImpl::write_parallel()
+    {
+        const unsigned int mcu_rows = ( height + 7 ) / 8;
+        const unsigned int band_count = std::min<unsigned int>( mcu_rows, 4 * num_threads );
+        const unsigned int band_rows = 8 * ( ( mcu_rows + band_count - 1 ) / band_count );
+        const unsigned int row_size = width * components;
+
+        std::vector< std::vector<JOCTET> > streams( band_count );
+        parallel_foreach( num_threads, band_count,
+                          JPEGBandEncoder( *this, band_rows, row_size, streams ) );
+
+        // write the headers of the first band with the total height
+        std::size_t sof = 0;
+        std::vector<JOCTET> & head = streams[0];
+        const std::size_t scan = jpeg_scan_start( head, sof );
+        head[sof + 5] = static_cast< JOCTET >( height >> 8 );
+        head[sof + 6] = static_cast< JOCTET >( height & 0xFF );
+        std::fwrite( &head[0], 1, scan, file.get() );
+
+        // join the entropy-coded data, renumbering the restart markers
+        unsigned int restart = 0;
+        for ( unsigned int k = 0; k < band_count && !streams[k].empty(); ++k ) {
+            std::vector<JOCTET> & stream = streams[k];
+            const std::size_t begin = k == 0 ? scan : jpeg_scan_start( stream, sof );
+            const std::size_t end = stream.size() - 2; // skip EOI
+            if ( k > 0 ) {
+                const JOCTET marker[2] = { 0xFF, static_cast< JOCTET >( 0xD0 + ( restart++ & 7 ) ) };
+                std::fwrite( marker, 1, 2, file.get() );
+            }
+            for ( std::size_t i = begin; i + 1 < end; ++i ) {
+                if ( stream[i] == 0xFF && stream[i + 1] >= 0xD0 && stream[i + 1] <= 0xD7 ) {
+                    stream[i + 1] = static_cast< JOCTET >( 0xD0 + ( restart++ & 7 ) );
+                    ++i;
+                }
+            }
+            std::fwrite( &stream[begin], 1, end - begin, file.get() );
+        }
+
+        const JOCTET eoi[2] = { 0xFF, 0xD9 };
+        std::fwrite( eoi, 1, 2, file.get() );
+        vigra_postcondition( !std::ferror( file.get() ), "JPEGEncoder: unable to write file." );
+    }
+
+#endif // VIGRA_SINGLE_THREADED
+
     void JPEGEncoder::init( const std::string & filename )
     {
         pimpl = new JPEGEncoderImpl(filename);
@@ -475,6 +689,16 @@ namespace vigra
         pimpl->quality = quality;
     }
 
+    void JPEGEncoder::setNumThreads( int n )
+    {
+        VIGRA_IMPEX_FINALIZED(pimpl->finalized);
+#ifndef VIGRA_SINGLE_THREADED
+        pimpl->num_threads = ParallelOptions().numThreads(n).getActualNumThreads();
+#else
+        (void)n; // sequential compression only
+#endif
+    }
+
     void JPEGEncoder::setPixelType( const std::string & pixelType )
     {
         VIGRA_IMPEX_FINALIZED(pimpl->finalized);
@@ -499,11 +723,18 @@ namespace vigra
 
     void * JPEGEncoder::currentScanlineOfBand( unsigned int band )
     {
+        if ( pimpl->parallel )
+            return pimpl->bands.data() + pimpl->scanline * pimpl->width * pimpl->components + band;
         return pimpl->bands.data() + band;
     }
 
     void JPEGEncoder::nextScanline()
     {
+        if ( pimpl->parallel ) {
+            ++(pimpl->scanline);
+            return;
+        }
+
         // check if there are scanlines left at all, eventually write one
         JSAMPLE * band = pimpl->bands.data();
         if ( pimpl->info.next_scanline < pimpl->info.image_height ) {
@@ -515,6 +746,13 @@ namespace vigra
 
     void JPEGEncoder::close()
     {
+#ifndef VIGRA_SINGLE_THREADED
+        if ( pimpl->parallel ) {
+            pimpl->write_parallel();
+            return;
+        }
+#endif
+
         // finish any pending compression
         if (setjmp(pimpl->err.buf))
             vigra_fail( "error in jpeg_finish_compress()" );
@@ -66,6 +66,8 @@ namespace vigra {
         unsigned int getHeight() const;
         unsigned int getNumBands() const;
 
+        bool decodeBlock( void *, std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t );
+
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
 
@@ -97,6 +99,7 @@ namespace vigra {
 
         void setCompressionType( const std::string &, int = -1 );
         void setPixelType( const std::string & );
+        void setNumThreads( int );
         unsigned int getOffset() const;
 
         void finalizeSettings();
@@ -46,6 +46,9 @@
 
 #include "vigra/config.hxx"
 #include "vigra/sized_int.hxx"
+#ifndef VIGRA_SINGLE_THREADED
+#include "vigra/parallel_foreach.hxx"
+#endif
 #include "void_vector.hxx"
 #include "auto_file.hxx"
 #include "png.hxx"
@@ -53,10 +56,15 @@
 #include "error.hxx"
 #include <stdexcept>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 extern "C"
 {
 #include <png.h>
+#include <zlib.h>
 }
 
 #if PNG_LIBPNG_VER < 10201
@@ -180,6 +188,8 @@ namespace vigra {
         // methods
         void init();
         void nextScanline();
+        bool decodeBlock( unsigned char * dest, std::ptrdiff_t pixelStride,
+                          std::ptrdiff_t rowStride, std::ptrdiff_t bandStride );
     };
 
     PngDecoderImpl::PngDecoderImpl( const std::string & filename )
@@ -385,6 +395,25 @@ namespace vigra {
         }
     }
 
+    bool PngDecoderImpl::decodeBlock( unsigned char * dest, std::ptrdiff_t pixelStride,
+                                      std::ptrdiff_t rowStride, std::ptrdiff_t bandStride )
+    {
+        // libpng writes interleaved rows, only the row stride is free
+        if ( pixelStride != (std::ptrdiff_t)components || bandStride != 1 )
+            return false;
+
+        // png_read_image() also takes care of the interlace passes
+        const std::ptrdiff_t rowbytes = rowStride * ( bit_depth / 8 );
+        void_vector<png_bytep> rows(height);
+        for ( png_uint_32 y = 0; y < height; ++y )
+            rows[y] = dest + y * rowbytes;
+
+        if (setjmp(png_jmpbuf(png)))
+            vigra_postcondition( false,png_error_message.insert(0, "error in png_read_image(): ").c_str());
+        png_read_image(png, rows.data());
+        return true;
+    }
+
     void PngDecoder::init( const std::string & filename )
     {
         pimpl = new PngDecoderImpl(filename);
@@ -483,6 +512,13 @@ namespace vigra {
         pimpl->nextScanline();
     }
 
+    bool PngDecoder::decodeBlock( void * dest, std::ptrdiff_t pixelStride,
+                                  std::ptrdiff_t rowStride, std::ptrdiff_t bandStride )
+    {
+        return pimpl->decodeBlock( static_cast< unsigned char * >(dest),
+                                   pixelStride, rowStride, bandStride );
+    }
+
     void PngDecoder::close() {}
 
     void PngDecoder::abort() {}
@@ -519,6 +555,9 @@ namespace vigra {
         // resolution
         float x_resolution, y_resolution;
 
+        // number of compression threads
+        int num_threads;
+
         // ctor, dtor
         PngEncoderImpl( const std::string & filename );
         ~PngEncoderImpl();
@@ -526,6 +565,9 @@ namespace vigra {
         // methods
         void finalize();
         void write();
+#ifndef VIGRA_SINGLE_THREADED
+        void write_parallel();
+#endif
     };
 
     PngEncoderImpl::PngEncoderImpl( const std::string & filename )
@@ -536,7 +578,7 @@ namespace vigra {
 #endif
           bands(0),
           scanline(0), finalized(false),
-          x_resolution(0), y_resolution(0)
+          x_resolution(0), y_resolution(0), num_threads(1)
     {
         png_error_message = "";
         // create png struct with user defined handlers
@@ -619,6 +661,13 @@ namespace vigra {
 
     void PngEncoderImpl::write()
     {
+#ifndef VIGRA_SINGLE_THREADED
+        if ( num_threads > 1 ) {
+            write_parallel();
+            return;
+        }
+#endif
+
         // prepare row pointers
         png_uint_32 row_stride = ( bit_depth >> 3 ) * width * components;
         void_vector<png_byte *>  row_pointers(height);
@@ -646,6 +695,188 @@ namespace vigra {
         png_write_end(png, info);
     }
 
+#ifndef VIGRA_SINGLE_THREADED
+
+    namespace {
+
+    inline int png_paeth_predictor( int a, int b, int c )
+    {
+        const int p = a + b - c;
+        const int pa = std::abs( p - a ), pb = std::abs( p - b ), pc = std::abs( p - c );
+        return ( pa <= pb && pa <= pc ) ? a : ( pb <= pc ) ? b : c;
+    }
+
+    // Apply all five PNG filters to 'row' (whose predecessor is 'prev', or 0 for the
+    // first row) and store the filter type and the filtered bytes with the smallest
+    // sum of absolute values in 'dest'. This is the heuristic used by libpng.
+    void png_filter_row( png_byte * dest, const png_byte * row, const png_byte * prev,
+                         std::size_t row_bytes, std::size_t bpp, png_byte * scratch )
+    {
+        unsigned long best_sum = ~0UL;
+        int best_filter = PNG_FILTER_VALUE_NONE;
+        for ( int filter = PNG_FILTER_VALUE_NONE; filter <= PNG_FILTER_VALUE_PAETH; ++filter ) {
+            png_byte * out = scratch + filter * row_bytes;
+            unsigned long sum = 0;
+            for ( std::size_t i = 0; i < row_bytes; ++i ) {
+                const int a = i >= bpp ? row[i - bpp] : 0;
+                const int b = prev ? prev[i] : 0;
+                const int c = ( prev && i >= bpp ) ? prev[i - bpp] : 0;
+                int predicted = 0;
+                switch ( filter ) {
+                case PNG_FILTER_VALUE_SUB:   predicted = a; break;
+                case PNG_FILTER_VALUE_UP:    predicted = b; break;
+                case PNG_FILTER_VALUE_AVG:   predicted = ( a + b ) >> 1; break;
+                case PNG_FILTER_VALUE_PAETH: predicted = png_paeth_predictor( a, b, c ); break;
+                }
+                const png_byte v = static_cast< png_byte >( row[i] - predicted );
+                out[i] = v;
+                sum += v < 128 ? v : 256 - v;
+            }
+            if ( sum < best_sum ) {
+                best_sum = sum;
+                best_filter = filter;
+            }
+        }
+        dest[0] = static_cast< png_byte >( best_filter );
+        std::memcpy( dest + 1, scratch + best_filter * row_bytes, row_bytes );
+    }
+
+    // filter row y (called by parallel_foreach())
+    struct PngRowFilter
+    {
+        PngRowFilter( std::vector<png_byte> & filtered, const png_byte * image,
+                      std::size_t row_bytes, std::size_t bpp,
+                      std::vector< std::vector<png_byte> > & scratch )
+        : filtered_(filtered), image_(image), row_bytes_(row_bytes), bpp_(bpp),
+          scratch_(scratch)
+        {}
+
+        void operator()( int thread, MultiArrayIndex y ) const
+        {
+            png_filter_row( &filtered_[y * ( row_bytes_ + 1 )], image_ + y * row_bytes_,
+                            y > 0 ? image_ + ( y - 1 ) * row_bytes_ : 0,
+                            row_bytes_, bpp_, &scratch_[thread][0] );
+        }
+
+        std::vector<png_byte> & filtered_;
+        const png_byte * image_;
+        std::size_t row_bytes_, bpp_;
+        std::vector< std::vector<png_byte> > & scratch_;
+    };
+
+    // deflate block k of the filtered data as a raw deflate stream
+    // (called by parallel_foreach())
+    struct PngBlockDeflater
+    {
+        PngBlockDeflater( const std::vector<png_byte> & filtered, std::size_t block_size,
+                          std::vector< std::vector<png_byte> > & compressed,
+                          std::vector<uLong> & checksums )
+        : filtered_(filtered), block_size_(block_size), compressed_(compressed),
+          checksums_(checksums)
+        {}
+
+        void operator()( int, MultiArrayIndex k ) const
+        {
+            const std::size_t dictionary_size = 32 * 1024;
+            const std::size_t total = filtered_.size();
+            const std::size_t begin = k * block_size_;
+            const std::size_t size = std::min( block_size_, total - begin );
+            const bool last = k + 1 == (MultiArrayIndex)compressed_.size();
+            // the first block starts with the zlib header
+            const std::size_t header = k == 0 ? 2 : 0;
+
+            z_stream stream;
+            std::memset( &stream, 0, sizeof(stream) );
+            vigra_postcondition( deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                               -15, 8, Z_FILTERED ) == Z_OK,
+                                 "PngEncoder: deflateInit2() failed." );
+            if ( k > 0 ) {
+                const std::size_t dict = std::min( dictionary_size, begin );
+                deflateSetDictionary( &stream, &filtered_[begin - dict], (uInt)dict );
+            }
+
+            std::vector<png_byte> & out = compressed_[k];
+            out.resize( header + deflateBound( &stream, (uLong)size ) + 64 );
+            out[0] = 0x78; // deflate, 32K window
+            out[1] = 0x9c; // default compression level, valid check bits
+            stream.next_in = const_cast< png_byte * >( &filtered_[begin] );
+            stream.avail_in = (uInt)size;
+            stream.next_out = &out[header];
+            stream.avail_out = (uInt)( out.size() - header );
+            const int res = deflate( &stream, last ? Z_FINISH : Z_SYNC_FLUSH );
+            const bool ok = ( last ? res == Z_STREAM_END : res == Z_OK ) &&
+                            stream.avail_in == 0 && stream.avail_out > 0;
+            out.resize( out.size() - stream.avail_out );
+            deflateEnd( &stream );
+            vigra_postcondition( ok, "PngEncoder: deflate() failed." );
+
+            checksums_[k] = adler32( adler32( 0L, Z_NULL, 0 ), &filtered_[begin], (uInt)size );
+        }
+
+        const std::vector<png_byte> & filtered_;
+        std::size_t block_size_;
+        std::vector< std::vector<png_byte> > & compressed_;
+        std::vector<uLong> & checksums_;
+    };
+
+    } // anonymous namespace
+
+    // Parallel compression in the spirit of pigz: the filtered image data are
+    // split into blocks which are deflated independently, using the last 32 KB
+    // of the preceding block as preset dictionary. Each block but the last ends
+    // with a sync flush, so that the raw deflate streams can simply be
+    // concatenated into a single zlib stream, which is written as one IDAT
+    // chunk per block.
+    void PngEncoderImpl::write_parallel()
+    {
+        typedef void_vector<png_byte> vector_type;
+        vector_type & cbands = static_cast< vector_type & >(bands);
+        png_byte * image = cbands.data();
+
+        const std::size_t bpp = ( bit_depth >> 3 ) * components;
+        const std::size_t row_bytes = bpp * width;
+        const std::size_t line_bytes = row_bytes + 1;
+
+        // png files must be big-endian
+        byteorder bo;
+        if ( bit_depth == 16 && bo.get_host_byteorder() == "little endian" ) {
+            for ( std::size_t i = 0; i < row_bytes * height; i += 2 )
+                std::swap( image[i], image[i+1] );
+        }
+
+        // filter the rows (each row only depends on the unfiltered previous row)
+        std::vector<png_byte> filtered( line_bytes * height );
+        std::vector< std::vector<png_byte> > scratch( num_threads,
+                                                      std::vector<png_byte>( 5 * row_bytes ) );
+        parallel_foreach( num_threads, height,
+                          PngRowFilter( filtered, image, row_bytes, bpp, scratch ) );
+
+        // deflate the blocks
+        const std::size_t block_size = 128 * 1024;
+        const std::size_t total = filtered.size();
+        const std::size_t block_count = ( total + block_size - 1 ) / block_size;
+        std::vector< std::vector<png_byte> > compressed( block_count );
+        std::vector<uLong> checksums( block_count );
+        parallel_foreach( num_threads, block_count,
+                          PngBlockDeflater( filtered, block_size, compressed, checksums ) );
+
+        // the zlib stream ends with the checksum of the complete data
+        uLong checksum = adler32( 0L, Z_NULL, 0 );
+        for ( std::size_t k = 0; k < block_count; ++k )
+            checksum = adler32_combine( checksum, checksums[k],
+                                        (z_off_t)std::min( block_size, total - k * block_size ) );
+        for ( int shift = 24; shift >= 0; shift -= 8 )
+            compressed.back().push_back( static_cast< png_byte >( checksum >> shift ) );
+
+        if (setjmp(png_jmpbuf(png)))
+            vigra_postcondition( false, png_error_message.insert(0, "error in png_write_chunk(): ").c_str() );
+        for ( std::size_t k = 0; k < block_count; ++k )
+            png_write_chunk( png, (png_bytep)"IDAT", &compressed[k][0], compressed[k].size() );
+        png_write_chunk( png, (png_bytep)"IEND", 0, 0 );
+    }
+
+#endif // VIGRA_SINGLE_THREADED
+
     void PngEncoder::init( const std::string & filename )
     {
         pimpl = new PngEncoderImpl(filename);
@@ -712,6 +943,16 @@ namespace vigra {
         pimpl->y_resolution = yres;
     }
 
+    void PngEncoder::setNumThreads( int n )
+    {
+        VIGRA_IMPEX_FINALIZED(pimpl->finalized);
+#ifndef VIGRA_SINGLE_THREADED
+        pimpl->num_threads = ParallelOptions().numThreads(n).getActualNumThreads();
+#else
+        (void)n; // sequential compression only
+#endif
+    }
+
     void PngEncoder::setPixelType( const std::string & pixelType )
     {
         VIGRA_IMPEX_FINALIZED(pimpl->finalized);
@@ -89,6 +89,8 @@ namespace vigra {
 
         unsigned int getOffset() const;
 
+        bool decodeBlock( void *, std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t );
+
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
     };
@@ -119,6 +121,7 @@ namespace vigra {
         void setPosition( const Diff2D & pos );
         void setXResolution( float xres );
         void setYResolution( float yres );
+        void setNumThreads( int n );
 
         void finalizeSettings();
 
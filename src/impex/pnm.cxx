@@ -122,6 +122,9 @@ namespace vigra {
         // data storage
         bool raw, bilevel;
 
+        // file position of the first pixel (raw files only)
+        std::size_t data_offset;
+
         // image dimensions
         unsigned int width, height, components;
 
@@ -269,6 +272,7 @@ namespace vigra {
 #else
         : stream( filename.c_str() )
 #endif
+        , data_offset(0)
     {
         long maxval = 1;
         char type;
@@ -396,6 +400,7 @@ namespace vigra {
                   seekOffset *= 4;
 
               stream.seekg( -static_cast<streamOffset>(seekOffset), std::ios::end );
+              data_offset = static_cast<std::size_t>(stream.tellg());
           }
         }
     }
@@ -473,6 +478,44 @@ namespace vigra {
         }
     }
 
+    bool PnmDecoder::decodeBlock( void * dest, std::ptrdiff_t pixelStride,
+                                  std::ptrdiff_t rowStride, std::ptrdiff_t bandStride )
+    {
+        // only raw files store the samples as they are laid out in memory
+        if ( !pimpl->raw || pimpl->bilevel ||
+             pixelStride != (std::ptrdiff_t)pimpl->components || bandStride != 1 )
+            return false;
+
+        const unsigned int count = pimpl->width * pimpl->components;
+        byteorder bo( "big endian" );
+        for ( unsigned int y = 0; y < pimpl->height; ++y ) {
+            if ( pimpl->pixeltype == "UINT8" ) {
+                UInt8 * row = static_cast< UInt8 * >(dest) + y * rowStride;
+                pimpl->stream.read( reinterpret_cast< char * >(row), count );
+            } else if ( pimpl->pixeltype == "UINT16" ) {
+                read_array( pimpl->stream, bo, static_cast< UInt16 * >(dest) + y * rowStride, count );
+            } else {
+                read_array( pimpl->stream, bo, static_cast< UInt32 * >(dest) + y * rowStride, count );
+            }
+        }
+        return true;
+    }
+
+    bool PnmDecoder::getRawDataLayout( std::size_t & offset, std::ptrdiff_t & pixelStride,
+                                       std::ptrdiff_t & rowStride, std::ptrdiff_t & bandStride,
+                                       std::string & byteOrder ) const
+    {
+        if ( !pimpl->raw || pimpl->bilevel )
+            return false;
+
+        offset = pimpl->data_offset;
+        pixelStride = pimpl->components;
+        rowStride = pimpl->width * pimpl->components;
+        bandStride = 1;
+        byteOrder = "big endian";
+        return true;
+    }
+
     void PnmDecoder::close()
     {}
 
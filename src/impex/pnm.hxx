@@ -74,6 +74,10 @@ namespace vigra {
         unsigned int getNumBands() const;
         unsigned int getOffset() const;
 
+        bool decodeBlock( void *, std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t );
+        bool getRawDataLayout( std::size_t &, std::ptrdiff_t &, std::ptrdiff_t &,
+                               std::ptrdiff_t &, std::string & ) const;
+
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
     };
@@ -64,6 +64,7 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <algorithm>
 
 extern "C"
 {
@@ -185,10 +186,13 @@ namespace vigra {
 
         TIFF * tiff;
         tdata_t * stripbuffer;
+        tdata_t tilebuffer;
+        unsigned int buffercount;
         tstrip_t strip;
 
         uint32 stripindex, stripheight;
         uint32 width, height;
+        uint32 tilewidth, tileheight;
         uint16 samples_per_pixel, bits_per_sample,
             photometric, planarconfig, fillorder, extra_samples_per_pixel;
         float x_resolution, y_resolution;
@@ -197,6 +201,10 @@ namespace vigra {
 
         Decoder::ICCProfile iccProfile;
 
+        // allocate 'count' strip buffers of 'size' bytes each
+        void allocateBuffers( unsigned int count, tsize_t size );
+        void freeBuffers();
+
     public:
 
         TIFFCodecImpl();
@@ -208,8 +216,12 @@ namespace vigra {
     {
         tiff = 0;
         stripbuffer = 0;
+        tilebuffer = 0;
+        buffercount = 0;
         strip = 0;
         stripindex = 0;
+        tilewidth = 0;
+        tileheight = 0;
         planarconfig = PLANARCONFIG_CONTIG;
         x_resolution = 0;
         y_resolution = 0;
@@ -218,34 +230,70 @@ namespace vigra {
 
     TIFFCodecImpl::~TIFFCodecImpl()
     {
-        if ( planarconfig == PLANARCONFIG_SEPARATE ) {
-            if ( stripbuffer != 0 ) {
-                for( unsigned int i = 0; i < samples_per_pixel; ++i )
-                    if ( stripbuffer[i] != 0 )
-                        _TIFFfree(stripbuffer[i]);
-                delete[] stripbuffer;
-            }
-        } else {
-            if ( stripbuffer != 0 ) {
-                if ( stripbuffer[0] != 0 )
-                    _TIFFfree(stripbuffer[0]);
-                delete[] stripbuffer;
-            }
-        }
+        freeBuffers();
 
         if ( tiff != 0 )
             TIFFClose(tiff);
     }
 
+    void TIFFCodecImpl::allocateBuffers( unsigned int count, tsize_t size )
+    {
+        freeBuffers();
+
+        stripbuffer = new tdata_t[count];
+        for( unsigned int i = 0; i < count; ++i ) {
+            stripbuffer[i] = 0;
+        }
+        buffercount = count;
+        for( unsigned int i = 0; i < count; ++i ) {
+            stripbuffer[i] = _TIFFmalloc(size);
+            if(stripbuffer[i] == 0)
+                throw std::bad_alloc();
+        }
+    }
+
+    void TIFFCodecImpl::freeBuffers()
+    {
+        if ( stripbuffer != 0 ) {
+            for( unsigned int i = 0; i < buffercount; ++i )
+                if ( stripbuffer[i] != 0 )
+                    _TIFFfree(stripbuffer[i]);
+            delete[] stripbuffer;
+            stripbuffer = 0;
+        }
+        buffercount = 0;
+
+        if ( tilebuffer != 0 ) {
+            _TIFFfree(tilebuffer);
+            tilebuffer = 0;
+        }
+    }
+
     class TIFFDecoderImpl : public TIFFCodecImpl
     {
         friend class TIFFDecoder;
 
+        // index of the next row to be read
         unsigned int scanline;
 
+        // tiled files are decoded one row of tiles at a time, restricted
+        // to the columns of the ROI. 'tilerow_start' and 'tilerow_end'
+        // denote the image rows currently held in the strip buffers.
+        bool tiled, started;
+        uint32 rowsperstrip, tilerow_start, tilerow_end;
+        uint32 roi_x, roi_y, roi_width, roi_height;
+
         std::string get_pixeltype_by_sampleformat() const;
         std::string get_pixeltype_by_datatype() const;
 
+        unsigned int planeCount() const;
+        unsigned int bytesPerPixel() const;
+        UInt8 * scanlinePointer( unsigned int band ) const;
+
+        void allocateDecoderBuffers();
+        void readScanline();
+        void readTileRow( uint32 row );
+
     public:
 
         TIFFDecoderImpl( const std::string & filename );
@@ -256,6 +304,10 @@ namespace vigra {
         void setImageIndex( unsigned int index );
         unsigned int getImageIndex();
 
+        bool setROI( const Diff2D & upperLeft, const Size2D & size );
+        bool decodeBlock( UInt8 * dest, std::ptrdiff_t pixelStride,
+                          std::ptrdiff_t rowStride, std::ptrdiff_t bandStride );
+
         const void * currentScanlineOfBand( unsigned int band ) const;
         void nextScanline();
     };
@@ -361,16 +413,26 @@ namespace vigra {
         TIFFGetField( tiff, TIFFTAG_IMAGELENGTH, &height );
 
         // check for tiled TIFFs
-        uint32 tileWidth, tileHeight;
-        if( TIFFGetField( tiff, TIFFTAG_TILEWIDTH, &tileWidth ) &&
-            TIFFGetField( tiff, TIFFTAG_TILELENGTH, &tileHeight ) )
-            vigra_precondition( (tileWidth == width) && (tileHeight == height),
-                                "TIFFDecoder: "
-                                "Cannot read tiled TIFFs (not implemented)." );
+        tiled = TIFFIsTiled( tiff ) != 0;
+        if ( tiled ) {
+            TIFFGetField( tiff, TIFFTAG_TILEWIDTH, &tilewidth );
+            TIFFGetField( tiff, TIFFTAG_TILELENGTH, &tileheight );
+        } else {
+            if ( !TIFFGetFieldDefaulted( tiff, TIFFTAG_ROWSPERSTRIP, &rowsperstrip ) )
+                rowsperstrip = 1;
+        }
 
         // find out strip heights
         stripheight = 1; // now using scanline interface instead of strip interface
 
+        // by default, the whole image is decoded
+        roi_x = roi_y = 0;
+        roi_width = width;
+        roi_height = height;
+        scanline = 0;
+        tilerow_start = tilerow_end = 0;
+        started = false;
+
         // get samples_per_pixel
         samples_per_pixel = 0;
         extra_samples_per_pixel = 0;
@@ -525,6 +587,9 @@ namespace vigra {
                 fillorder = FILLORDER_MSB2LSB;
         }
 
+        if ( tiled && bits_per_sample % 8 != 0 )
+            vigra_fail( "TIFFDecoder: Cannot read tiled bilevel TIFFs (not implemented)." );
+
         // make sure the LogLuv has correct pixeltype because only float is supported
         if (photometric == PHOTOMETRIC_LOGLUV) {
             pixeltype = "FLOAT";
@@ -596,30 +661,114 @@ namespace vigra {
             iccProfile.swap(iccData);
         }
 
-        // allocate data buffers
-        const unsigned int stripsize = TIFFScanlineSize(tiff);
-        if ( planarconfig == PLANARCONFIG_SEPARATE ) {
-            stripbuffer = new tdata_t[samples_per_pixel];
-            for( unsigned int i = 0; i < samples_per_pixel; ++i ) {
-                stripbuffer[i] = 0;
-            }
-            for( unsigned int i = 0; i < samples_per_pixel; ++i ) {
-                stripbuffer[i] = _TIFFmalloc(stripsize);
-                if(stripbuffer[i] == 0)
-                    throw std::bad_alloc();
-            }
-        } else {
-            stripbuffer = new tdata_t[1];
-            stripbuffer[0] = 0;
-            stripbuffer[0] = _TIFFmalloc(stripsize < width ? width : stripsize);
-            if(stripbuffer[0] == 0)
-                throw std::bad_alloc();
-        }
+        allocateDecoderBuffers();
 
         // let the codec read a new strip
         stripindex = stripheight;
     }
 
+    unsigned int TIFFDecoderImpl::planeCount() const
+    {
+        return planarconfig == PLANARCONFIG_SEPARATE ? samples_per_pixel : 1;
+    }
+
+    // bytes per pixel within one plane of the strip buffers
+    unsigned int TIFFDecoderImpl::bytesPerPixel() const
+    {
+        return ( bits_per_sample / 8 ) *
+            ( planarconfig == PLANARCONFIG_SEPARATE ? 1 : samples_per_pixel );
+    }
+
+    void TIFFDecoderImpl::allocateDecoderBuffers()
+    {
+        if ( tiled ) {
+            // one row of tiles, restricted to the ROI
+            allocateBuffers( planeCount(),
+                             (tsize_t)roi_width * tileheight * bytesPerPixel() );
+            tilebuffer = _TIFFmalloc( TIFFTileSize(tiff) );
+            if(tilebuffer == 0)
+                throw std::bad_alloc();
+        } else {
+            const tsize_t stripsize = TIFFScanlineSize(tiff);
+            if ( planarconfig == PLANARCONFIG_SEPARATE )
+                allocateBuffers( samples_per_pixel, stripsize );
+            else
+                allocateBuffers( 1, stripsize < (tsize_t)width ? (tsize_t)width : stripsize );
+        }
+    }
+
+    bool TIFFDecoderImpl::setROI( const Diff2D & upperLeft, const Size2D & size )
+    {
+        vigra_precondition( !started,
+            "TIFFDecoder::setROI(): must be called before the first scanline is read." );
+        vigra_precondition( upperLeft.x >= 0 && upperLeft.y >= 0 &&
+                            size.x > 0 && size.y > 0 &&
+                            (uint32)(upperLeft.x + size.x) <= width &&
+                            (uint32)(upperLeft.y + size.y) <= height,
+            "TIFFDecoder::setROI(): region of interest exceeds the image." );
+
+        // bilevel images are expanded in complete scanlines, let the caller crop them
+        if ( bits_per_sample == 1 )
+            return false;
+
+        roi_x = upperLeft.x;
+        roi_y = upperLeft.y;
+        roi_width = size.x;
+        roi_height = size.y;
+
+        if ( tiled ) {
+            scanline = roi_y;
+            allocateDecoderBuffers();
+        } else {
+            // compressed strips can only be decoded from their first row on
+            scanline = roi_y - roi_y % rowsperstrip;
+        }
+        return true;
+    }
+
+    bool TIFFDecoderImpl::decodeBlock( UInt8 * dest, std::ptrdiff_t pixelStride,
+                                       std::ptrdiff_t rowStride, std::ptrdiff_t bandStride )
+    {
+        // TIFFReadScanline() writes complete interleaved rows, so the
+        // destination must match the file layout exactly
+        if ( started || tiled || bits_per_sample % 8 != 0 ||
+             planarconfig == PLANARCONFIG_SEPARATE ||
+             photometric == PHOTOMETRIC_MINISWHITE ||
+             photometric == PHOTOMETRIC_LOGL || photometric == PHOTOMETRIC_LOGLUV ||
+             roi_x != 0 || roi_width != width ||
+             pixelStride != (std::ptrdiff_t)samples_per_pixel || bandStride != 1 )
+            return false;
+
+        const std::ptrdiff_t rowbytes = rowStride * ( bits_per_sample / 8 );
+        const uint32 roi_end = roi_y + roi_height;
+        started = true;
+
+        // rows between the strip start and the ROI go to the scratch buffer
+        for( ; scanline < roi_end; ++scanline ) {
+            tdata_t buf = scanline < roi_y
+                ? stripbuffer[0]
+                : static_cast< tdata_t >(dest + ( scanline - roi_y ) * rowbytes);
+            if ( TIFFReadScanline( tiff, buf, scanline, 0 ) == -1 )
+                vigra_fail( "TIFFDecoder: Unable to read scanline." );
+        }
+        return true;
+    }
+
+    UInt8 * TIFFDecoderImpl::scanlinePointer( unsigned int band ) const
+    {
+        const unsigned int bytes = bits_per_sample / 8;
+        const unsigned int plane = planarconfig == PLANARCONFIG_SEPARATE ? band : 0;
+        const unsigned int first = planarconfig == PLANARCONFIG_SEPARATE ? 0 : band;
+        UInt8 * buf = static_cast< UInt8 * >(stripbuffer[plane]) + first * bytes;
+
+        if ( tiled ) {
+            // the buffer holds the ROI columns of the current tile row
+            return buf + ( scanline - 1 - tilerow_start ) * roi_width * bytesPerPixel();
+        } else {
+            return buf + roi_x * bytesPerPixel();
+        }
+    }
+
     const void *
     TIFFDecoderImpl::currentScanlineOfBand( unsigned int band ) const
     {
@@ -648,46 +797,85 @@ namespace vigra {
             // XXX probably right
             return startpointer + ( stripindex * width ) / 8;
         } else {
-            if ( planarconfig == PLANARCONFIG_SEPARATE ) {
-                UInt8 * const buf
-                    = static_cast< UInt8 * >(stripbuffer[band]);
-                return buf + ( stripindex * width ) * ( bits_per_sample / 8 );
-            } else {
-                UInt8 * const buf
-                    = static_cast< UInt8 * >(stripbuffer[0]);
-                return buf + ( band + stripindex * width * samples_per_pixel )
-                    * ( bits_per_sample / 8 );
+            return scanlinePointer( band );
+        }
+    }
+
+    void TIFFDecoderImpl::readScanline()
+    {
+        if ( planarconfig == PLANARCONFIG_SEPARATE ) {
+            for( unsigned int i = 0; i < samples_per_pixel; ++i )
+                if ( TIFFReadScanline( tiff, stripbuffer[i], scanline, (tsample_t)i ) == -1 )
+                    vigra_fail( "TIFFDecoder: Unable to read scanline." );
+        } else {
+            if ( TIFFReadScanline( tiff, stripbuffer[0], scanline, 0 ) == -1 )
+                vigra_fail( "TIFFDecoder: Unable to read scanline." );
+        }
+        ++scanline;
+    }
+
+    void TIFFDecoderImpl::readTileRow( uint32 row )
+    {
+        const unsigned int pixelbytes = bytesPerPixel();
+        const uint32 tiley = row - row % tileheight;
+        const uint32 rows = std::min( tileheight, height - tiley );
+        const uint32 roi_end = roi_x + roi_width;
+
+        // only decode the tiles intersecting the ROI
+        for( uint32 tilex = roi_x - roi_x % tilewidth; tilex < roi_end; tilex += tilewidth ) {
+            const uint32 begin = std::max( tilex, roi_x );
+            const uint32 end = std::min( tilex + tilewidth, roi_end );
+
+            for( unsigned int plane = 0; plane < planeCount(); ++plane ) {
+                if ( TIFFReadTile( tiff, tilebuffer, tilex, tiley, 0, (tsample_t)plane ) == -1 )
+                    vigra_fail( "TIFFDecoder: Unable to read tile." );
+
+                const UInt8 * src = static_cast< UInt8 * >(tilebuffer)
+                    + ( begin - tilex ) * pixelbytes;
+                UInt8 * dest = static_cast< UInt8 * >(stripbuffer[plane])
+                    + ( begin - roi_x ) * pixelbytes;
+                for( uint32 y = 0; y < rows; ++y ) {
+                    _TIFFmemcpy( dest, src, ( end - begin ) * pixelbytes );
+                    src += tilewidth * pixelbytes;
+                    dest += roi_width * pixelbytes;
+                }
             }
         }
+
+        tilerow_start = tiley;
+        tilerow_end = tiley + rows;
     }
 
     void TIFFDecoderImpl::nextScanline()
     {
+        started = true;
+
+        if ( tiled ) {
+            if ( scanline >= tilerow_end )
+                readTileRow( scanline );
+            ++scanline;
+        }
         // eventually read a new strip
-        if ( ++stripindex >= stripheight ) {
+        else if ( ++stripindex >= stripheight ) {
             stripindex = 0;
 
-            if ( planarconfig == PLANARCONFIG_SEPARATE ) {
-                const tsize_t size = TIFFScanlineSize(tiff);
-                for( unsigned int i = 0; i < samples_per_pixel; ++i )
-                    TIFFReadScanline(tiff, stripbuffer[i], scanline++, size);
-            } else {
-                TIFFReadScanline( tiff, stripbuffer[0], scanline++, 0);
-            }
+            // skip the rows between the strip start and the ROI
+            do {
+                readScanline();
+            } while ( scanline <= roi_y );
+        }
 
-            // XXX handle bilevel images
+        // XXX handle bilevel images
 
-            // invert grayscale images that interpret 0 as white
-            if ( photometric == PHOTOMETRIC_MINISWHITE &&
-                 samples_per_pixel == 1 && pixeltype == "UINT8" ) {
+        // invert grayscale images that interpret 0 as white
+        if ( photometric == PHOTOMETRIC_MINISWHITE &&
+             samples_per_pixel == 1 && pixeltype == "UINT8" ) {
 
-                UInt8 * buf = static_cast< UInt8 * >(stripbuffer[0]);
-                const unsigned int n = TIFFScanlineSize(tiff);
+            UInt8 * buf = scanlinePointer(0);
 
-                // invert every pixel
-                for ( unsigned int i = 0; i < n; ++i, ++buf )
-                    *buf = 0xff - *buf;
-            }
+            // invert every pixel
+            for ( unsigned int i = 0; i < roi_width; ++i, ++buf )
+                *buf = 0xff - *buf;
         }
     }
 
@@ -710,12 +898,24 @@ namespace vigra {
 
     unsigned int TIFFDecoder::getWidth() const
     {
-        return pimpl->width;
+        return pimpl->roi_width;
     }
 
     unsigned int TIFFDecoder::getHeight() const
     {
-        return pimpl->height;
+        return pimpl->roi_height;
+    }
+
+    bool TIFFDecoder::setROI( const Diff2D & upperLeft, const Size2D & size )
+    {
+        return pimpl->setROI( upperLeft, size );
+    }
+
+    bool TIFFDecoder::decodeBlock( void * dest, std::ptrdiff_t pixelStride,
+                                   std::ptrdiff_t rowStride, std::ptrdiff_t bandStride )
+    {
+        return pimpl->decodeBlock( static_cast< UInt8 * >(dest),
+                                   pixelStride, rowStride, bandStride );
     }
 
     unsigned int TIFFDecoder::getNumBands() const
@@ -817,17 +1017,13 @@ namespace vigra {
 
         // attributes
 
+        std::string filename, mode;
         unsigned short tiffcomp;
         bool finalized;
 
-    public:
-
-        // ctor, dtor
-
-        TIFFEncoderImpl( const std::string & filename, const std::string & mode )
-            : tiffcomp(COMPRESSION_LZW), finalized(false)
+        void open( const std::string & openmode )
         {
-            tiff = TIFFOpen( filename.c_str(), mode.c_str() );
+            tiff = TIFFOpen( filename.c_str(), openmode.c_str() );
             if (!tiff)
             {
                 std::string msg("Unable to open file '");
@@ -835,13 +1031,25 @@ namespace vigra {
                 msg += "'.";
                 vigra_precondition( false, msg.c_str() );
             }
+        }
+
+        int writeTileRow( unsigned int rows );
 
+    public:
+
+        // ctor, dtor
+
+        TIFFEncoderImpl( const std::string & filename, const std::string & mode )
+            : filename(filename), mode(mode), tiffcomp(COMPRESSION_LZW), finalized(false)
+        {
+            open( mode );
             planarconfig = PLANARCONFIG_CONTIG;
         }
 
         // methods
 
         void setCompressionType( const std::string &, int );
+        void setTileSize( const Size2D & size );
         void finalizeSettings();
 
         void * currentScanlineOfBand( unsigned int band ) const
@@ -863,8 +1071,11 @@ namespace vigra {
                 // write next strip
                 stripindex = 0;
 
-                int success = TIFFWriteEncodedStrip( tiff, strip++, stripbuffer[0],
-                                       TIFFVStripSize( tiff, rows ) );
+                int success = tilewidth > 0
+                    ? writeTileRow( rows )
+                    : TIFFWriteEncodedStrip( tiff, strip, stripbuffer[0],
+                                             TIFFVStripSize( tiff, rows ) );
+                ++strip;
                 if(success == -1 && tiffcomp != COMPRESSION_NONE)
                 {
                     throw Encoder::TIFFCompressionException(); // retry without compression
@@ -895,8 +1106,75 @@ namespace vigra {
             tiffcomp = COMPRESSION_DEFLATE;
     }
 
+    // cut the buffered rows into tiles, padding the ones at the
+    // right and bottom border with zeros
+    int TIFFEncoderImpl::writeTileRow( unsigned int rows )
+    {
+        const unsigned int pixelbytes = samples_per_pixel * ( bits_per_sample >> 3 );
+        const tsize_t tilesize = TIFFTileSize( tiff );
+
+        for( uint32 x = 0; x < width; x += tilewidth ) {
+            const uint32 columns = std::min( tilewidth, width - x );
+            const UInt8 * src = static_cast< UInt8 * >(stripbuffer[0]) + x * pixelbytes;
+            UInt8 * dest = static_cast< UInt8 * >(tilebuffer);
+
+            if ( columns < tilewidth || rows < tileheight )
+                _TIFFmemset( tilebuffer, 0, tilesize );
+            for( unsigned int y = 0; y < rows; ++y ) {
+                _TIFFmemcpy( dest, src, columns * pixelbytes );
+                src += width * pixelbytes;
+                dest += tilewidth * pixelbytes;
+            }
+
+            ttile_t tile = TIFFComputeTile( tiff, x, strip * tileheight, 0, 0 );
+            if ( TIFFWriteEncodedTile( tiff, tile, tilebuffer, tilesize ) == -1 )
+                return -1;
+        }
+        return 0;
+    }
+
+    void TIFFEncoderImpl::setTileSize( const Size2D & size )
+    {
+        // TIFF requires tile dimensions to be multiples of 16
+        if ( size.x > 0 && size.y > 0 ) {
+            tilewidth = ( size.x + 15 ) / 16 * 16;
+            tileheight = ( size.y + 15 ) / 16 * 16;
+        } else {
+            tilewidth = tileheight = 0;
+        }
+    }
+
     void TIFFEncoderImpl::finalizeSettings()
     {
+        // bilevel data is always written in strips
+        if ( pixeltype == "BILEVEL" )
+            tilewidth = tileheight = 0;
+
+        // classic TIFF uses 32-bit file offsets, switch to BigTIFF when the
+        // (uncompressed) data may not fit, leaving some room for the tags
+        if ( mode.find('w') != std::string::npos && mode.find('8') == std::string::npos ) {
+            unsigned int bytes = 1;
+            if ( pixeltype == "INT16" || pixeltype == "UINT16" )
+                bytes = 2;
+            else if ( pixeltype == "INT32" || pixeltype == "UINT32" || pixeltype == "FLOAT" )
+                bytes = 4;
+            else if ( pixeltype == "DOUBLE" )
+                bytes = 8;
+            const UIntBiggest size = static_cast<UIntBiggest>(width) * height *
+                                     samples_per_pixel * bytes;
+            if ( size > static_cast<UIntBiggest>(0xF0000000u) ) {
+#if TIFFLIB_VERSION >= 20111221
+                TIFFClose( tiff );
+                tiff = 0;
+                open( mode + "8" );
+#else
+                // BigTIFF requires libtiff 4.0
+                vigra_fail( "TIFFEncoder: Image too large for classic TIFF, "
+                            "and this libtiff version cannot write BigTIFF." );
+#endif
+            }
+        }
+
         // decide if we should write Grey, or RGB files
         // all additional channels are treated as extra samples
         if (samples_per_pixel < 3) {
@@ -909,14 +1187,21 @@ namespace vigra {
         TIFFSetField( tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG );
         TIFFSetField( tiff, TIFFTAG_IMAGEWIDTH, width );
         TIFFSetField( tiff, TIFFTAG_IMAGELENGTH, height );
-        // TIFFDefaultStripSize tries for 8kb strips! Laughable!
-        // This will do a 1MB strip for 8-bit images,
-        // 2MB strip for 16-bit, and so forth.
-        unsigned int estimate =
-            (unsigned int)std::max(static_cast<UIntBiggest>(1),
-                                  (static_cast<UIntBiggest>(1)<<20) / (width * samples_per_pixel));
-        TIFFSetField( tiff, TIFFTAG_ROWSPERSTRIP,
-                      stripheight = TIFFDefaultStripSize( tiff, estimate ) );
+        if ( tilewidth > 0 ) {
+            // the scanline interface fills one row of tiles at a time
+            TIFFSetField( tiff, TIFFTAG_TILEWIDTH, tilewidth );
+            TIFFSetField( tiff, TIFFTAG_TILELENGTH, tileheight );
+            stripheight = tileheight;
+        } else {
+            // TIFFDefaultStripSize tries for 8kb strips! Laughable!
+            // This will do a 1MB strip for 8-bit images,
+            // 2MB strip for 16-bit, and so forth.
+            unsigned int estimate =
+                (unsigned int)std::max(static_cast<UIntBiggest>(1),
+                                      (static_cast<UIntBiggest>(1)<<20) / (width * samples_per_pixel));
+            TIFFSetField( tiff, TIFFTAG_ROWSPERSTRIP,
+                          stripheight = TIFFDefaultStripSize( tiff, estimate ) );
+        }
         TIFFSetField( tiff, TIFFTAG_SAMPLESPERPIXEL, samples_per_pixel );
         TIFFSetField( tiff, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT );
         TIFFSetField( tiff, TIFFTAG_COMPRESSION, tiffcomp );
@@ -1001,11 +1286,14 @@ namespace vigra {
         }
 
         // alloc memory
-        stripbuffer = new tdata_t[1];
-        stripbuffer[0] = 0;
-        stripbuffer[0] = _TIFFmalloc( TIFFStripSize(tiff) );
-        if(stripbuffer[0] == 0)
-            throw std::bad_alloc();
+        if ( tilewidth > 0 ) {
+            allocateBuffers( 1, TIFFScanlineSize(tiff) * tileheight );
+            tilebuffer = _TIFFmalloc( TIFFTileSize(tiff) );
+            if(tilebuffer == 0)
+                throw std::bad_alloc();
+        } else {
+            allocateBuffers( 1, TIFFStripSize(tiff) );
+        }
 
         finalized = true;
     }
@@ -1080,6 +1368,12 @@ namespace vigra {
         pimpl->y_resolution = yres;
     }
 
+    void TIFFEncoder::setTileSize( const Size2D & size )
+    {
+        VIGRA_IMPEX_FINALIZED(pimpl->finalized);
+        pimpl->setTileSize(size);
+    }
+
     unsigned int TIFFEncoder::getOffset() const
     {
         return pimpl->samples_per_pixel;
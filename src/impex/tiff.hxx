@@ -89,6 +89,9 @@ namespace vigra {
         float getXResolution() const;
         float getYResolution() const;
 
+        bool setROI( const Diff2D & upperLeft, const Size2D & size );
+        bool decodeBlock( void *, std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t );
+
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
 
@@ -127,6 +130,7 @@ namespace vigra {
         void setCanvasSize( const Size2D & pos );
         void setXResolution( float xres );
         void setYResolution( float yres );
+        void setTileSize( const Size2D & size );
 
         unsigned int getOffset() const;
 
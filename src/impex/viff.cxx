@@ -522,22 +522,28 @@ namespace vigra {
         ViffHeader header;
         void_vector_base maps, bands;
 
+        // data source, kept open until the bands have been read
+        std::ifstream stream;
+        byteorder bo;
+        bool bands_loaded;
+
         ViffDecoderImpl( const std::string & filename );
 
+        void load_bands();
         void read_maps( std::ifstream & stream, byteorder & bo );
         void read_bands( std::ifstream & stream, byteorder & bo );
         void color_map();
     };
 
     ViffDecoderImpl::ViffDecoderImpl( const std::string & filename )
-        : pixelType("undefined"), current_scanline(-1)
-    {
+        : pixelType("undefined"), current_scanline(-1),
 #ifdef VIGRA_NEED_BIN_STREAMS
-        std::ifstream stream( filename.c_str(), std::ios::binary );
+          stream( filename.c_str(), std::ios::binary ),
 #else
-        std::ifstream stream( filename.c_str() );
+          stream( filename.c_str() ),
 #endif
-        
+          bo( "big endian" ), bands_loaded(false)
+    {
         if(!stream.good())
         {
             std::string msg("Unable to open file '");
@@ -545,7 +551,6 @@ namespace vigra {
             msg += "'.";
             vigra_precondition(0, msg.c_str());
         }
-        byteorder bo( "big endian" );
 
         // get header
         header.from_stream( stream, bo );
@@ -553,12 +558,43 @@ namespace vigra {
         height = header.col_size;
         components = header.num_data_bands;
 
+        if ( header.map_scheme != VFF_MS_NONE )
+        {
+            // the pixel type and number of bands depend on the map
+            load_bands();
+            return;
+        }
+
+        // unmapped data are read on the first call to nextScanline(), so
+        // that the header can be queried without loading the whole file
+        if ( header.data_storage_type == VFF_TYP_1_BYTE )
+            pixelType = "UINT8";
+        else if ( header.data_storage_type == VFF_TYP_2_BYTE )
+            pixelType = "INT16";
+        else if ( header.data_storage_type == VFF_TYP_4_BYTE )
+            pixelType = "INT32";
+        else if ( header.data_storage_type == VFF_TYP_FLOAT )
+            pixelType = "FLOAT";
+        else if ( header.data_storage_type == VFF_TYP_DOUBLE )
+            pixelType = "DOUBLE";
+        else
+            vigra_precondition( false, "storage type unsupported" );
+    }
+
+    void ViffDecoderImpl::load_bands()
+    {
+        if ( bands_loaded )
+            return;
+
         // read data and eventually map it
         if ( header.map_scheme != VFF_MS_NONE )
             read_maps( stream, bo );
         read_bands( stream, bo );
         if ( header.map_scheme != VFF_MS_NONE )
             color_map();
+
+        stream.close();
+        bands_loaded = true;
     }
 
     void ViffDecoderImpl::read_maps( std::ifstream & stream, byteorder & bo )
@@ -884,9 +920,28 @@ namespace vigra {
 
     void ViffDecoder::nextScanline()
     {
+        pimpl->load_bands();
         ++(pimpl->current_scanline);
     }
 
+    bool ViffDecoder::getRawDataLayout( std::size_t & offset, std::ptrdiff_t & pixelStride,
+                                        std::ptrdiff_t & rowStride, std::ptrdiff_t & bandStride,
+                                        std::string & byteOrder ) const
+    {
+        // mapped data must be converted through the color map
+        if ( pimpl->header.map_scheme != VFF_MS_NONE )
+            return false;
+
+        // the header occupies the first 1024 bytes, followed by the bands
+        // stored one after the other
+        offset = 1024;
+        pixelStride = 1;
+        rowStride = pimpl->width;
+        bandStride = pimpl->width * pimpl->height;
+        byteOrder = pimpl->bo.get();
+        return true;
+    }
+
     void ViffDecoder::close() {}
     void ViffDecoder::abort() {}
 
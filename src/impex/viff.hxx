@@ -73,6 +73,9 @@ namespace vigra {
         unsigned int getNumBands() const;
         unsigned int getOffset() const;
 
+        bool getRawDataLayout( std::size_t &, std::ptrdiff_t &, std::ptrdiff_t &,
+                               std::ptrdiff_t &, std::string & ) const;
+
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
     };
@@ -198,6 +198,105 @@ struct BlockwiseWatershedTest
                                      correct_labels.begin(), correct_labels.end()),
                     true);
     }
+
+    template <class Array>
+    void seededTestImpl(Array const & data, WatershedOptions const & options)
+    {
+        typedef typename Array::difference_type Shape;
+        typedef MultiArray<3, unsigned int> LabelArray;
+
+        LabelArray seeds(data.shape());
+        srand(42);
+        for(unsigned int k=1; k<=12; ++k)
+            seeds[rand() % data.size()] = k;
+
+        vector<Shape> block_shapes;
+        block_shapes.push_back(Shape(1));
+        block_shapes.push_back(Shape(4, 5, 3));
+        block_shapes.push_back(Shape(8));
+        block_shapes.push_back(Shape(100));
+        
+        vector<NeighborhoodType> neighborhoods;
+        neighborhoods.push_back(DirectNeighborhood);
+        neighborhoods.push_back(IndirectNeighborhood);
+
+        for(unsigned int k = 0; k != neighborhoods.size(); ++k)
+        {
+            LabelArray correct_labels(seeds);
+            unsigned int correct_label_number = watershedsMultiArray(data, correct_labels, neighborhoods[k], options);
+
+            for(unsigned int j = 0; j != block_shapes.size(); ++j)
+            {
+                for(int threads = 0; threads <= 4; threads += 4)
+                {
+                    LabelArray tested_labels(seeds);
+                    unsigned int tested_label_number = 
+                        seededWatershedsBlockwise(data, tested_labels, neighborhoods[k], options, 
+                                                  block_shapes[j], ParallelOptions().numThreads(threads));
+                    shouldEqual(tested_label_number, correct_label_number);
+                    if(tested_labels != correct_labels)
+                    {
+                        ostringstream oss;
+                        oss << "labeling not equal" << endl;
+                        oss << "block shape: " << block_shapes[j] << endl;
+                        oss << "neighborhood: " << neighborhoods[k] << endl;
+                        oss << "threads: " << threads << endl;
+                        failTest(oss.str().c_str());
+                    }
+                }
+            }
+        }
+    }
+
+    void seededTest()
+    {
+        typedef MultiArray<3, float> Array;
+        
+        // distinct data values, so that there are no ties
+        Array data(Shape3(23, 17, 11));
+        linearSequence(data.begin(), data.end(), 0.5);
+        srand(1);
+        for(int k = data.size()-1; k > 0; --k)
+            std::swap(data[k], data[rand() % (k+1)]);
+
+        seededTestImpl(data, WatershedOptions());
+        seededTestImpl(data, WatershedOptions().stopAtThreshold(data.size() / 3));
+
+        // integer data => bucket queue
+        MultiArray<3, UInt16> data16(data);
+        seededTestImpl(data16, WatershedOptions());
+        seededTestImpl(data16, WatershedOptions().stopAtThreshold(data.size() / 3));
+
+        // signed integer data => bucket queue with negative offset
+        MultiArray<3, Int16> data16s(data16);
+        data16s -= 2000;
+        seededTestImpl(data16s, WatershedOptions());
+        seededTestImpl(data16s, WatershedOptions().stopAtThreshold(-1000.0));
+
+        // quantized bucket queue (enough buckets to keep all values apart)
+        seededTestImpl(data, WatershedOptions().turboAlgorithm(4*data.size()));
+
+        // with ties, only the number of regions is guaranteed to be equal
+        MultiArray<3, UInt8> data8(data.shape());
+        fillRandom(data8.begin(), data8.end(), 20);
+        MultiArray<3, unsigned int> labels(data.shape()), correct_labels(data.shape());
+        unsigned int count = watershedsMultiArray(data8, correct_labels, IndirectNeighborhood);
+        shouldEqual(seededWatershedsBlockwise(data8, labels, IndirectNeighborhood, WatershedOptions(), Shape3(5)), count);
+        should(labels.all());
+
+        try
+        {
+            seededWatershedsBlockwise(data8, labels, IndirectNeighborhood, WatershedOptions().keepContours());
+            failTest("no exception thrown");
+        }
+        catch(PreconditionViolation &) {}
+        try
+        {
+            seededWatershedsBlockwise(data8, labels, IndirectNeighborhood, WatershedOptions().biasLabel(1, 0.73));
+            failTest("no exception thrown");
+        }
+        catch(PreconditionViolation &) {}
+    }
 };
 
 struct BlockwiseWatershedTestSuite
@@ -209,6 +308,7 @@ struct BlockwiseWatershedTestSuite
         add(testCase(&BlockwiseWatershedTest::fourDimensionalRandomTest));
         add(testCase(&BlockwiseWatershedTest::oneDimensionalTest));
         add(testCase(&BlockwiseWatershedTest::chunkedTest));
+        add(testCase(&BlockwiseWatershedTest::seededTest));
     }
 };
 
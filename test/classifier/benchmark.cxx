@@ -0,0 +1,349 @@
+/************************************************************************/
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+/*
+    Random forest benchmark.
+
+    Trains and applies random forests on synthetic data and reports
+    learn() throughput, predictProbabilities() throughput, the memory
+    high-water mark and the scaling across threads as JSON.
+
+    Usage:
+        classifier_benchmark [options]
+
+    Options (lists are comma separated):
+        --samples  n1,n2,...   number of training samples  (default: 10000)
+        --features f1,f2,...   number of features          (default: 10,50)
+        --threads  t1,t2,...   thread counts               (default: 1,2,4)
+        --trees    n           trees per forest            (default: 32)
+        --classes  n           number of classes           (default: 2)
+        --predict  n           samples to predict          (default: same as training)
+        --max-memory MB        skip configurations whose feature matrices
+                               need more memory than this  (default: 4096)
+        --sweep                use samples 10^4 ... 10^8 and features
+                               10, 50, 100, 500
+        --output   file        write the JSON report to file (default: stdout)
+
+    RandomForest::learn() and predictProbabilities() are single-threaded.
+    With t threads, learning trains t forests of (trees / t) trees each on
+    the same data (as one would do to parallelize training), and prediction
+    splits the samples into t contiguous row blocks which are classified
+    by the same forest. Features are stored as float to halve the memory
+    of the large configurations.
+
+    The memory high-water mark is the peak resident set size of the whole
+    process, i.e. it never decreases between consecutive configurations.
+*/
+
+#include <vigra/random_forest.hxx>
+#include <vigra/random.hxx>
+#include <vigra/threading.hxx>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+# include <windows.h>
+# include <psapi.h>
+#else
+# include <sys/resource.h>
+#endif
+
+using namespace vigra;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// peak resident set size of this process in bytes
+double peakMemory()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return (double)counters.PeakWorkingSetSize;
+    return 0.0;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.0;
+# ifdef __APPLE__
+    return (double)usage.ru_maxrss;          // bytes
+# else
+    return (double)usage.ru_maxrss * 1024.0; // kilobytes
+# endif
+#endif
+}
+
+std::vector<long> parseList(std::string const & s)
+{
+    std::vector<long> res;
+    std::stringstream stream(s);
+    std::string item;
+    while(std::getline(stream, item, ','))
+        res.push_back(std::atol(item.c_str()));
+    return res;
+}
+
+/* Synthetic classification problem: uniformly distributed features,
+   the label is determined by a random linear function of the first
+   (at most 10) features plus some label noise.
+*/
+void makeProblem(MultiArray<2, float> & features, MultiArray<2, UInt32> & labels,
+                 int classCount, UInt32 seed)
+{
+    // the weights must be the same for training and test data
+    RandomMT19937 weightRandom(0);
+    int informative = std::min<int>(10, (int)features.shape(1));
+    std::vector<double> weights(informative);
+    double norm = 0.0;
+    for(int j = 0; j < informative; ++j)
+    {
+        weights[j] = weightRandom.uniform53() - 0.5;
+        norm += std::abs(weights[j]);
+    }
+
+    RandomMT19937 random(seed);
+    for(MultiArrayIndex i = 0; i < features.shape(0); ++i)
+    {
+        double score = 0.0;
+        for(MultiArrayIndex j = 0; j < features.shape(1); ++j)
+        {
+            features(i, j) = (float)random.uniform53();
+            if(j < informative)
+                score += weights[j] * (features(i, j) - 0.5);
+        }
+        // map score to [0, 1) and add 5% label noise
+        score = score / norm + 0.5;
+        if(random.uniform53() < 0.05)
+            score = random.uniform53();
+        int label = (int)(score * classCount);
+        labels(i, 0) = (UInt32)std::max(0, std::min(classCount - 1, label));
+    }
+}
+
+struct Options
+{
+    std::vector<long> samples, features, threads;
+    int trees, classes;
+    long predict;
+    double maxMemory;
+    std::string output;
+
+    Options()
+    : trees(32), classes(2), predict(0), maxMemory(4096.0)
+    {
+        samples.push_back(10000);
+        features.push_back(10);
+        features.push_back(50);
+        threads.push_back(1);
+        threads.push_back(2);
+        threads.push_back(4);
+    }
+};
+
+void runConfiguration(long sampleCount, long featureCount, Options const & options,
+                      std::ostream & json, bool & first)
+{
+    long predictCount = options.predict > 0 ? options.predict : sampleCount;
+    double requiredMB = (double)(sampleCount + predictCount) * featureCount * sizeof(float)
+                        / (1024.0 * 1024.0);
+    if(requiredMB > options.maxMemory)
+    {
+        std::cerr << "skipping samples=" << sampleCount << " features=" << featureCount
+                  << " (needs " << requiredMB << " MB)\n";
+        json << (first ? "" : ",\n")
+             << "    {\"samples\": " << sampleCount << ", \"features\": " << featureCount
+             << ", \"skipped\": true, \"required_mb\": " << requiredMB << "}";
+        first = false;
+        return;
+    }
+
+    MultiArray<2, float>  trainFeatures(Shape2(sampleCount, featureCount));
+    MultiArray<2, UInt32> trainLabels(Shape2(sampleCount, 1));
+    makeProblem(trainFeatures, trainLabels, options.classes, 1);
+    MultiArray<2, float>  testFeatures(Shape2(predictCount, featureCount));
+    MultiArray<2, UInt32> testLabels(Shape2(predictCount, 1));
+    makeProblem(testFeatures, testLabels, options.classes, 2);
+
+    // all prediction runs use the same forest with the full number of trees
+    RandomForest<UInt32> predictor(RandomForestOptions().tree_count(options.trees));
+    predictor.learn(trainFeatures, trainLabels, rf_default(), rf_default(),
+                    rf_default(), RandomMT19937(1));
+
+    for(unsigned int t = 0; t < options.threads.size(); ++t)
+    {
+        int threadCount = (int)std::max<long>(1, options.threads[t]);
+        std::cerr << "samples=" << sampleCount << " features=" << featureCount
+                  << " threads=" << threadCount << "\n";
+
+        // learning: one forest per thread, trees distributed evenly
+        std::vector<RandomForest<UInt32> > forests(threadCount);
+        Clock::time_point start = Clock::now();
+        {
+            std::vector<threading::thread> workers;
+            for(int k = 0; k < threadCount; ++k)
+            {
+                int trees = options.trees / threadCount + (k < options.trees % threadCount ? 1 : 0);
+                forests[k].set_options().tree_count(std::max(1, trees));
+                workers.push_back(threading::thread([&forests, &trainFeatures, &trainLabels, k]()
+                {
+                    forests[k].learn(trainFeatures, trainLabels, rf_default(), rf_default(),
+                                     rf_default(), RandomMT19937(k + 1));
+                }));
+            }
+            for(unsigned int k = 0; k < workers.size(); ++k)
+                workers[k].join();
+        }
+        double learnTime = seconds(start);
+
+        // prediction: contiguous row blocks, one per thread
+        MultiArray<2, float> prob(Shape2(predictCount, predictor.class_count()));
+        start = Clock::now();
+        {
+            std::vector<threading::thread> workers;
+            long blockSize = (predictCount + threadCount - 1) / threadCount;
+            for(int k = 0; k < threadCount; ++k)
+            {
+                long begin = std::min(predictCount, k * blockSize),
+                     end   = std::min(predictCount, begin + blockSize);
+                if(begin == end)
+                    continue;
+                workers.push_back(threading::thread([&predictor, &testFeatures, &prob, begin, end]()
+                {
+                    MultiArrayView<2, float> features = testFeatures.subarray(Shape2(begin, 0),
+                                                            Shape2(end, testFeatures.shape(1)));
+                    MultiArrayView<2, float> p = prob.subarray(Shape2(begin, 0),
+                                                            Shape2(end, prob.shape(1)));
+                    predictor.predictProbabilities(features, p);
+                }));
+            }
+            for(unsigned int k = 0; k < workers.size(); ++k)
+                workers[k].join();
+        }
+        double predictTime = seconds(start);
+
+        // sanity check that the forest learned something
+        long correct = 0;
+        for(long i = 0; i < predictCount; ++i)
+            if((UInt32)argMax(rowVector(prob, i)) == testLabels(i, 0))
+                ++correct;
+
+        json << (first ? "" : ",\n")
+             << "    {\"samples\": " << sampleCount
+             << ", \"features\": " << featureCount
+             << ", \"classes\": " << options.classes
+             << ", \"trees\": " << options.trees
+             << ", \"threads\": " << threadCount
+             << ", \"learn_seconds\": " << learnTime
+             << ", \"learn_samples_per_second\": " << sampleCount / learnTime
+             << ", \"learn_trees_per_second\": " << options.trees / learnTime
+             << ", \"predict_samples\": " << predictCount
+             << ", \"predict_seconds\": " << predictTime
+             << ", \"predict_samples_per_second\": " << predictCount / predictTime
+             << ", \"accuracy\": " << (double)correct / predictCount
+             << ", \"peak_memory_mb\": " << peakMemory() / (1024.0 * 1024.0)
+             << "}";
+        first = false;
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    Options options;
+    for(int k = 1; k < argc; ++k)
+    {
+        std::string arg(argv[k]);
+        bool hasValue = k + 1 < argc;
+        if(arg == "--samples" && hasValue)
+            options.samples = parseList(argv[++k]);
+        else if(arg == "--features" && hasValue)
+            options.features = parseList(argv[++k]);
+        else if(arg == "--threads" && hasValue)
+            options.threads = parseList(argv[++k]);
+        else if(arg == "--trees" && hasValue)
+            options.trees = std::max(1, std::atoi(argv[++k]));
+        else if(arg == "--classes" && hasValue)
+            options.classes = std::max(2, std::atoi(argv[++k]));
+        else if(arg == "--predict" && hasValue)
+            options.predict = std::atol(argv[++k]);
+        else if(arg == "--max-memory" && hasValue)
+            options.maxMemory = std::atof(argv[++k]);
+        else if(arg == "--output" && hasValue)
+            options.output = argv[++k];
+        else if(arg == "--sweep")
+        {
+            options.samples = parseList("10000,100000,1000000,10000000,100000000");
+            options.features = parseList("10,50,100,500");
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--samples n,...] [--features f,...] "
+                         "[--threads t,...] [--trees n] [--classes n] [--predict n] "
+                         "[--max-memory MB] [--sweep] [--output file]\n";
+            return 1;
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"vigra_random_forest\",\n"
+         << "  \"hardware_concurrency\": " << threading::thread::hardware_concurrency() << ",\n"
+         << "  \"results\": [\n";
+    bool first = true;
+    for(unsigned int s = 0; s < options.samples.size(); ++s)
+        for(unsigned int f = 0; f < options.features.size(); ++f)
+            runConfiguration(options.samples[s], options.features[f], options, json, first);
+    json << "\n  ]\n}\n";
+
+    if(options.output.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream out(options.output.c_str());
+        out << json.str();
+    }
+    return 0;
+}
@@ -47,6 +47,8 @@
 #include <vigra/random_forest.hxx>
 #include <vigra/random_forest_deprec.hxx>
 #include <vigra/multi_math.hxx>
+#include <vigra/multi_array_chunked.hxx>
+#include <vigra/random_forest_binary_impex.hxx>
 #include <vigra/unittest.hxx>
 #include <vector>
 #include <limits>
@@ -427,6 +429,313 @@ struct ClassifierTest
         }
         std::cerr << "DONE!\n\n";
     }
+/**
+        ClassifierTest::RFPresortedSplitTest():
+    Checks that sorting the feature columns only once per tree leads to exactly
+    the same trees as sorting them at every node.
+**/
+    void RFPresortedSplitTest()
+    {
+        for(int ii = 0; ii < data.size() ; ii++)
+        {
+            vigra::RandomForest<>
+                RF(vigra::RandomForestOptions().tree_count(8));
+            vigra::RandomForest<>
+                RFpresorted(vigra::RandomForestOptions().tree_count(8));
+
+            RF.learn(   data.features(ii),
+                        data.labels(ii),
+                        rf_default(),
+                        rf_default(),
+                        rf_default(),
+                        vigra::RandomMT19937(1));
+            RFpresorted.learn(  data.features(ii),
+                                data.labels(ii),
+                                rf_default(),
+                                rf::split::PresortedGiniSplit(),
+                                rf_default(),
+                                vigra::RandomMT19937(1));
+
+            for(int k = 0; k < RF.tree_count(); ++k)
+            {
+                shouldEqual(RF.tree(k).topology_, RFpresorted.tree(k).topology_);
+                shouldEqual(RF.tree(k).parameters_, RFpresorted.tree(k).parameters_);
+            }
+
+            vigra::RandomForest<>
+                RFentropy(vigra::RandomForestOptions().tree_count(8));
+            vigra::RandomForest<>
+                RFpresortedEntropy(vigra::RandomForestOptions().tree_count(8));
+
+            RFentropy.learn(    data.features(ii),
+                                data.labels(ii),
+                                rf_default(),
+                                vigra::EntropySplit(),
+                                rf_default(),
+                                vigra::RandomMT19937(1));
+            RFpresortedEntropy.learn(   data.features(ii),
+                                        data.labels(ii),
+                                        rf_default(),
+                                        rf::split::PresortedEntropySplit(),
+                                        rf_default(),
+                                        vigra::RandomMT19937(1));
+
+            for(int k = 0; k < RFentropy.tree_count(); ++k)
+            {
+                shouldEqual(RFentropy.tree(k).topology_, RFpresortedEntropy.tree(k).topology_);
+                shouldEqual(RFentropy.tree(k).parameters_, RFpresortedEntropy.tree(k).parameters_);
+            }
+        }
+
+        // regression: the losses are accumulated in a different order, 
+        // so the trees only agree up to rounding
+        int samples = 200;
+        MultiArray<2, double> features(Shape2(samples, 3)), response(Shape2(samples, 1));
+        vigra::RandomMT19937 random(3);
+        for(int i = 0; i < samples; ++i)
+        {
+            for(int j = 0; j < 3; ++j)
+                features(i, j) = random.uniform();
+            response(i, 0) = features(i, 0)*features(i, 0) + 2.0*features(i, 1);
+        }
+
+        vigra::RandomForest<double, RegressionTag> 
+            RFregression(vigra::RandomForestOptions().tree_count(8));
+        vigra::RandomForest<double, RegressionTag> 
+            RFpresortedRegression(vigra::RandomForestOptions().tree_count(8));
+        RFregression.learn(features, response, 
+                           rf_default(), vigra::RegressionSplit(), 
+                           rf_default(), vigra::RandomMT19937(1));
+        RFpresortedRegression.learn(features, response, 
+                                    rf_default(), rf::split::PresortedRegressionSplit(), 
+                                    rf_default(), vigra::RandomMT19937(1));
+
+        for(int k = 0; k < RFregression.tree_count(); ++k)
+        {
+            shouldEqual(RFregression.tree(k).topology_, RFpresortedRegression.tree(k).topology_);
+            shouldEqualSequenceTolerance(RFregression.tree(k).parameters_.begin(),
+                                         RFregression.tree(k).parameters_.end(),
+                                         RFpresortedRegression.tree(k).parameters_.begin(),
+                                         1e-10);
+        }
+    }
+
+/**
+        ClassifierTest::RFFeatureTypeTest():
+    Checks that float and integer feature matrices are used directly and give
+    the same forest as the equivalent double matrix.
+**/
+    void RFFeatureTypeTest()
+    {
+        int samples = 500, features = 6;
+        MultiArray<2, double> dfeatures(Shape2(samples, features));
+        MultiArray<2, int>    labels(Shape2(samples, 1));
+        RandomMT19937 random(42);
+        for(int k = 0; k < samples; ++k)
+        {
+            for(int j = 0; j < features; ++j)
+                dfeatures(k, j) = random.uniformInt(256);
+            labels(k, 0) = (dfeatures(k, 0) + dfeatures(k, 1) + random.uniformInt(64) > 288) ? 1 : 0;
+        }
+        MultiArray<2, float>  ffeatures(dfeatures);
+        MultiArray<2, UInt8>  bfeatures(dfeatures);
+        MultiArray<2, UInt16> sfeatures(dfeatures);
+
+        RandomForest<int> drf(RandomForestOptions().tree_count(10)),
+                          frf(RandomForestOptions().tree_count(10)),
+                          brf(RandomForestOptions().tree_count(10)),
+                          srf(RandomForestOptions().tree_count(10));
+        drf.learn(dfeatures, labels, rf_default(), rf_default(), rf_default(), RandomMT19937(1));
+        frf.learn(ffeatures, labels, rf_default(), rf_default(), rf_default(), RandomMT19937(1));
+        brf.learn(bfeatures, labels, rf_default(), rf_default(), rf_default(), RandomMT19937(1));
+        srf.learn(sfeatures, labels, rf_default(), rf_default(), rf_default(), RandomMT19937(1));
+        for(int k = 0; k < drf.tree_count(); ++k)
+        {
+            shouldEqual(drf.tree(k).topology_, frf.tree(k).topology_);
+            shouldEqual(drf.tree(k).parameters_, frf.tree(k).parameters_);
+            shouldEqual(drf.tree(k).topology_, brf.tree(k).topology_);
+            shouldEqual(drf.tree(k).parameters_, brf.tree(k).parameters_);
+            shouldEqual(drf.tree(k).topology_, srf.tree(k).topology_);
+            shouldEqual(drf.tree(k).parameters_, srf.tree(k).parameters_);
+        }
+
+        MultiArray<2, float> dprob(Shape2(samples, 2)), bprob(Shape2(samples, 2));
+        drf.predictProbabilities(dfeatures, dprob);
+        brf.predictProbabilities(bfeatures, bprob);
+        shouldEqualSequence(dprob.begin(), dprob.end(), bprob.begin());
+
+        MultiArray<2, int> dlabels(Shape2(samples, 1)), slabels(Shape2(samples, 1));
+        drf.predictLabels(dfeatures, dlabels);
+        srf.predictLabels(sfeatures, slabels);
+        shouldEqualSequence(dlabels.begin(), dlabels.end(), slabels.begin());
+    }
+
+/**
+        ClassifierTest::RFImagePredictionTest():
+    Checks that pixelwise prediction on feature images gives the same result
+    as prediction on the equivalent sample matrix.
+**/
+    void RFImagePredictionTest()
+    {
+        int ii = 0, featureCount = 3;
+        MultiArrayView<2, double> samples = 
+            data.features(ii).subarray(Shape2(0, 0), Shape2(data.features(ii).shape(0), featureCount));
+        vigra::RandomForest<> RF(vigra::RandomForestOptions().tree_count(10));
+        RF.learn(samples, data.labels(ii), rf_default(), rf_default(), rf_default(),
+                 vigra::RandomMT19937(1));
+
+        // arrange the samples as a 2D feature image
+        Shape3 shape(13, 7, featureCount);
+        int pixels = shape[0]*shape[1];
+        MultiArray<3, float> image(shape);
+        MultiArray<2, float> matrix(Shape2(pixels, featureCount));
+        for(int y = 0, k = 0; y < shape[1]; ++y)
+            for(int x = 0; x < shape[0]; ++x, ++k)
+                for(int j = 0; j < featureCount; ++j)
+                    image(x, y, j) = matrix(k, j) = samples(k % samples.shape(0), j);
+
+        MultiArray<2, float> reference(Shape2(pixels, RF.class_count()));
+        RF.predictProbabilities(matrix, reference);
+
+        MultiArray<3, float> prob(Shape3(shape[0], shape[1], RF.class_count()));
+        RF.predictProbabilities(image.multiband(), prob.multiband());
+        for(int y = 0, k = 0; y < shape[1]; ++y)
+            for(int x = 0; x < shape[0]; ++x, ++k)
+                for(int c = 0; c < RF.class_count(); ++c)
+                    shouldEqual(prob(x, y, c), reference(k, c));
+
+        // strided (transposed) probability output
+        MultiArray<3, float> probT(Shape3(RF.class_count(), shape[1], shape[0]));
+        RF.predictProbabilities(image.multiband(), probT.transpose().multiband());
+        shouldEqualSequence(prob.begin(), prob.end(), probT.transpose().begin());
+
+        // vector-valued pixels
+        MultiArray<2, TinyVector<float, 3> > vimage(Shape2(shape[0], shape[1]));
+        for(int y = 0; y < shape[1]; ++y)
+            for(int x = 0; x < shape[0]; ++x)
+                for(int j = 0; j < featureCount; ++j)
+                    vimage(x, y)[j] = image(x, y, j);
+        prob.init(0.0);
+        RF.predictProbabilities(vimage, prob.multiband());
+        for(int y = 0, k = 0; y < shape[1]; ++y)
+            for(int x = 0; x < shape[0]; ++x, ++k)
+                for(int c = 0; c < RF.class_count(); ++c)
+                    shouldEqual(prob(x, y, c), reference(k, c));
+
+        // chunked feature and probability images with small chunks
+        ChunkedArrayLazy<3, float> chunkedImage(shape, Shape3(4, 4, 4));
+        ChunkedArrayLazy<3, float> chunkedProb(Shape3(shape[0], shape[1], RF.class_count()), 
+                                               Shape3(4, 4, 4));
+        chunkedImage.commitSubarray(Shape3(0), image);
+        RF.predictProbabilities(chunkedImage, chunkedProb);
+        prob.init(0.0);
+        chunkedProb.checkoutSubarray(Shape3(0), prob);
+        for(int y = 0, k = 0; y < shape[1]; ++y)
+            for(int x = 0; x < shape[0]; ++x, ++k)
+                for(int c = 0; c < RF.class_count(); ++c)
+                    shouldEqual(prob(x, y, c), reference(k, c));
+    }
+
+/**
+        ClassifierTest::RFBinaryImpexTest():
+    Exports random forests into the binary format and checks that the
+    memory-mapped forest and the re-imported forest predict exactly like
+    the original one.
+**/
+    void RFBinaryImpexTest()
+    {
+        for(int ii = 0; ii < data.size() ; ii++)
+        {
+            std::string filename = data.names(ii) + "_rf.bin";
+            vigra::RandomForest<> RF(vigra::RandomForestOptions().tree_count(20));
+            RF.learn(data.features(ii), data.labels(ii), rf_default(), rf_default(), rf_default(),
+                     vigra::RandomMT19937(1));
+            rf_export_binary(RF, filename);
+
+            MultiArray<2, double> reference(Shape2(data.features(ii).shape(0), RF.class_count())),
+                                  prob(reference.shape());
+            MultiArray<2, double> referenceLabels(Shape2(data.features(ii).shape(0), 1)),
+                                  labels(referenceLabels.shape());
+            RF.predictProbabilities(data.features(ii), reference);
+            RF.predictLabels(data.features(ii), referenceLabels);
+            {
+                vigra::MappedRandomForest<> mapped(filename);
+                shouldEqual(mapped.tree_count(), RF.tree_count());
+                shouldEqual(mapped.class_count(), RF.class_count());
+                shouldEqual(mapped.column_count(), RF.column_count());
+                should(mapped.ext_param().classes == RF.ext_param().classes);
+                for(int k = 0; k < RF.tree_count(); ++k)
+                {
+                    should(mapped.tree(k).topology_ == RF.tree(k).topology_);
+                    should(mapped.tree(k).parameters_ == RF.tree(k).parameters_);
+                }
+                mapped.predictProbabilities(data.features(ii), prob);
+                shouldEqualSequence(prob.begin(), prob.end(), reference.begin());
+                mapped.predictLabels(data.features(ii), labels);
+                shouldEqualSequence(labels.begin(), labels.end(), referenceLabels.begin());
+            }
+
+            vigra::RandomForest<> RF2;
+            rf_import_binary(RF2, filename);
+            should(RF.ext_param_ == RF2.ext_param_);
+            should(RF.options_ == RF2.options_);
+            shouldEqual(RF2.tree_count(), RF.tree_count());
+            for(int k = 0; k < RF.tree_count(); ++k)
+            {
+                should(RF.trees_[k].topology_ == RF2.trees_[k].topology_);
+                should(RF.trees_[k].parameters_ == RF2.trees_[k].parameters_);
+            }
+            RF2.predictProbabilities(data.features(ii), prob);
+            shouldEqualSequence(prob.begin(), prob.end(), reference.begin());
+            std::remove(filename.c_str());
+        }
+
+        // invalid files must be rejected
+        {
+            std::ofstream invalid("invalid_rf.bin", std::ios::binary);
+            invalid << "this is not a random forest";
+        }
+        try
+        {
+            vigra::MappedRandomForest<> mapped("invalid_rf.bin");
+            failTest("MappedRandomForest didn't throw on invalid file.");
+        }
+        catch(vigra::PreconditionViolation &)
+        {}
+        std::remove("invalid_rf.bin");
+
+        // corrupt indices in a tree must be detected before prediction
+        {
+            vigra::RandomForest<> RF(vigra::RandomForestOptions().tree_count(1));
+            RF.learn(data.features(0), data.labels(0), rf_default(), rf_default(), rf_default(),
+                     vigra::RandomMT19937(1));
+            ArrayVector<Int32> topology(RF.tree(0).topology_);
+            ArrayVector<double> parameters(RF.tree(0).parameters_);
+            typedef ArrayVectorView<Int32 const> TView;
+            typedef ArrayVectorView<double const> PView;
+            detail::DecisionTreeView(TView(topology.size(), topology.data()),
+                                     PView(parameters.size(), parameters.data())).checkIndices();
+
+            ArrayVector<Int32> corrupt[5] = { topology, topology, topology, topology, topology };
+            corrupt[0][4] = (Int32)topology.size();     // child index
+            corrupt[1][3] = (Int32)parameters.size();   // parameter index
+            corrupt[2][6] = topology[0];                // feature index
+            corrupt[3][4] = 2;                          // cycle
+            corrupt[4].resize(4);                       // truncated
+            for(int k = 0; k < 5; ++k)
+            {
+                try
+                {
+                    detail::DecisionTreeView(TView(corrupt[k].size(), corrupt[k].data()),
+                                             PView(parameters.size(), parameters.data())).checkIndices();
+                    failTest("DecisionTreeView::checkIndices() didn't throw on corrupt tree.");
+                }
+                catch(std::runtime_error &)
+                {}
+            }
+        }
+    }
+
 /**
         ClassifierTest::RFdefaultTest():
     Learns The Refactored Random Forest with a fixed Random Seed and default sampling Options on
@@ -884,6 +1193,14 @@ struct ClassifierTest
                 rf_import_HDF5(RF6, fileId2, "t");
                 should_all(RF, RF6);
 
+                // conversion into the binary format
+                std::string filename_bin = data.names(ii) + "_rf.bin";
+                rf_convert_HDF5_to_binary(filename, filename_bin);
+                vigra::RandomForest<> RF8;
+                rf_import_binary(RF8, filename_bin);
+                should_all(RF, RF8);
+                std::remove(filename_bin.c_str());
+
                  std::cerr << "[";
                  for(int ss = 0; ss < ii+1; ++ss)
                      std::cerr << "#";
@@ -1075,6 +1392,10 @@ struct ClassifierTestSuite
 
         add( testCase( &ClassifierTest::RFridgeRegressionTest));
         add( testCase( &ClassifierTest::RFSplitFunctorTest));
+        add( testCase( &ClassifierTest::RFPresortedSplitTest));
+        add( testCase( &ClassifierTest::RFFeatureTypeTest));
+        add( testCase( &ClassifierTest::RFImagePredictionTest));
+        add( testCase( &ClassifierTest::RFBinaryImpexTest));
 #ifdef HasHDF5
         add( testCase( &ClassifierTest::HDF5ImpexTest));
         add( testCase( &ClassifierTest::HDF5InvalidImportTest));
@@ -0,0 +1,463 @@
+/************************************************************************/
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+/*
+    Graph algorithm benchmark.
+
+    Generates 2D and 3D GridGraphs with a smooth random node signal and times
+    watershedsGraph(), makeRegionAdjacencyGraph(), ShortestPathDijkstra,
+    felzenszwalbSegmentation() and HierarchicalClustering (on the region
+    adjacency graph of the watershed regions). For each algorithm, the wall
+    clock time, the number and size of heap allocations per node and edge, and
+    the memory high-water mark are reported as JSON.
+
+    Usage:
+        graph_benchmark [options]
+
+    Options (lists are comma separated):
+        --nodes    n1,n2,...   approximate number of grid nodes (default: 10000,1000000)
+        --dims     d1,d2,...   grid dimensions, 2 or 3          (default: 2,3)
+        --threads  t1,t2,...   thread counts                    (default: 1,4)
+        --repeat   n           repetitions, the fastest is kept (default: 1)
+        --max-memory MB        skip configurations which are estimated to
+                               need more memory than this       (default: 4096)
+        --sweep                use nodes 10^4 ... 10^8
+        --output   file        write the JSON report to file    (default: stdout)
+
+    Only makeRegionAdjacencyGraph() and felzenszwalbSegmentation() use
+    multiple threads, the other algorithms are single-threaded.
+
+    Allocations are counted by replacing the global operator new. The
+    memory high-water mark is the peak resident set size of the whole
+    process, i.e. it never decreases between consecutive measurements.
+*/
+
+#include <iostream>
+#include <vigra/graph_algorithms.hxx>
+#include <vigra/merge_graph_adaptor.hxx>
+#include <vigra/hierarchical_clustering.hxx>
+#include <vigra/multi_watersheds.hxx>
+#include <vigra/random.hxx>
+#include <vigra/threading.hxx>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+# include <windows.h>
+# include <psapi.h>
+#else
+# include <sys/resource.h>
+#endif
+
+namespace {
+
+std::atomic<long long> allocationCount(0), allocationBytes(0);
+
+void * countedAllocation(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add((long long)size, std::memory_order_relaxed);
+    void * p = std::malloc(size == 0 ? 1 : size);
+    if(p == 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+} // anonymous namespace
+
+void * operator new(std::size_t size)
+{
+    return countedAllocation(size);
+}
+
+void * operator new[](std::size_t size)
+{
+    return countedAllocation(size);
+}
+
+void operator delete(void * p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void * p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void * p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+using namespace vigra;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// peak resident set size of this process in bytes
+double peakMemory()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return (double)counters.PeakWorkingSetSize;
+    return 0.0;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.0;
+# ifdef __APPLE__
+    return (double)usage.ru_maxrss;          // bytes
+# else
+    return (double)usage.ru_maxrss * 1024.0; // kilobytes
+# endif
+#endif
+}
+
+std::vector<long> parseList(std::string const & s)
+{
+    std::vector<long> res;
+    std::stringstream stream(s);
+    std::string item;
+    while(std::getline(stream, item, ','))
+        res.push_back(std::atol(item.c_str()));
+    return res;
+}
+
+struct Options
+{
+    std::vector<long> nodes, dims, threads;
+    int repeat;
+    double maxMemory;
+    std::string output;
+
+    Options()
+    : repeat(1), maxMemory(4096.0)
+    {
+        nodes = parseList("10000,1000000");
+        dims = parseList("2,3");
+        threads = parseList("1,4");
+    }
+};
+
+// time and allocations of a single algorithm run
+class Measurement
+{
+  public:
+    Measurement()
+    : seconds_(0.0), allocations_(0), bytes_(0)
+    {}
+
+    template <class F>
+    void run(F f, int repeat)
+    {
+        for(int k = 0; k < repeat; ++k)
+        {
+            long long count = allocationCount.load(), bytes = allocationBytes.load();
+            Clock::time_point start = Clock::now();
+            f();
+            double time = seconds(start);
+            if(k == 0 || time < seconds_)
+                seconds_ = time;
+            allocations_ = allocationCount.load() - count;
+            bytes_ = allocationBytes.load() - bytes;
+        }
+    }
+
+    void report(std::ostream & json, char const * name, double nodes, double edges) const
+    {
+        json << "\"" << name << "\": {"
+             << "\"seconds\": " << seconds_
+             << ", \"nodes_per_second\": " << nodes / seconds_
+             << ", \"allocations\": " << allocations_
+             << ", \"allocations_per_node\": " << allocations_ / nodes
+             << ", \"allocated_bytes_per_node\": " << bytes_ / nodes
+             << ", \"allocated_bytes_per_edge\": " << bytes_ / edges
+             << ", \"peak_memory_mb\": " << peakMemory() / (1024.0 * 1024.0)
+             << "}";
+    }
+
+  private:
+    double seconds_;
+    long long allocations_, bytes_;
+};
+
+/* Smooth random signal: a sum of random plane waves plus a little noise,
+   so that watersheds produce regions of a few hundred nodes.
+*/
+template <unsigned int N>
+void makeSignal(MultiArray<N, float> & data)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    RandomMT19937 random(1);
+    const int waveCount = 8;
+    std::vector<TinyVector<double, N> > frequencies(waveCount);
+    std::vector<double> phases(waveCount);
+    for(int k = 0; k < waveCount; ++k)
+    {
+        for(unsigned int d = 0; d < N; ++d)
+            frequencies[k][d] = 0.2 * (random.uniform53() - 0.5);
+        phases[k] = 2.0 * M_PI * random.uniform53();
+    }
+    MultiCoordinateIterator<N> iter(data.shape()), end(iter.getEndIterator());
+    for(; iter != end; ++iter)
+    {
+        const Shape & p = *iter;
+        double v = 0.0;
+        for(int k = 0; k < waveCount; ++k)
+            v += std::sin(dot(frequencies[k], TinyVector<double, N>(p)) + phases[k]);
+        data[p] = (float)(v / waveCount + 1.0 + 0.05 * random.uniform53());
+    }
+}
+
+template <unsigned int N>
+void runConfiguration(long nodeCount, Options const & options, std::ostream & json, bool & first)
+{
+    typedef GridGraph<N, undirected_tag>              Graph;
+    typedef typename Graph::shape_type                Shape;
+    typedef typename Graph::Node                      Node;
+    typedef typename Graph::template EdgeMap<float>   FloatEdgeMap;
+    typedef typename Graph::template NodeMap<float>   FloatNodeMap;
+    typedef typename Graph::template NodeMap<UInt32>  LabelMap;
+
+    typedef AdjacencyListGraph                        Rag;
+    typedef Rag::EdgeMap<float>                       RagFloatEdgeMap;
+    typedef Rag::NodeMap<float>                       RagFloatNodeMap;
+    typedef MergeGraphAdaptor<Rag>                    MergeGraph;
+    typedef cluster_operators::EdgeWeightNodeFeatures<
+        MergeGraph, RagFloatEdgeMap, RagFloatEdgeMap, RagFloatNodeMap,
+        RagFloatNodeMap, RagFloatEdgeMap>             ClusterOperator;
+    typedef HierarchicalClustering<ClusterOperator>   Clustering;
+
+    const MultiArrayIndex side = (MultiArrayIndex)std::ceil(std::pow((double)nodeCount, 1.0 / N));
+    const Shape shape(side);
+    const double gridNodes = (double)prod(shape);
+
+    // signal, labels, edge weights, Dijkstra maps, sorted edges of felzenszwalb
+    const double requiredMB = gridNodes * (4.0 + 4.0 + 4.0 * N + 32.0 + N * (N + 1) * 8.0)
+                              / (1024.0 * 1024.0);
+    if(requiredMB > options.maxMemory)
+    {
+        std::cerr << "skipping dims=" << N << " nodes=" << gridNodes
+                  << " (needs " << requiredMB << " MB)\n";
+        json << (first ? "" : ",\n")
+             << "    {\"dims\": " << N << ", \"nodes\": " << gridNodes
+             << ", \"skipped\": true, \"required_mb\": " << requiredMB << "}";
+        first = false;
+        return;
+    }
+
+    Graph graph(shape, DirectNeighborhood);
+    const double gridEdges = (double)graph.edgeNum();
+    MultiArray<N, float> data(shape);
+    makeSignal(data);
+
+    for(unsigned int t = 0; t < options.threads.size(); ++t)
+    {
+        const int threadCount = (int)std::max<long>(1, options.threads[t]);
+        const ParallelOptions parallelOptions = ParallelOptions().numThreads(threadCount);
+        std::cerr << "dims=" << N << " nodes=" << gridNodes << " threads=" << threadCount << "\n";
+
+        LabelMap labels(graph);
+        Measurement watersheds;
+        watersheds.run([&]()
+        {
+            labels.init(0);
+            lemon_graph::watershedsGraph(graph, data, labels,
+                                         WatershedOptions().unionFind());
+        }, options.repeat);
+
+        Rag rag;
+        Rag::EdgeMap<std::vector<typename Graph::Edge> > affiliatedEdges;
+        Measurement ragTime;
+        ragTime.run([&]()
+        {
+            makeRegionAdjacencyGraph(graph, labels, rag, affiliatedEdges, -1, parallelOptions);
+        }, options.repeat);
+
+        FloatEdgeMap edgeWeights(graph);
+        edgeWeightsFromNodeWeights(graph, data, edgeWeights);
+
+        ShortestPathDijkstra<Graph, float> shortestPath(graph);
+        Measurement dijkstra;
+        dijkstra.run([&]()
+        {
+            shortestPath.run(edgeWeights, Node(0), Node(shape - Shape(1)));
+        }, options.repeat);
+
+        FloatNodeMap nodeSizes(graph);
+        nodeSizes.init(1.0f);
+        LabelMap felzenszwalbLabels(graph);
+        Measurement felzenszwalb;
+        felzenszwalb.run([&]()
+        {
+            felzenszwalbSegmentation(graph, edgeWeights, nodeSizes, 1.0f, felzenszwalbLabels,
+                                     -1, parallelOptions);
+        }, options.repeat);
+
+        // RAG features: mean weight along the boundaries, mean signal of the regions
+        RagFloatEdgeMap ragWeights(rag), ragEdgeSizes(rag), minWeights(rag);
+        RagFloatNodeMap ragFeatures(rag), ragNodeSizes(rag);
+        std::fill(ragFeatures.begin(), ragFeatures.end(), 0.0f);
+        std::fill(ragNodeSizes.begin(), ragNodeSizes.end(), 0.0f);
+        for(typename Rag::EdgeIt e(rag); e != lemon::INVALID; ++e)
+        {
+            std::vector<typename Graph::Edge> const & edges = affiliatedEdges[*e];
+            float sum = 0.0f;
+            for(size_t k = 0; k < edges.size(); ++k)
+                sum += edgeWeights[edges[k]];
+            ragWeights[*e] = sum / edges.size();
+            ragEdgeSizes[*e] = (float)edges.size();
+        }
+        for(typename Graph::NodeIt n(graph); n != lemon::INVALID; ++n)
+        {
+            ragFeatures[rag.nodeFromId(labels[*n])] += data[*n];
+            ragNodeSizes[rag.nodeFromId(labels[*n])] += 1.0f;
+        }
+        for(typename Rag::NodeIt n(rag); n != lemon::INVALID; ++n)
+            ragFeatures[*n] /= ragNodeSizes[*n];
+
+        Measurement clustering;
+        clustering.run([&]()
+        {
+            MergeGraph mergeGraph(rag);
+            ClusterOperator clusterOperator(mergeGraph, ragWeights, ragEdgeSizes, ragFeatures,
+                                            ragNodeSizes, minWeights, 0.5f,
+                                            metrics::ManhattanMetric, 0.5f);
+            Clustering hc(clusterOperator, typename Clustering::Parameter(1, true));
+            hc.cluster();
+        }, options.repeat);
+
+        json << (first ? "" : ",\n")
+             << "    {\"dims\": " << N
+             << ", \"nodes\": " << gridNodes
+             << ", \"edges\": " << gridEdges
+             << ", \"rag_nodes\": " << rag.nodeNum()
+             << ", \"rag_edges\": " << rag.edgeNum()
+             << ", \"threads\": " << threadCount
+             << ",\n     ";
+        watersheds.report(json, "watershedsGraph", gridNodes, gridEdges);
+        json << ",\n     ";
+        ragTime.report(json, "makeRegionAdjacencyGraph", gridNodes, gridEdges);
+        json << ",\n     ";
+        dijkstra.report(json, "ShortestPathDijkstra", gridNodes, gridEdges);
+        json << ",\n     ";
+        felzenszwalb.report(json, "felzenszwalbSegmentation", gridNodes, gridEdges);
+        json << ",\n     ";
+        clustering.report(json, "HierarchicalClustering", (double)rag.nodeNum(), (double)rag.edgeNum());
+        json << "}";
+        first = false;
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    Options options;
+    for(int k = 1; k < argc; ++k)
+    {
+        std::string arg(argv[k]);
+        bool hasValue = k + 1 < argc;
+        if(arg == "--nodes" && hasValue)
+            options.nodes = parseList(argv[++k]);
+        else if(arg == "--dims" && hasValue)
+            options.dims = parseList(argv[++k]);
+        else if(arg == "--threads" && hasValue)
+            options.threads = parseList(argv[++k]);
+        else if(arg == "--repeat" && hasValue)
+            options.repeat = std::max(1, std::atoi(argv[++k]));
+        else if(arg == "--max-memory" && hasValue)
+            options.maxMemory = std::atof(argv[++k]);
+        else if(arg == "--output" && hasValue)
+            options.output = argv[++k];
+        else if(arg == "--sweep")
+            options.nodes = parseList("10000,100000,1000000,10000000,100000000");
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--nodes n,...] [--dims d,...] "
+                         "[--threads t,...] [--repeat n] [--max-memory MB] [--sweep] "
+                         "[--output file]\n";
+            return 1;
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"vigra_graph_algorithms\",\n"
+         << "  \"hardware_concurrency\": " << threading::thread::hardware_concurrency() << ",\n"
+         << "  \"results\": [\n";
+    bool first = true;
+    for(unsigned int n = 0; n < options.nodes.size(); ++n)
+    {
+        for(unsigned int d = 0; d < options.dims.size(); ++d)
+        {
+            if(options.dims[d] == 2)
+                runConfiguration<2>(options.nodes[n], options, json, first);
+            else if(options.dims[d] == 3)
+                runConfiguration<3>(options.nodes[n], options, json, first);
+            else
+                std::cerr << "skipping unsupported dimension " << options.dims[d] << "\n";
+        }
+    }
+    json << "\n  ]\n}\n";
+
+    if(options.output.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream out(options.output.c_str());
+        out << json.str();
+    }
+    return 0;
+}
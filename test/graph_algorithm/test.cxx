@@ -34,12 +34,21 @@
 /************************************************************************/
 
 #include <iostream>
+#include <map>
+#include <set>
 #include "vigra/unittest.hxx"
 #include "vigra/stdimage.hxx"
 #include "vigra/multi_array.hxx"
 #include "vigra/adjacency_list_graph.hxx"
 #include "vigra/graph_algorithms.hxx"
+#include "vigra/merge_graph_adaptor.hxx"
+#include "vigra/hierarchical_clustering.hxx"
+#ifndef VIGRA_SINGLE_THREADED
+#include "vigra/blockwise_hierarchical_clustering.hxx"
+#endif
+#include "vigra/graph_rag_features.hxx"
 #include "vigra/multi_resize.hxx"
+#include "vigra/random.hxx"
 
 using namespace vigra;
 
@@ -305,6 +314,86 @@ struct GraphAlgorithmTest{
         testShortestPathWithROIImpl(g);
     }
 
+    void testShortestPathVariants()
+    {
+        typedef GridGraph<2> Grid;
+        typedef Grid::Node Node;
+        Grid g(Shape2(53, 41), DirectNeighborhood);
+        Grid::EdgeMap<float> weights(g);
+        RandomMT19937 random(7);
+        for(Grid::EdgeIt e(g); e != lemon::INVALID; ++e)
+            weights[*e] = (float)(1 + random.uniformInt(10));
+
+        ShortestPathDijkstra<Grid, float> sp(g);
+        BidirectionalShortestPathDijkstra<Grid, float> bsp(g);
+        for(int k = 0; k < 20; ++k)
+        {
+            Node source(random.uniformInt(53), random.uniformInt(41)),
+                 target(random.uniformInt(53), random.uniformInt(41));
+
+            // repeated runs only reset the nodes of the previous run
+            sp.run(weights, source, target);
+            float distance = bsp.run(weights, source, target);
+            shouldEqual(distance, sp.distances()[target]);
+            shouldEqual(bsp.distance(), distance);
+            should(bsp.touchedNodeCount() <= (size_t)g.nodeNum());
+
+            Grid::NodeMap<Node> const & pred = sp.predecessors();
+            for(Grid::NodeIt n(g); n != lemon::INVALID; ++n)
+                should(pred[*n] == lemon::INVALID || sp.distances()[*n] <= distance);
+
+            BidirectionalShortestPathDijkstra<Grid, float>::Path const & path = bsp.path();
+            shouldEqual(path.front(), source);
+            shouldEqual(path.back(), target);
+            float length = 0.0f;
+            for(unsigned int i = 1; i < path.size(); ++i)
+            {
+                Grid::Edge edge = g.findEdge(path[i-1], path[i]);
+                should(edge != lemon::INVALID);
+                length += weights[edge];
+            }
+            shouldEqual(length, distance);
+        }
+        {
+            // maxDistance too small
+            Node source(0, 0), target(52, 40);
+            shouldEqual(bsp.run(weights, source, target, 10.0f), NumericTraits<float>::max());
+            shouldEqual(bsp.path().size(), 0u);
+            shouldEqual(bsp.run(weights, source, source), 0.0f);
+            shouldEqual(bsp.path().size(), 1u);
+        }
+        {
+            // delta-stepping gives the same distances as multi-source Dijkstra
+            std::vector<Node> sources;
+            sources.push_back(Node(3, 4));
+            sources.push_back(Node(40, 30));
+            sources.push_back(Node(20, 2));
+            sp.runMultiSource(weights, sources.begin(), sources.end());
+
+            for(int threads = 1; threads <= 4; threads += 3)
+            {
+                Grid::NodeMap<float> distances(g);
+                Grid::NodeMap<Node> predecessors(g);
+                shortestPathDeltaStepping(g, weights, sources.begin(), sources.end(), 3.0f,
+                                          distances, predecessors,
+                                          ParallelOptions().numThreads(threads));
+                for(Grid::NodeIt n(g); n != lemon::INVALID; ++n)
+                {
+                    shouldEqual(distances[*n], sp.distances()[*n]);
+                    Node p = predecessors[*n];
+                    if(p == *n)
+                    {
+                        shouldEqual(distances[*n], 0.0f);
+                    }
+                    else
+                    {
+                        shouldEqual(distances[*n], distances[p] + weights[g.findEdge(p, *n)]);
+                    }
+                }
+            }
+        }
+    }
+
     void testRegionAdjacencyGraph(){
         {
             GraphType g(0,0);
@@ -377,6 +466,563 @@ struct GraphAlgorithmTest{
     }
 
 
+    template <unsigned int N>
+    void testGridGraphRegionAdjacencyGraphImpl(GridGraph<N> const & g, 
+                                               typename GridGraph<N>::template NodeMap<UInt32> const & labels,
+                                               Int64 ignoreLabel)
+    {
+        typedef GridGraph<N> GridGraphType;
+        typedef typename GridGraphType::Edge GridEdge;
+        typedef typename GridGraphType::template NodeMap<UInt32> LabelMap;
+
+        // reference result from the generic implementation
+        GraphType refRag;
+        GraphType::EdgeMap< std::vector<GridEdge> > refAffEdges;
+        makeRegionAdjacencyGraph<GridGraphType, LabelMap>(g, labels, refRag, refAffEdges, ignoreLabel);
+
+        for(int nThreads = 1; nThreads <= 4; nThreads *= 2)
+        {
+            GraphType rag;
+            GraphType::EdgeMap< std::vector<GridEdge> > affEdges;
+            makeRegionAdjacencyGraph(g, labels, rag, affEdges, ignoreLabel,
+                                     ParallelOptions().numThreads(nThreads));
+
+            shouldEqual(rag.nodeNum(), refRag.nodeNum());
+            shouldEqual(rag.edgeNum(), refRag.edgeNum());
+            shouldEqual(rag.maxNodeId(), refRag.maxNodeId());
+            for(NodeIt n(refRag); n != lemon::INVALID; ++n)
+                should(rag.nodeFromId(refRag.id(*n)) != lemon::INVALID);
+            for(EdgeIt e(refRag); e != lemon::INVALID; ++e)
+            {
+                const Edge edge = rag.edgeFromId(refRag.id(*e));
+                shouldEqual(rag.id(rag.u(edge)), refRag.id(refRag.u(*e)));
+                shouldEqual(rag.id(rag.v(edge)), refRag.id(refRag.v(*e)));
+                should(affEdges[edge] == refAffEdges[*e]);
+            }
+        }
+    }
+
+    void testGridGraphRegionAdjacencyGraph()
+    {
+        // 2D: blocks of 3x3 pixels with consecutive labels
+        {
+            GridGraph<2> g(Shape2(10, 7), IndirectNeighborhood);
+            GridGraph<2>::NodeMap<UInt32> labels(g);
+            for(MultiArrayIndex y = 0; y < labels.shape(1); ++y)
+                for(MultiArrayIndex x = 0; x < labels.shape(0); ++x)
+                    labels(x, y) = 1 + x / 3 + 4 * (y / 3);
+            testGridGraphRegionAdjacencyGraphImpl(g, labels, -1);
+            testGridGraphRegionAdjacencyGraphImpl(g, labels, 5);
+        }
+        // 3D: random labels from a small set, including 0
+        {
+            GridGraph<3> g(Shape3(9, 8, 11), DirectNeighborhood);
+            GridGraph<3>::NodeMap<UInt32> labels(g);
+            RandomMT19937 random(42);
+            for(MultiArrayIndex k = 0; k < labels.size(); ++k)
+                labels[k] = random.uniformInt(20);
+            testGridGraphRegionAdjacencyGraphImpl(g, labels, -1);
+            testGridGraphRegionAdjacencyGraphImpl(g, labels, 0);
+        }
+    }
+
+    template <class GRAPH_IN, class INDEX_TYPE>
+    void checkCompressedAffiliatedEdges(GRAPH_IN const & g, GraphType const & rag,
+                                        GraphType::EdgeMap< std::vector<typename GRAPH_IN::Edge> > const & refAffEdges,
+                                        CompressedAffiliatedEdges<GRAPH_IN, INDEX_TYPE> const & affEdges)
+    {
+        shouldEqual(affEdges.offsets().size(), (size_t)rag.maxEdgeId() + 2);
+        MultiArrayIndex total = 0;
+        for(EdgeIt e(rag); e != lemon::INVALID; ++e)
+        {
+            shouldEqual(affEdges.size(*e), (MultiArrayIndex)refAffEdges[*e].size());
+            typename CompressedAffiliatedEdges<GRAPH_IN, INDEX_TYPE>::const_iterator id = affEdges.begin(*e);
+            for(size_t i = 0; i < refAffEdges[*e].size(); ++i, ++id)
+                should(g.edgeFromId(*id) == refAffEdges[*e][i]);
+            should(id == affEdges.end(*e));
+            total += affEdges.size(*e);
+        }
+        shouldEqual(affEdges.totalSize(), total);
+    }
+
+    template <unsigned int N>
+    void testCompressedAffiliatedEdgesImpl(GridGraph<N> const & g, 
+                                           typename GridGraph<N>::template NodeMap<UInt32> const & labels,
+                                           Int64 ignoreLabel)
+    {
+        typedef GridGraph<N> GridGraphType;
+        typedef typename GridGraphType::Edge GridEdge;
+        typedef typename GridGraphType::template NodeMap<UInt32> LabelMap;
+
+        GraphType refRag;
+        GraphType::EdgeMap< std::vector<GridEdge> > refAffEdges;
+        makeRegionAdjacencyGraph<GridGraphType, LabelMap>(g, labels, refRag, refAffEdges, ignoreLabel);
+
+        // conversion from the std::vector representation
+        CompressedAffiliatedEdges<GridGraphType> converted(g, refRag, refAffEdges);
+        checkCompressedAffiliatedEdges(g, refRag, refAffEdges, converted);
+
+        // generic implementation
+        {
+            GraphType rag;
+            CompressedAffiliatedEdges<GridGraphType, UInt32> affEdges;
+            makeRegionAdjacencyGraph<GridGraphType, LabelMap, UInt32>(g, labels, rag, affEdges, ignoreLabel);
+            shouldEqual(rag.edgeNum(), refRag.edgeNum());
+            checkCompressedAffiliatedEdges(g, refRag, refAffEdges, affEdges);
+        }
+
+        // GridGraph implementation
+        for(int nThreads = 1; nThreads <= 4; nThreads *= 2)
+        {
+            GraphType rag32, rag64;
+            CompressedAffiliatedEdges<GridGraphType, UInt32> affEdges32;
+            CompressedAffiliatedEdges<GridGraphType, UInt64> affEdges64;
+            makeRegionAdjacencyGraph(g, labels, rag32, affEdges32, ignoreLabel,
+                                     ParallelOptions().numThreads(nThreads));
+            makeRegionAdjacencyGraph(g, labels, rag64, affEdges64, ignoreLabel,
+                                     ParallelOptions().numThreads(nThreads));
+            shouldEqual(rag32.edgeNum(), refRag.edgeNum());
+            shouldEqual(rag64.edgeNum(), refRag.edgeNum());
+            checkCompressedAffiliatedEdges(g, refRag, refAffEdges, affEdges32);
+            checkCompressedAffiliatedEdges(g, refRag, refAffEdges, affEdges64);
+            should(affEdges32.memoryUsage() < affEdges64.memoryUsage());
+        }
+    }
+
+    void testCompressedAffiliatedEdges()
+    {
+        {
+            GridGraph<2> g(Shape2(10, 7), IndirectNeighborhood);
+            GridGraph<2>::NodeMap<UInt32> labels(g);
+            for(MultiArrayIndex y = 0; y < labels.shape(1); ++y)
+                for(MultiArrayIndex x = 0; x < labels.shape(0); ++x)
+                    labels(x, y) = 1 + x / 3 + 4 * (y / 3);
+            testCompressedAffiliatedEdgesImpl(g, labels, -1);
+            testCompressedAffiliatedEdgesImpl(g, labels, 5);
+        }
+        {
+            GridGraph<3> g(Shape3(9, 8, 11), DirectNeighborhood);
+            GridGraph<3>::NodeMap<UInt32> labels(g);
+            RandomMT19937 random(42);
+            for(MultiArrayIndex k = 0; k < labels.size(); ++k)
+                labels[k] = random.uniformInt(20);
+            testCompressedAffiliatedEdgesImpl(g, labels, -1);
+            testCompressedAffiliatedEdgesImpl(g, labels, 0);
+        }
+    }
+
+    typedef MergeGraphAdaptor<GraphType>                    MergeGraph;
+    typedef GraphType::EdgeMap<float>                       FloatEdgeMap;
+    typedef GraphType::NodeMap<float>                       FloatNodeMap;
+    typedef GraphType::NodeMap< TinyVector<float, 2> >      FeatureNodeMap;
+    typedef cluster_operators::EdgeWeightNodeFeatures<
+        MergeGraph, FloatEdgeMap, FloatEdgeMap, FeatureNodeMap, FloatNodeMap, FloatEdgeMap
+    > ClusterOperator;
+    typedef HierarchicalClustering<ClusterOperator>         HCluster;
+
+    HCluster::MergeTreeEncoding
+    runHierarchicalClustering(GraphType const & g, FloatEdgeMap const & edgeIndicators,
+                              FeatureNodeMap const & features, float beta, size_t nodeNumStopCond,
+                              cluster_operators::ClusterQueueOptions const & queueOptions)
+    {
+        FloatEdgeMap edgeSizes(g), minWeights(g);
+        FloatNodeMap nodeSizes(g);
+        std::fill(edgeSizes.begin(), edgeSizes.end(), 1.0f);
+        std::fill(nodeSizes.begin(), nodeSizes.end(), 1.0f);
+        MergeGraph mg(g);
+        ClusterOperator op(mg, edgeIndicators, edgeSizes, features, nodeSizes, minWeights,
+                           beta, metrics::SquaredNormMetric, 0.0f, queueOptions);
+        HCluster hc(op, HCluster::Parameter(nodeNumStopCond));
+        hc.cluster();
+        shouldEqual(mg.nodeNum(), nodeNumStopCond);
+        shouldEqual(hc.mergeTreeEndcoding().size(), (size_t)g.nodeNum() - nodeNumStopCond);
+        return hc.mergeTreeEndcoding();
+    }
+
+    // the cluster operator copies its maps, so hand it a reference
+    // to read back the min weight map
+    struct FloatEdgeMapReference
+    {
+        typedef float           Value;
+        typedef float &         Reference;
+        typedef float const &   ConstReference;
+
+        FloatEdgeMapReference(FloatEdgeMap & map)
+        : map_(&map)
+        {}
+
+        Reference operator[](Edge const & e) const
+        {
+            return (*map_)[e];
+        }
+
+        FloatEdgeMap * map_;
+    };
+
+    typedef cluster_operators::EdgeWeightNodeFeatures<
+        MergeGraph, FloatEdgeMap, FloatEdgeMap, FeatureNodeMap, FloatNodeMap, FloatEdgeMapReference
+    > MinWeightClusterOperator;
+
+    // a cluster operator written against the interface without done()
+    struct OperatorWithoutDone
+    {
+        typedef ClusterOperator::MergeGraph  MergeGraph;
+        typedef ClusterOperator::WeightType  WeightType;
+        typedef ClusterOperator::Edge        Edge;
+
+        OperatorWithoutDone(ClusterOperator & op)
+        : op_(op)
+        {}
+
+        Edge contractionEdge()
+        {
+            return op_.contractionEdge();
+        }
+
+        WeightType contractionWeight()
+        {
+            return op_.contractionWeight();
+        }
+
+        MergeGraph & mergeGraph()
+        {
+            return op_.mergeGraph();
+        }
+
+        ClusterOperator & op_;
+    };
+
+    void
+    runHierarchicalClusteringMinWeights(GraphType const & g, FloatEdgeMap const & edgeIndicators,
+                                        size_t nodeNumStopCond,
+                                        cluster_operators::ClusterQueueOptions const & queueOptions,
+                                        FloatEdgeMap & minWeights, std::vector<int> & activeEdges)
+    {
+        FloatEdgeMap edgeSizes(g);
+        FloatNodeMap nodeSizes(g);
+        FeatureNodeMap features(g);
+        std::fill(edgeSizes.begin(), edgeSizes.end(), 1.0f);
+        std::fill(nodeSizes.begin(), nodeSizes.end(), 2.0f);
+        MergeGraph mg(g);
+        MinWeightClusterOperator op(mg, edgeIndicators, edgeSizes, features, nodeSizes,
+                                    FloatEdgeMapReference(minWeights),
+                                    0.0f, metrics::SquaredNormMetric, 1.0f, queueOptions);
+        HierarchicalClustering<MinWeightClusterOperator> 
+            hc(op, HierarchicalClustering<MinWeightClusterOperator>::Parameter(nodeNumStopCond));
+        hc.cluster();
+        activeEdges.clear();
+        for(MergeGraph::EdgeIt e(mg); e != lemon::INVALID; ++e)
+            activeEdges.push_back(mg.id(*e));
+    }
+
+    void testHierarchicalClusteringQueueModes()
+    {
+        typedef cluster_operators::ClusterQueueOptions QueueOptions;
+        {
+            // a chain has no double edges, so the weights never change
+            // and all queue modes must produce the same merge order
+            GraphType g;
+            for(int i = 0; i < 20; ++i)
+                g.addNode(i);
+            for(int i = 0; i < 19; ++i)
+                g.addEdge(g.nodeFromId(i), g.nodeFromId(i+1));
+            FloatEdgeMap edgeIndicators(g);
+            FeatureNodeMap features(g);
+            for(int i = 0; i < 19; ++i)
+                edgeIndicators[g.edgeFromId(i)] = ((7 * i) % 19 + 0.5f) / 19.0f;
+
+            HCluster::MergeTreeEncoding eager = runHierarchicalClustering(g, edgeIndicators, features, 0.0f, 1, QueueOptions());
+            HCluster::MergeTreeEncoding lazy = runHierarchicalClustering(g, edgeIndicators, features, 0.0f, 1, QueueOptions().lazy());
+            HCluster::MergeTreeEncoding buckets = runHierarchicalClustering(g, edgeIndicators, features, 0.0f, 1, QueueOptions().buckets(1000, 0.0, 1.0));
+            for(size_t k = 0; k < eager.size(); ++k)
+            {
+                shouldEqual(lazy[k].a_, eager[k].a_);
+                shouldEqual(lazy[k].b_, eager[k].b_);
+                shouldEqualTolerance(lazy[k].w_, eager[k].w_, 1e-6);
+                shouldEqual(buckets[k].a_, eager[k].a_);
+                shouldEqual(buckets[k].b_, eager[k].b_);
+                shouldEqualTolerance(buckets[k].w_, eager[k].w_, 1e-6);
+            }
+        }
+        {
+            // grid with random edge indicators and node features
+            const int width = 10;
+            GraphType g;
+            for(int i = 0; i < width*width; ++i)
+                g.addNode(i);
+            for(int y = 0; y < width; ++y)
+                for(int x = 0; x < width; ++x)
+                {
+                    if(x+1 < width)
+                        g.addEdge(g.nodeFromId(x + y*width), g.nodeFromId(x+1 + y*width));
+                    if(y+1 < width)
+                        g.addEdge(g.nodeFromId(x + y*width), g.nodeFromId(x + (y+1)*width));
+                }
+            RandomMT19937 random(1);
+            FloatEdgeMap edgeIndicators(g);
+            FeatureNodeMap features(g);
+            for(EdgeIt e(g); e != lemon::INVALID; ++e)
+                edgeIndicators[*e] = random.uniform();
+            for(NodeIt n(g); n != lemon::INVALID; ++n)
+                features[*n] = TinyVector<float, 2>(random.uniform(), random.uniform());
+
+            HCluster::MergeTreeEncoding eager = runHierarchicalClustering(g, edgeIndicators, features, 0.5f, 5, QueueOptions());
+            HCluster::MergeTreeEncoding lazy = runHierarchicalClustering(g, edgeIndicators, features, 0.5f, 5, QueueOptions().lazy());
+            HCluster::MergeTreeEncoding buckets = runHierarchicalClustering(g, edgeIndicators, features, 0.5f, 5, QueueOptions().buckets(64, 0.0, 2.0));
+            // the first merge happens before any weight can be stale
+            shouldEqual(lazy[0].a_, eager[0].a_);
+            shouldEqual(lazy[0].b_, eager[0].b_);
+        }
+        {
+            // with ward factors, merging only increases the weights of a chain, 
+            // so all modes contract the same edges. Afterwards, the min weight 
+            // map must hold the current weights of the remaining edges in all 
+            // modes, not only in eager mode.
+            GraphType g;
+            for(int i = 0; i < 20; ++i)
+                g.addNode(i);
+            for(int i = 0; i < 19; ++i)
+                g.addEdge(g.nodeFromId(i), g.nodeFromId(i+1));
+            FloatEdgeMap edgeIndicators(g);
+            for(int i = 0; i < 19; ++i)
+                edgeIndicators[g.edgeFromId(i)] = ((7 * i) % 19 + 0.5f) / 19.0f;
+
+            FloatEdgeMap eager(g), lazy(g), buckets(g);
+            std::vector<int> eagerEdges, lazyEdges, bucketEdges;
+            runHierarchicalClusteringMinWeights(g, edgeIndicators, 8, QueueOptions(), eager, eagerEdges);
+            runHierarchicalClusteringMinWeights(g, edgeIndicators, 8, QueueOptions().lazy(), lazy, lazyEdges);
+            runHierarchicalClusteringMinWeights(g, edgeIndicators, 8, QueueOptions().buckets(100000, 0.0, 2.0), buckets, bucketEdges);
+            shouldEqual(eagerEdges.size(), (size_t)7);
+            shouldEqualSequence(lazyEdges.begin(), lazyEdges.end(), eagerEdges.begin());
+            shouldEqualSequence(bucketEdges.begin(), bucketEdges.end(), eagerEdges.begin());
+            for(size_t k = 0; k < eagerEdges.size(); ++k)
+            {
+                const Edge e = g.edgeFromId(eagerEdges[k]);
+                shouldEqualTolerance(lazy[e], eager[e], 1e-6);
+                shouldEqualTolerance(buckets[e], eager[e], 1e-6);
+            }
+        }
+        {
+            // done() is optional
+            should(detail_hierarchical_clustering::HasDone<ClusterOperator>::value);
+            should(!detail_hierarchical_clustering::HasDone<OperatorWithoutDone>::value);
+
+            GraphType g;
+            for(int i = 0; i < 20; ++i)
+                g.addNode(i);
+            for(int i = 0; i < 19; ++i)
+                g.addEdge(g.nodeFromId(i), g.nodeFromId(i+1));
+            FloatEdgeMap edgeIndicators(g), edgeSizes(g), minWeights(g);
+            FloatNodeMap nodeSizes(g);
+            FeatureNodeMap features(g);
+            for(int i = 0; i < 19; ++i)
+                edgeIndicators[g.edgeFromId(i)] = ((7 * i) % 19 + 0.5f) / 19.0f;
+            std::fill(edgeSizes.begin(), edgeSizes.end(), 1.0f);
+            std::fill(nodeSizes.begin(), nodeSizes.end(), 1.0f);
+
+            MergeGraph mg(g);
+            ClusterOperator op(mg, edgeIndicators, edgeSizes, features, nodeSizes, minWeights,
+                               0.0f, metrics::SquaredNormMetric, 0.0f, QueueOptions().lazy());
+            OperatorWithoutDone wrapper(op);
+            HierarchicalClustering<OperatorWithoutDone> 
+                hc(wrapper, HierarchicalClustering<OperatorWithoutDone>::Parameter(1));
+            hc.cluster();
+
+            HCluster::MergeTreeEncoding lazy = runHierarchicalClustering(g, edgeIndicators, features, 0.0f, 1, QueueOptions().lazy());
+            shouldEqual(hc.mergeTreeEndcoding().size(), lazy.size());
+            for(size_t k = 0; k < lazy.size(); ++k)
+            {
+                shouldEqual(hc.mergeTreeEndcoding()[k].a_, lazy[k].a_);
+                shouldEqual(hc.mergeTreeEndcoding()[k].b_, lazy[k].b_);
+            }
+        }
+    }
+
+#ifndef VIGRA_SINGLE_THREADED  // chunked feature storage needs threading
+    void runBlockwiseClustering(GraphType const & g, FloatEdgeMap const & edgeIndicators,
+                                FeatureNodeMap const & features,
+                                MultiArrayView<1, Shape2> const & nodeBlocks,
+                                BlockwiseClusteringOptions const & options,
+                                MultiArrayView<1, UInt32> labels,
+                                ChunkedArray<1, float> & edgeArray, ChunkedArray<1, float> & nodeSizeArray)
+    {
+        ChunkedArrayLazy<1, float> edgeSizeArray(Shape1(g.maxEdgeId()+1), Shape1(16));
+        ChunkedArrayLazy<1, TinyVector<float, 2> > featureArray(Shape1(g.maxNodeId()+1), Shape1(16));
+        for(EdgeIt e(g); e != lemon::INVALID; ++e)
+        {
+            edgeArray.setItem(Shape1(g.id(*e)), edgeIndicators[*e]);
+            edgeSizeArray.setItem(Shape1(g.id(*e)), 1.0f);
+        }
+        for(NodeIt n(g); n != lemon::INVALID; ++n)
+        {
+            featureArray.setItem(Shape1(g.id(*n)), features[*n]);
+            nodeSizeArray.setItem(Shape1(g.id(*n)), 1.0f);
+        }
+        blockwiseHierarchicalClustering(g, nodeBlocks, edgeArray, edgeSizeArray,
+                                        featureArray, nodeSizeArray, labels, options);
+    }
+
+    void testBlockwiseHierarchicalClustering()
+    {
+        const int width = 16;
+        GraphType g;
+        for(int i = 0; i < width*width; ++i)
+            g.addNode(i);
+        for(int y = 0; y < width; ++y)
+            for(int x = 0; x < width; ++x)
+            {
+                if(x+1 < width)
+                    g.addEdge(g.nodeFromId(x + y*width), g.nodeFromId(x+1 + y*width));
+                if(y+1 < width)
+                    g.addEdge(g.nodeFromId(x + y*width), g.nodeFromId(x + (y+1)*width));
+            }
+        MultiArray<1, Shape2> nodeBlocks(Shape1(g.maxNodeId()+1));
+        for(NodeIt n(g); n != lemon::INVALID; ++n)
+            nodeBlocks(g.id(*n)) = Shape2(g.id(*n) % width / 4, g.id(*n) / width / 4);
+
+        RandomMT19937 random(11);
+        FloatEdgeMap edgeIndicators(g);
+        FeatureNodeMap features(g);
+        MultiArray<1, UInt32> labels(Shape1(g.maxNodeId()+1)), labels2(labels.shape());
+        ChunkedArrayLazy<1, float> edgeArray(Shape1(g.maxEdgeId()+1), Shape1(16)),
+                                   nodeSizeArray(Shape1(g.maxNodeId()+1), Shape1(16));
+        {
+            // two halves separated by strong edges
+            for(EdgeIt e(g); e != lemon::INVALID; ++e)
+                edgeIndicators[*e] = (g.id(g.u(*e)) % width < 8) == (g.id(g.v(*e)) % width < 8)
+                                          ? 0.1f + 0.1f*(float)random.uniform()
+                                          : 0.9f;
+            for(NodeIt n(g); n != lemon::INVALID; ++n)
+                features[*n] = TinyVector<float, 2>(0.0f);
+            BlockwiseClusteringOptions options;
+            options.beta(0.0f).wardness(0.0f).blockThreshold(0.3f).stopCondition(1, 0.5f);
+            runBlockwiseClustering(g, edgeIndicators, features, nodeBlocks, options.numThreads(4),
+                                   labels, edgeArray, nodeSizeArray);
+            for(NodeIt n(g); n != lemon::INVALID; ++n)
+                shouldEqual(labels(g.id(*n)), g.id(*n) % width < 8 ? 0u : 8u);
+            shouldEqual(nodeSizeArray.getItem(Shape1(0)), 128.0f);
+            shouldEqual(nodeSizeArray.getItem(Shape1(8)), 128.0f);
+            shouldEqualTolerance(edgeArray.getItem(Shape1(g.id(g.findEdge(g.nodeFromId(7), g.nodeFromId(8))))),
+                                 0.9f, 1e-5f);
+        }
+        {
+            // random data: the result does not depend on the number of threads,
+            // and a single block is identical to global clustering
+            for(EdgeIt e(g); e != lemon::INVALID; ++e)
+                edgeIndicators[*e] = (float)random.uniform();
+            for(NodeIt n(g); n != lemon::INVALID; ++n)
+                features[*n] = TinyVector<float, 2>(random.uniform(), random.uniform());
+            BlockwiseClusteringOptions options;
+            options.beta(0.5f).wardness(0.0f).blockThreshold(0.2f).stopCondition(10, 0.6f);
+            runBlockwiseClustering(g, edgeIndicators, features, nodeBlocks, options.numThreads(1),
+                                   labels, edgeArray, nodeSizeArray);
+            runBlockwiseClustering(g, edgeIndicators, features, nodeBlocks, options.numThreads(4),
+                                   labels2, edgeArray, nodeSizeArray);
+            shouldEqualSequence(labels.begin(), labels.end(), labels2.begin());
+            std::set<UInt32> clusters(labels.begin(), labels.end());
+            should(clusters.size() >= 10 && clusters.size() < 100);
+
+            MultiArray<1, Shape2> singleBlock(nodeBlocks.shape());
+            options.blockThreshold(0.6f);
+            runBlockwiseClustering(g, edgeIndicators, features, singleBlock, options,
+                                   labels, edgeArray, nodeSizeArray);
+
+            FloatEdgeMap edgeSizes(g), minWeights(g);
+            FloatNodeMap nodeSizes(g);
+            std::fill(edgeSizes.begin(), edgeSizes.end(), 1.0f);
+            std::fill(nodeSizes.begin(), nodeSizes.end(), 1.0f);
+            MergeGraph mg(g);
+            ClusterOperator op(mg, edgeIndicators, edgeSizes, features, nodeSizes, minWeights,
+                               0.5f, metrics::ManhattanMetric, 0.0f);
+            HCluster hc(op, HCluster::Parameter(10, false, false, 0.6f));
+            hc.cluster();
+            std::map<UInt32, MergeGraph::index_type> mapping;
+            for(NodeIt n(g); n != lemon::INVALID; ++n)
+            {
+                UInt32 label = labels(g.id(*n));
+                if(mapping.find(label) == mapping.end())
+                    mapping[label] = mg.reprNodeId(g.id(*n));
+                shouldEqual(mapping[label], mg.reprNodeId(g.id(*n)));
+            }
+            shouldEqual(mapping.size(), (size_t)mg.nodeNum());
+        }
+    }
+#endif // VIGRA_SINGLE_THREADED
+
+    void testRagFeatures()
+    {
+        using namespace vigra::acc;
+        typedef GridGraph<2> Grid;
+        typedef AccumulatorChain<float, Select<Mean, Minimum, Maximum, Count, Skewness> > EdgeStatistics;
+        typedef AccumulatorChain<TinyVector<float, 2>, Select<Mean, Count> > NodeStatistics;
+
+        Grid g(Shape2(40, 30), DirectNeighborhood);
+        Grid::NodeMap<UInt32> labels(g);
+        Grid::NodeMap<TinyVector<float, 2> > nodeData(g);
+        Grid::EdgeMap<float> edgeData(g);
+        RandomMT19937 random(13);
+        for(Grid::NodeIt n(g); n != lemon::INVALID; ++n)
+        {
+            labels[*n] = (*n)[0] / 7 + 6 * ((*n)[1] / 6) + 1;
+            nodeData[*n] = TinyVector<float, 2>(random.uniform(), (float)(*n)[0]);
+        }
+        for(Grid::EdgeIt e(g); e != lemon::INVALID; ++e)
+            edgeData[*e] = random.uniform();
+
+        AdjacencyListGraph rag;
+        AdjacencyListGraph::EdgeMap<std::vector<Grid::Edge> > affiliatedEdges;
+        makeRegionAdjacencyGraph(g, labels, rag, affiliatedEdges);
+
+        ArrayVector<EdgeStatistics> edgeFeatures(rag.maxEdgeId()+1), edgeFeatures2(rag.maxEdgeId()+1);
+        ArrayVector<NodeStatistics> nodeFeatures(rag.maxNodeId()+1);
+        accumulateRagFeatures(g, labels, rag, edgeData, nodeData, edgeFeatures, nodeFeatures,
+                              -1, ParallelOptions().numThreads(4));
+        accumulateRagEdgeFeatures(g, labels, rag, edgeData, edgeFeatures2,
+                                  -1, ParallelOptions().numThreads(1));
+
+        for(AdjacencyListGraph::EdgeIt e(rag); e != lemon::INVALID; ++e)
+        {
+            std::vector<Grid::Edge> const & edges = affiliatedEdges[*e];
+            float sum = 0.0f, minimum = 1.0f, maximum = 0.0f;
+            for(size_t k = 0; k < edges.size(); ++k)
+            {
+                sum += edgeData[edges[k]];
+                minimum = std::min(minimum, edgeData[edges[k]]);
+                maximum = std::max(maximum, edgeData[edges[k]]);
+            }
+            EdgeStatistics const & a = edgeFeatures[rag.id(*e)];
+            EdgeStatistics const & b = edgeFeatures2[rag.id(*e)];
+            shouldEqual(get<Count>(a), (double)edges.size());
+            shouldEqualTolerance(get<Mean>(a), sum / edges.size(), 1e-5);
+            shouldEqual(get<Minimum>(a), minimum);
+            shouldEqual(get<Maximum>(a), maximum);
+            shouldEqual(get<Count>(b), (double)edges.size());
+            shouldEqualTolerance(get<Mean>(b), get<Mean>(a), 1e-5);
+            shouldEqualTolerance(get<Skewness>(b), get<Skewness>(a), 1e-4);
+        }
+
+        std::map<UInt32, TinyVector<double, 2> > sums;
+        std::map<UInt32, double> counts;
+        for(Grid::NodeIt n(g); n != lemon::INVALID; ++n)
+        {
+            sums[labels[*n]] += nodeData[*n];
+            counts[labels[*n]] += 1.0;
+        }
+        for(AdjacencyListGraph::NodeIt n(rag); n != lemon::INVALID; ++n)
+        {
+            NodeStatistics const & a = nodeFeatures[rag.id(*n)];
+            shouldEqual(get<Count>(a), counts[rag.id(*n)]);
+            shouldEqualTolerance(get<Mean>(a)[0], sums[rag.id(*n)][0] / counts[rag.id(*n)], 1e-5);
+            shouldEqualTolerance(get<Mean>(a)[1], sums[rag.id(*n)][1] / counts[rag.id(*n)], 1e-5);
+        }
+
+        // ignored regions contribute neither edges nor nodes
+        ArrayVector<NodeStatistics> nodeFeatures2(rag.maxNodeId()+1);
+        accumulateRagNodeFeatures(g, labels, rag, nodeData, nodeFeatures2, 1, ParallelOptions().numThreads(3));
+        shouldEqual(get<Count>(nodeFeatures2[1]), 0.0);
+        shouldEqual(get<Count>(nodeFeatures2[2]), counts[2]);
+    }
+
     void testEdgeSort(){
         {
             GraphType g(0,0);
@@ -427,6 +1073,100 @@ struct GraphAlgorithmTest{
             should(edgeVec[1]==e34);
             should(edgeVec[0]==e24);
 
+            // radix sort
+            edgeSort(g,ew,l,edgeVec,ParallelOptions().numThreads(2));
+            shouldEqual(edgeVec.size(),g.edgeNum());
+            should(edgeVec[0]==e13);
+            should(edgeVec[1]==e12);
+            should(edgeVec[2]==e45);
+            should(edgeVec[3]==e34);
+            should(edgeVec[4]==e24);
+
+            edgeSort(g,ew,gr,edgeVec,ParallelOptions().numThreads(2));
+            should(edgeVec[4]==e13);
+            should(edgeVec[3]==e12);
+            should(edgeVec[2]==e45);
+            should(edgeVec[1]==e34);
+            should(edgeVec[0]==e24);
+        }
+        {
+            // large graph with negative weights and ties
+            GridGraph<2> g(Shape2(400, 300), IndirectNeighborhood);
+            GridGraph<2>::EdgeMap<float>  fw(g);
+            GridGraph<2>::EdgeMap<double> dw(g);
+            GridGraph<2>::EdgeMap<int>    position(g);
+            RandomMT19937 random(3);
+            int c = 0;
+            for(GridGraph<2>::EdgeIt e(g); e != lemon::INVALID; ++e, ++c)
+            {
+                position[*e] = c;
+                fw[*e] = (float)random.uniformInt(1000) - 500.0f;
+                dw[*e] = random.normal();
+            }
+            for(int nThreads = 1; nThreads <= 4; nThreads *= 4)
+            {
+                std::vector<GridGraph<2>::Edge> sorted, reference;
+                edgeSort(g, fw, std::less<float>(), sorted, ParallelOptions().numThreads(nThreads));
+                shouldEqual(sorted.size(), (size_t)g.edgeNum());
+                for(size_t i = 1; i < sorted.size(); ++i)
+                {
+                    should(fw[sorted[i-1]] <= fw[sorted[i]]);
+                    // stable: ties stay in EdgeIt order
+                    if(fw[sorted[i-1]] == fw[sorted[i]])
+                        should(position[sorted[i-1]] < position[sorted[i]]);
+                }
+
+                edgeSort(g, dw, std::greater<double>(), sorted, ParallelOptions().numThreads(nThreads));
+                edgeSort(g, dw, std::greater<double>(), reference);
+                shouldEqual(sorted.size(), reference.size());
+                for(size_t i = 0; i < sorted.size(); ++i)
+                    shouldEqual(dw[sorted[i]], dw[reference[i]]);
+            }
+        }
+    }
+
+    void testFelzenszwalbSegmentationBlockwise()
+    {
+        typedef GridGraph<2> Grid;
+        Grid g(Shape2(61, 47), DirectNeighborhood);
+        Grid::EdgeMap<float> weights(g);
+        Grid::NodeMap<float> sizes(g);
+        sizes.init(1.0f);
+        {
+            // two constant halves: the block borders must be closed again
+            for(Grid::EdgeIt e(g); e != lemon::INVALID; ++e)
+                weights[*e] = (g.u(*e)[0] < 30) == (g.v(*e)[0] < 30) ? 0.0f : 1.0f;
+            Grid::NodeMap<UInt32> labels(g);
+            felzenszwalbSegmentationBlockwise(g, weights, sizes, 0.5f, labels, Shape2(8, 10),
+                                              ParallelOptions().numThreads(4));
+            for(Grid::NodeIt n(g); n != lemon::INVALID; ++n)
+                shouldEqual(labels[*n] == labels[Shape2(0,0)], (*n)[0] < 30);
+        }
+        {
+            // a single block gives the same partition as the global algorithm
+            RandomMT19937 random(5);
+            for(Grid::EdgeIt e(g); e != lemon::INVALID; ++e)
+                weights[*e] = (float)random.uniformInt(20);
+            Grid::NodeMap<UInt32> labels(g), reference(g);
+            felzenszwalbSegmentation(g, weights, sizes, 10.0f, reference);
+            felzenszwalbSegmentationBlockwise(g, weights, sizes, 10.0f, labels, g.shape());
+            std::map<UInt32, UInt32> mapping, inverse;
+            for(Grid::NodeIt n(g); n != lemon::INVALID; ++n)
+            {
+                if(mapping.find(labels[*n]) == mapping.end())
+                    mapping[labels[*n]] = reference[*n];
+                if(inverse.find(reference[*n]) == inverse.end())
+                    inverse[reference[*n]] = labels[*n];
+                shouldEqual(mapping[labels[*n]], reference[*n]);
+                shouldEqual(inverse[reference[*n]], labels[*n]);
+            }
+            should(mapping.size() > 1);
+
+            // many blocks give a similar number of regions
+            felzenszwalbSegmentationBlockwise(g, weights, sizes, 10.0f, labels, Shape2(16, 16),
+                                              ParallelOptions().numThreads(3));
+            std::set<UInt32> regions(labels.begin(), labels.end());
+            should(regions.size() > mapping.size() / 2 && regions.size() < mapping.size() * 2);
         }
     }
 
@@ -467,6 +1207,66 @@ struct GraphAlgorithmTest{
         shouldEqualSequence(edgeMap1.begin(), edgeMap1.end(), ref2);
         shouldEqualSequence(edgeMap2.begin(), edgeMap2.end(), ref2);
     }
+
+    void testImplicitEdgeMaps()
+    {
+        typedef GridGraph<3> Grid;
+        MultiArray<3, float> nodeMap(Shape3(9,7,5));
+        MultiArray<3, float> interpolated(Shape3(17,13,9));
+        RandomMT19937 random(3);
+        for(MultiArray<3, float>::iterator i = nodeMap.begin(); i != nodeMap.end(); ++i)
+            *i = (float)(1 + random.uniformInt(16));
+        resizeMultiArraySplineInterpolation(nodeMap, interpolated);
+
+        Grid g(nodeMap.shape(), IndirectNeighborhood);
+        Grid::EdgeMap<float> explicit1(g), explicit2(g);
+        for(int euclidean = 0; euclidean < 2; ++euclidean)
+        {
+            edgeWeightsFromNodeWeights(g, nodeMap, explicit1, euclidean == 1);
+            edgeWeightsFromInterpolatedImage(g, interpolated, explicit2, euclidean == 1);
+            ImplicitNodeWeightsEdgeMap<3, undirected_tag, float> implicit1 =
+                implicitEdgeWeightsFromNodeWeights(g, nodeMap, euclidean == 1);
+            ImplicitInterpolatedEdgeMap<3, undirected_tag, float> implicit2 =
+                implicitEdgeWeightsFromInterpolatedImage(g, interpolated, euclidean == 1);
+            for(Grid::EdgeIt e(g); e != lemon::INVALID; ++e)
+            {
+                shouldEqual(implicit1[*e], explicit1[*e]);
+                shouldEqual(implicit2[*e], explicit2[*e]);
+            }
+        }
+        {
+            using namespace vigra::functor;
+            edgeWeightsFromNodeWeights(g, nodeMap, explicit1, false, max(Arg1(), Arg2()));
+            ImplicitNodeWeightsEdgeMap<3, undirected_tag, float> implicit(g, nodeMap);
+            shouldEqual(implicitEdgeWeightsFromNodeWeights(g, nodeMap, false, max(Arg1(), Arg2()))[Grid::Edge(1,2,3,4)],
+                        explicit1[Grid::Edge(1,2,3,4)]);
+            shouldEqual(implicit[Grid::Edge(1,2,3,4)],
+                        0.5f*(nodeMap[g.u(Grid::Edge(1,2,3,4))] + nodeMap[g.v(Grid::Edge(1,2,3,4))]));
+        }
+        {
+            // the mean of integer weights is not truncated
+            MultiArray<3, int> intNodeMap(nodeMap.shape());
+            intNodeMap[Shape3(0,0,0)] = 1;
+            ImplicitNodeWeightsEdgeMap<3, undirected_tag, int> implicit(g, intNodeMap);
+            shouldEqual(implicit[g.findEdge(Grid::Node(0,0,0), Grid::Node(1,0,0))], 0.5);
+        }
+
+        // algorithms give the same results on implicit and explicit maps
+        edgeWeightsFromNodeWeights(g, nodeMap, explicit1);
+        ImplicitNodeWeightsEdgeMap<3, undirected_tag, float> implicit(g, nodeMap);
+
+        ShortestPathDijkstra<Grid, float> sp1(g), sp2(g);
+        sp1.run(explicit1, Grid::Node(0,0,0));
+        sp2.run(implicit, Grid::Node(0,0,0));
+        shouldEqualSequence(sp1.distances().begin(), sp1.distances().end(), sp2.distances().begin());
+
+        Grid::NodeMap<float> sizes(g);
+        sizes.init(1.0f);
+        Grid::NodeMap<UInt32> labels1(g), labels2(g);
+        felzenszwalbSegmentation(g, explicit1, sizes, 20.0f, labels1);
+        felzenszwalbSegmentation(g, implicit, sizes, 20.0f, labels2);
+        shouldEqualSequence(labels1.begin(), labels1.end(), labels2.begin());
+    }
 };
 
 
@@ -479,9 +1279,19 @@ struct GraphAlgorithmTestSuite
     {   
         add( testCase( &GraphAlgorithmTest::testShortestPathAdjacencyListGraph));
         add( testCase( &GraphAlgorithmTest::testShortestPathGridGraph));
+        add( testCase( &GraphAlgorithmTest::testShortestPathVariants));
         add( testCase( &GraphAlgorithmTest::testRegionAdjacencyGraph));
+        add( testCase( &GraphAlgorithmTest::testGridGraphRegionAdjacencyGraph));
+        add( testCase( &GraphAlgorithmTest::testCompressedAffiliatedEdges));
+        add( testCase( &GraphAlgorithmTest::testHierarchicalClusteringQueueModes));
+#ifndef VIGRA_SINGLE_THREADED
+        add( testCase( &GraphAlgorithmTest::testBlockwiseHierarchicalClustering));
+#endif
+        add( testCase( &GraphAlgorithmTest::testRagFeatures));
         add( testCase( &GraphAlgorithmTest::testEdgeSort));
+        add( testCase( &GraphAlgorithmTest::testFelzenszwalbSegmentationBlockwise));
         add( testCase( &GraphAlgorithmTest::testEdgeWeightComputation));
+        add( testCase( &GraphAlgorithmTest::testImplicitEdgeMaps));
     }
 };
 
@@ -40,6 +40,7 @@
 #include "vigra/stdimage.hxx"
 #include "vigra/impex.hxx"
 #include "vigra/impexalpha.hxx"
+#include "vigra/tile_pyramid.hxx"
 #include "vigra/unittest.hxx"
 #include "vigra/multi_array.hxx"
 
@@ -300,6 +301,214 @@ public:
 #endif
     }
 
+    void testROI()
+    {
+        // codecs without native ROI support deliver full scanlines,
+        // which are cropped by importImage()
+        vigra::ImageImportInfo info ("lenna.xv");
+        MultiArray<2, unsigned char> roi(Shape2(40, 30));
+
+        importImage(info, roi, Shape2(10, 20));
+        should(roi == View(img).subarray(Shape2(10, 20), Shape2(50, 50)));
+
+        importImage(info, roi, Shape2(info.width() - 40, info.height() - 30));
+        should(roi == View(img).subarray(Shape2(info.width() - 40, info.height() - 30), info.shape()));
+
+        MultiArray<2, RGBValue<unsigned char> > rgb, rgbROI(Shape2(40, 30));
+        importImage("lennargb.xv", rgb);
+        importImage(vigra::ImageImportInfo("lennargb.xv"), rgbROI, Shape2(10, 20));
+        should(rgbROI == rgb.subarray(Shape2(10, 20), Shape2(50, 50)));
+
+        try
+        {
+            importImage(info, roi, Shape2(info.width() - 39, 0));
+            failTest("Failed to throw exception.");
+        }
+        catch(vigra::PreconditionViolation & e)
+        {
+            std::string expected("\nPrecondition violation!\nimportImage(): region of interest exceeds the image.");
+            should(std::string(e.what()).compare(0, expected.size(), expected) == 0);
+        }
+    }
+
+    void testBlockDecoding()
+    {
+        // codecs with a bulk interface decode directly into the array,
+        // which must give the same result as the scanline interface
+        std::vector<std::string> files;
+        files.push_back("resblock.pgm");
+#if defined(HasPNG)
+        files.push_back("resblock.png");
+#endif
+#if defined(HasJPEG)
+        files.push_back("resblock.jpg");
+#endif
+#if defined(HasTIFF)
+        files.push_back("resblock.tif");
+#endif
+        MultiArray<2, RGBValue<unsigned char> > rgb;
+        importImage("lennargb.xv", rgb);
+
+        for (unsigned int k = 0; k < files.size(); ++k)
+        {
+            exportImage(View(img), files[k]);
+            vigra::ImageImportInfo info(files[k].c_str());
+
+            Image ref(info.width(), info.height());
+            importImage(info, destImage(ref));
+
+            // rows of the destination are not consecutive
+            MultiArray<2, unsigned char> padded(Shape2(info.width() + 7, info.height()));
+            MultiArrayView<2, unsigned char> view(padded.subarray(Shape2(), info.shape()));
+            importImage(info, view);
+            should(view == View(ref));
+
+            // a ROI at the origin must not be decoded as a whole image
+            MultiArray<2, unsigned char> roi(Shape2(40, 30));
+            importImage(info, roi, Shape2(0, 0));
+            should(roi == View(ref).subarray(Shape2(), Shape2(40, 30)));
+
+            std::string rgbfile = "rgb" + files[k];
+            exportImage(rgb, rgbfile);
+            vigra::ImageImportInfo rgbinfo(rgbfile.c_str());
+
+            BRGBImage rgbref(rgbinfo.width(), rgbinfo.height());
+            importImage(rgbinfo, destImage(rgbref));
+
+            MultiArray<2, RGBValue<unsigned char> > rgbres;
+            importImage(rgbfile, rgbres);
+            shouldEqualSequence(rgbres.begin(), rgbres.end(), rgbref.begin());
+        }
+    }
+
+    void testTIFFTiled()
+    {
+#if defined(HasTIFF)
+        // tile size is rounded up to multiples of 16, border tiles are partial
+        vigra::ImageExportInfo exportinfo ("restiled.tif");
+        exportinfo.setTileSize(Size2D(40, 20));
+        exportImage (srcImageRange (img), exportinfo);
+
+        vigra::ImageImportInfo info ("restiled.tif");
+        shouldEqual(info.shape(), View(img).shape());
+
+        MultiArray<2, unsigned char> res(info.shape());
+        importImage(info, res);
+        should(res == View(img));
+
+        // the ROI straddles tile boundaries in both directions
+        MultiArray<2, unsigned char> roi(Shape2(70, 45));
+        importImage(info, roi, Shape2(30, 25));
+        should(roi == View(img).subarray(Shape2(30, 25), Shape2(100, 70)));
+
+        // strip-wise files support the ROI as well
+        exportImage (srcImageRange (img), vigra::ImageExportInfo ("res.tif"));
+        importImage(vigra::ImageImportInfo ("res.tif"), roi, Shape2(30, 25));
+        should(roi == View(img).subarray(Shape2(30, 25), Shape2(100, 70)));
+#endif
+    }
+
+    void testParallelEncoding()
+    {
+        // large enough for several compression blocks resp. bands,
+        // height is not a multiple of the JPEG block size
+        MultiArray<2, RGBValue<unsigned char> > rgb(Shape2(523, 437));
+        MultiArray<2, UInt16> gray(Shape2(389, 301));
+        for (int y = 0; y < rgb.height(); ++y)
+            for (int x = 0; x < rgb.width(); ++x)
+                rgb(x, y) = RGBValue<unsigned char>(x + y, (x * y) % 251, (7 * x + rand() % 5) & 0xFF);
+        for (int k = 0; k < gray.size(); ++k)
+            gray[k] = (UInt16)(k * 37 + rand() % 100);
+
+#if defined(HasPNG)
+        exportImage(rgb, ImageExportInfo("resparallel.png").setNumThreads(4));
+        MultiArray<2, RGBValue<unsigned char> > rgbres;
+        importImage("resparallel.png", rgbres);
+        should(rgbres == rgb);
+
+        exportImage(gray, ImageExportInfo("resparallel16.png").setNumThreads(4));
+        MultiArray<2, UInt16> grayres;
+        importImage("resparallel16.png", grayres);
+        should(grayres == gray);
+#endif
+
+#if defined(HasJPEG)
+        // the parallel encoder only differs in the entropy coding,
+        // so both files must decode to the same pixels
+        exportImage(rgb, ImageExportInfo("resparallel.jpg").setCompression("JPEG QUALITY=90").setNumThreads(4));
+        exportImage(rgb, ImageExportInfo("resserial.jpg").setCompression("JPEG QUALITY=90"));
+        MultiArray<2, RGBValue<unsigned char> > parallel, serial;
+        importImage("resparallel.jpg", parallel);
+        importImage("resserial.jpg", serial);
+        shouldEqual(parallel.shape(), rgb.shape());
+        should(parallel == serial);
+
+        MultiArray<2, unsigned char> gray8(gray.shape());
+        for (int y = 0; y < gray8.height(); ++y)
+            for (int x = 0; x < gray8.width(); ++x)
+                gray8(x, y) = (unsigned char)(x * x / (y + 1) + rand() % 9);
+        exportImage(gray8, ImageExportInfo("resparallelgray.jpg").setNumThreads(4));
+        exportImage(gray8, ImageExportInfo("resserialgray.jpg"));
+        MultiArray<2, unsigned char> grayparallel, grayserial;
+        importImage("resparallelgray.jpg", grayparallel);
+        importImage("resserialgray.jpg", grayserial);
+        should(grayparallel == grayserial);
+#endif
+    }
+
+    void testTilePyramid()
+    {
+        MultiArray<2, unsigned char> image(Shape2(300, 217));
+        for (int y = 0; y < image.height(); ++y)
+            for (int x = 0; x < image.width(); ++x)
+                image(x, y) = (unsigned char)((x * y) / 7 + rand() % 17);
+
+        // feed the image in bands whose height is unrelated to the tile size
+        int tileSize = 64, overlap = 1;
+        TilePyramidWriter<unsigned char> writer("respyramid", image.shape(), tileSize, overlap, "pgm");
+        shouldEqual(writer.levels(), 10);
+        for (int y = 0; y < image.height(); y += 50)
+        {
+            should(!writer.isComplete());
+            writer.addRows(image.subarray(Shape2(0, y), Shape2(300, std::min(y + 50, 217))));
+        }
+        should(writer.isComplete());
+        should(std::ifstream("respyramid.dzi").good());
+
+        // compare with the in-memory pyramid
+        MultiArray<2, unsigned char> level(image);
+        for (int l = writer.levels() - 1; l >= 0; --l)
+        {
+            shouldEqual(writer.levelShape(l), level.shape());
+            for (int r = 0; r*tileSize < level.height(); ++r)
+            {
+                for (int c = 0; c*tileSize < level.width(); ++c)
+                {
+                    std::ostringstream name;
+                    name << "respyramid_files/" << l << "/" << c << "_" << r << ".pgm";
+                    MultiArray<2, unsigned char> tile;
+                    importImage(name.str(), tile);
+                    Shape2 begin(std::max(0, c*tileSize - overlap), std::max(0, r*tileSize - overlap)),
+                           end(std::min<MultiArrayIndex>(level.width(), (c + 1)*tileSize + overlap),
+                               std::min<MultiArrayIndex>(level.height(), (r + 1)*tileSize + overlap));
+                    shouldEqual(tile.shape(), end - begin);
+                    should(tile == level.subarray(begin, end));
+                }
+            }
+            if (l == 0)
+                break;
+            if (level.width() < 3 || level.height() < 3)
+            {
+                // the remaining levels are tiny, only check their shape
+                shouldEqual(writer.levelShape(0), Shape2(1, 1));
+                break;
+            }
+            MultiArray<2, unsigned char> reduced(Shape2((level.width() + 1) / 2, (level.height() + 1) / 2));
+            pyramidReduceBurtFilter(srcImageRange(level), destImageRange(reduced));
+            level.swap(reduced);
+        }
+    }
+
     void testBMP ()
     {
         testFile ("res.bmp");
@@ -1773,6 +1982,11 @@ struct ImageImportExportTestSuite : public vigra::test_suite
         add(testCase(&ByteImageExportImportTest::testJPEG));
         add(testCase(&ByteImageExportImportTest::testTIFF));
         add(testCase(&ByteImageExportImportTest::testTIFFSequence));
+        add(testCase(&ByteImageExportImportTest::testTIFFTiled));
+        add(testCase(&ByteImageExportImportTest::testROI));
+        add(testCase(&ByteImageExportImportTest::testBlockDecoding));
+        add(testCase(&ByteImageExportImportTest::testParallelEncoding));
+        add(testCase(&ByteImageExportImportTest::testTilePyramid));
         add(testCase(&ByteImageExportImportTest::testBMP));
         add(testCase(&ByteImageExportImportTest::testPGM));
         add(testCase(&ByteImageExportImportTest::testPNM));
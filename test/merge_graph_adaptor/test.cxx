@@ -35,6 +35,7 @@
 
 
 #include <iostream>
+#include <set>
 #include "vigra/unittest.hxx"
 #include "vigra/stdimage.hxx"
 #include "vigra/multi_array.hxx"
@@ -1678,6 +1679,63 @@ struct AdjacencyListGraph2MergeGraphTest{
 
     }
 
+    void GraphMergeLargeDegreeTest(){
+        // 12x12 grid, merged in a fixed pseudo-random order until
+        // the nodes have many more neighbors than fit into the
+        // inline adjacency storage
+        const int width = 12;
+        Graph graph;
+        for(int i=0;i<width*width;++i)
+            graph.addNode(i);
+        for(int y=0;y<width;++y)
+        for(int x=0;x<width;++x){
+            if(x+1<width)
+                graph.addEdge(graph.nodeFromId(x+y*width),graph.nodeFromId(x+1+y*width));
+            if(y+1<width)
+                graph.addEdge(graph.nodeFromId(x+y*width),graph.nodeFromId(x+(y+1)*width));
+        }
+        MergeGraphType g(graph);
+
+        UInt32 seed = 1;
+        size_t maxDegree = 0;
+        while(g.nodeNum()>3){
+            // pick a pseudo-random alive edge
+            seed = seed*1664525u+1013904223u;
+            IdType edgeId = (seed>>8) % (g.maxEdgeId()+1);
+            while(g.edgeFromId(edgeId)==lemon::INVALID)
+                edgeId = (edgeId+1) % (g.maxEdgeId()+1);
+            g.contractEdge(g.edgeFromId(edgeId));
+
+            shouldEqual(degreeSum(g),g.edgeNum()*2);
+
+            // compare the adjacency of each node with the
+            // adjacency induced by the original graph
+            for(NodeIt n(g);n!=lemon::INVALID;++n){
+                std::set<IdType> neighbors;
+                for(GraphEdgeIt e(graph);e!=lemon::INVALID;++e){
+                    const IdType ru = g.reprNodeId(graph.id(graph.u(*e)));
+                    const IdType rv = g.reprNodeId(graph.id(graph.v(*e)));
+                    if(ru!=rv && ru==g.id(*n))
+                        neighbors.insert(rv);
+                    if(ru!=rv && rv==g.id(*n))
+                        neighbors.insert(ru);
+                }
+                shouldEqual(static_cast<size_t>(g.degree(*n)),neighbors.size());
+                maxDegree = std::max(maxDegree,neighbors.size());
+
+                IdType lastNeighbor = -1;
+                for(IncEdgeIt e(g,*n);e!=lemon::INVALID;++e){
+                    const Node other = g.u(*e)==*n ? g.v(*e) : g.u(*e);
+                    should(neighbors.count(g.id(other))==1);
+                    should(g.findEdge(*n,other)==*e);
+                    should(lastNeighbor<g.id(other));
+                    lastNeighbor = g.id(other);
+                }
+            }
+        }
+        should(maxDegree>6);
+    }
+
     size_t degreeSum(const MergeGraphType & g){
         size_t degreeSum=0;
         for(NodeIt n(g);n!=lemon::INVALID;++n){
@@ -1716,6 +1774,7 @@ struct AdjacencyListGraphMergeGraphAdaptorTestSuite
         // test which do some merging
         add( testCase( &AdjacencyListGraph2MergeGraphTest<vigra::UInt32>::GraphMergeGridDegreeTest));
         add( testCase( &AdjacencyListGraph2MergeGraphTest<vigra::UInt32>::GraphMergeGridEdgeTest));
+        add( testCase( &AdjacencyListGraph2MergeGraphTest<vigra::UInt32>::GraphMergeLargeDegreeTest));
     }
 };
 
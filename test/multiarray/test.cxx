@@ -38,6 +38,7 @@
 #include "vigra/multi_iterator_coupled.hxx"
 #include "vigra/multi_hierarchical_iterator.hxx"
 #include "vigra/multi_impex.hxx"
+#include "vigra/multi_array_mapped.hxx"
 #include "vigra/basicimageview.hxx"
 #include "vigra/navigator.hxx"
 #include "vigra/multi_pointoperators.hxx"
@@ -1683,6 +1684,14 @@ struct MultiImpexTest
         shouldEqual(result(0,1,2), 3);
         shouldEqual(result(0,1,3), 4);
 
+        // slices decoded in parallel must match the sequential import
+        VolumeImportInfo stack_info(std::string("impex/test"), std::string(ext2));
+        Array parallel(stack_info.shape()), serial(stack_info.shape());
+        importVolume(stack_info, parallel, ParallelOptions().numThreads(4));
+        importVolume(stack_info, serial, ParallelOptions().numThreads(ParallelOptions::NoThreads));
+        should(parallel == serial);
+        should(parallel == result);
+
 #ifdef _MSC_VER
         exportVolume(array, VolumeExportInfo("impex\\test", ext2));
         
@@ -1696,6 +1705,125 @@ struct MultiImpexTest
 #endif // _MSC_VER
     }
 
+    void testMapped()
+    {
+        typedef MultiArray<3, UInt16> Array16;
+        Array16 data(Shape(5,3,4));
+        linearSequence(data.begin(), data.end(), 250);
+
+        // write the raw data in both byte orders
+        Array16 swapped(data);
+        for(Array16::iterator i = swapped.begin(); i != swapped.end(); ++i)
+            *i = (UInt16)((*i >> 8) | (*i << 8));
+        const bool littleEndian = detail::isHostByteOrder("little endian");
+        {
+            std::ofstream raw("mapped_native.raw", std::ios::binary);
+            raw.write((char const *)data.data(), data.size()*sizeof(UInt16));
+            std::ofstream rawSwapped("mapped_swapped.raw", std::ios::binary);
+            rawSwapped.write((char const *)swapped.data(), swapped.size()*sizeof(UInt16));
+            std::ofstream info("mapped_native.info");
+            info << "filename = mapped_native.raw\nwidth = 5\nheight = 3\ndepth = 4\ndatatype = UINT16\n";
+            std::ofstream infoSwapped("mapped_swapped.info");
+            infoSwapped << "filename = mapped_swapped.raw\nwidth = 5\nheight = 3\ndepth = 4\ndatatype = UINT16\n"
+                        << "byteorder = " << (littleEndian ? "big endian" : "little endian") << "\n";
+        }
+
+        VolumeImportInfo info("mapped_native.info");
+        MappedMultiArray<3, UInt16> mapped = mapVolume<UInt16>(info);
+        shouldEqual(mapped.shape(), data.shape());
+        should(mapped == data);
+
+        VolumeImportInfo infoSwapped("mapped_swapped.info");
+        MappedMultiArray<3, UInt16> mappedSwapped = mapVolume<UInt16>(infoSwapped);
+        should(mappedSwapped == data);
+
+        // the ifstream-based import must agree with the mapping
+        Array16 imported(infoSwapped.shape());
+        importVolume(infoSwapped, imported);
+        should(imported == data);
+
+        // swapping must not modify the file
+        MappedFile file("mapped_swapped.raw");
+        should(std::equal(swapped.data(), swapped.data() + swapped.size(), (UInt16 const *)file.data()));
+
+        // copies share the mapping and survive the original
+        MappedMultiArray<3, UInt16> copy;
+        {
+            MappedMultiArray<3, UInt16> tmp = mapVolume<UInt16>(info);
+            copy = tmp;
+        }
+        should(copy == data);
+
+        try
+        {
+            mapVolume<UInt8>(info);
+            failTest("mapVolume() failed to throw exception.");
+        }
+        catch(PreconditionViolation & e)
+        {
+            std::string expected("\nPrecondition violation!\nmapVolume(): value_type doesn't match the volume's pixel type.");
+            std::string message(e.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+
+        // interleaved PNM
+        MultiArray<2, RGBValue<UInt8> > rgb(Shape2(7, 5));
+        for(int k = 0; k < rgb.size(); ++k)
+            rgb[k] = RGBValue<UInt8>(k, 2*k, 3*k);
+        exportImage(rgb, ImageExportInfo("mapped.ppm").setPixelType("UINT8"));
+        MappedMultiArray<3, UInt8> mappedPPM = mapImage<UInt8>(ImageImportInfo("mapped.ppm"));
+        shouldEqual(mappedPPM.shape(), Shape(7, 5, 3));
+        for(int k = 0; k < 3; ++k)
+            should(mappedPPM.bindOuter(k) == rgb.bindElementChannel(k));
+
+        // planar VIFF
+        MultiArray<2, RGBValue<float> > rgbf(Shape2(7, 5));
+        for(int k = 0; k < rgbf.size(); ++k)
+            rgbf[k] = RGBValue<float>(k + 0.5f, -k, k*0.25f);
+        exportImage(rgbf, ImageExportInfo("mapped.xv"));
+        MappedMultiArray<3, float> mappedVIFF = mapImage<float>(ImageImportInfo("mapped.xv"));
+        shouldEqual(mappedVIFF.shape(), Shape(7, 5, 3));
+        for(int k = 0; k < 3; ++k)
+            should(mappedVIFF.bindOuter(k) == rgbf.bindElementChannel(k));
+
+        // 16-bit PGM with headers of odd and even length, the former 
+        // place the (big endian) data at an unaligned file offset
+        MultiArray<2, UInt16> gray(Shape2(7, 5));
+        linearSequence(gray.begin(), gray.end(), 1000, 997);
+        const char * headers[] = { "P5\n7 5\n65535\n", "P5\n7  5\n65535\n" };
+        for(int h = 0; h < 2; ++h)
+        {
+            {
+                std::ofstream pgm("mapped16.pgm", std::ios::binary);
+                pgm << headers[h];
+                for(int k = 0; k < gray.size(); ++k)
+                    pgm.put((char)(gray[k] >> 8)).put((char)(gray[k] & 0xff));
+            }
+            ImageImportInfo pgmInfo("mapped16.pgm");
+            shouldEqual(pgmInfo.getPixelType(), std::string("UINT16"));
+            MappedMultiArray<3, UInt16> mappedPGM = mapImage<UInt16>(pgmInfo);
+            shouldEqual(mappedPGM.shape(), Shape(7, 5, 1));
+            should(mappedPGM.bindOuter(0) == gray);
+
+            MultiArray<2, UInt16> importedPGM(pgmInfo.shape());
+            importImage(pgmInfo, importedPGM);
+            should(importedPGM == gray);
+        }
+
+        exportImage(rgb, ImageExportInfo("mapped.bmp"));
+        try
+        {
+            mapImage<UInt8>(ImageImportInfo("mapped.bmp"));
+            failTest("mapImage() failed to throw exception.");
+        }
+        catch(PreconditionViolation & e)
+        {
+            std::string expected("\nPrecondition violation!\nmapImage(): file format doesn't store the pixels uncompressed");
+            std::string message(e.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+    }
+
 #if defined(HasTIFF)
     void testMultipageTIFF()
     {
@@ -3066,6 +3194,7 @@ struct MultiArrayTestSuite
         add( testCase( &MultiArrayTest::test_expandElements ) );
 
         add( testCase( &MultiImpexTest::testImpex ) );
+        add( testCase( &MultiImpexTest::testMapped ) );
 #if defined(HasTIFF)
         add( testCase( &MultiImpexTest::testMultipageTIFF ) );
 #endif
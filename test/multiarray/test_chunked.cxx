@@ -738,6 +738,46 @@ public:
         shouldEqualSequence(array->cbegin(), array->cend(), ref.begin());
     }
     
+    void testPinChunk()
+    {
+        Shape3 chunk_index = min(Shape3(1,0,1), array->chunkArrayShape() - Shape3(1));
+        Shape3 start = chunk_index*array->chunkShape(),
+               stop  = min(start + array->chunkShape(), shape);
+
+        MultiArrayView<3, T, StridedArrayTag> v = array->pinChunk(chunk_index);
+        shouldEqual(v.shape(), stop - start);
+        should(v == ref.subarray(start, stop));
+
+        // writes through the view are visible in the array
+        v[Shape3()] = T(fill_value);
+        ref[start] = T(fill_value);
+        shouldEqual(array->getItem(start), T(fill_value));
+
+        // the pinned chunk is not evicted when other chunks are loaded
+        array->setCacheMaxSize(1);
+        shouldEqualSequence(array->cbegin(), array->cend(), ref.begin());
+        array->releaseChunks(Shape3(), shape);
+        should(v == ref.subarray(start, stop));
+
+        array->unpinChunk(chunk_index, v.data());
+        shouldEqualSequence(array->cbegin(), array->cend(), ref.begin());
+
+        // a read-only pin of an empty chunk refers to the fill value and allocates nothing
+        std::size_t dataBytesBefore = empty_array->dataBytes();
+        MultiArrayView<3, T, StridedArrayTag> c = empty_array->pinChunk(chunk_index, true);
+        shouldEqual(c.shape(), stop - start);
+        should(c == PlainArray(stop - start, T(fill_value)));
+        shouldEqual(empty_array->dataBytes(), dataBytesBefore);
+        empty_array->unpinChunk(chunk_index, c.data());
+
+        try
+        {
+            array->pinChunk(array->chunkArrayShape());
+            failTest("no exception thrown");
+        }
+        catch(PreconditionViolation &) {}
+    }
+
     static void testMultiThreadedRun(BaseArray * v, int startIndex, int d, int * go)
     {
         while(*go == 0)
@@ -1523,6 +1563,7 @@ struct ChunkedMultiArrayTestSuite
         add( testCase( &ChunkedMultiArrayTest<Array>::test_subarray ) );
         add( testCase( &ChunkedMultiArrayTest<Array>::test_iterator ) );
         add( testCase( &ChunkedMultiArrayTest<Array>::testChunkIterator ) );
+        add( testCase( &ChunkedMultiArrayTest<Array>::testPinChunk ) );
         add( testCase( &ChunkedMultiArrayTest<Array>::testMultiThreaded ) );
     }
     
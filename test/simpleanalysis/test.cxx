@@ -1631,6 +1631,51 @@ struct WatershedsTest
         should(5 == watershedsMultiArray(img, res2, IndirectNeighborhood, WatershedOptions().regionGrowing().seedOptions(SeedOptions().extendedMinima())));
         should(res == res2);
 
+        // integer data are processed with a bucket queue
+        MultiArray<2, UInt8> img8(img.shape());
+        MultiArray<2, UInt16> img16(img.shape());
+        for(int k=0; k<img.size(); ++k)
+        {
+            img8[k] = (UInt8)roundi(img[k]);
+            img16[k] = (UInt16)(1000 + 100*roundi(img[k]));
+        }
+
+        res2.init(0);
+        should(5 == watershedsMultiArray(img8, res2, IndirectNeighborhood, WatershedOptions().seedOptions(SeedOptions().extendedMinima())));
+        should(res == res2);
+
+        res2.init(0);
+        should(5 == watershedsMultiArray(img16, res2, IndirectNeighborhood, WatershedOptions().seedOptions(SeedOptions().extendedMinima())));
+        should(res == res2);
+
+        // quantized real-valued data
+        res2.init(0);
+        should(5 == watershedsMultiArray(img, res2, IndirectNeighborhood, WatershedOptions().turboAlgorithm().seedOptions(SeedOptions().extendedMinima())));
+        should(res == res2);
+
+        // threshold is applied to the original data, not to the bucket index
+        res.init(0);
+        res2.init(0);
+        should(5 == watershedsMultiArray(img, res, IndirectNeighborhood, WatershedOptions().stopAtThreshold(25.0).seedOptions(SeedOptions().extendedMinima())));
+        should(5 == watershedsMultiArray(img16, res2, IndirectNeighborhood, WatershedOptions().stopAtThreshold(3550.0).seedOptions(SeedOptions().extendedMinima())));
+        should(res == res2);
+        should(res.any() && !res.all());
+
+        // a non-integral bias must not merge neighboring integer costs
+        GridGraph<2, undirected_tag> graph(img8.shape());
+        double offset, scale;
+        std::ptrdiff_t bucketCount;
+        bool exact;
+        should(lemon_graph::graph_detail::watershedBucketParameters(graph, img8, 
+                   WatershedOptions().biasLabel(1, 2.0), offset, scale, bucketCount, exact));
+        should(exact);
+        should(!lemon_graph::graph_detail::watershedBucketParameters(graph, img8, 
+                   WatershedOptions().biasLabel(1, 0.5), offset, scale, bucketCount, exact));
+        should(lemon_graph::graph_detail::watershedBucketParameters(graph, img8, 
+                   WatershedOptions().biasLabel(1, 0.5).turboAlgorithm(), offset, scale, bucketCount, exact));
+        should(!exact);
+        shouldEqual(bucketCount, 256);
+
 #if 0
         std::cerr << count << "\n";
         for(int y=0;y<9;++y)
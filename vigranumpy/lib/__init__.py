@@ -1006,8 +1006,10 @@ def _genRegionAdjacencyGraphConvenienceFunctions():
 
                     - baseGraph : baseGraph is the graph passed in constructor
 
-                    - affiliatedEdges : for each edge in the region adjacency graph,
-                        a vector of edges of the baseGraph is stored in affiliatedEdges
+                    - affiliatedEdges : the ids of the baseGraph edges belonging to each
+                        edge of the region adjacency graph, stored in compressed sparse
+                        row (CSR) layout, i.e. one array of edge ids for all edges plus
+                        an offset array (opaque object, used by the rag functions)
 
 
             """
@@ -1172,8 +1174,10 @@ def _genRegionAdjacencyGraphConvenienceFunctions():
 
                     - baseGraph : baseGraph is the graph passed in constructor
 
-                    - affiliatedEdges : for each edge in the region adjacency graph,
-                        a vector of edges of the baseGraph is stored in affiliatedEdges
+                    - affiliatedEdges : the ids of the baseGraph edges belonging to each
+                        edge of the region adjacency graph, stored in compressed sparse
+                        row (CSR) layout, i.e. one array of edge ids for all edges plus
+                        an offset array (opaque object, used by the rag functions)
 
                     - shape : shape of the grid graph which is a base graph in the
                         complete graph chain.
@@ -1304,6 +1308,10 @@ def _genRegionAdjacencyGraphConvenienceFunctions():
                     If graph is a GridGraph or a GridRegionAdjacencyGraph, a GridRegionAdjacencyGraph 
                     will be returned.
                     Otherwise a RegionAdjacencyGraph will be returned
+
+            For a GridGraph, the region adjacency graph is built with as many
+            threads as there are CPU cores (earlier versions used a single thread).
+            The result does not depend on the number of threads.
         """
         if isinstance(graph , graphs.GridRegionAdjacencyGraph) or graphs.isGridGraph(graph):
             return GridRegionAdjacencyGraph(graph=graph,labels=labels,ignoreLabel=ignoreLabel,reserveEdges=reserveEdges)
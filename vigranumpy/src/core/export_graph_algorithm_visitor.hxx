@@ -233,13 +233,16 @@ public:
         FloatNodeArrayMap  nodeSizeArrayMap(g,nodeSizeArray);
         FloatEdgeArrayMap  outArrayMap(g,outArray);
 
-        for(EdgeIt iter(g);iter!=lemon::INVALID;++iter){
-            const float uSize=nodeSizeArrayMap[g.u(*iter)];
-            const float vSize=nodeSizeArrayMap[g.v(*iter)];
-            const float w = edgeWeightsArrayMap[*iter];
-            const float ward  = 1.0f/(1.0f/std::log(uSize) + 1.0f/std::log(vSize)  );
-            const float wardF = wardness*ward + (1.0-wardness);
-            outArrayMap[*iter]=w*wardF;
+        {
+            PyAllowThreads _pythread;
+            for(EdgeIt iter(g);iter!=lemon::INVALID;++iter){
+                const float uSize=nodeSizeArrayMap[g.u(*iter)];
+                const float vSize=nodeSizeArrayMap[g.v(*iter)];
+                const float w = edgeWeightsArrayMap[*iter];
+                const float ward  = 1.0f/(1.0f/std::log(uSize) + 1.0f/std::log(vSize)  );
+                const float wardF = wardness*ward + (1.0-wardness);
+                outArrayMap[*iter]=w*wardF;
+            }
         }
         return outArray;
 
@@ -259,19 +262,22 @@ public:
         NumpyArray<2,UInt32> vis      ((    typename NumpyArray<2,UInt64>::difference_type(g.edgeNum(),2)));
         NumpyArray<1,float > weights  ((    typename NumpyArray<1,double>::difference_type(g.edgeNum()  )));
         
-        size_t denseIndex = 0 ;
-        for(NodeIt iter(g);iter!=lemon::INVALID;++iter){
-            toDenseArrayMap[*iter]=denseIndex;
-            ++denseIndex;
-        }
-        denseIndex=0;
-        for(EdgeIt iter(g);iter!=lemon::INVALID;++iter){
-            const size_t dU=toDenseArrayMap[g.u(*iter)];
-            const size_t dV=toDenseArrayMap[g.v(*iter)];
-            vis(denseIndex,0)=std::min(dU,dV);
-            vis(denseIndex,1)=std::max(dU,dV);
-            weights(denseIndex)=edgeWeightsArrayMap[*iter];
-            ++denseIndex;
+        {
+            PyAllowThreads _pythread;
+            size_t denseIndex = 0 ;
+            for(NodeIt iter(g);iter!=lemon::INVALID;++iter){
+                toDenseArrayMap[*iter]=denseIndex;
+                ++denseIndex;
+            }
+            denseIndex=0;
+            for(EdgeIt iter(g);iter!=lemon::INVALID;++iter){
+                const size_t dU=toDenseArrayMap[g.u(*iter)];
+                const size_t dV=toDenseArrayMap[g.v(*iter)];
+                vis(denseIndex,0)=std::min(dU,dV);
+                vis(denseIndex,1)=std::max(dU,dV);
+                weights(denseIndex)=edgeWeightsArrayMap[*iter];
+                ++denseIndex;
+            }
         }
         return python::make_tuple(vis,weights);
 
@@ -382,11 +388,14 @@ public:
         FloatNodeArrayMap  nodeFeatureArrayMap(g,nodeFeaturesArray);
         FloatEdgeArrayMap  edgeWeightsArrayMap(g,edgeWeightsArray);
         
-        for(EdgeIt e(g);e!=lemon::INVALID;++e){
-            const Edge edge(*e);
-            const Node u=g.u(edge);
-            const Node v=g.v(edge);
-            edgeWeightsArrayMap[edge]=nodeFeatureArrayMap[u]+nodeFeatureArrayMap[v];
+        {
+            PyAllowThreads _pythread;
+            for(EdgeIt e(g);e!=lemon::INVALID;++e){
+                const Edge edge(*e);
+                const Node u=g.u(edge);
+                const Node v=g.v(edge);
+                edgeWeightsArrayMap[edge]=nodeFeatureArrayMap[u]+nodeFeatureArrayMap[v];
+            }
         }
         return edgeWeightsArray;
     }
@@ -405,11 +414,14 @@ public:
         MultiFloatNodeArrayMap nodeFeatureArrayMap(g,nodeFeaturesArray);
         FloatEdgeArrayMap      edgeWeightsArrayMap(g,edgeWeightsArray);
         
-        for(EdgeIt e(g);e!=lemon::INVALID;++e){
-            const Edge edge(*e);
-            const Node u=g.u(edge);
-            const Node v=g.v(edge);
-            edgeWeightsArrayMap[edge]=functor(nodeFeatureArrayMap[u],nodeFeatureArrayMap[v]);
+        {
+            PyAllowThreads _pythread;
+            for(EdgeIt e(g);e!=lemon::INVALID;++e){
+                const Edge edge(*e);
+                const Node u=g.u(edge);
+                const Node v=g.v(edge);
+                edgeWeightsArrayMap[edge]=functor(nodeFeatureArrayMap[u],nodeFeatureArrayMap[v]);
+            }
         }
         return edgeWeightsArray;
     }
@@ -429,7 +441,10 @@ public:
         UInt32NodeArrayMap labelsArrayMap(g,labelsArray);
 
         // call algorithm itself
-        edgeWeightedWatershedsSegmentation(g,edgeWeightsArrayMap,seedsArrayMap,labelsArrayMap);
+        {
+            PyAllowThreads _pythread;
+            edgeWeightedWatershedsSegmentation(g,edgeWeightsArrayMap,seedsArrayMap,labelsArrayMap);
+        }
 
         // retun labels
         return labelsArray;
@@ -457,10 +472,13 @@ public:
         FloatNodeArrayMap  nodeWeightsArrayMap(g,nodeWeightsArray);
         UInt32NodeArrayMap labelsArrayMap(g,labelsArray);
 
-        std::copy(seedsArray.begin(),seedsArray.end(),labelsArray.begin());
+        {
+            PyAllowThreads _pythread;
+            std::copy(seedsArray.begin(),seedsArray.end(),labelsArray.begin());
 
-        //lemon_graph::graph_detail::generateWatershedSeeds(g, nodeWeightsArrayMap, labelsArrayMap, watershedsOption.seed_options);
-        lemon_graph::watershedsGraph(g, nodeWeightsArrayMap, labelsArrayMap, watershedsOption);
+            //lemon_graph::graph_detail::generateWatershedSeeds(g, nodeWeightsArrayMap, labelsArrayMap, watershedsOption.seed_options);
+            lemon_graph::watershedsGraph(g, nodeWeightsArrayMap, labelsArrayMap, watershedsOption);
+        }
         //lemon_graph::graph_detail::seededWatersheds(g, nodeWeightsArrayMap, seedsArrayMap, watershedsOption);
         
         return labelsArray;
@@ -483,7 +501,10 @@ public:
         FloatNodeArrayMap  nodeWeightsArrayMap(g,nodeWeightsArray);
         UInt32NodeArrayMap seedsArrayMap(g,seedsArray);
 
-        lemon_graph::graph_detail::generateWatershedSeeds(g, nodeWeightsArrayMap, seedsArrayMap, watershedsOption.seed_options);
+        {
+            PyAllowThreads _pythread;
+            lemon_graph::graph_detail::generateWatershedSeeds(g, nodeWeightsArrayMap, seedsArrayMap, watershedsOption.seed_options);
+        }
 
         return seedsArray;
     }
@@ -505,7 +526,10 @@ public:
         UInt32NodeArrayMap labelsArrayMap(g,labelsArray);
 
         // call algorithm itself
-        carvingSegmentation(g,edgeWeightsArrayMap,seedsArrayMap,backgroundLabel,backgroundBias,labelsArrayMap);
+        {
+            PyAllowThreads _pythread;
+            carvingSegmentation(g,edgeWeightsArrayMap,seedsArrayMap,backgroundLabel,backgroundBias,labelsArrayMap);
+        }
 
         // retun labels
         return labelsArray;
@@ -528,7 +552,10 @@ public:
         UInt32NodeArrayMap labelsArrayMap(g,labelsArray);
 
         // call algorithm itself
-        felzenszwalbSegmentation(g,edgeWeightsArrayMap,nodeSizesArrayMap,k,labelsArrayMap,nodeNumStop);
+        {
+            PyAllowThreads _pythread;
+            felzenszwalbSegmentation(g,edgeWeightsArrayMap,nodeSizesArrayMap,k,labelsArrayMap,nodeNumStop);
+        }
 
         // retun labels
         return labelsArray;
@@ -560,7 +587,10 @@ public:
         MultiFloatNodeArrayMap nodeFeaturesOutArrayMap(g,nodeFeaturesOutArray);
 
         // call algorithm itself
-        recursiveGraphSmoothing(g,nodeFeaturesArrayMap,edgeIndicatorArrayMap,lambda,edgeThreshold,scale,iterations,nodeFeaturesBufferArrayMap,nodeFeaturesOutArrayMap);
+        {
+            PyAllowThreads _pythread;
+            recursiveGraphSmoothing(g,nodeFeaturesArrayMap,edgeIndicatorArrayMap,lambda,edgeThreshold,scale,iterations,nodeFeaturesBufferArrayMap,nodeFeaturesOutArrayMap);
+        }
 
         // retun smoothed features
         return nodeFeaturesOutArray;
@@ -676,13 +706,16 @@ public:
         // numpy arrays => lemon maps
         FloatEdgeArrayMap edgeWeightsArrayMap(g,edgeWeightsArray);
         typedef typename FloatNodeArray::difference_type CoordType;
-        for(EdgeIt iter(g); iter!=lemon::INVALID; ++ iter){
-
-            const Edge edge(*iter);
-            const CoordType uCoord(g.u(edge));
-            const CoordType vCoord(g.v(edge));
-            const CoordType tCoord = uCoord+vCoord;
-            edgeWeightsArrayMap[edge]=interpolatedImage[tCoord];
+        {
+            PyAllowThreads _pythread;
+            for(EdgeIt iter(g); iter!=lemon::INVALID; ++ iter){
+
+                const Edge edge(*iter);
+                const CoordType uCoord(g.u(edge));
+                const CoordType vCoord(g.v(edge));
+                const CoordType tCoord = uCoord+vCoord;
+                edgeWeightsArrayMap[edge]=interpolatedImage[tCoord];
+            }
         }
         return edgeWeightsArray;
     }
@@ -153,7 +153,7 @@ public:
         python::class_<HCluster,boost::noncopyable>(
             clsName.c_str(),python::init<ClusterOperator &>()[python::with_custodian_and_ward<1 /*custodian == self*/, 2 /*ward == const InputLabelingView & */>()]
         )
-        .def("cluster",&HCluster::cluster)
+        .def("cluster",static_cast<void (*)(HCluster &)>(&pyCluster))
         .def("reprNodeIds",registerConverters(&pyReprNodeIds<HCluster>))
         .def("resultLabels",registerConverters(&pyResultLabels<HCluster>),
             (
@@ -267,6 +267,17 @@ public:
 
 
 
+    template<class CLUSTER_OP>
+    static void pyCluster(HierarchicalClustering<CLUSTER_OP> & hcluster){
+        PyAllowThreads _pythread;
+        hcluster.cluster();
+    }
+
+    // the Python operator calls back into the interpreter, so it must keep the GIL
+    static void pyCluster(HierarchicalClustering<PythonClusterOperator> & hcluster){
+        hcluster.cluster();
+    }
+
     template<class HCLUSTER>
     static void pyReprNodeIds(
         const HCLUSTER &     hcluster,
@@ -286,8 +297,11 @@ public:
 
         UInt32NodeArrayMap resultArrayMap(hcluster.graph(),resultArray);
 
-        for(NodeIt iter(hcluster.graph());iter!=lemon::INVALID;++iter ){
-            resultArrayMap[*iter]=hcluster.mergeGraph().reprNodeId(hcluster.graph().id(*iter));
+        {
+            PyAllowThreads _pythread;
+            for(NodeIt iter(hcluster.graph());iter!=lemon::INVALID;++iter ){
+                resultArrayMap[*iter]=hcluster.mergeGraph().reprNodeId(hcluster.graph().id(*iter));
+            }
         }
         return resultArray;
     }
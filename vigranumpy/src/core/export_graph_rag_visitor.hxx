@@ -97,7 +97,8 @@ public:
 
 
 
-    typedef typename RagGraph:: template EdgeMap< std::vector<Edge> > RagAffiliatedEdges;
+    typedef CompressedAffiliatedEdges<Graph,UInt64> RagAffiliatedEdges;
+    typedef typename RagAffiliatedEdges::const_iterator AffiliatedEdgeIdIter;
 
 
     typedef typename GraphDescriptorToMultiArrayIndex<Graph>::IntrinsicNodeMapShape NodeCoordinate;
@@ -111,7 +112,7 @@ public:
     void exportRagAffiliatedEdges()const{
 
         const std::string hyperEdgeMapNamClsName = clsName_ + std::string("RagAffiliatedEdges");
-        python::class_<RagAffiliatedEdges>(hyperEdgeMapNamClsName.c_str(),python::init<const RagGraph &>())
+        python::class_<RagAffiliatedEdges>(hyperEdgeMapNamClsName.c_str(),python::init<>())
         ;
 
     }
@@ -120,7 +121,7 @@ public:
     void visit(classT& c) const
     {   
 
-        // something like RagEdgeMap< std::vector< Edge > >
+        // edge ids of the base graph for each rag edge (CSR layout)
         exportRagAffiliatedEdges();
 
         // make the region adjacency graph
@@ -235,8 +236,11 @@ public:
         RagFloatNodeArrayMap ragGtQtMap(rag, ragGtQt);
 
         // call algorithm
-        projectGroundTruth(rag, baseGraph, baseGraphRagLabelsMap,
-                           baseGraphGtMap, ragGtMap, ragGtQtMap);
+        {
+            PyAllowThreads _pythread;
+            projectGroundTruth(rag, baseGraph, baseGraphRagLabelsMap,
+                               baseGraphGtMap, ragGtMap, ragGtQtMap);
+        }
 
 
         return python::make_tuple(ragGt, ragGtQt);
@@ -253,10 +257,13 @@ public:
         UInt32NodeArrayMap labelsArrayMap(graph,labelsArray);
 
         // allocate a new RagAffiliatedEdges
-        RagAffiliatedEdges * affiliatedEdges = new RagAffiliatedEdges(rag);
+        RagAffiliatedEdges * affiliatedEdges = new RagAffiliatedEdges();
 
         // call algorithm itself
-        makeRegionAdjacencyGraph(graph,labelsArrayMap,rag,*affiliatedEdges,ignoreLabel);
+        {
+            PyAllowThreads _pythread;
+            makeRegionAdjacencyGraph(graph,labelsArrayMap,rag,*affiliatedEdges,ignoreLabel);
+        }
 
         return affiliatedEdges;
     }
@@ -289,53 +296,53 @@ public:
         typename PyEdgeMapTraits<RagGraph,T >::Map ragEdgeFeaturesArrayMap(rag,ragEdgeFeaturesArray);
 
 
-        if(accumulator == std::string("mean") ){
-            for(RagEdgeIt iter(rag);iter!=lemon::INVALID;++iter){
-                const RagEdge ragEdge = *iter;
-                const std::vector<Edge> & affEdges = affiliatedEdges[ragEdge];
-                float weightSum=0.0;
-                for(size_t i=0;i<affEdges.size();++i){
-                    const float weight = edgeSizesArrayMap[affEdges[i]];
-                    ragEdgeFeaturesArrayMap[ragEdge]+=weight*edgeFeaturesArrayMap[affEdges[i]];
-                    weightSum+=weight;
+        {
+            PyAllowThreads _pythread;
+            if(accumulator == std::string("mean") ){
+                for(RagEdgeIt iter(rag);iter!=lemon::INVALID;++iter){
+                    const RagEdge ragEdge = *iter;
+                    float weightSum=0.0;
+                    for(AffiliatedEdgeIdIter id=affiliatedEdges.begin(ragEdge);id!=affiliatedEdges.end(ragEdge);++id){
+                        const Edge affEdge = graph.edgeFromId(*id);
+                        const float weight = edgeSizesArrayMap[affEdge];
+                        ragEdgeFeaturesArrayMap[ragEdge]+=weight*edgeFeaturesArrayMap[affEdge];
+                        weightSum+=weight;
+                    }
+
+                    ragEdgeFeaturesArrayMap[ragEdge]/=weightSum;
                 }
-
-                ragEdgeFeaturesArrayMap[ragEdge]/=weightSum;
             }
-        }
-        else if( accumulator == std::string("sum")){
-            for(RagEdgeIt iter(rag);iter!=lemon::INVALID;++iter){
-                const RagEdge ragEdge = *iter;
-                const std::vector<Edge> & affEdges = affiliatedEdges[ragEdge];
-                for(size_t i=0;i<affEdges.size();++i){
-                    ragEdgeFeaturesArrayMap[ragEdge]+=edgeFeaturesArrayMap[affEdges[i]];
+            else if( accumulator == std::string("sum")){
+                for(RagEdgeIt iter(rag);iter!=lemon::INVALID;++iter){
+                    const RagEdge ragEdge = *iter;
+                    for(AffiliatedEdgeIdIter id=affiliatedEdges.begin(ragEdge);id!=affiliatedEdges.end(ragEdge);++id){
+                        ragEdgeFeaturesArrayMap[ragEdge]+=edgeFeaturesArrayMap[graph.edgeFromId(*id)];
+                    }
                 }
             }
-        }
-        else if(accumulator == std::string("min")){
-            for(RagEdgeIt iter(rag);iter!=lemon::INVALID;++iter){
-                const RagEdge ragEdge = *iter;
-                const std::vector<Edge> & affEdges = affiliatedEdges[ragEdge];
-                float minVal=std::numeric_limits<float>::infinity();
-                for(size_t i=0;i<affEdges.size();++i){
-                    minVal  = std::min(minVal,edgeFeaturesArrayMap[affEdges[i]]);
+            else if(accumulator == std::string("min")){
+                for(RagEdgeIt iter(rag);iter!=lemon::INVALID;++iter){
+                    const RagEdge ragEdge = *iter;
+                    float minVal=std::numeric_limits<float>::infinity();
+                    for(AffiliatedEdgeIdIter id=affiliatedEdges.begin(ragEdge);id!=affiliatedEdges.end(ragEdge);++id){
+                        minVal  = std::min(minVal,edgeFeaturesArrayMap[graph.edgeFromId(*id)]);
+                    }
+                    ragEdgeFeaturesArrayMap[ragEdge]=minVal;
                 }
-                ragEdgeFeaturesArrayMap[ragEdge]=minVal;
             }
-        }
-        else if(accumulator == std::string("max")){
-            for(RagEdgeIt iter(rag);iter!=lemon::INVALID;++iter){
-                const RagEdge ragEdge = *iter;
-                const std::vector<Edge> & affEdges = affiliatedEdges[ragEdge];
-                float maxVal=-1.0*std::numeric_limits<float>::infinity();
-                for(size_t i=0;i<affEdges.size();++i){
-                    maxVal  = std::max(maxVal,edgeFeaturesArrayMap[affEdges[i]]);
+            else if(accumulator == std::string("max")){
+                for(RagEdgeIt iter(rag);iter!=lemon::INVALID;++iter){
+                    const RagEdge ragEdge = *iter;
+                    float maxVal=-1.0*std::numeric_limits<float>::infinity();
+                    for(AffiliatedEdgeIdIter id=affiliatedEdges.begin(ragEdge);id!=affiliatedEdges.end(ragEdge);++id){
+                        maxVal  = std::max(maxVal,edgeFeaturesArrayMap[graph.edgeFromId(*id)]);
+                    }
+                    ragEdgeFeaturesArrayMap[ragEdge]=maxVal;
                 }
-                ragEdgeFeaturesArrayMap[ragEdge]=maxVal;
             }
-        }
-        else{
-            throw std::runtime_error("not supported accumulator");
+            else{
+                throw std::runtime_error("not supported accumulator");
+            }
         }
 
         return ragEdgeFeaturesArray;
@@ -358,34 +365,36 @@ public:
         UInt32 nPoints = 0;
         for (RagOutArcIt iter(rag, node); iter != lemon::INVALID; ++iter) {
             const RagEdge ragEdge(*iter);
-            const std::vector<Edge> & affEdges = affiliatedEdges[ragEdge];
-            nPoints += affEdges.size();
+            nPoints += affiliatedEdges.size(ragEdge);
         }
         NumpyArray<2, UInt32> edgePoints(NumpyArray<2, UInt32>::difference_type(nPoints, NodeMapDim));
 
         // Find edges
-        size_t nNext = 0;
-        for(RagOutArcIt iter(rag, node); iter != lemon::INVALID; ++iter) {
-            const RagEdge ragEdge(*iter);
-            const std::vector<Edge> & affEdges = affiliatedEdges[ragEdge];
-            for (size_t i=0; i<affEdges.size(); ++i) {
-                Node u = graph.u(affEdges[i]);
-                Node v = graph.v(affEdges[i]);
-                UInt32 uLabel = labelsArrayMap[u];
-                UInt32 vLabel = labelsArrayMap[v];
-
-                NodeCoordinate coords;
-                if (uLabel == nodeLabel) {
-                    coords = GraphDescriptorToMultiArrayIndex<Graph>::intrinsicNodeCoordinate(graph, u);
-                } else if (vLabel == nodeLabel) {
-                    coords = GraphDescriptorToMultiArrayIndex<Graph>::intrinsicNodeCoordinate(graph, v);
-                } else {
-                    // If you get here, then there's an error. Maybe print a message?
-                }
-                for(size_t k=0; k<coords.size(); ++k) {
-                    edgePoints(nNext, k) = coords[k];
+        {
+            PyAllowThreads _pythread;
+            size_t nNext = 0;
+            for(RagOutArcIt iter(rag, node); iter != lemon::INVALID; ++iter) {
+                const RagEdge ragEdge(*iter);
+                for (AffiliatedEdgeIdIter id=affiliatedEdges.begin(ragEdge); id!=affiliatedEdges.end(ragEdge); ++id) {
+                    const Edge affEdge = graph.edgeFromId(*id);
+                    Node u = graph.u(affEdge);
+                    Node v = graph.v(affEdge);
+                    UInt32 uLabel = labelsArrayMap[u];
+                    UInt32 vLabel = labelsArrayMap[v];
+
+                    NodeCoordinate coords;
+                    if (uLabel == nodeLabel) {
+                        coords = GraphDescriptorToMultiArrayIndex<Graph>::intrinsicNodeCoordinate(graph, u);
+                    } else if (vLabel == nodeLabel) {
+                        coords = GraphDescriptorToMultiArrayIndex<Graph>::intrinsicNodeCoordinate(graph, v);
+                    } else {
+                        // If you get here, then there's an error. Maybe print a message?
+                    }
+                    for(size_t k=0; k<coords.size(); ++k) {
+                        edgePoints(nNext, k) = coords[k];
+                    }
+                    nNext++;
                 }
-                nNext++;
             }
         }
         return edgePoints;
@@ -419,65 +428,68 @@ public:
         FloatNodeArrayMap    nodeSizesArrayMap(graph,nodeSizesArray);
         RagFloatNodeArrayMap ragNodeFeaturesArrayMap(rag,ragNodeFeaturesArray);
 
-        if(accumulator == std::string("mean")){
-            typename RagGraph:: template NodeMap<float> counting(rag,0.0f);
-            for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
-                UInt32 l = labelsArrayMap[*iter];
-                if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
-                    const float  weight = nodeSizesArrayMap[*iter];
-                    const RagNode ragNode   = rag.nodeFromId(l);
-                    ragNodeFeaturesArrayMap[ragNode]+= weight*nodeFeaturesArrayMap[*iter];
-                    counting[ragNode]+=weight;
+        {
+            PyAllowThreads _pythread;
+            if(accumulator == std::string("mean")){
+                typename RagGraph:: template NodeMap<float> counting(rag,0.0f);
+                for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
+                    UInt32 l = labelsArrayMap[*iter];
+                    if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
+                        const float  weight = nodeSizesArrayMap[*iter];
+                        const RagNode ragNode   = rag.nodeFromId(l);
+                        ragNodeFeaturesArrayMap[ragNode]+= weight*nodeFeaturesArrayMap[*iter];
+                        counting[ragNode]+=weight;
+                    }
                 }
-            }
-            for(RagNodeIt iter(rag);iter!=lemon::INVALID;++iter){
-                const RagNode ragNode   = *iter;
-                ragNodeFeaturesArrayMap[ragNode]/=counting[ragNode];
-            }
-        }
-        else if(accumulator == std::string("sum")){
-            for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
-                UInt32 l = labelsArrayMap[*iter];
-                if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
-                    const RagNode ragNode   = rag.nodeFromId(l);
-                    ragNodeFeaturesArrayMap[ragNode]+=nodeFeaturesArrayMap[*iter];
+                for(RagNodeIt iter(rag);iter!=lemon::INVALID;++iter){
+                    const RagNode ragNode   = *iter;
+                    ragNodeFeaturesArrayMap[ragNode]/=counting[ragNode];
                 }
             }
-        }
-        else if(accumulator == std::string("min")){
-            for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
-                UInt32 l = labelsArrayMap[*iter];
-                if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
-                    const RagNode ragNode   = rag.nodeFromId(l);
-                    ragNodeFeaturesArrayMap[ragNode]=std::numeric_limits<float>::infinity();
+            else if(accumulator == std::string("sum")){
+                for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
+                    UInt32 l = labelsArrayMap[*iter];
+                    if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
+                        const RagNode ragNode   = rag.nodeFromId(l);
+                        ragNodeFeaturesArrayMap[ragNode]+=nodeFeaturesArrayMap[*iter];
+                    }
                 }
             }
-            for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
-                UInt32 l = labelsArrayMap[*iter];
-                if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
-                    const RagNode ragNode   = rag.nodeFromId(l);
-                    ragNodeFeaturesArrayMap[ragNode]=std::min(nodeFeaturesArrayMap[*iter],ragNodeFeaturesArrayMap[ragNode]);
+            else if(accumulator == std::string("min")){
+                for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
+                    UInt32 l = labelsArrayMap[*iter];
+                    if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
+                        const RagNode ragNode   = rag.nodeFromId(l);
+                        ragNodeFeaturesArrayMap[ragNode]=std::numeric_limits<float>::infinity();
+                    }
                 }
-            }
-        }
-        else if(accumulator == std::string("max")){
-            for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
-                UInt32 l = labelsArrayMap[*iter];
-                if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
-                    const RagNode ragNode   = rag.nodeFromId(l);
-                    ragNodeFeaturesArrayMap[ragNode]= -1.0*std::numeric_limits<float>::infinity();
+                for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
+                    UInt32 l = labelsArrayMap[*iter];
+                    if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
+                        const RagNode ragNode   = rag.nodeFromId(l);
+                        ragNodeFeaturesArrayMap[ragNode]=std::min(nodeFeaturesArrayMap[*iter],ragNodeFeaturesArrayMap[ragNode]);
+                    }
                 }
             }
-            for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
-                UInt32 l = labelsArrayMap[*iter];
-                if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
-                    const RagNode ragNode   = rag.nodeFromId(l);
-                    ragNodeFeaturesArrayMap[ragNode]=std::max(nodeFeaturesArrayMap[*iter],ragNodeFeaturesArrayMap[ragNode]);
+            else if(accumulator == std::string("max")){
+                for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
+                    UInt32 l = labelsArrayMap[*iter];
+                    if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
+                        const RagNode ragNode   = rag.nodeFromId(l);
+                        ragNodeFeaturesArrayMap[ragNode]= -1.0*std::numeric_limits<float>::infinity();
+                    }
+                }
+                for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
+                    UInt32 l = labelsArrayMap[*iter];
+                    if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
+                        const RagNode ragNode   = rag.nodeFromId(l);
+                        ragNodeFeaturesArrayMap[ragNode]=std::max(nodeFeaturesArrayMap[*iter],ragNodeFeaturesArrayMap[ragNode]);
+                    }
                 }
             }
-        }
-        else{
+            else{
            
+            }
         }
         return ragNodeFeaturesArray;
     }
@@ -513,30 +525,33 @@ public:
         FloatNodeArrayMap         nodeSizesArrayMap(graph,nodeSizesArray);
         RagMultiFloatNodeArrayMap ragNodeFeaturesArrayMap(rag,ragNodeFeaturesArray);
 
-        if(accumulator == std::string("mean")){
-            typename RagGraph:: template NodeMap<float> counting(rag,0.0f);
-            for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
-                UInt32 l = labelsArrayMap[*iter];
-                if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
-                    const float weight = nodeSizesArrayMap[*iter];
-                    const RagNode ragNode   = rag.nodeFromId(l);
-                    typename MultiFloatNodeArrayMap::Value feat = nodeFeaturesArrayMap[*iter];
-                    feat*=weight;
-                    ragNodeFeaturesArrayMap[ragNode]+=feat;
-                    counting[ragNode]+=weight;
+        {
+            PyAllowThreads _pythread;
+            if(accumulator == std::string("mean")){
+                typename RagGraph:: template NodeMap<float> counting(rag,0.0f);
+                for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
+                    UInt32 l = labelsArrayMap[*iter];
+                    if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
+                        const float weight = nodeSizesArrayMap[*iter];
+                        const RagNode ragNode   = rag.nodeFromId(l);
+                        typename MultiFloatNodeArrayMap::Value feat = nodeFeaturesArrayMap[*iter];
+                        feat*=weight;
+                        ragNodeFeaturesArrayMap[ragNode]+=feat;
+                        counting[ragNode]+=weight;
+                    }
+                }
+                for(RagNodeIt iter(rag);iter!=lemon::INVALID;++iter){
+                    const RagNode ragNode   = *iter;
+                    ragNodeFeaturesArrayMap[ragNode]/=counting[ragNode];
                 }
             }
-            for(RagNodeIt iter(rag);iter!=lemon::INVALID;++iter){
-                const RagNode ragNode   = *iter;
-                ragNodeFeaturesArrayMap[ragNode]/=counting[ragNode];
-            }
-        }
-        else{
-            for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
-                UInt32 l = labelsArrayMap[*iter];
-                if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
-                    const RagNode ragNode   = rag.nodeFromId(l);
-                    ragNodeFeaturesArrayMap[ragNode]+=nodeFeaturesArrayMap[*iter];
+            else{
+                for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
+                    UInt32 l = labelsArrayMap[*iter];
+                    if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
+                        const RagNode ragNode   = rag.nodeFromId(l);
+                        ragNodeFeaturesArrayMap[ragNode]+=nodeFeaturesArrayMap[*iter];
+                    }
                 }
             }
         }
@@ -557,11 +572,14 @@ public:
         // numpy arrays => lemon maps
         UInt32NodeArrayMap labelsArrayMap(graph,labelsArray);
         RagFloatNodeArrayMap ragNodeSizeArrayMap(rag,ragNodeSizeArray);
-        for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
-            UInt32 l = labelsArrayMap[*iter];
-            if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
-                const RagNode ragNode   = rag.nodeFromId(l);
-                ragNodeSizeArrayMap[ragNode]+=1.0f;
+        {
+            PyAllowThreads _pythread;
+            for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
+                UInt32 l = labelsArrayMap[*iter];
+                if(ignoreLabel==-1 || static_cast<Int32>(l)!=ignoreLabel){
+                    const RagNode ragNode   = rag.nodeFromId(l);
+                    ragNodeSizeArrayMap[ragNode]+=1.0f;
+                }
             }
         }
 
@@ -578,10 +596,12 @@ public:
         // numpy arrays => lemon maps
         RagFloatEdgeArrayMap ragEdgeFeaturesArrayMap(rag,ragEdgeFeaturesArray);
 
-        for(RagEdgeIt iter(rag);iter!=lemon::INVALID;++iter){
-            const RagEdge ragEdge = *iter;
-            const std::vector<Edge> & affEdges = affiliatedEdges[ragEdge];
-            ragEdgeFeaturesArrayMap[ragEdge]=static_cast<float>(affEdges.size());
+        {
+            PyAllowThreads _pythread;
+            for(RagEdgeIt iter(rag);iter!=lemon::INVALID;++iter){
+                const RagEdge ragEdge = *iter;
+                ragEdgeFeaturesArrayMap[ragEdge]=static_cast<float>(affiliatedEdges.size(ragEdge));
+            }
         }
         return ragEdgeFeaturesArray;
     }
@@ -628,11 +648,14 @@ public:
         typename PyNodeMapTraits<RagGraph,T     >::Map ragNodeFeaturesArrayMap(rag,ragNodeFeaturesArray);
         typename PyNodeMapTraits<Graph,   T     >::Map graphNodeFeaturesArrayMap(graph,graphNodeFeaturesArray);
         // run algorithm
-        for(typename Graph::NodeIt iter(graph);iter!=lemon::INVALID;++iter){
-            if(ignoreLabel==-1 || static_cast<Int32>(labelsWhichGeneratedRagArrayMap[*iter])!=ignoreLabel)
-                graphNodeFeaturesArrayMap[*iter]=ragNodeFeaturesArrayMap[rag.nodeFromId(labelsWhichGeneratedRagArrayMap[*iter])];
-            else{
-                // do nothing
+        {
+            PyAllowThreads _pythread;
+            for(typename Graph::NodeIt iter(graph);iter!=lemon::INVALID;++iter){
+                if(ignoreLabel==-1 || static_cast<Int32>(labelsWhichGeneratedRagArrayMap[*iter])!=ignoreLabel)
+                    graphNodeFeaturesArrayMap[*iter]=ragNodeFeaturesArrayMap[rag.nodeFromId(labelsWhichGeneratedRagArrayMap[*iter])];
+                else{
+                    // do nothing
+                }
             }
         }
         return graphNodeFeaturesArray; // out
@@ -206,7 +206,10 @@ public:
         // numpy arrays => lemon maps
         FloatNodeArrayMap distanceArrayMap(sp.graph(),distanceArray);
 
-        copyNodeMap(sp.graph(),sp.distances(),distanceArrayMap);
+        {
+            PyAllowThreads _pythread;
+            copyNodeMap(sp.graph(),sp.distances(),distanceArrayMap);
+        }
 
         return distanceArray;
     }
@@ -229,9 +232,12 @@ public:
         // numpy arrays => lemon maps
         Int32NodeArrayMap predecessorsArrayMap(sp.graph(),predecessorsArray);
 
-        for(NodeIt n(sp.graph());n!=lemon::INVALID;++n){
-            const Node pred = sp.predecessors()[*n];
-            predecessorsArrayMap[*n]= (pred!=lemon::INVALID ? sp.graph().id(pred) : -1);
+        {
+            PyAllowThreads _pythread;
+            for(NodeIt n(sp.graph());n!=lemon::INVALID;++n){
+                const Node pred = sp.predecessors()[*n];
+                predecessorsArrayMap[*n]= (pred!=lemon::INVALID ? sp.graph().id(pred) : -1);
+            }
         }
         return predecessorsArray;
     }
@@ -248,7 +254,10 @@ public:
         // comput length of the path
         const size_t length = pathLength(Node(source),Node(target),predMap);
         nodeIdPath.reshapeIfEmpty(typename NumpyArray<1,Singleband<UInt32> >::difference_type(length));
-        pathIds(sp.graph(),source,target,predMap,nodeIdPath);
+        {
+            PyAllowThreads _pythread;
+            pathIds(sp.graph(),source,target,predMap,nodeIdPath);
+        }
         return nodeIdPath;
         
     }
@@ -263,7 +272,10 @@ public:
         // comput length of the path
         const size_t length = pathLength(Node(source),Node(target),predMap);
         nodeCoordinates.reshapeIfEmpty(typename NumpyArray<1,Singleband<UInt32> >::difference_type(length));
-        pathCoordinates(sp.graph(),source,target,predMap,nodeCoordinates);
+        {
+            PyAllowThreads _pythread;
+            pathCoordinates(sp.graph(),source,target,predMap,nodeCoordinates);
+        }
         return nodeCoordinates;
     }
 
@@ -277,7 +289,10 @@ public:
         FloatEdgeArrayMap edgeWeightsArrayMap(sp.graph(),edgeWeightsArray);
 
         // run algorithm itself
-        sp.run(edgeWeightsArrayMap,source,target);
+        {
+            PyAllowThreads _pythread;
+            sp.run(edgeWeightsArrayMap,source,target);
+        }
     }
 
     static void runShortestPathNoTarget(
@@ -289,7 +304,10 @@ public:
         FloatEdgeArrayMap edgeWeightsArrayMap(sp.graph(),edgeWeightsArray);
 
         // run algorithm itself
-        sp.run(edgeWeightsArrayMap,source);
+        {
+            PyAllowThreads _pythread;
+            sp.run(edgeWeightsArrayMap,source);
+        }
     }
 
 };
@@ -274,10 +274,13 @@ public:
         typedef GraphItemHelper<Graph,ITEM> ItemHelper;
         out.reshapeIfEmpty(typename NumpyArray<1,ITEM>::difference_type(  ItemHelper::itemNum(g)  ));
         size_t  counter=0;
-        for(ITEM_IT i(g);i!=lemon::INVALID;++i){
-            const ITEM item = *i;
-            out(counter)=item;
-            ++counter;
+        {
+            PyAllowThreads _pythread;
+            for(ITEM_IT i(g);i!=lemon::INVALID;++i){
+                const ITEM item = *i;
+                out(counter)=item;
+                ++counter;
+            }
         }
         return out;
     }
@@ -289,12 +292,15 @@ public:
         NumpyArray<1,Int32> out =(NumpyArray<1,Int32>())
     ){
         out.reshapeIfEmpty(typename NumpyArray<1,Int32>::difference_type(  nodeIdPairs.shape(0)  ));
-        for(MultiArrayIndex i=0; i<nodeIdPairs.shape(0); ++i){
-            const Edge e = g.findEdge(
-                g.nodeFromId(nodeIdPairs(i,0)),
-                g.nodeFromId(nodeIdPairs(i,1))
-            );
-            out(i) = e==lemon::INVALID ? -1 : g.id(e);
+        {
+            PyAllowThreads _pythread;
+            for(MultiArrayIndex i=0; i<nodeIdPairs.shape(0); ++i){
+                const Edge e = g.findEdge(
+                    g.nodeFromId(nodeIdPairs(i,0)),
+                    g.nodeFromId(nodeIdPairs(i,1))
+                );
+                out(i) = e==lemon::INVALID ? -1 : g.id(e);
+            }
         }
        
         return out;
@@ -312,9 +318,12 @@ public:
         typedef GraphItemHelper<Graph,Edge> ItemHelper;
         out.reshapeIfEmpty(typename NumpyArray<1,UInt32>::difference_type(  ItemHelper::itemNum(g)  ));
         size_t  counter=0;
-        for(EdgeIt i(g);i!=lemon::INVALID;++i){
-            out(counter)=g.id(g.u(*i));
-            ++counter;
+        {
+            PyAllowThreads _pythread;
+            for(EdgeIt i(g);i!=lemon::INVALID;++i){
+                out(counter)=g.id(g.u(*i));
+                ++counter;
+            }
         }
         return out;
     }
@@ -322,9 +331,12 @@ public:
         typedef GraphItemHelper<Graph,Edge> ItemHelper;
         out.reshapeIfEmpty(typename NumpyArray<1,UInt32>::difference_type(  ItemHelper::itemNum(g)  ));
         size_t  counter=0;
-        for(EdgeIt i(g);i!=lemon::INVALID;++i){
-            out(counter)=g.id(g.v(*i));
-            ++counter;
+        {
+            PyAllowThreads _pythread;
+            for(EdgeIt i(g);i!=lemon::INVALID;++i){
+                out(counter)=g.id(g.v(*i));
+                ++counter;
+            }
         }
         return out;
     }
@@ -333,10 +345,13 @@ public:
         typedef GraphItemHelper<Graph,Edge> ItemHelper;
         out.reshapeIfEmpty(typename NumpyArray<2,UInt32>::difference_type(  ItemHelper::itemNum(g) ,2 ));
         size_t  counter=0;
-        for(EdgeIt i(g);i!=lemon::INVALID;++i){
-            out(counter,0)=g.id(g.u(*i));
-            out(counter,1)=g.id(g.v(*i));
-            ++counter;
+        {
+            PyAllowThreads _pythread;
+            for(EdgeIt i(g);i!=lemon::INVALID;++i){
+                out(counter,0)=g.id(g.u(*i));
+                out(counter,1)=g.id(g.v(*i));
+                ++counter;
+            }
         }
         return out;
     }
@@ -347,11 +362,14 @@ public:
         NumpyArray<1,UInt32> out =(NumpyArray<1,UInt32>())
     ){
         out.reshapeIfEmpty(typename NumpyArray<1,UInt32>::difference_type(  edgeIds.shape(0)));
-        for(MultiArrayIndex i=0; i<edgeIds.shape(0); ++i){
-            const index_type edgeId=edgeIds(i);
-            const Edge edge  = g.edgeFromId(edgeId);
-            if(edge!=lemon::INVALID){
-                out(i)=g.id(g.u(edge));
+        {
+            PyAllowThreads _pythread;
+            for(MultiArrayIndex i=0; i<edgeIds.shape(0); ++i){
+                const index_type edgeId=edgeIds(i);
+                const Edge edge  = g.edgeFromId(edgeId);
+                if(edge!=lemon::INVALID){
+                    out(i)=g.id(g.u(edge));
+                }
             }
         }
         return out;
@@ -362,11 +380,14 @@ public:
         NumpyArray<1,UInt32> out =(NumpyArray<1,UInt32>())
     ){
         out.reshapeIfEmpty(typename NumpyArray<1,UInt32>::difference_type(  edgeIds.shape(0)));
-        for(MultiArrayIndex i=0; i<edgeIds.shape(0); ++i){
-            const index_type edgeId=edgeIds(i);
-            const Edge edge  = g.edgeFromId(edgeId);
-            if(edge!=lemon::INVALID){
-                out(i)=g.id(g.v(edge));
+        {
+            PyAllowThreads _pythread;
+            for(MultiArrayIndex i=0; i<edgeIds.shape(0); ++i){
+                const index_type edgeId=edgeIds(i);
+                const Edge edge  = g.edgeFromId(edgeId);
+                if(edge!=lemon::INVALID){
+                    out(i)=g.id(g.v(edge));
+                }
             }
         }
         return out;
@@ -378,12 +399,15 @@ public:
         NumpyArray<2,UInt32> out =(NumpyArray<2,UInt32>())
     ){
         out.reshapeIfEmpty(typename NumpyArray<2,UInt32>::difference_type(  edgeIds.shape(0) ,2 ));
-        for(MultiArrayIndex i=0; i<edgeIds.shape(0); ++i){
-            const index_type edgeId=edgeIds(i);
-            const Edge edge  = g.edgeFromId(edgeId);
-            if(edge!=lemon::INVALID){
-                out(i,0)=g.id(g.u(edge));
-                out(i,1)=g.id(g.v(edge));
+        {
+            PyAllowThreads _pythread;
+            for(MultiArrayIndex i=0; i<edgeIds.shape(0); ++i){
+                const index_type edgeId=edgeIds(i);
+                const Edge edge  = g.edgeFromId(edgeId);
+                if(edge!=lemon::INVALID){
+                    out(i,0)=g.id(g.u(edge));
+                    out(i,1)=g.id(g.v(edge));
+                }
             }
         }
         return out;
@@ -395,9 +419,12 @@ public:
         out.reshapeIfEmpty(typename NumpyArray<1,UInt32>::difference_type(  ItemHelper::maxItemId(g)  ));
         std::fill(out.begin(),out.end(),false);
         size_t  counter=0;
-        for(ITEM_IT i(g);i!=lemon::INVALID;++i){
-            out(g.id(*i))=true;
-            ++counter;
+        {
+            PyAllowThreads _pythread;
+            for(ITEM_IT i(g);i!=lemon::INVALID;++i){
+                out(g.id(*i))=true;
+                ++counter;
+            }
         }
         return out;
     }
@@ -407,9 +434,12 @@ public:
         typedef GraphItemHelper<Graph,ITEM> ItemHelper;
         out.reshapeIfEmpty(typename NumpyArray<1,UInt32>::difference_type(  ItemHelper::itemNum(g)  ));
         size_t  counter=0;
-        for(ITEM_IT i(g);i!=lemon::INVALID;++i){
-            out(counter)=g.id(*i);
-            ++counter;
+        {
+            PyAllowThreads _pythread;
+            for(ITEM_IT i(g);i!=lemon::INVALID;++i){
+                out(counter)=g.id(*i);
+                ++counter;
+            }
         }
         return out;
     }
@@ -488,8 +518,11 @@ public:
         // array to lemon map
         typename PyNodeMapTraits<Graph,   UInt32>::Map idArrayMap(graph, idArray);
 
-        for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
-            idArrayMap[*iter]=graph.id(*iter);
+        {
+            PyAllowThreads _pythread;
+            for(NodeIt iter(graph);iter!=lemon::INVALID;++iter){
+                idArrayMap[*iter]=graph.id(*iter);
+            }
         }
 
         return idArray;
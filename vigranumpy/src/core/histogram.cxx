@@ -61,8 +61,11 @@ namespace vigra{
         outShape[DIM]=bins;
         outShape[DIM+1]=CHANNELS;
         histogram.reshapeIfEmpty(outShape);
-        multi_gaussian_histogram<DIM,float,CHANNELS,float>(image,minVals,maxVals,bins,
-            sigma,sigmaBin,histogram);
+        {
+            PyAllowThreads _pythread;
+            multi_gaussian_histogram<DIM,float,CHANNELS,float>(image,minVals,maxVals,bins,
+                sigma,sigmaBin,histogram);
+        }
         return histogram;
     }
 
@@ -84,8 +87,11 @@ namespace vigra{
         outShape[DIM]=bins[0];
         outShape[DIM+1]=bins[1];
         histogram.reshapeIfEmpty(outShape);
-        multi_gaussian_co_histogram<DIM,float,float>(imageA,imageB,minVals,maxVals,bins,
-           sigma,histogram);
+        {
+            PyAllowThreads _pythread;
+            multi_gaussian_co_histogram<DIM,float,float>(imageA,imageB,minVals,maxVals,bins,
+               sigma,histogram);
+        }
         return histogram;
     }
 
@@ -65,31 +65,46 @@ NumpyAnyArray readImageImpl(ImageImportInfo const & info, std::string order = ""
       case 1:
       {
         NumpyArray<2, Singleband<T>, Stride> res(MultiArrayShape<2>::type(info.width(), info.height()), order);
-        importImage(info, destImage(res));
+        {
+            PyAllowThreads _pythread;
+            importImage(info, destImage(res));
+        }
         return res;
       }
       case 2:
       {
         NumpyArray<2, TinyVector<T, 2>, Stride> res(MultiArrayShape<2>::type(info.width(), info.height()), order);
-        importImage(info, destImage(res));
+        {
+            PyAllowThreads _pythread;
+            importImage(info, destImage(res));
+        }
         return res;
       }
       case 3:
       {
         NumpyArray<2, RGBValue<T>, Stride> res(MultiArrayShape<2>::type(info.width(), info.height()), order);
-        importImage(info, destImage(res));
+        {
+            PyAllowThreads _pythread;
+            importImage(info, destImage(res));
+        }
         return res;
       }
       case 4:
       {
         NumpyArray<2, TinyVector<T, 4>, Stride> res(MultiArrayShape<2>::type(info.width(), info.height()), order);
-        importImage(info, destImage(res));
+        {
+            PyAllowThreads _pythread;
+            importImage(info, destImage(res));
+        }
         return res;
       }
       default:
       {
         NumpyArray<3, Multiband<T> > res(MultiArrayShape<3>::type(info.width(), info.height(), info.numBands()), order);
-        importImage(info, destImage(res));
+        {
+            PyAllowThreads _pythread;
+            importImage(info, destImage(res));
+        }
         return res;
       }
     }
@@ -190,7 +205,10 @@ void writeImage(NumpyArray<3, Multiband<T> > const & image,
         info.setCompression("RLE");
     else if(std::string(compression) != "")
         info.setCompression(compression);
-    exportImage(srcImageRange(image), info);
+    {
+        PyAllowThreads _pythread;
+        exportImage(srcImageRange(image), info);
+    }
 }
 
 unsigned int numberImages(const char * filename)
@@ -215,25 +233,37 @@ readVolumeImpl(VolumeImportInfo const & info, std::string order = "")
       case 1:
       {
         NumpyArray<3, Singleband<T> > volume(info.shape(), order);
-        importVolume(info, volume);
+        {
+            PyAllowThreads _pythread;
+            importVolume(info, volume);
+        }
         return volume;
       }
       case 2:
       {
         NumpyArray<3, TinyVector<T, 2> > volume(info.shape(), order);
-        importVolume(info, volume);
+        {
+            PyAllowThreads _pythread;
+            importVolume(info, volume);
+        }
         return volume;
       }
       case 3:
       {
         NumpyArray<3, RGBValue<T> > volume(info.shape(), order);
-        importVolume(info, volume);
+        {
+            PyAllowThreads _pythread;
+            importVolume(info, volume);
+        }
         return volume;
       }
       case 4:
       {
         NumpyArray<3, TinyVector<T, 4> > volume(info.shape(), order);
-        importVolume(info, volume);
+        {
+            PyAllowThreads _pythread;
+            importVolume(info, volume);
+        }
         return volume;
       }
       //FIXME not yet supported
@@ -246,7 +276,10 @@ readVolumeImpl(VolumeImportInfo const & info, std::string order = "")
       default:
       {
         NumpyArray<3, RGBValue<T> > volume(info.shape(), order);
-        importVolume(info, volume);
+        {
+            PyAllowThreads _pythread;
+            importVolume(info, volume);
+        }
         return volume;
       }
     }
@@ -324,7 +357,10 @@ void writeVolume(NumpyArray<3, T > const & volume,
         info.setCompression("RLE");
     else if(std::string(compression) != "")
         info.setCompression(compression);
-    exportVolume(volume, info);
+    {
+        PyAllowThreads _pythread;
+        exportVolume(volume, info);
+    }
 }
 
 VIGRA_PYTHON_MULTITYPE_FUNCTOR(pywriteVolume, writeVolume)
@@ -127,6 +127,196 @@ ChunkedArray_checkoutSubarray(python::object array,
     return res;
 }
 
+    // keeps a chunk pinned for as long as a NumPy view of it exists
+template <unsigned int N, class T>
+struct ChunkedArrayPin
+{
+    ChunkedArray<N, T> * array;
+    TinyVector<MultiArrayIndex, N> chunk_index;
+    T const * data;
+    PyObject * owner;
+};
+
+template <unsigned int N, class T>
+void ChunkedArrayPin_release(PyObject * capsule)
+{
+    ChunkedArrayPin<N, T> * pin =
+        (ChunkedArrayPin<N, T> *)PyCapsule_GetPointer(capsule, "vigra.ChunkedArrayPin");
+    pin->array->unpinChunk(pin->chunk_index, pin->data);
+    Py_DECREF(pin->owner);
+    delete pin;
+}
+
+template <unsigned int N, class T>
+python::object
+ChunkedArray_viewSubarray(python::object array,
+                          TinyVector<MultiArrayIndex, N> const & start,
+                          TinyVector<MultiArrayIndex, N> const & stop)
+{
+    typedef TinyVector<MultiArrayIndex, N> Shape;
+
+    ChunkedArray<N, T> & self = python::extract<ChunkedArray<N, T> &>(array)();
+    self.checkSubarrayBounds(start, stop, "ChunkedArray.viewSubarray()");
+    Shape chunk_index = self.chunkStart(start);
+    vigra_precondition(chunk_index + Shape(1) == self.chunkStop(stop),
+        "ChunkedArray.viewSubarray(): subarray must be contained in a single chunk, "
+        "use checkoutSubarray().");
+
+    MultiArrayView<N, T, StridedArrayTag> chunk;
+    {
+        PyAllowThreads _pythread;
+        chunk = self.pinChunk(chunk_index, self.isReadOnly());
+    }
+
+    ChunkedArrayPin<N, T> * pin = new ChunkedArrayPin<N, T>();
+    pin->array = &self;
+    pin->chunk_index = chunk_index;
+    pin->data = chunk.data();
+    pin->owner = array.ptr();
+    python_ptr capsule(PyCapsule_New(pin, "vigra.ChunkedArrayPin", &ChunkedArrayPin_release<N, T>),
+                       python_ptr::keep_count);
+    if(!capsule)
+    {
+        delete pin;
+        self.unpinChunk(chunk_index, chunk.data());
+        pythonToCppException(false);
+    }
+    // the capsule now owns the pin and a reference to the array
+    Py_INCREF(pin->owner);
+
+    Shape offset = chunk_index*self.chunkShape();
+    MultiArrayView<N, T, StridedArrayTag> view = chunk.subarray(start - offset, stop - offset);
+    TinyVector<npy_intp, N> strides(view.stride()*MultiArrayIndex(sizeof(T)));
+    python_ptr res = constructNumpyArrayFromData(view.shape(), strides.begin(),
+                                                 NumpyArrayValuetypeTraits<T>::typeCode,
+                                                 view.data());
+    PyArrayObject * a = (PyArrayObject *)res.get();
+#if NPY_API_VERSION >= 0x00000007
+    if(self.isReadOnly())
+        PyArray_CLEARFLAGS(a, NPY_ARRAY_WRITEABLE);
+    int failed = PyArray_SetBaseObject(a, capsule.release());
+    pythonToCppException(failed == 0);
+#else
+    if(self.isReadOnly())
+        a->flags &= ~NPY_WRITEABLE;
+    a->base = capsule.release();
+#endif
+    return python::object(python::detail::new_reference(res.release()));
+}
+
+template <unsigned int N, class T>
+python::object
+ChunkedArray_chunkView(python::object array,
+                       TinyVector<MultiArrayIndex, N> const & chunk_index)
+{
+    typedef TinyVector<MultiArrayIndex, N> Shape;
+
+    ChunkedArray<N, T> const & self = python::extract<ChunkedArray<N, T> const &>(array)();
+    vigra_precondition(allLessEqual(Shape(), chunk_index) &&
+                       allLess(chunk_index, self.chunkArrayShape()),
+        "ChunkedArray.chunkView(): chunk index out of bounds.");
+    Shape start = chunk_index*self.chunkShape(),
+          stop  = min(start + self.chunkShape(), self.shape());
+    return ChunkedArray_viewSubarray<N, T>(array, start, stop);
+}
+
+    // PEP 3118 buffer protocol, only supported by ChunkedArrayFull
+template <unsigned int N, class T>
+struct ChunkedArrayBuffer
+{
+    static const char * format()
+    {
+        static char f[2] = { 0, 0 };
+        if(f[0] == 0)
+        {
+            PyArray_Descr * dtype = PyArray_DescrFromType(NumpyArrayValuetypeTraits<T>::typeCode);
+            f[0] = dtype->type;
+            Py_DECREF(dtype);
+        }
+        return f;
+    }
+
+    static int getbuffer(PyObject * obj, Py_buffer * view, int flags)
+    {
+        view->obj = NULL;
+        python::extract<ChunkedArray<N, T> &> array(obj);
+        ChunkedArrayFull<N, T> * full = array.check()
+                                           ? dynamic_cast<ChunkedArrayFull<N, T> *>(&array())
+                                           : 0;
+        if(full == 0)
+        {
+            PyErr_SetString(PyExc_BufferError,
+                "ChunkedArray: only ChunkedArrayFull supports the buffer protocol.");
+            return -1;
+        }
+        if((flags & PyBUF_STRIDES) != PyBUF_STRIDES)
+        {
+            PyErr_SetString(PyExc_BufferError,
+                "ChunkedArray: buffer consumer must accept strides.");
+            return -1;
+        }
+        if((flags & PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS)
+        {
+            PyErr_SetString(PyExc_BufferError,
+                "ChunkedArray: data are in Fortran order, C-contiguous buffer not available.");
+            return -1;
+        }
+        if((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE && full->isReadOnly())
+        {
+            PyErr_SetString(PyExc_BufferError, "ChunkedArray: array is read-only.");
+            return -1;
+        }
+
+        MultiArrayView<N, T> const & storage = *full;
+        Py_ssize_t * shape = new Py_ssize_t[2*N];
+        for(unsigned int k=0; k<N; ++k)
+        {
+            shape[k] = storage.shape(k);
+            shape[N+k] = storage.stride(k)*sizeof(T);
+        }
+        view->buf = (void *)storage.data();
+        view->obj = obj;
+        Py_INCREF(obj);
+        view->len = storage.size()*sizeof(T);
+        view->itemsize = sizeof(T);
+        view->readonly = full->isReadOnly();
+        view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT
+                           ? const_cast<char *>(format())
+                           : NULL;
+        view->ndim = N;
+        view->shape = shape;
+        view->strides = shape + N;
+        view->suboffsets = NULL;
+        view->internal = shape;
+        return 0;
+    }
+
+    static void releasebuffer(PyObject *, Py_buffer * view)
+    {
+        delete [] (Py_ssize_t *)view->internal;
+    }
+
+        // Boost.Python readies the class when it is created, so the slot can only be
+        // installed afterwards. Derived types copy the buffer slots of their bases
+        // when they are readied, so this must happen before any derived class
+        // (e.g. ChunkedArrayHDF5) is created.
+    static void define(python::object const & cls)
+    {
+        vigra_precondition(python::len(cls.attr("__subclasses__")()) == 0,
+            "ChunkedArray: buffer protocol must be installed before derived classes are created.");
+        PyTypeObject * type = (PyTypeObject *)cls.ptr();
+        // Boost.Python classes are heap types, which own their PyBufferProcs
+        PyBufferProcs * procs = &((PyHeapTypeObject *)type)->as_buffer;
+        procs->bf_getbuffer = &getbuffer;
+        procs->bf_releasebuffer = &releasebuffer;
+        type->tp_as_buffer = procs;
+#if PY_MAJOR_VERSION < 3
+        type->tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+        PyType_Modified(type);
+    }
+};
+
 template <unsigned int N, class T>
 void 
 ChunkedArray_commitSubarray(ChunkedArray<N, T> & self,
@@ -137,6 +327,43 @@ ChunkedArray_commitSubarray(ChunkedArray<N, T> & self,
     self.commitSubarray(start, array);
 }
 
+template <unsigned int N, class T>
+void 
+ChunkedArray_releaseChunks(ChunkedArray<N, T> & self,
+                           TinyVector<MultiArrayIndex, N> const & start,
+                           TinyVector<MultiArrayIndex, N> const & stop,
+                           bool destroy)
+{
+    PyAllowThreads _pythread;
+    self.releaseChunks(start, stop, destroy);
+}
+
+template <unsigned int N, class T>
+void 
+ChunkedArray_setCacheMaxSize(ChunkedArray<N, T> & self, std::size_t size)
+{
+    PyAllowThreads _pythread;
+    self.setCacheMaxSize(size);
+}
+
+#ifdef HasHDF5
+template <unsigned int N, class T>
+void 
+ChunkedArrayHDF5_close(ChunkedArrayHDF5<N, T> & self)
+{
+    PyAllowThreads _pythread;
+    self.close();
+}
+
+template <unsigned int N, class T>
+void 
+ChunkedArrayHDF5_flush(ChunkedArrayHDF5<N, T> & self)
+{
+    PyAllowThreads _pythread;
+    self.flushToDisk();
+}
+#endif
+
 template <class Shape>
 python::object
 bindNumpyArray(NumpyAnyArray self, Shape const & stop)
@@ -642,7 +869,7 @@ void defineChunkedArrayImpl()
     docstring_options doc_options(true, false, false);
 
     typedef ChunkedArray<N, T> Array;
-    class_<Array, boost::noncopyable>("ChunkedArray", 
+    python::object cls = class_<Array, boost::noncopyable>("ChunkedArray", 
          "\n"
          "Base class for chunked arrays.\n\n", 
          no_init)
@@ -667,7 +894,7 @@ void defineChunkedArrayImpl()
         .add_property("read_only", &Array::isReadOnly,
              "\n'True' if array values cannot be changed.\n")
         .add_property("cache_max_size", 
-             &Array::cacheMaxSize, &Array::setCacheMaxSize,
+             &Array::cacheMaxSize, &ChunkedArray_setCacheMaxSize<N, T>,
              "\nget/set the size of the chunk cache.\n")
         .add_property("dtype", &ChunkedArray_dtype<N, T>, 
              "\nthe array's value type\n")
@@ -684,19 +911,33 @@ void defineChunkedArrayImpl()
              (arg("start"), arg("array")),
              "\nwrite the given array at offset 'start'.\n")
         .def("releaseChunks", 
-             &Array::releaseChunks,
+             &ChunkedArray_releaseChunks<N, T>,
              (arg("start"), arg("stop"),arg("destroy")=false),
              "\nrelease or destroy all chunks that are completely contained in [start, stop).\n")
+        .def("viewSubarray", 
+             &ChunkedArray_viewSubarray<N, T>,
+             (arg("start"), arg("stop")),
+             "\nobtain a view (not a copy) of the specified subarray, which must be\n"
+             "contained in a single chunk. The chunk stays in memory for as long as\n"
+             "the view exists. Raises an error when the subarray spans several chunks,\n"
+             "use checkoutSubarray() in this case.\n")
+        .def("chunkView", 
+             &ChunkedArray_chunkView<N, T>,
+             arg("chunk_index"),
+             "\nobtain a view (not a copy) of the chunk at the given position in the\n"
+             "chunk array (see 'chunk_array_shape'). The chunk stays in memory for as long\n"
+             "as the view exists.\n")
         .def("__getitem__", &ChunkedArray_getitem<N, T>)
         .def("__setitem__", &ChunkedArray_setitem<N, T>)
         .def("__setitem__", &ChunkedArray_setitem2<N, T>)
         ;
+    ChunkedArrayBuffer<N, T>::define(cls);
         
 #ifdef HasHDF5
     typedef ChunkedArrayHDF5<N, T> ArrayHDF5;
     class_<ChunkedArrayHDF5<N, T>, bases<Array>, boost::noncopyable>("ChunkedArrayHDF5", no_init)
-        .def("close", &ArrayHDF5::close)
-        .def("flush", &ArrayHDF5::flushToDisk)
+        .def("close", &ChunkedArrayHDF5_close<N, T>)
+        .def("flush", &ChunkedArrayHDF5_flush<N, T>)
         .add_property("filename", &ArrayHDF5::fileName,
              "\nname of the file backend of this array.\n")
         .add_property("dataset_name", &ArrayHDF5::datasetName,
@@ -76,7 +76,10 @@ NumpyAnyArray  pyNonLocalMean(
     param.nThreads_ = nThreads;
     param.verbose_=verbose;
     out.reshapeIfEmpty(image.shape());
-    nonLocalMean<DIM,PIXEL_TYPE>(image,smoothPolicy,param,out);
+    {
+        PyAllowThreads _pythread;
+        nonLocalMean<DIM,PIXEL_TYPE>(image,smoothPolicy,param,out);
+    }
     return out;
 }
 
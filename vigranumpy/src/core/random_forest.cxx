@@ -395,12 +395,26 @@ void defineRandomForest()
              "If a 'nanLabel' is provided, it will be returned for all rows of\n"
              "the 'testData' that contain an NaN value. Otherwise, an exception is\n"
              "thrown whenever Nan is encountered.\n\n"
-             "The output is an array containing a label for every test samples.\n")
+             "The output is an array containing a label for every test samples.\n"
+             "'testData' can have dtype float32, uint8 or uint16.\n")
+        .def("predictLabels",
+             registerConverters(&pythonRFPredictLabels<LabelType,UInt8>),
+             (arg("testData"), arg("nanLabel")=object(), arg("out")=object()))
+        .def("predictLabels",
+             registerConverters(&pythonRFPredictLabels<LabelType,UInt16>),
+             (arg("testData"), arg("nanLabel")=object(), arg("out")=object()))
         .def("predictProbabilities",
              registerConverters(&pythonRFPredictProbabilities<LabelType,float>),
              (arg("testData"), arg("out")=object()),
              "Predict probabilities for different classes on 'testData'.\n\n"
-             "The output is an array containing a probability for every test sample and class.\n")
+             "The output is an array containing a probability for every test sample and class.\n"
+             "'testData' can have dtype float32, uint8 or uint16.\n")
+        .def("predictProbabilities",
+             registerConverters(&pythonRFPredictProbabilities<LabelType,UInt8>),
+             (arg("testData"), arg("out")=object()))
+        .def("predictProbabilities",
+             registerConverters(&pythonRFPredictProbabilities<LabelType,UInt16>),
+             (arg("testData"), arg("out")=object()))
         .def("predictProbabilities",
              registerConverters(&pythonRFPredictProbabilitiesOnlinePredSet<LabelType,float>),
              (arg("testData"), arg("out")=object()),
@@ -410,7 +424,17 @@ void defineRandomForest()
              (arg("trainData"), arg("trainLabels"), arg("randomSeed")=0,
               arg("maxDepth")=-1, arg("minSize")=0),
              "Trains a random Forest using 'trainData' and 'trainLabels'.\n\n"
-             "and returns the OOB. See the vigra documentation for the meaning af the rest of the parameters.\n")
+             "and returns the OOB. See the vigra documentation for the meaning af the rest of the parameters.\n\n"
+             "'trainData' can have dtype float32, uint8 or uint16. It is used directly,\n"
+             "without conversion to a floating point matrix.\n")
+        .def("learnRF",
+             registerConverters(&pythonLearnRandomForest<LabelType,UInt8>),
+             (arg("trainData"), arg("trainLabels"), arg("randomSeed")=0,
+              arg("maxDepth")=-1, arg("minSize")=0))
+        .def("learnRF",
+             registerConverters(&pythonLearnRandomForest<LabelType,UInt16>),
+             (arg("trainData"), arg("trainLabels"), arg("randomSeed")=0,
+              arg("maxDepth")=-1, arg("minSize")=0))
         .def("reLearnTree",
              registerConverters(&pythonRFReLearnTree<LabelType,float>),
             (arg("trainData"), arg("trainLabels"), arg("treeId"),
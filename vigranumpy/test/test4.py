@@ -153,6 +153,38 @@ def testGridGraphAgglomerativeClustering():
     g1  = graphs.regionAdjacencyGraph(graph=g0,labels=labels)
     assert g1.nodeNum == 5
 
+def testGridGraphConcurrentAlgorithms():
+    # the graph algorithms release the GIL, so several Python threads
+    # may run them on the same graph at the same time
+    import threading
+
+    data  = numpy.random.random([40,40,40]).astype(numpy.float32)
+    edata = numpy.random.random([40*2-1,40*2-1,40*2-1]).astype(numpy.float32)
+    g0 = graphs.gridGraph(data.shape)
+    ew = graphs.edgeFeaturesFromInterpolatedImage(graph=g0,image=edata)
+    seeds = graphs.nodeWeightedWatershedsSeeds(graph=g0,nodeWeights=data)
+
+    def run():
+        watersheds = graphs.edgeWeightedWatersheds(graph=g0,edgeWeights=ew,seeds=seeds)
+        clustering = graphs.agglomerativeClustering(graph=g0,edgeWeights=ew,nodeNumStop=20)
+        rag = graphs.regionAdjacencyGraph(graph=g0,labels=clustering)
+        return watersheds, clustering, rag.nodeNum
+
+    expected = run()
+    results  = [None]*4
+    def worker(k):
+        results[k] = run()
+    threads = [threading.Thread(target=worker,args=(k,)) for k in range(len(results))]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    for res in results:
+        assert numpy.array_equal(res[0],expected[0])
+        assert numpy.array_equal(res[1],expected[1])
+        assert res[2] == expected[2] == 20
+
 class TestGraph(object):
 
     def testAddNodesWithIds(self):
@@ -1224,6 +1224,42 @@ def testZMQ():
     assert_equal(b.axistags, a.axistags)
     assert numpy.all(a == b)
     
+def testChunkedArrayViews():
+    import vigra
+    ref = numpy.random.random((10, 20)).astype(numpy.float32)
+
+    # ChunkedArrayFull exports its memory via the buffer protocol
+    a = vigra.ChunkedArrayFull((10, 20), dtype=numpy.float32)
+    a.commitSubarray((0, 0), ref)
+    m = memoryview(a)
+    assert_equal(m.shape, (10, 20))
+    assert_equal(m.format, 'f')
+    b = numpy.asarray(a)
+    assert_equal(b.shape, (10, 20))
+    assert numpy.all(b == ref)
+    b[1, 2] = 42.0
+    assert_equal(a[1, 2], 42.0)
+    del m, b
+
+    c = vigra.ChunkedArrayLazy((10, 20), dtype=numpy.float32, chunk_shape=(8, 8))
+    try:
+        memoryview(c)
+        raise AssertionError("BufferError not raised")
+    except BufferError:
+        pass
+
+    # a chunk view shares memory with the array and keeps it alive
+    c.commitSubarray((0, 0), ref)
+    refcount = sys.getrefcount(c)
+    v = c.chunkView((1, 0))
+    assert_equal(v.shape, (2, 8))
+    assert numpy.all(v == ref[8:, :8])
+    assert sys.getrefcount(c) > refcount
+    v[...] = 7.0
+    assert numpy.all(c.checkoutSubarray((8, 0), (10, 8)) == 7.0)
+    del v
+    assert_equal(sys.getrefcount(c), refcount)
+
 def testSlicing():
     a = arraytypes.Vector2Volume((5,4,3))
     a.flat[...] = xrange(a.size)
@@ -93,6 +93,32 @@ def test_multiImageTiff():
     checkEqualData(im.readImage(filename, index=5).dropChannelAxis(), scalar_image)
 
 
+def test_concurrentReadWrite():
+    # readImage() and writeImage() release the GIL, so several Python
+    # threads can overlap their I/O
+    import threading
+
+    images = [at.RGBImage(np.random.rand(300,200,3)*255, dtype=np.uint8,
+                          axistags=at.VigraArray.defaultAxistags(3, 'V'))
+              for k in range(4)]
+    results = [None]*len(images)
+
+    def worker(k):
+        filename = 'resthread%d.ppm' % k
+        for i in range(5):
+            im.writeImage(images[k], filename)
+            results[k] = im.readImage(filename, dtype='UINT8')
+
+    threads = [threading.Thread(target=worker, args=(k,)) for k in range(len(images))]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    for k in range(len(images)):
+        checkEqualData(results[k], images[k])
+
+
 def test_writeAndReadImageHDF5():
     try:
         import h5py
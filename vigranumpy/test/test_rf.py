@@ -18,5 +18,14 @@ def test_rf_learn():
     lmat=np.vstack([label_gaus1,label_gaus2]).reshape(-1,1)
     RF.learnRF(fmat,lmat,0,1,100)
 
+def test_rf_integer_features():
+    fmat=np.vstack([gaus1,gaus2]).clip(0, 255)
+    lmat=np.vstack([label_gaus1,label_gaus2]).reshape(-1,1)
+    for dtype in [np.uint8, np.uint16]:
+        RF=vigra.learning.RandomForest(10)
+        RF.learnRF(fmat.astype(dtype),lmat,0,1,100)
+        assert RF.predictLabels(fmat.astype(dtype)).shape == (1000, 1)
+        assert RF.predictProbabilities(fmat.astype(dtype)).shape == (1000, 2)
+
 def ok_():
     print >> sys.stderr, ".",